@@ -6,12 +6,12 @@
 
 #include <chain.h>
 #include <netmessagemaker.h>
-#include <reverse_iterator.h>
 #include <scheduler.h>
 #include <util/bitmanip.h>
 #include <validation.h>
 
 #include <tuple>
+#include <utility>
 
 /**
  * Run the avalanche event loop every 10ms.
@@ -129,6 +129,22 @@ static bool IsWorthPolling(const CBlockIndex *pindex) {
     return true;
 }
 
+RWCollection<BlockVoteMap> &
+AvalancheProcessor::getVoteShard(const CBlockIndex *pindex) {
+    return vote_records[pindex->GetBlockHash().GetUint64(0) %
+                        AVALANCHE_SHARD_COUNT];
+}
+
+const RWCollection<BlockVoteMap> &
+AvalancheProcessor::getVoteShard(const CBlockIndex *pindex) const {
+    return const_cast<AvalancheProcessor *>(this)->getVoteShard(pindex);
+}
+
+RWCollection<AvalancheProcessor::QuerySet> &
+AvalancheProcessor::getQueryShard(NodeId nodeid) {
+    return queries[uint64_t(nodeid) % AVALANCHE_SHARD_COUNT];
+}
+
 bool AvalancheProcessor::addBlockToReconcile(const CBlockIndex *pindex) {
     bool isAccepted;
 
@@ -142,13 +158,14 @@ bool AvalancheProcessor::addBlockToReconcile(const CBlockIndex *pindex) {
         isAccepted = chainActive.Contains(pindex);
     }
 
-    return vote_records.getWriteView()
+    return getVoteShard(pindex)
+        .getWriteView()
         ->insert(std::make_pair(pindex, VoteRecord(isAccepted)))
         .second;
 }
 
 bool AvalancheProcessor::isAccepted(const CBlockIndex *pindex) const {
-    auto r = vote_records.getReadView();
+    auto r = getVoteShard(pindex).getReadView();
     auto it = r->find(pindex);
     if (it == r.end()) {
         return false;
@@ -158,7 +175,7 @@ bool AvalancheProcessor::isAccepted(const CBlockIndex *pindex) const {
 }
 
 int AvalancheProcessor::getConfidence(const CBlockIndex *pindex) const {
-    auto r = vote_records.getReadView();
+    auto r = getVoteShard(pindex).getReadView();
     auto it = r->find(pindex);
     if (it == r.end()) {
         return -1;
@@ -190,7 +207,7 @@ bool AvalancheProcessor::registerVotes(
 
     {
         // Check that the query exists.
-        auto w = queries.getWriteView();
+        auto w = getQueryShard(nodeid).getWriteView();
         auto it = w->find(std::make_tuple(nodeid, response.getRound()));
         if (it == w.end()) {
             // NB: The request may be old, so we don't increase banscore.
@@ -218,7 +235,10 @@ bool AvalancheProcessor::registerVotes(
         }
     }
 
-    std::map<CBlockIndex *, AvalancheVote> responseIndex;
+    // Group the votes by shard so each shard is locked once.
+    std::array<std::vector<std::pair<CBlockIndex *, AvalancheVote>>,
+               AVALANCHE_SHARD_COUNT>
+        responseIndex;
 
     {
         LOCK(cs_main);
@@ -235,14 +255,20 @@ bool AvalancheProcessor::registerVotes(
                 continue;
             }
 
-            responseIndex.insert(std::make_pair(pindex, v));
+            responseIndex[pindex->GetBlockHash().GetUint64(0) %
+                          AVALANCHE_SHARD_COUNT]
+                .emplace_back(pindex, v);
         }
     }
 
-    {
-        // Register votes.
-        auto w = vote_records.getWriteView();
-        for (auto &p : responseIndex) {
+    // Register votes.
+    for (size_t shard = 0; shard < AVALANCHE_SHARD_COUNT; shard++) {
+        if (responseIndex[shard].empty()) {
+            continue;
+        }
+
+        auto w = vote_records[shard].getWriteView();
+        for (auto &p : responseIndex[shard]) {
             CBlockIndex *pindex = p.first;
             const AvalancheVote &v = p.second;
 
@@ -338,17 +364,44 @@ bool AvalancheProcessor::stopEventLoop() {
 std::vector<CInv> AvalancheProcessor::getInvsForNextPoll(bool forPoll) const {
     std::vector<CInv> invs;
 
-    auto r = vote_records.getReadView();
-    for (const std::pair<const CBlockIndex *const, VoteRecord> &p :
-         reverse_iterate(r)) {
-        const CBlockIndex *pindex = p.first;
+    typedef RWCollection<BlockVoteMap>::ReadView::const_iterator Iterator;
+    std::vector<RWCollection<BlockVoteMap>::ReadView> views;
+    std::vector<std::reverse_iterator<Iterator>> its;
+    views.reserve(AVALANCHE_SHARD_COUNT);
+    its.reserve(AVALANCHE_SHARD_COUNT);
+    for (const RWCollection<BlockVoteMap> &shard : vote_records) {
+        views.push_back(shard.getReadView());
+        its.push_back(views.back().rbegin());
+    }
 
-        {
-            LOCK(cs_main);
-            if (!IsWorthPolling(pindex)) {
-                // Obviously do not poll if the block is not worth polling.
+    // Merge the shards so that the most worked blocks are polled first, as if
+    // the vote records were a single map.
+    const CBlockIndexWorkComparator comparator;
+    LOCK(cs_main);
+    while (true) {
+        size_t next = AVALANCHE_SHARD_COUNT;
+        for (size_t i = 0; i < AVALANCHE_SHARD_COUNT; i++) {
+            if (its[i] == views[i].rend()) {
                 continue;
             }
+
+            if (next == AVALANCHE_SHARD_COUNT ||
+                comparator(its[next]->first, its[i]->first)) {
+                next = i;
+            }
+        }
+
+        if (next == AVALANCHE_SHARD_COUNT) {
+            // All the shards have been visited.
+            return invs;
+        }
+
+        const std::pair<const CBlockIndex *const, VoteRecord> &p =
+            *its[next]++;
+        const CBlockIndex *pindex = p.first;
+        if (!IsWorthPolling(pindex)) {
+            // Obviously do not poll if the block is not worth polling.
+            continue;
         }
 
         // Check if we can run poll.
@@ -366,8 +419,6 @@ std::vector<CInv> AvalancheProcessor::getInvsForNextPoll(bool forPoll) const {
             return invs;
         }
     }
-
-    return invs;
 }
 
 NodeId AvalancheProcessor::getSuitableNodeToQuery() {
@@ -388,9 +439,9 @@ void AvalancheProcessor::clearTimedoutRequests() {
     auto now = std::chrono::steady_clock::now();
     std::map<CInv, uint8_t> timedout_items{};
 
-    {
+    for (RWCollection<QuerySet> &shard : queries) {
         // Clear expired requests.
-        auto w = queries.getWriteView();
+        auto w = shard.getWriteView();
         auto it = w->get<query_timeout>().begin();
         while (it != w->get<query_timeout>().end() && it->timeout < now) {
             for (auto &i : it->invs) {
@@ -422,9 +473,9 @@ void AvalancheProcessor::clearTimedoutRequests() {
             pindex = mi->second;
         }
 
-        auto w = vote_records.getWriteView();
-        auto it = w->find(pindex);
-        if (it == w.end()) {
+        auto r = getVoteShard(pindex).getReadView();
+        auto it = r->find(pindex);
+        if (it == r.end()) {
             continue;
         }
 
@@ -437,10 +488,20 @@ void AvalancheProcessor::runEventLoop() {
     // them.
     clearTimedoutRequests();
 
+    // Then poll as many peers as we are allowed to, until we run out of either
+    // peers or items to poll.
+    for (size_t i = 0; i < maxPollsPerTick; i++) {
+        if (!sendNextPoll()) {
+            return;
+        }
+    }
+}
+
+bool AvalancheProcessor::sendNextPoll() {
     while (true) {
         NodeId nodeid = getSuitableNodeToQuery();
         if (nodeid == NO_NODE) {
-            return;
+            return false;
         }
 
         /**
@@ -462,8 +523,9 @@ void AvalancheProcessor::runEventLoop() {
                 auto timeout =
                     std::chrono::steady_clock::now() + queryTimeoutDuration;
                 // Register the query.
-                queries.getWriteView()->insert(
-                    {pnode->GetId(), current_round, timeout, invs});
+                getQueryShard(pnode->GetId())
+                    .getWriteView()
+                    ->insert({pnode->GetId(), current_round, timeout, invs});
                 // Set the timeout.
                 auto w = peerSet.getWriteView();
                 auto it = w->find(pnode->GetId());
@@ -484,8 +546,12 @@ void AvalancheProcessor::runEventLoop() {
         });
 
         // Success!
-        if (hasSent || invs.empty()) {
-            return;
+        if (hasSent) {
+            return true;
+        }
+
+        if (invs.empty()) {
+            return false;
         }
 
         // This node is obsolete, delete it.
@@ -18,6 +18,7 @@
 #include <boost/multi_index/ordered_index.hpp>
 #include <boost/multi_index_container.hpp>
 
+#include <array>
 #include <atomic>
 #include <chrono>
 #include <condition_variable>
@@ -44,6 +45,18 @@ static const int AVALANCHE_DEFAULT_QUERY_TIMEOUT_DURATION_MILLISECONDS = 10000;
  */
 static const int AVALANCHE_MAX_INFLIGHT_POLL = 10;
 
+/**
+ * How many peers can be polled in one run of the event loop.
+ */
+static const size_t AVALANCHE_DEFAULT_MAX_POLLS_PER_TICK = 16;
+
+/**
+ * Number of shards the vote records and the queries are split into, so that
+ * votes on different blocks and responses from different peers do not contend
+ * on the same lock.
+ */
+static const size_t AVALANCHE_SHARD_COUNT = 16;
+
 /**
  * Special NodeId that represent no node.
  */
@@ -117,8 +130,9 @@ public:
 
     /**
      * Clear `count` inflight requests.
+     * Made const for the same reason as registerPoll.
      */
-    void clearInflightRequest(uint8_t count = 1) { inflight -= count; }
+    void clearInflightRequest(uint8_t count = 1) const { inflight -= count; }
 
 private:
     /**
@@ -243,11 +257,12 @@ class AvalancheProcessor {
 private:
     CConnman *connman;
     std::chrono::milliseconds queryTimeoutDuration;
+    size_t maxPollsPerTick;
 
     /**
-     * Blocks to run avalanche on.
+     * Blocks to run avalanche on, sharded by block hash.
      */
-    RWCollection<BlockVoteMap> vote_records;
+    std::array<RWCollection<BlockVoteMap>, AVALANCHE_SHARD_COUNT> vote_records;
 
     /**
      * Keep track of peers and queries sent.
@@ -307,7 +322,10 @@ private:
                 boost::multi_index::member<Query, TimePoint, &Query::timeout>>>>
         QuerySet;
 
-    RWCollection<QuerySet> queries;
+    /**
+     * Queries sent, sharded by nodeid.
+     */
+    std::array<RWCollection<QuerySet>, AVALANCHE_SHARD_COUNT> queries;
 
     /**
      * Start stop machinery.
@@ -323,13 +341,16 @@ public:
         : connman(connmanIn),
           queryTimeoutDuration(
               AVALANCHE_DEFAULT_QUERY_TIMEOUT_DURATION_MILLISECONDS),
-          round(0), stopRequest(false), running(false) {}
+          maxPollsPerTick(AVALANCHE_DEFAULT_MAX_POLLS_PER_TICK), round(0),
+          stopRequest(false), running(false) {}
     ~AvalancheProcessor() { stopEventLoop(); }
 
     void setQueryTimeoutDuration(std::chrono::milliseconds d) {
         queryTimeoutDuration = d;
     }
 
+    void setMaxPollsPerTick(size_t n) { maxPollsPerTick = n; }
+
     bool addBlockToReconcile(const CBlockIndex *pindex);
     bool isAccepted(const CBlockIndex *pindex) const;
     int getConfidence(const CBlockIndex *pindex) const;
@@ -344,10 +365,16 @@ public:
 
 private:
     void runEventLoop();
+    bool sendNextPoll();
     void clearTimedoutRequests();
     std::vector<CInv> getInvsForNextPoll(bool forPoll = true) const;
     NodeId getSuitableNodeToQuery();
 
+    RWCollection<BlockVoteMap> &getVoteShard(const CBlockIndex *pindex);
+    const RWCollection<BlockVoteMap> &
+    getVoteShard(const CBlockIndex *pindex) const;
+    RWCollection<QuerySet> &getQueryShard(NodeId nodeid);
+
     friend struct AvalancheTest;
 };
 
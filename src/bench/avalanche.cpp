@@ -0,0 +1,176 @@
+// Copyright (c) 2019 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <avalanche.h>
+
+#include <bench/bench.h>
+#include <chain.h>
+#include <chainparams.h>
+#include <config.h>
+#include <net.h>
+#include <random.h>
+#include <reverse_iterator.h>
+#include <validation.h>
+
+#include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
+
+static const size_t NUM_PEERS = 2000;
+static const size_t NUM_BLOCKS = 1000;
+static const size_t NUM_VOTING_THREADS = 4;
+
+// Same helpers as in avalanche_tests, which this benchmark mirrors.
+struct AvalancheTest {
+    static void runEventLoop(AvalancheProcessor &p) { p.runEventLoop(); }
+
+    // The queries in flight, as (nodeid, round) pairs.
+    static std::vector<std::pair<NodeId, uint64_t>>
+    getQueries(AvalancheProcessor &p) {
+        std::vector<std::pair<NodeId, uint64_t>> queries;
+        for (auto &shard : p.queries) {
+            auto r = shard.getReadView();
+            for (const auto &q : r) {
+                queries.emplace_back(q.nodeid, q.round);
+            }
+        }
+        return queries;
+    }
+};
+
+struct CConnmanTest : public CConnman {
+    using CConnman::CConnman;
+    void AddNode(CNode &node) {
+        LOCK(cs_vNodes);
+        vNodes.push_back(&node);
+    }
+    void ClearNodes() {
+        LOCK(cs_vNodes);
+        for (CNode *node : vNodes) {
+            delete node;
+        }
+        vNodes.clear();
+    }
+    // The polls are never sent as the nodes have no socket, drop them.
+    void ClearSendQueues() {
+        LOCK(cs_vNodes);
+        for (CNode *node : vNodes) {
+            LOCK(node->cs_vSend);
+            node->vSendMsg.clear();
+            node->nSendSize = 0;
+        }
+    }
+};
+
+// Sets up NUM_PEERS avalanche peers and NUM_BLOCKS blocks to vote on, with
+// fake block indexes registered in mapBlockIndex.
+class AvalancheSetup {
+public:
+    std::unique_ptr<CConnmanTest> connman;
+    std::unique_ptr<AvalancheProcessor> processor;
+    std::vector<CBlockIndex *> blocks;
+
+    AvalancheSetup() {
+        connman = std::make_unique<CConnmanTest>(GetConfig(), 0x1337, 0x1337);
+        processor = std::make_unique<AvalancheProcessor>(connman.get());
+        // Poll every peer we can in each run of the event loop.
+        processor->setMaxPollsPerTick(NUM_PEERS);
+
+        for (size_t i = 0; i < NUM_PEERS; i++) {
+            CAddress addr(CService(), NODE_NONE);
+            auto node = new CNode(i, ServiceFlags(NODE_NETWORK), 0,
+                                  INVALID_SOCKET, addr, 0, 0, CAddress(), "",
+                                  /*fInboundIn=*/false);
+            node->SetSendVersion(PROTOCOL_VERSION);
+            node->nServices = NODE_AVALANCHE;
+            node->nVersion = 1;
+            node->fSuccessfullyConnected = true;
+            connman->AddNode(*node);
+            processor->addPeer(node->GetId(), 0);
+        }
+
+        LOCK(cs_main);
+        for (size_t i = 0; i < NUM_BLOCKS; i++) {
+            CBlockIndex *pindex = new CBlockIndex();
+            auto it = mapBlockIndex.emplace(GetRandHash(), pindex).first;
+            pindex->phashBlock = &it->first;
+            pindex->nChainWork = i;
+            blocks.push_back(pindex);
+        }
+    }
+
+    ~AvalancheSetup() {
+        processor.reset();
+        connman->ClearNodes();
+
+        LOCK(cs_main);
+        for (CBlockIndex *pindex : blocks) {
+            mapBlockIndex.erase(pindex->GetBlockHash());
+            delete pindex;
+        }
+    }
+};
+
+// Run the event loop to poll as many peers as the inflight limit allows, then
+// register a yes vote on every block from each polled peer, on
+// NUM_VOTING_THREADS threads. Finalized blocks are voted on again so that
+// NUM_BLOCKS blocks are always in flight. Each iteration processes
+// AVALANCHE_MAX_INFLIGHT_POLL * NUM_BLOCKS votes.
+static void AvalancheRegisterVotes(benchmark::State &state) {
+    SelectParams(CBaseChainParams::REGTEST);
+    AvalancheSetup setup;
+    AvalancheProcessor &p = *setup.processor;
+
+    for (const CBlockIndex *pindex : setup.blocks) {
+        p.addBlockToReconcile(pindex);
+    }
+
+    // Blocks are polled by decreasing work.
+    std::vector<AvalancheVote> votes;
+    for (const CBlockIndex *pindex : reverse_iterate(setup.blocks)) {
+        votes.emplace_back(0, pindex->GetBlockHash());
+    }
+
+    while (state.KeepRunning()) {
+        AvalancheTest::runEventLoop(p);
+        setup.connman->ClearSendQueues();
+
+        std::vector<std::pair<NodeId, AvalancheResponse>> responses;
+        for (const auto &q : AvalancheTest::getQueries(p)) {
+            responses.emplace_back(q.first,
+                                   AvalancheResponse(q.second, 0, votes));
+        }
+
+        std::vector<std::vector<AvalancheBlockUpdate>> updates(
+            NUM_VOTING_THREADS);
+        std::vector<std::thread> threads;
+        for (size_t t = 0; t < NUM_VOTING_THREADS; t++) {
+            threads.emplace_back([&, t]() {
+                for (size_t i = t; i < responses.size();
+                     i += NUM_VOTING_THREADS) {
+                    bool ok = p.registerVotes(responses[i].first,
+                                              responses[i].second, updates[t]);
+                    assert(ok);
+                }
+            });
+        }
+        for (std::thread &thread : threads) {
+            thread.join();
+        }
+
+        for (const std::vector<AvalancheBlockUpdate> &u : updates) {
+            for (const AvalancheBlockUpdate &update : u) {
+                if (update.getStatus() ==
+                        AvalancheBlockUpdate::Status::Finalized ||
+                    update.getStatus() ==
+                        AvalancheBlockUpdate::Status::Invalid) {
+                    p.addBlockToReconcile(update.getBlockIndex());
+                }
+            }
+        }
+    }
+}
+
+BENCHMARK(AvalancheRegisterVotes, 10);
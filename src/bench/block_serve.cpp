@@ -0,0 +1,102 @@
+// Copyright (c) 2019 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+
+#include <chain.h>
+#include <chainparams.h>
+#include <clientversion.h>
+#include <fs.h>
+#include <net.h>
+#include <netmessagemaker.h>
+#include <streams.h>
+#include <util/system.h>
+#include <validation.h>
+
+#include <cassert>
+
+namespace block_bench {
+#include <bench/data/block413567.raw.h>
+} // namespace block_bench
+
+// Writes block 413567 to a block file in a temporary data directory, the way
+// WriteBlockToDisk does, along with a block index pointing at it.
+class BlockFileSetup {
+public:
+    CBlockIndex index;
+
+    BlockFileSetup() {
+        SelectParams(CBaseChainParams::MAIN);
+        path = fs::temp_directory_path() /
+               fs::unique_path("bench_block_serve_%%%%-%%%%-%%%%");
+        fs::create_directories(path);
+        gArgs.ForceSetArg("-datadir", path.string());
+        ClearDatadirCache();
+
+        CDataStream stream((const char *)block_bench::block413567,
+                           (const char *)&block_bench::block413567[sizeof(
+                               block_bench::block413567)],
+                           SER_NETWORK, PROTOCOL_VERSION);
+        CBlock block;
+        stream >> block;
+        hash = block.GetHash();
+
+        FlatFilePos pos(0, 0);
+        CAutoFile fileout(OpenBlockFile(pos), SER_DISK, CLIENT_VERSION);
+        assert(!fileout.IsNull());
+        fileout << Params().DiskMagic()
+                << uint32_t(sizeof(block_bench::block413567));
+        fileout.write((const char *)block_bench::block413567,
+                      sizeof(block_bench::block413567));
+
+        index = CBlockIndex(block.GetBlockHeader());
+        index.phashBlock = &hash;
+        index.nFile = 0;
+        index.nDataPos = CMessageHeader::MESSAGE_START_SIZE + sizeof(uint32_t);
+        index.nStatus = index.nStatus.withData();
+    }
+
+    ~BlockFileSetup() {
+        ClearDatadirCache();
+        gArgs.ForceSetArg("-datadir", "");
+        fs::remove_all(path);
+    }
+
+private:
+    fs::path path;
+    uint256 hash;
+};
+
+// Answer a getdata for a block by reading it from disk and serializing it back
+// into a message.
+static void BlockServeDeserialize(benchmark::State &state) {
+    BlockFileSetup setup;
+    const CNetMsgMaker msgMaker(PROTOCOL_VERSION);
+
+    while (state.KeepRunning()) {
+        CBlock block;
+        bool ret =
+            ReadBlockFromDisk(block, &setup.index, Params().GetConsensus());
+        assert(ret);
+        CSerializedNetMsg msg = msgMaker.Make(NetMsgType::BLOCK, block);
+        assert(msg.data.size() == sizeof(block_bench::block413567));
+    }
+}
+
+// Answer a getdata for a block with the bytes from disk.
+static void BlockServeRaw(benchmark::State &state) {
+    BlockFileSetup setup;
+
+    while (state.KeepRunning()) {
+        CSerializedNetMsg msg;
+        msg.command = NetMsgType::BLOCK;
+        bool ret =
+            ReadRawBlockFromDisk(msg.data, &setup.index, Params().DiskMagic());
+        assert(ret);
+        assert(msg.data.size() == sizeof(block_bench::block413567));
+    }
+}
+
+BENCHMARK(BlockServeDeserialize, 100);
+BENCHMARK(BlockServeRaw, 100);
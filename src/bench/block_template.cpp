@@ -0,0 +1,123 @@
+// Copyright (c) 2019 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <chain.h>
+#include <chainparams.h>
+#include <coins.h>
+#include <config.h>
+#include <miner.h>
+#include <random.h>
+#include <txmempool.h>
+#include <validation.h>
+
+#include <algorithm>
+#include <vector>
+
+static CTransactionRef MakeTx(const COutPoint &prevout) {
+    CMutableTransaction tx;
+    tx.vin.resize(1);
+    tx.vin[0].prevout = prevout;
+    tx.vin[0].scriptSig = CScript() << OP_1;
+    tx.vout.resize(1);
+    tx.vout[0].scriptPubKey = CScript() << OP_TRUE;
+    tx.vout[0].nValue = 10 * COIN;
+    return MakeTransactionRef(tx);
+}
+
+static void AddTx(const CTransactionRef &tx, CTxMemPool &pool)
+    EXCLUSIVE_LOCKS_REQUIRED(cs_main, pool.cs) {
+    LockPoints lp;
+    pool.addUnchecked(tx->GetId(),
+                      CTxMemPoolEntry(tx, 1000 * SATOSHI, /* time */ 0,
+                                      /* priority */ 10.0, /* height */ 1,
+                                      tx->GetValueOut(),
+                                      /* spendsCoinbase */ false,
+                                      /* sigOpCost */ 1, lp));
+}
+
+// Measure how long it takes to serve a block template from the template cache
+// while the mempool churns, for various mempool sizes. The mempool is filled
+// after the initial full build (which has to pass TestBlockValidity against
+// an empty coins view), and the journal is sized to hold all of it, so every
+// transaction goes through the incremental path. Half of the transactions are
+// children of the other half.
+static void BlockTemplateLatency(benchmark::State &state, size_t nMempoolTx) {
+    SelectParams(CBaseChainParams::REGTEST);
+    const Config &config = GetConfig();
+    const CChainParams &params = config.GetChainParams();
+
+    CBlockIndex genesis(params.GenesisBlock());
+    uint256 genesisHash = params.GenesisBlock().GetHash();
+    genesis.phashBlock = &genesisHash;
+
+    CCoinsView coinsDummy;
+    std::unique_ptr<CCoinsViewCache> pcoinsOld = std::move(pcoinsTip);
+    pcoinsTip.reset(new CCoinsViewCache(&coinsDummy));
+    pcoinsTip->SetBestBlock(genesisHash);
+
+    CTxMemPool pool;
+    {
+        LOCK(cs_main);
+        chainActive.SetTip(&genesis);
+    }
+
+    BlockTemplateCache cache(config, pool,
+                             std::max(nMempoolTx,
+                                      BLOCK_TEMPLATE_CACHE_MAX_JOURNAL));
+    const CScript scriptPubKey = CScript() << OP_TRUE;
+    cache.GetBlockTemplate(scriptPubKey);
+
+    std::vector<CTransactionRef> txs;
+    txs.reserve(nMempoolTx);
+    while (txs.size() < nMempoolTx) {
+        CTransactionRef parent = MakeTx(COutPoint(TxId(GetRandHash()), 0));
+        txs.push_back(parent);
+        txs.push_back(MakeTx(COutPoint(parent->GetId(), 0)));
+    }
+
+    {
+        LOCK2(cs_main, pool.cs);
+        for (const CTransactionRef &tx : txs) {
+            AddTx(tx, pool);
+        }
+    }
+    cache.GetBlockTemplate(scriptPubKey);
+
+    size_t i = 0;
+    while (state.KeepRunning()) {
+        // Replace one parent/child pair, then request a template.
+        const CTransactionRef &parent = txs[i];
+        const CTransactionRef &child = txs[i + 1];
+        {
+            LOCK2(cs_main, pool.cs);
+            pool.removeRecursive(*parent);
+            AddTx(parent, pool);
+            AddTx(child, pool);
+        }
+        cache.GetBlockTemplate(scriptPubKey);
+        i = (i + 2) % txs.size();
+    }
+
+    {
+        LOCK2(cs_main, pool.cs);
+        pool.clear();
+        chainActive.SetTip(nullptr);
+    }
+    pcoinsTip = std::move(pcoinsOld);
+}
+
+static void BlockTemplateLatency1k(benchmark::State &state) {
+    BlockTemplateLatency(state, 1000);
+}
+static void BlockTemplateLatency10k(benchmark::State &state) {
+    BlockTemplateLatency(state, 10000);
+}
+static void BlockTemplateLatency100k(benchmark::State &state) {
+    BlockTemplateLatency(state, 100000);
+}
+
+BENCHMARK(BlockTemplateLatency1k, 500);
+BENCHMARK(BlockTemplateLatency10k, 50);
+BENCHMARK(BlockTemplateLatency100k, 5);
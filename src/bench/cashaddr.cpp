@@ -28,5 +28,43 @@ static void CashAddrDecode(benchmark::State &state) {
     }
 }
 
+// Encode a batch of addresses sharing the prefix, as when listing the outputs
+// of a block or the transactions of a wallet.
+static void CashAddrEncodeBatch(benchmark::State &state) {
+    std::vector<std::vector<uint8_t>> payloads(1000);
+    for (size_t i = 0; i < payloads.size(); i++) {
+        // Version byte and 20 bytes of hash, packed as 34 5-bit groups.
+        payloads[i].resize(34);
+        for (size_t j = 0; j < payloads[i].size(); j++) {
+            payloads[i][j] = (i * 7 + j * 13) & 0x1f;
+        }
+        payloads[i].back() &= 0x1e;
+    }
+    while (state.KeepRunning()) {
+        cashaddr::Encode("bitcoincash", payloads);
+    }
+}
+
+static void CashAddrDecodeBatch(benchmark::State &state) {
+    std::vector<std::vector<uint8_t>> payloads(1000);
+    for (size_t i = 0; i < payloads.size(); i++) {
+        payloads[i].resize(34);
+        for (size_t j = 0; j < payloads[i].size(); j++) {
+            payloads[i][j] = (i * 7 + j * 13) & 0x1f;
+        }
+        payloads[i].back() &= 0x1e;
+    }
+    std::vector<std::string> addrs = cashaddr::Encode("bitcoincash", payloads);
+    // Half of the addresses come without their prefix.
+    for (size_t i = 0; i < addrs.size(); i += 2) {
+        addrs[i] = addrs[i].substr(addrs[i].find(':') + 1);
+    }
+    while (state.KeepRunning()) {
+        cashaddr::Decode(addrs, "bitcoincash");
+    }
+}
+
 BENCHMARK(CashAddrEncode, 800 * 1000);
 BENCHMARK(CashAddrDecode, 800 * 1000);
+BENCHMARK(CashAddrEncodeBatch, 800);
+BENCHMARK(CashAddrDecodeBatch, 800);
@@ -7,6 +7,9 @@
 #include <chainparams.h>
 #include <config.h>
 #include <consensus/validation.h>
+#include <key.h>
+#include <random.h>
+#include <script/schnorrbatch.h>
 #include <streams.h>
 #include <validation.h>
 
@@ -57,5 +60,52 @@ static void DeserializeAndCheckBlockTest(benchmark::State &state) {
     }
 }
 
+// Signature verification for a block carrying NUM_BLOCK_SCHNORR_SIGS Schnorr
+// signatures, either one by one as CScriptCheck used to do, or deferred to a
+// SchnorrBatchVerifier the way ConnectBlock does.
+static const size_t NUM_BLOCK_SCHNORR_SIGS = 1000;
+
+static std::vector<DeferredSchnorrSig> MakeBlockSchnorrSigs() {
+    std::vector<DeferredSchnorrSig> sigs(NUM_BLOCK_SCHNORR_SIGS);
+    for (DeferredSchnorrSig &sig : sigs) {
+        CKey key;
+        key.MakeNewKey(true);
+        sig.pubkey = key.GetPubKey();
+        sig.sighash = GetRandHash();
+
+        std::vector<uint8_t> vchSig;
+        key.SignSchnorr(sig.sighash, vchSig);
+        std::copy(vchSig.begin(), vchSig.end(), sig.sig.begin());
+    }
+    return sigs;
+}
+
+static void VerifyBlockSchnorrSigs(benchmark::State &state) {
+    const std::vector<DeferredSchnorrSig> sigs = MakeBlockSchnorrSigs();
+    while (state.KeepRunning()) {
+        for (const DeferredSchnorrSig &sig : sigs) {
+            std::vector<uint8_t> vchSig(sig.sig.begin(), sig.sig.end());
+            bool ret = sig.pubkey.VerifySchnorr(sig.sighash, vchSig);
+            assert(ret);
+        }
+    }
+}
+
+static void BatchVerifyBlockSchnorrSigs(benchmark::State &state) {
+    const std::vector<DeferredSchnorrSig> sigs = MakeBlockSchnorrSigs();
+    while (state.KeepRunning()) {
+        SchnorrBatchVerifier batch;
+        bool ret = true;
+        for (const DeferredSchnorrSig &sig : sigs) {
+            std::vector<DeferredSchnorrSig> deferred{sig};
+            ret &= batch.Add(deferred);
+        }
+        ret &= batch.Verify();
+        assert(ret);
+    }
+}
+
 BENCHMARK(DeserializeBlockTest, 130);
 BENCHMARK(DeserializeAndCheckBlockTest, 160);
+BENCHMARK(VerifyBlockSchnorrSigs, 10);
+BENCHMARK(BatchVerifyBlockSchnorrSigs, 20);
@@ -0,0 +1,79 @@
+// Copyright (c) 2019 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <blockencodings.h>
+#include <config.h>
+#include <policy/policy.h>
+#include <random.h>
+#include <txmempool.h>
+
+#include <cassert>
+#include <vector>
+
+static const size_t NUM_BLOCK_TXS = 1000;
+
+static CTransactionRef MakeTx(FastRandomContext &rng) {
+    CMutableTransaction tx;
+    tx.vin.resize(1);
+    tx.vin[0].prevout = COutPoint(TxId(rng.rand256()), 0);
+    tx.vin[0].scriptSig = CScript() << OP_1;
+    tx.vout.resize(1);
+    tx.vout[0].scriptPubKey = CScript() << OP_TRUE;
+    tx.vout[0].nValue = 10 * COIN;
+    return MakeTransactionRef(tx);
+}
+
+// Reconstruct a compact block of NUM_BLOCK_TXS transactions from a mempool of
+// mempool_size transactions. One transaction of the block is missing from the
+// mempool, so that the whole mempool is scanned as in the worst case.
+static void CompactBlockInitData(benchmark::State &state,
+                                 size_t mempool_size) {
+    FastRandomContext rng(true);
+    CTxMemPool pool;
+    CBlock block;
+    block.vtx.push_back(MakeTx(rng));
+    {
+        LOCK2(cs_main, pool.cs);
+        for (size_t i = 0; i < mempool_size; i++) {
+            CTransactionRef tx = MakeTx(rng);
+            LockPoints lp;
+            pool.addUnchecked(
+                tx->GetId(),
+                CTxMemPoolEntry(tx, 1000 * SATOSHI, /* time */ 0,
+                                /* priority */ 10.0, /* height */ 1,
+                                tx->GetValueOut(),
+                                /* spendsCoinbase */ false,
+                                /* sigOpCost */ 1, lp));
+            if (block.vtx.size() < NUM_BLOCK_TXS) {
+                block.vtx.push_back(tx);
+            }
+        }
+    }
+    block.vtx.push_back(MakeTx(rng));
+
+    const CBlockHeaderAndShortTxIDs cmpctblock(block);
+    const std::vector<std::pair<uint256, CTransactionRef>> extra_txn;
+
+    while (state.KeepRunning()) {
+        PartiallyDownloadedBlock partial_block(GetConfig(), &pool);
+        ReadStatus status = partial_block.InitData(cmpctblock, extra_txn);
+        assert(status == READ_STATUS_OK);
+        assert(!partial_block.IsTxAvailable(block.vtx.size() - 1));
+    }
+}
+
+static void CompactBlockInitData1000(benchmark::State &state) {
+    CompactBlockInitData(state, 1000);
+}
+static void CompactBlockInitData10000(benchmark::State &state) {
+    CompactBlockInitData(state, 10000);
+}
+static void CompactBlockInitData100000(benchmark::State &state) {
+    CompactBlockInitData(state, 100000);
+}
+
+BENCHMARK(CompactBlockInitData1000, 2000);
+BENCHMARK(CompactBlockInitData10000, 200);
+BENCHMARK(CompactBlockInitData100000, 20);
@@ -69,6 +69,20 @@ static void SipHash_32b(benchmark::State &state) {
     }
 }
 
+static void SipHash_32b_batch8(benchmark::State &state) {
+    uint256 x[8];
+    const uint256 *ptrs[8];
+    for (int i = 0; i < 8; i++) {
+        ptrs[i] = &x[i];
+    }
+    uint64_t out[8];
+    uint64_t k1 = 0;
+    while (state.KeepRunning()) {
+        SipHashUint256Batch(0, ++k1, ptrs, 8, out);
+        *((uint64_t *)x[0].begin()) = out[7];
+    }
+}
+
 static void FastRandom_32bit(benchmark::State &state) {
     FastRandomContext rng(true);
     while (state.KeepRunning()) {
@@ -90,6 +104,7 @@ BENCHMARK(SHA512, 330);
 
 BENCHMARK(SHA256_32b, 4700 * 1000);
 BENCHMARK(SipHash_32b, 40 * 1000 * 1000);
+BENCHMARK(SipHash_32b_batch8, 5 * 1000 * 1000);
 BENCHMARK(SHA256D64_1024, 7400);
 BENCHMARK(FastRandom_32bit, 110 * 1000 * 1000);
 BENCHMARK(FastRandom_1bit, 440 * 1000 * 1000);
@@ -0,0 +1,90 @@
+// Copyright (c) 2019 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <coins.h>
+#include <dbwrapper.h>
+#include <random.h>
+#include <script/script.h>
+
+#include <cassert>
+#include <memory>
+#include <utility>
+
+static const int NUM_COINS = 10000;
+static const char DB_BENCH_COIN = 'C';
+
+// An obfuscated in-memory database holding NUM_COINS pay to pubkey hash coins,
+// the most common entry of the chainstate.
+static std::unique_ptr<CDBWrapper> MakeCoinsDB() {
+    std::unique_ptr<CDBWrapper> db = std::make_unique<CDBWrapper>(
+        "bench_dbwrapper", 8 << 20, /* fMemory */ true, /* fWipe */ false,
+        /* obfuscate */ true);
+
+    FastRandomContext rng(true);
+    CDBBatch batch(*db);
+    for (int i = 0; i < NUM_COINS; i++) {
+        std::vector<uint8_t> hash = ToByteVector(rng.rand256());
+        hash.resize(20);
+        CScript script = CScript() << OP_DUP << OP_HASH160 << hash
+                                   << OP_EQUALVERIFY << OP_CHECKSIG;
+        Coin coin(CTxOut(int64_t(rng.randrange(1000000)) * SATOSHI, script),
+                  rng.randrange(600000), false);
+        batch.Write(std::make_pair(DB_BENCH_COIN, uint32_t(i)), coin);
+    }
+    bool ret = db->WriteBatch(batch);
+    assert(ret);
+    return db;
+}
+
+// Look up every coin by key, as the coins cache does on a miss.
+static void DBWrapperReadCoins(benchmark::State &state) {
+    std::unique_ptr<CDBWrapper> db = MakeCoinsDB();
+
+    while (state.KeepRunning()) {
+        for (int i = 0; i < NUM_COINS; i++) {
+            Coin coin;
+            bool ret =
+                db->Read(std::make_pair(DB_BENCH_COIN, uint32_t(i)), coin);
+            assert(ret);
+        }
+    }
+}
+
+// Walk over every coin with a cursor, as gettxoutsetinfo does.
+static void DBWrapperIterateCoins(benchmark::State &state) {
+    std::unique_ptr<CDBWrapper> db = MakeCoinsDB();
+
+    while (state.KeepRunning()) {
+        std::unique_ptr<CDBIterator> it(db->NewIterator());
+        int count = 0;
+        for (it->SeekToFirst(); it->Valid(); it->Next()) {
+            Coin coin;
+            if (it->GetValue(coin)) {
+                count++;
+            }
+        }
+        // The obfuscation key is stored along with the coins.
+        assert(count >= NUM_COINS);
+    }
+}
+
+// Obfuscate a batch sized value buffer.
+static void DBValueXor(benchmark::State &state) {
+    FastRandomContext rng(true);
+    std::vector<uint8_t> key(8);
+    for (uint8_t &byte : key) {
+        byte = rng.randbits(8);
+    }
+    CDataStream stream(std::vector<uint8_t>(DBWRAPPER_PREALLOC_VALUE_SIZE * 64),
+                       SER_DISK, CLIENT_VERSION);
+
+    while (state.KeepRunning()) {
+        stream.Xor(key);
+    }
+}
+
+BENCHMARK(DBWrapperReadCoins, 20);
+BENCHMARK(DBWrapperIterateCoins, 20);
+BENCHMARK(DBValueXor, 100000);
@@ -0,0 +1,90 @@
+// Copyright (c) 2019 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+
+#include <bloom.h>
+#include <merkleblock.h>
+#include <random.h>
+#include <streams.h>
+#include <version.h>
+
+#include <cassert>
+#include <vector>
+
+namespace block_bench {
+#include <bench/data/block413567.raw.h>
+} // namespace block_bench
+
+static const int NUM_PEERS = 8;
+
+// Block 413567 and the filters of NUM_PEERS SPV peers, each watching a few of
+// the scripts of the block among other things.
+struct FilteredBlockSetup {
+    CBlock block;
+    std::vector<CBloomFilter> filters;
+
+    FilteredBlockSetup() {
+        CDataStream stream((const char *)block_bench::block413567,
+                           (const char *)&block_bench::block413567[sizeof(
+                               block_bench::block413567)],
+                           SER_NETWORK, PROTOCOL_VERSION);
+        stream >> block;
+
+        FastRandomContext rng(true);
+        for (int i = 0; i < NUM_PEERS; i++) {
+            CBloomFilter filter(100, 0.0001, rng.rand32(), BLOOM_UPDATE_ALL);
+            int watched = 0;
+            while (watched < 5) {
+                const CTransaction &tx =
+                    *block.vtx[rng.randrange(block.vtx.size())];
+                const CScript &script = tx.vout[0].scriptPubKey;
+                // The key hash of a pay to pubkey hash output.
+                if (script.size() == 25 && script[0] == OP_DUP) {
+                    filter.insert(std::vector<uint8_t>(script.begin() + 3,
+                                                       script.end() - 2));
+                    watched++;
+                }
+            }
+            for (int j = 0; j < 95; j++) {
+                filter.insert(rng.rand256());
+            }
+            filters.push_back(filter);
+        }
+    }
+};
+
+// Match the block against the filter of each peer one transaction at a time,
+// as before the elements of a block were shared.
+static void FilteredBlockPerTx(benchmark::State &state) {
+    FilteredBlockSetup setup;
+    while (state.KeepRunning()) {
+        for (const CBloomFilter &peer_filter : setup.filters) {
+            CBloomFilter filter = peer_filter;
+            size_t matches = 0;
+            for (const CTransactionRef &tx : setup.block.vtx) {
+                matches += filter.MatchAndInsertOutputs(*tx);
+            }
+            for (const CTransactionRef &tx : setup.block.vtx) {
+                matches += filter.MatchInputs(*tx);
+            }
+            assert(matches > 0);
+        }
+    }
+}
+
+// Build the merkle block sent to each peer, from the shared elements.
+static void FilteredBlockShared(benchmark::State &state) {
+    FilteredBlockSetup setup;
+    while (state.KeepRunning()) {
+        for (const CBloomFilter &peer_filter : setup.filters) {
+            CBloomFilter filter = peer_filter;
+            CMerkleBlock merkleBlock(setup.block, filter);
+            assert(!merkleBlock.vMatchedTxn.empty());
+        }
+    }
+}
+
+BENCHMARK(FilteredBlockPerTx, 5);
+BENCHMARK(FilteredBlockShared, 5);
@@ -0,0 +1,151 @@
+// Copyright (c) 2019 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <chain.h>
+#include <chainparams.h>
+#include <coins.h>
+#include <config.h>
+#include <consensus/validation.h>
+#include <key.h>
+#include <keystore.h>
+#include <policy/policy.h>
+#include <script/scriptcache.h>
+#include <script/sigcache.h>
+#include <script/sign.h>
+#include <script/standard.h>
+#include <txmempool.h>
+#include <util/system.h>
+#include <validation.h>
+
+#include <boost/thread.hpp>
+
+#include <vector>
+
+static const size_t NUM_TX = 100;
+static const size_t NUM_INPUTS = 4;
+static const int NUM_SCRIPT_CHECK_THREADS = 3;
+
+// Sets up a regtest chain with only the genesis block, an in-memory coins tip
+// and a stream of NUM_TX transactions spending NUM_INPUTS P2PKH coins each.
+// The signature and script execution caches are shrunk to their minimum size
+// so every iteration verifies all the signatures again.
+class AdmissionSetup {
+public:
+    std::vector<CTransactionRef> txs;
+
+    AdmissionSetup() : genesis(Params().GenesisBlock()) {
+        genesisHash = Params().GenesisBlock().GetHash();
+        genesis.phashBlock = &genesisHash;
+
+        gArgs.ForceSetArg("-maxsigcachesize", "0");
+        gArgs.ForceSetArg("-maxscriptcachesize", "0");
+        InitSignatureCache();
+        InitScriptExecutionCache();
+
+        pcoinsOld = std::move(pcoinsTip);
+        pcoinsTip.reset(new CCoinsViewCache(&coinsDummy));
+        pcoinsTip->SetBestBlock(genesisHash);
+        {
+            LOCK(cs_main);
+            chainActive.SetTip(&genesis);
+        }
+
+        CKey key;
+        key.MakeNewKey(true);
+        CBasicKeyStore keystore;
+        keystore.AddKey(key);
+        const CScript scriptPubKey =
+            GetScriptForDestination(key.GetPubKey().GetID());
+
+        for (size_t i = 0; i < NUM_TX; i++) {
+            CMutableTransaction txFrom;
+            txFrom.vout.resize(NUM_INPUTS);
+            for (CTxOut &out : txFrom.vout) {
+                out.nValue = COIN;
+                out.scriptPubKey = scriptPubKey;
+            }
+            AddCoins(*pcoinsTip, CTransaction(txFrom), 1);
+
+            CMutableTransaction tx;
+            tx.vin.resize(NUM_INPUTS);
+            for (size_t n = 0; n < NUM_INPUTS; n++) {
+                tx.vin[n].prevout = COutPoint(txFrom.GetId(), n);
+            }
+            tx.vout.resize(1);
+            tx.vout[0].nValue = int64_t(NUM_INPUTS - 1) * COIN;
+            tx.vout[0].scriptPubKey = scriptPubKey;
+            for (size_t n = 0; n < NUM_INPUTS; n++) {
+                SignSignature(keystore, CTransaction(txFrom), tx, n,
+                              SigHashType().withForkId());
+            }
+            txs.push_back(MakeTransactionRef(tx));
+        }
+
+        for (int i = 0; i < NUM_SCRIPT_CHECK_THREADS; i++) {
+            threadGroup.create_thread(&ThreadScriptCheck);
+        }
+    }
+
+    ~AdmissionSetup() {
+        threadGroup.interrupt_all();
+        threadGroup.join_all();
+
+        {
+            LOCK(cs_main);
+            chainActive.SetTip(nullptr);
+        }
+        pcoinsTip = std::move(pcoinsOld);
+    }
+
+private:
+    CBlockIndex genesis;
+    uint256 genesisHash;
+    CCoinsView coinsDummy;
+    std::unique_ptr<CCoinsViewCache> pcoinsOld;
+    boost::thread_group threadGroup;
+};
+
+// Verify the scripts of the stream one transaction at a time under cs_main,
+// against both the standard and the consensus flags, the way
+// AcceptToMemoryPool does without the pre-validation stage.
+static void MempoolAdmissionSerial(benchmark::State &state) {
+    SelectParams(CBaseChainParams::REGTEST);
+    AdmissionSetup setup;
+
+    while (state.KeepRunning()) {
+        for (const CTransactionRef &tx : setup.txs) {
+            LOCK(cs_main);
+            CValidationState validationState;
+            PrecomputedTransactionData txdata(*tx);
+            bool ok = CheckInputs(*tx, validationState, *pcoinsTip, true,
+                                  STANDARD_SCRIPT_VERIFY_FLAGS, true, false,
+                                  txdata) &&
+                      CheckInputs(*tx, validationState, *pcoinsTip, true,
+                                  MANDATORY_SCRIPT_VERIFY_FLAGS, true, true,
+                                  txdata);
+            assert(ok);
+        }
+    }
+}
+
+// Feed the same stream through PreValidateTransaction, which verifies the
+// inputs of each transaction on the script check threads without holding
+// cs_main.
+static void MempoolAdmissionPreValidate(benchmark::State &state) {
+    SelectParams(CBaseChainParams::REGTEST);
+    AdmissionSetup setup;
+
+    const Config &config = GetConfig();
+    CTxMemPool pool;
+    while (state.KeepRunning()) {
+        for (const CTransactionRef &tx : setup.txs) {
+            bool ok = PreValidateTransaction(config, pool, tx);
+            assert(ok);
+        }
+    }
+}
+
+BENCHMARK(MempoolAdmissionSerial, 10);
+BENCHMARK(MempoolAdmissionPreValidate, 10);
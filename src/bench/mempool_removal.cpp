@@ -0,0 +1,91 @@
+// Copyright (c) 2019 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <policy/policy.h>
+#include <random.h>
+#include <txmempool.h>
+
+#include <vector>
+
+static const size_t NUM_CHAINS = 100;
+static const size_t CHAIN_DEPTH = 25;
+static const size_t CONFIRMED_DEPTH = 20;
+
+static void AddTx(const CTransactionRef &tx, CTxMemPool &pool)
+    EXCLUSIVE_LOCKS_REQUIRED(cs_main, pool.cs) {
+    LockPoints lp;
+    pool.addUnchecked(tx->GetId(),
+                      CTxMemPoolEntry(tx, 1000 * SATOSHI, /* time */ 0,
+                                      /* priority */ 10.0, /* height */ 1,
+                                      tx->GetValueOut(),
+                                      /* spendsCoinbase */ false,
+                                      /* sigOpCost */ 1, lp));
+}
+
+// Build NUM_CHAINS chains of CHAIN_DEPTH transactions. The first
+// CONFIRMED_DEPTH transactions of every chain go to vBlock, the rest stay
+// behind as descendants.
+static void MakeChains(std::vector<CTransactionRef> &vAll,
+                       std::vector<CTransactionRef> &vBlock) {
+    for (size_t i = 0; i < NUM_CHAINS; i++) {
+        COutPoint prevout(TxId(GetRandHash()), 0);
+        for (size_t depth = 0; depth < CHAIN_DEPTH; depth++) {
+            CMutableTransaction tx;
+            tx.vin.resize(1);
+            tx.vin[0].prevout = prevout;
+            tx.vin[0].scriptSig = CScript() << OP_1;
+            tx.vout.resize(2);
+            tx.vout[0].scriptPubKey = CScript() << OP_TRUE;
+            tx.vout[0].nValue = 10 * COIN;
+            tx.vout[1].scriptPubKey = CScript() << OP_TRUE;
+            tx.vout[1].nValue = 10 * COIN;
+
+            CTransactionRef txref = MakeTransactionRef(tx);
+            vAll.push_back(txref);
+            if (depth < CONFIRMED_DEPTH) {
+                vBlock.push_back(txref);
+            }
+            prevout = COutPoint(txref->GetId(), 0);
+        }
+    }
+}
+
+// Baseline for MempoolRemoveForBlockDeepChains: fill the mempool with the
+// chains, then clear it.
+static void MempoolAddDeepChains(benchmark::State &state) {
+    std::vector<CTransactionRef> vAll, vBlock;
+    MakeChains(vAll, vBlock);
+
+    CTxMemPool pool;
+    LOCK2(cs_main, pool.cs);
+    while (state.KeepRunning()) {
+        for (const CTransactionRef &tx : vAll) {
+            AddTx(tx, pool);
+        }
+        pool.clear();
+    }
+}
+
+// Fill the mempool with the chains, then connect a block confirming the first
+// CONFIRMED_DEPTH transactions of each of them. Subtract MempoolAddDeepChains
+// to get the removal cost.
+static void MempoolRemoveForBlockDeepChains(benchmark::State &state) {
+    std::vector<CTransactionRef> vAll, vBlock;
+    MakeChains(vAll, vBlock);
+
+    CTxMemPool pool;
+    LOCK2(cs_main, pool.cs);
+    while (state.KeepRunning()) {
+        for (const CTransactionRef &tx : vAll) {
+            AddTx(tx, pool);
+        }
+        pool.removeForBlock(vBlock, 1);
+        assert(pool.size() == NUM_CHAINS * (CHAIN_DEPTH - CONFIRMED_DEPTH));
+        pool.clear();
+    }
+}
+
+BENCHMARK(MempoolAddDeepChains, 20);
+BENCHMARK(MempoolRemoveForBlockDeepChains, 10);
@@ -5,16 +5,24 @@
 #include <bench/bench.h>
 
 #include <consensus/merkle.h>
+#include <merkleblock.h>
 #include <random.h>
 #include <uint256.h>
 
-static void MerkleRoot(benchmark::State &state) {
+#include <thread>
+
+static std::vector<uint256> MakeLeaves(size_t count) {
     FastRandomContext rng(true);
     std::vector<uint256> leaves;
-    leaves.resize(9001);
+    leaves.resize(count);
     for (auto &item : leaves) {
         item = rng.rand256();
     }
+    return leaves;
+}
+
+static void MerkleRoot(benchmark::State &state) {
+    std::vector<uint256> leaves = MakeLeaves(9001);
     while (state.KeepRunning()) {
         bool mutation = false;
         uint256 hash =
@@ -23,4 +31,49 @@ static void MerkleRoot(benchmark::State &state) {
     }
 }
 
+// The tree of a block of about 32MB.
+static const size_t LARGE_BLOCK_TXS = 150000;
+
+static void MerkleRootLarge(benchmark::State &state,
+                            unsigned int num_threads) {
+    std::vector<uint256> leaves = MakeLeaves(LARGE_BLOCK_TXS);
+    while (state.KeepRunning()) {
+        bool mutation = false;
+        uint256 hash = ComputeMerkleRootParallel(std::vector<uint256>(leaves),
+                                                 &mutation, num_threads);
+        leaves[mutation] = hash;
+    }
+}
+
+static void MerkleRootLargeSingleThread(benchmark::State &state) {
+    MerkleRootLarge(state, 1);
+}
+static void MerkleRootLargeParallel(benchmark::State &state) {
+    MerkleRootLarge(state, std::thread::hardware_concurrency());
+}
+
+// A proof for a single transaction of a large block, built from its txids as
+// the first request for a block does, or from its cached Merkle tree.
+static void MerkleProofLarge(benchmark::State &state) {
+    const std::vector<uint256> leaves = MakeLeaves(LARGE_BLOCK_TXS);
+    std::vector<bool> match(leaves.size());
+    match[leaves.size() / 3] = true;
+    while (state.KeepRunning()) {
+        CPartialMerkleTree proof(leaves, match);
+    }
+}
+
+static void MerkleProofLargeCached(benchmark::State &state) {
+    const CMerkleTree tree(MakeLeaves(LARGE_BLOCK_TXS));
+    std::vector<bool> match(tree.GetNumLeaves());
+    match[tree.GetNumLeaves() / 3] = true;
+    while (state.KeepRunning()) {
+        CPartialMerkleTree proof(tree, match);
+    }
+}
+
 BENCHMARK(MerkleRoot, 800);
+BENCHMARK(MerkleRootLargeSingleThread, 20);
+BENCHMARK(MerkleRootLargeParallel, 20);
+BENCHMARK(MerkleProofLarge, 20);
+BENCHMARK(MerkleProofLargeCached, 2000);
@@ -0,0 +1,62 @@
+// Copyright (c) 2019 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+
+#include <omnicore/createpayload.h>
+#include <omnicore/tx.h>
+#include <uint256.h>
+
+#include <univalue.h>
+
+#include <cassert>
+#include <vector>
+
+static std::vector<unsigned char> CreatePropertyPayload() {
+    return CreatePayload_IssuanceFixed(1, 2, 0, "Companies", "Bitcoin Mining",
+                                       "Quantum Miner", "www.quantumminer.com",
+                                       "Quantum Miner Tokens", 1000000);
+}
+
+// A new transaction object for each Omni transaction of a block, which takes
+// the payload and interprets it.
+static void OmniTxParse(benchmark::State &state) {
+    std::vector<unsigned char> payload = CreatePropertyPayload();
+    while (state.KeepRunning()) {
+        CMPTransaction mp_obj;
+        mp_obj.Set("", "", 0, uint256(), 0, 0, payload.data(), payload.size(),
+                   3, 0);
+        bool valid = mp_obj.interpret_Transaction();
+        assert(valid);
+    }
+}
+
+// Parse the transaction and write out its details, as the RPC calls do for
+// each transaction they return.
+static void OmniTxPopulate(benchmark::State &state) {
+    std::vector<unsigned char> payload = CreatePropertyPayload();
+    while (state.KeepRunning()) {
+        CMPTransaction mp_obj;
+        mp_obj.Set("", "", 0, uint256(), 0, 0, payload.data(), payload.size(),
+                   3, 0);
+        bool valid = mp_obj.interpret_Transaction();
+        assert(valid);
+
+        UniValue txobj(UniValue::VOBJ);
+        txobj.pushKV("type_int", (uint64_t)mp_obj.getType());
+        txobj.pushKV("type", mp_obj.getTypeString());
+        txobj.pushKV("ecosystem", mp_obj.getEcosystem());
+        txobj.pushKV("propertytype", mp_obj.getPropertyType());
+        txobj.pushKV("category", mp_obj.getSPCategory());
+        txobj.pushKV("subcategory", mp_obj.getSPSubCategory());
+        txobj.pushKV("propertyname", mp_obj.getSPName());
+        txobj.pushKV("data", mp_obj.getSPData());
+        txobj.pushKV("url", mp_obj.getSPUrl());
+        txobj.pushKV("amount", mp_obj.getAmount());
+        txobj.pushKV("payload", mp_obj.getPayload());
+    }
+}
+
+BENCHMARK(OmniTxParse, 100 * 1000);
+BENCHMARK(OmniTxPopulate, 100 * 1000);
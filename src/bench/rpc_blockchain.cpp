@@ -0,0 +1,67 @@
+// Copyright (c) 2019 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+
+#include <chain.h>
+#include <chainparams.h>
+#include <rpc/blockchain.h>
+#include <streams.h>
+#include <validation.h>
+
+#include <univalue.h>
+
+#include <cassert>
+
+namespace block_bench {
+#include <bench/data/block413567.raw.h>
+} // namespace block_bench
+
+// Block 413567 along with a block index for it, as the tip of the chain.
+struct TestBlockAndIndex {
+    CBlock block;
+    uint256 blockHash;
+    CBlockIndex blockindex;
+
+    TestBlockAndIndex() {
+        SelectParams(CBaseChainParams::MAIN);
+        CDataStream stream((const char *)block_bench::block413567,
+                           (const char *)&block_bench::block413567[sizeof(
+                               block_bench::block413567)],
+                           SER_NETWORK, PROTOCOL_VERSION);
+        char a = '\0';
+        stream.write(&a, 1); // Prevent compaction
+
+        stream >> block;
+
+        blockHash = block.GetHash();
+        blockindex.phashBlock = &blockHash;
+        blockindex.nBits = 403014710;
+    }
+};
+
+// getblock with verbosity 2 through a UniValue, as before.
+static void BlockToJsonVerbose(benchmark::State &state) {
+    TestBlockAndIndex data;
+    while (state.KeepRunning()) {
+        UniValue univalue = blockToJSON(data.block, &data.blockindex,
+                                        &data.blockindex, /*verbose*/ true);
+        std::string json = univalue.write();
+        assert(!json.empty());
+    }
+}
+
+// getblock with verbosity 2 through the streaming writer.
+static void BlockToJsonVerboseWriter(benchmark::State &state) {
+    TestBlockAndIndex data;
+    while (state.KeepRunning()) {
+        std::string json;
+        WriteBlockJSON(data.block, &data.blockindex, &data.blockindex,
+                       /*verbose*/ true, json);
+        assert(!json.empty());
+    }
+}
+
+BENCHMARK(BlockToJsonVerbose, 10);
+BENCHMARK(BlockToJsonVerboseWriter, 10);
@@ -0,0 +1,194 @@
+// Copyright (c) 2019 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <hash.h>
+#include <protocol.h>
+#include <seeder/bitcoin.h>
+#include <seeder/crawler.h>
+#include <seeder/db.h>
+#include <streams.h>
+#include <support/events.h>
+#include <version.h>
+
+#include <event2/buffer.h>
+#include <event2/bufferevent.h>
+#include <event2/listener.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+static const int NUM_ADDRESSES = 2000;
+static const int NUM_CRAWLER_THREADS = 2;
+// Keep both ends of the connections below the usual limit of 1024 fds.
+static const int NUM_PROBES_PER_THREAD = 200;
+
+static std::vector<uint8_t> MakeMessage(const char *command,
+                                        const CDataStream &payload) {
+    CMessageHeader hdr(netMagic, command, payload.size());
+    uint256 hash = Hash(payload.begin(), payload.end());
+    memcpy(hdr.pchChecksum, hash.begin(), CMessageHeader::CHECKSUM_SIZE);
+
+    CDataStream msg(SER_NETWORK, PROTOCOL_VERSION);
+    msg << hdr;
+    std::vector<uint8_t> ret(msg.begin(), msg.end());
+    ret.insert(ret.end(), payload.begin(), payload.end());
+    return ret;
+}
+
+// Fake peers listening on the loopback interface. They answer the version of
+// the seeder with their own version and a verack, and its getaddr with more
+// than 1000 addresses, which ends the probe right away. Every 127.0.0.0/8
+// address reaches them, so each probe can target a different address.
+class FakePeers {
+public:
+    FakePeers() : base(obtain_event_base()) {
+        struct sockaddr_in sin = {};
+        sin.sin_family = AF_INET;
+        sin.sin_addr.s_addr = htonl(INADDR_ANY);
+        listener = evconnlistener_new_bind(
+            base.get(), AcceptCallback, this,
+            LEV_OPT_CLOSE_ON_FREE | LEV_OPT_REUSEABLE, -1,
+            (struct sockaddr *)&sin, sizeof(sin));
+        assert(listener);
+
+        socklen_t len = sizeof(sin);
+        getsockname(evconnlistener_get_fd(listener), (struct sockaddr *)&sin,
+                    &len);
+        port = ntohs(sin.sin_port);
+
+        CDataStream version(SER_NETWORK, INIT_PROTO_VERSION);
+        version << PROTOCOL_VERSION << uint64_t(NODE_NETWORK)
+                << int64_t(time(nullptr)) << CAddress() << CAddress()
+                << uint64_t(1) << std::string("/fake:0.1/")
+                << GetRequireHeight();
+        msgVersion = MakeMessage("version", version);
+        msgVerack =
+            MakeMessage("verack", CDataStream(SER_NETWORK, PROTOCOL_VERSION));
+
+        std::vector<CAddress> vAddr;
+        for (uint32_t i = 0; i < 1001; i++) {
+            // Addresses in 10.0.0.0/8 are not routable, so the database
+            // ignores them.
+            struct in_addr s;
+            s.s_addr = htonl(0x0a000000 | i);
+            vAddr.emplace_back(CService(CNetAddr(s), GetDefaultPort()),
+                               NODE_NETWORK);
+            vAddr.back().nTime = time(nullptr);
+        }
+        CDataStream addr(SER_NETWORK, PROTOCOL_VERSION);
+        addr << vAddr;
+        msgAddr = MakeMessage("addr", addr);
+
+        stop = obtain_event(base.get(), -1, EV_PERSIST, StopCallback, this);
+        struct timeval tv = {0, 10000};
+        event_add(stop.get(), &tv);
+        thread = std::thread([this]() { event_base_dispatch(base.get()); });
+    }
+
+    ~FakePeers() {
+        fStop = true;
+        thread.join();
+        evconnlistener_free(listener);
+    }
+
+    CService GetService(int i) const {
+        struct in_addr s;
+        s.s_addr = htonl(0x7f000001 + i);
+        return CService(CNetAddr(s), port);
+    }
+
+private:
+    raii_event_base base;
+    raii_event stop;
+    struct evconnlistener *listener;
+    uint16_t port;
+    std::thread thread;
+    std::atomic<bool> fStop{false};
+
+    std::vector<uint8_t> msgVersion;
+    std::vector<uint8_t> msgVerack;
+    std::vector<uint8_t> msgAddr;
+
+    static void StopCallback(evutil_socket_t, short, void *ctx) {
+        FakePeers *self = static_cast<FakePeers *>(ctx);
+        if (self->fStop) {
+            event_base_loopbreak(self->base.get());
+        }
+    }
+
+    static void AcceptCallback(struct evconnlistener *, evutil_socket_t fd,
+                               struct sockaddr *, int, void *ctx) {
+        FakePeers *self = static_cast<FakePeers *>(ctx);
+        struct bufferevent *bev =
+            bufferevent_socket_new(self->base.get(), fd, BEV_OPT_CLOSE_ON_FREE);
+        bufferevent_setcb(bev, ReadCallback, nullptr, EventCallback, self);
+        bufferevent_enable(bev, EV_READ | EV_WRITE);
+    }
+
+    static void ReadCallback(struct bufferevent *bev, void *ctx) {
+        FakePeers *self = static_cast<FakePeers *>(ctx);
+        struct evbuffer *input = bufferevent_get_input(bev);
+        while (evbuffer_get_length(input) >= CMessageHeader::HEADER_SIZE) {
+            CDataStream header(SER_NETWORK, PROTOCOL_VERSION);
+            header.resize(CMessageHeader::HEADER_SIZE);
+            evbuffer_copyout(input, header.data(), header.size());
+            CMessageHeader hdr(netMagic);
+            header >> hdr;
+
+            const size_t nSize = CMessageHeader::HEADER_SIZE + hdr.nMessageSize;
+            if (evbuffer_get_length(input) < nSize) {
+                return;
+            }
+            evbuffer_drain(input, nSize);
+
+            const std::string command = hdr.GetCommand();
+            if (command == "version") {
+                bufferevent_write(bev, self->msgVersion.data(),
+                                  self->msgVersion.size());
+                bufferevent_write(bev, self->msgVerack.data(),
+                                  self->msgVerack.size());
+            } else if (command == "getaddr") {
+                bufferevent_write(bev, self->msgAddr.data(),
+                                  self->msgAddr.size());
+            }
+        }
+    }
+
+    static void EventCallback(struct bufferevent *bev, short what, void *) {
+        if (what & (BEV_EVENT_EOF | BEV_EVENT_ERROR)) {
+            bufferevent_free(bev);
+        }
+    }
+};
+
+// Probe NUM_ADDRESSES fake peers with the event-driven crawler, from a fresh
+// database each iteration. Divide NUM_ADDRESSES by the time per iteration to
+// get the probes per second.
+static void SeederCrawl(benchmark::State &state) {
+    FakePeers peers;
+
+    while (state.KeepRunning()) {
+        CAddrDb db;
+        for (int i = 0; i < NUM_ADDRESSES; i++) {
+            db.Add(CAddress(peers.GetService(i), ServiceFlags()), true);
+        }
+
+        CSeederCrawler crawler(db, NUM_CRAWLER_THREADS, NUM_PROBES_PER_THREAD);
+        crawler.Start();
+        while (crawler.GetProbeCount() < uint64_t(NUM_ADDRESSES)) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        crawler.Stop();
+
+        CAddrDbStats stats;
+        db.GetStats(stats);
+        assert(stats.nTracked == NUM_ADDRESSES);
+    }
+}
+
+BENCHMARK(SeederCrawl, 1);
@@ -0,0 +1,167 @@
+// Copyright (c) 2019 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <random.h>
+#include <seeder/bitcoin.h>
+#include <seeder/db.h>
+#include <seeder/dns.h>
+#include <seeder/dnscache.h>
+#include <version.h>
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <vector>
+
+static const int NUM_ADDRESSES = 1000;
+static const int NUM_DNS_THREADS = 4;
+static const int NUM_CLIENT_THREADS = 4;
+static const int NUM_QUERIES_PER_CLIENT = 1000;
+static const char *BENCH_HOST = "seed.bench.local";
+
+struct BenchDnsThread {
+    dns_opt_t dns_opt; // must be first
+    CDnsAnswerCache &cache;
+    FastRandomContext rng;
+
+    explicit BenchDnsThread(CDnsAnswerCache &cacheIn) : cache(cacheIn) {}
+};
+
+static uint32_t GetBenchIPList(void *data, char *requestedHostname,
+                               addr_t *addr, uint32_t max, uint32_t ipv4,
+                               uint32_t ipv6) {
+    BenchDnsThread *thread = (BenchDnsThread *)data;
+    return thread->cache.GetAnswers(0, addr, max, ipv4, ipv6, thread->rng);
+}
+
+// A DNS server answering for BENCH_HOST on the loopback interface, from
+// NUM_ADDRESSES good nodes. dnsserver never returns, so it is started once and
+// left running until the process exits.
+class BenchDnsServer {
+public:
+    uint16_t port;
+
+    BenchDnsServer() : cache(db, {}) {
+        for (int i = 0; i < NUM_ADDRESSES; i++) {
+            struct in_addr s;
+            s.s_addr = htonl(0x01000000 | i);
+            CService service(CNetAddr(s), GetDefaultPort());
+            db.Add(CAddress(service, NODE_NETWORK), true);
+            db.Good(service, PROTOCOL_VERSION, "/bench:0.1/",
+                    GetRequireHeight());
+        }
+        cache.Start();
+
+        // Find a free port for the server to bind.
+        struct sockaddr_in6 sin = {};
+        sin.sin6_family = AF_INET6;
+        sin.sin6_addr = in6addr_any;
+        socklen_t len = sizeof(sin);
+        int fd = socket(AF_INET6, SOCK_DGRAM, IPPROTO_UDP);
+        assert(fd != -1);
+        bind(fd, (struct sockaddr *)&sin, sizeof(sin));
+        getsockname(fd, (struct sockaddr *)&sin, &len);
+        close(fd);
+        port = ntohs(sin.sin6_port);
+
+        for (int i = 0; i < NUM_DNS_THREADS; i++) {
+            threads.emplace_back(new BenchDnsThread(cache));
+            dns_opt_t &opt = threads.back()->dns_opt;
+            opt.host = BENCH_HOST;
+            opt.ns = "ns.bench.local";
+            opt.mbox = "admin.bench.local";
+            opt.datattl = 3600;
+            opt.nsttl = 40000;
+            opt.cb = GetBenchIPList;
+            opt.port = port;
+            opt.nRequests = 0;
+            std::thread(dnsserver, &opt).detach();
+            // The first thread creates the listening socket.
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        }
+    }
+
+private:
+    CAddrDb db;
+    CDnsAnswerCache cache;
+    std::vector<std::unique_ptr<BenchDnsThread>> threads;
+};
+
+static std::vector<uint8_t> MakeQuery(uint16_t id) {
+    // Header with recursion desired and one question.
+    std::vector<uint8_t> query = {
+        uint8_t(id >> 8), uint8_t(id), 0x01, 0x00, 0, 1, 0, 0, 0, 0, 0, 0};
+    const char *label = BENCH_HOST;
+    while (*label) {
+        const char *end = strchr(label, '.');
+        size_t len = end ? end - label : strlen(label);
+        query.push_back(len);
+        query.insert(query.end(), label, label + len);
+        label += len + (end ? 1 : 0);
+    }
+    query.push_back(0);
+    // Type A, class IN.
+    query.insert(query.end(), {0, 1, 0, 1});
+    return query;
+}
+
+// Send NUM_QUERIES_PER_CLIENT A queries and wait for each answer. Returns the
+// number of answers with at least one address.
+static int RunClient(uint16_t port) {
+    int fd = socket(AF_INET6, SOCK_DGRAM, IPPROTO_UDP);
+    assert(fd != -1);
+    struct timeval tv = {1, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+    struct sockaddr_in6 sin = {};
+    sin.sin6_family = AF_INET6;
+    sin.sin6_addr = in6addr_loopback;
+    sin.sin6_port = htons(port);
+    connect(fd, (struct sockaddr *)&sin, sizeof(sin));
+
+    int nAnswered = 0;
+    uint8_t buf[512];
+    for (int i = 0; i < NUM_QUERIES_PER_CLIENT; i++) {
+        std::vector<uint8_t> query = MakeQuery(i);
+        send(fd, query.data(), query.size(), 0);
+        ssize_t n = recv(fd, buf, sizeof(buf), 0);
+        // Lost datagrams time out and are not counted.
+        if (n >= 12 && buf[7] > 0) {
+            nAnswered++;
+        }
+    }
+
+    close(fd);
+    return nAnswered;
+}
+
+// Flood the DNS server with queries from NUM_CLIENT_THREADS clients, each
+// waiting for the answer before sending the next query.
+static void SeederDnsFlood(benchmark::State &state) {
+    static BenchDnsServer *server = new BenchDnsServer();
+
+    while (state.KeepRunning()) {
+        std::atomic<int> nAnswered{0};
+        std::vector<std::thread> clients;
+        for (int i = 0; i < NUM_CLIENT_THREADS; i++) {
+            clients.emplace_back(
+                [&]() { nAnswered += RunClient(server->port); });
+        }
+        for (std::thread &client : clients) {
+            client.join();
+        }
+        assert(nAnswered > 0);
+    }
+}
+
+BENCHMARK(SeederDnsFlood, 1);
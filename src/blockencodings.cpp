@@ -48,6 +48,17 @@ uint64_t CBlockHeaderAndShortTxIDs::GetShortID(const uint256 &txhash) const {
     return SipHashUint256(shorttxidk0, shorttxidk1, txhash) & 0xffffffffffffL;
 }
 
+void CBlockHeaderAndShortTxIDs::GetShortIDs(const uint256 *const *txhashes,
+                                            size_t n,
+                                            uint64_t *shortids) const {
+    static_assert(SHORTTXIDS_LENGTH == 6,
+                  "shorttxids calculation assumes 6-byte shorttxids");
+    SipHashUint256Batch(shorttxidk0, shorttxidk1, txhashes, n, shortids);
+    for (size_t i = 0; i < n; i++) {
+        shortids[i] &= 0xffffffffffffL;
+    }
+}
+
 ReadStatus PartiallyDownloadedBlock::InitData(
     const CBlockHeaderAndShortTxIDs &cmpctblock,
     const std::vector<std::pair<uint256, CTransactionRef>> &extra_txns) {
@@ -133,31 +144,48 @@ ReadStatus PartiallyDownloadedBlock::InitData(
         LOCK(pool->cs);
         const std::vector<std::pair<uint256, CTxMemPool::txiter>> &vTxHashes =
             pool->vTxHashes;
-        for (auto txHash : vTxHashes) {
-            uint64_t shortid = cmpctblock.GetShortID(txHash.first);
-            std::unordered_map<uint64_t, uint32_t>::iterator idit =
-                shorttxids.find(shortid);
-            if (idit != shorttxids.end()) {
-                if (!have_txn[idit->second]) {
-                    txns_available[idit->second] = txHash.second->GetSharedTx();
-                    have_txn[idit->second] = true;
-                    mempool_count++;
-                } else {
-                    // If we find two mempool txn that match the short id, just
-                    // request it. This should be rare enough that the extra
-                    // bandwidth doesn't matter, but eating a round-trip due to
-                    // FillBlock failure would be annoying.
-                    if (txns_available[idit->second]) {
-                        txns_available[idit->second].reset();
-                        mempool_count--;
+        // The short ids are computed a batch at a time.
+        static const size_t SHORTID_BATCH_SIZE = 8;
+        const uint256 *hashes[SHORTID_BATCH_SIZE];
+        uint64_t shortids[SHORTID_BATCH_SIZE];
+        for (size_t start = 0; start < vTxHashes.size() &&
+                               mempool_count != shorttxids.size();
+             start += SHORTID_BATCH_SIZE) {
+            const size_t count =
+                std::min(SHORTID_BATCH_SIZE, vTxHashes.size() - start);
+            for (size_t i = 0; i < count; i++) {
+                hashes[i] = &vTxHashes[start + i].first;
+            }
+            cmpctblock.GetShortIDs(hashes, count, shortids);
+
+            for (size_t i = 0; i < count; i++) {
+                const auto &txHash = vTxHashes[start + i];
+                std::unordered_map<uint64_t, uint32_t>::iterator idit =
+                    shorttxids.find(shortids[i]);
+                if (idit != shorttxids.end()) {
+                    if (!have_txn[idit->second]) {
+                        txns_available[idit->second] =
+                            txHash.second->GetSharedTx();
+                        have_txn[idit->second] = true;
+                        mempool_count++;
+                    } else {
+                        // If we find two mempool txn that match the short id,
+                        // just request it. This should be rare enough that the
+                        // extra bandwidth doesn't matter, but eating a
+                        // round-trip due to FillBlock failure would be
+                        // annoying.
+                        if (txns_available[idit->second]) {
+                            txns_available[idit->second].reset();
+                            mempool_count--;
+                        }
                     }
                 }
-            }
-            // Though ideally we'd continue scanning for the
-            // two-txn-match-shortid case, the performance win of an early exit
-            // here is too good to pass up and worth the extra risk.
-            if (mempool_count == shorttxids.size()) {
-                break;
+                // Though ideally we'd continue scanning for the
+                // two-txn-match-shortid case, the performance win of an early
+                // exit here is too good to pass up and worth the extra risk.
+                if (mempool_count == shorttxids.size()) {
+                    break;
+                }
             }
         }
     }
@@ -4,6 +4,7 @@
 
 #include <bloom.h>
 
+#include <crypto/common.h>
 #include <hash.h>
 #include <primitives/transaction.h>
 #include <random.h>
@@ -11,6 +12,7 @@
 #include <script/standard.h>
 #include <streams.h>
 
+#include <algorithm>
 #include <cmath>
 #include <cstdlib>
 
@@ -127,6 +129,154 @@ bool CBloomFilter::IsWithinSizeConstraints() const {
            nHashFuncs <= MAX_HASH_FUNCS;
 }
 
+static inline uint32_t RotL32(uint32_t x, int8_t r) {
+    return (x << r) | (x >> (32 - r));
+}
+
+/**
+ * MurmurHash3 (see hash.cpp) split into the mixing of the message words, which
+ * doesn't depend on the seed, and the rest.
+ */
+static inline uint32_t MurmurMixWord(uint32_t k1) {
+    k1 *= 0xcc9e2d51;
+    k1 = RotL32(k1, 15);
+    k1 *= 0x1b873593;
+    return k1;
+}
+
+static inline uint32_t MurmurFinish(uint32_t h1, uint32_t nSize) {
+    h1 ^= nSize;
+    h1 ^= h1 >> 16;
+    h1 *= 0x85ebca6b;
+    h1 ^= h1 >> 13;
+    h1 *= 0xc2b2ae35;
+    h1 ^= h1 >> 16;
+    return h1;
+}
+
+//! The number of hash functions of a filter that are computed together.
+static const uint32_t BLOOM_HASH_BATCH = 4;
+
+CBloomTxElements::CBloomTxElements(const std::vector<CTransactionRef> &vtx) {
+    vTx.reserve(vtx.size());
+    for (const CTransactionRef &tx : vtx) {
+        Tx entry;
+        entry.tx = tx;
+        entry.nTxId = vElements.size();
+        const TxId &txid = tx->GetId();
+        AddElement(txid.begin(), txid.end());
+
+        entry.nOutputsBegin = vOutputs.size();
+        for (const CTxOut &txout : tx->vout) {
+            Output output;
+            output.nPushesBegin = vElements.size();
+            AddPushes(txout.scriptPubKey);
+            output.nPushesEnd = vElements.size();
+            vOutputs.push_back(output);
+        }
+
+        entry.nInputsBegin = vInputs.size();
+        for (const CTxIn &txin : tx->vin) {
+            Input input;
+            input.nPrevOut = vElements.size();
+            CDataStream stream(SER_NETWORK, PROTOCOL_VERSION);
+            stream << txin.prevout;
+            const uint8_t *data = reinterpret_cast<const uint8_t *>(&stream[0]);
+            AddElement(data, data + stream.size());
+            AddPushes(txin.scriptSig);
+            input.nPushesEnd = vElements.size();
+            vInputs.push_back(input);
+        }
+        vTx.push_back(std::move(entry));
+    }
+}
+
+void CBloomTxElements::AddElement(const uint8_t *begin, const uint8_t *end) {
+    Element element;
+    element.nWordsBegin = vWords.size();
+    element.nSize = end - begin;
+
+    const uint8_t *tail = begin + (element.nSize & ~3);
+    for (const uint8_t *it = begin; it != tail; it += 4) {
+        vWords.push_back(MurmurMixWord(ReadLE32(it)));
+    }
+    element.nWordsEnd = vWords.size();
+
+    uint32_t k1 = 0;
+    switch (element.nSize & 3) {
+        case 3:
+            k1 ^= tail[2] << 16;
+        // FALLTHROUGH
+        case 2:
+            k1 ^= tail[1] << 8;
+        // FALLTHROUGH
+        case 1:
+            k1 ^= tail[0];
+            k1 = MurmurMixWord(k1);
+    }
+    element.nTail = k1;
+    vElements.push_back(element);
+}
+
+void CBloomTxElements::AddPushes(const CScript &script) {
+    // The same elements as MatchAndInsertOutputs and MatchInputs look at: the
+    // non empty pushes, up to the first invalid opcode.
+    CScript::const_iterator pc = script.begin();
+    std::vector<uint8_t> data;
+    while (pc < script.end()) {
+        opcodetype opcode;
+        if (!script.GetOp(pc, opcode, data)) {
+            break;
+        }
+        if (data.size() != 0) {
+            AddElement(data.data(), data.data() + data.size());
+        }
+    }
+}
+
+bool CBloomFilter::contains(const CBloomTxElements &elements,
+                            uint32_t nElement) const {
+    if (isFull) {
+        return true;
+    }
+    if (isEmpty) {
+        return false;
+    }
+
+    const CBloomTxElements::Element &element = elements.vElements[nElement];
+    const uint32_t *words = elements.vWords.data();
+    const uint32_t nBits = vData.size() * 8;
+    for (uint32_t i = 0; i < nHashFuncs; i += BLOOM_HASH_BATCH) {
+        // Hash the element for a few hash functions at once, which the
+        // compiler can lay out side by side in vector registers.
+        uint32_t h[BLOOM_HASH_BATCH];
+        for (uint32_t j = 0; j < BLOOM_HASH_BATCH; j++) {
+            // As in Hash()
+            h[j] = (i + j) * 0xFBA4C795 + nTweak;
+        }
+        for (uint32_t w = element.nWordsBegin; w < element.nWordsEnd; w++) {
+            for (uint32_t j = 0; j < BLOOM_HASH_BATCH; j++) {
+                h[j] ^= words[w];
+                h[j] = RotL32(h[j], 13);
+                h[j] = h[j] * 5 + 0xe6546b64;
+            }
+        }
+        for (uint32_t j = 0; j < BLOOM_HASH_BATCH; j++) {
+            h[j] = MurmurFinish(h[j] ^ element.nTail, element.nSize);
+        }
+
+        const uint32_t nBatch = std::min(BLOOM_HASH_BATCH, nHashFuncs - i);
+        for (uint32_t j = 0; j < nBatch; j++) {
+            uint32_t nIndex = h[j] % nBits;
+            // Checks bit nIndex of vData
+            if (!(vData[nIndex >> 3] & (1 << (7 & nIndex)))) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
 bool CBloomFilter::MatchAndInsertOutputs(const CTransaction &tx) {
     bool fFound = false;
     // Match if the filter contains the hash of tx for finding tx when they
@@ -208,6 +358,67 @@ bool CBloomFilter::MatchInputs(const CTransaction &tx) {
     return false;
 }
 
+bool CBloomFilter::MatchAndInsertOutputs(const CBloomTxElements &elements,
+                                         size_t nTx) {
+    if (isFull) {
+        return true;
+    }
+    if (isEmpty) {
+        return false;
+    }
+
+    const CBloomTxElements::Tx &entry = elements.vTx[nTx];
+    bool fFound = contains(elements, entry.nTxId);
+
+    for (size_t i = 0; i < entry.tx->vout.size(); i++) {
+        const CBloomTxElements::Output &output =
+            elements.vOutputs[entry.nOutputsBegin + i];
+        for (uint32_t nPush = output.nPushesBegin; nPush < output.nPushesEnd;
+             nPush++) {
+            if (!contains(elements, nPush)) {
+                continue;
+            }
+            fFound = true;
+            const CTxOut &txout = entry.tx->vout[i];
+            if ((nFlags & BLOOM_UPDATE_MASK) == BLOOM_UPDATE_ALL) {
+                insert(COutPoint(entry.tx->GetId(), i));
+            } else if ((nFlags & BLOOM_UPDATE_MASK) ==
+                       BLOOM_UPDATE_P2PUBKEY_ONLY) {
+                txnouttype type;
+                std::vector<std::vector<uint8_t>> vSolutions;
+                if (Solver(txout.scriptPubKey, type, vSolutions) &&
+                    (type == TX_PUBKEY || type == TX_MULTISIG)) {
+                    insert(COutPoint(entry.tx->GetId(), i));
+                }
+            }
+            break;
+        }
+    }
+
+    return fFound;
+}
+
+bool CBloomFilter::MatchInputs(const CBloomTxElements &elements, size_t nTx) {
+    if (isEmpty) {
+        return false;
+    }
+
+    const CBloomTxElements::Tx &entry = elements.vTx[nTx];
+    for (size_t i = 0; i < entry.tx->vin.size(); i++) {
+        const CBloomTxElements::Input &input =
+            elements.vInputs[entry.nInputsBegin + i];
+        // The spent outpoint comes first, then the pushes of the scriptSig.
+        for (uint32_t nElement = input.nPrevOut; nElement < input.nPushesEnd;
+             nElement++) {
+            if (contains(elements, nElement)) {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
 void CBloomFilter::UpdateEmptyFull() {
     bool full = true;
     bool empty = true;
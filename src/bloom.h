@@ -5,9 +5,11 @@
 #ifndef BITCOIN_BLOOM_H
 #define BITCOIN_BLOOM_H
 
+#include <primitives/transaction.h>
 #include <serialize.h>
 
 #include <cstdint>
+#include <memory>
 #include <vector>
 
 class COutPoint;
@@ -31,6 +33,65 @@ enum bloomflags {
     BLOOM_UPDATE_MASK = 3,
 };
 
+/**
+ * The data elements of a list of transactions that bloom filters are matched
+ * against: the txids, the spent outpoints and the data pushes of the scripts.
+ *
+ * The elements are extracted once, so that a block can be matched against the
+ * filters of many peers without parsing its scripts for each of them. The
+ * message words of MurmurHash3 don't depend on the seed, so they are also
+ * mixed once here, leaving only the seeded part of the hash to each hash
+ * function of each filter.
+ */
+class CBloomTxElements {
+private:
+    struct Element {
+        //! The mixed words of the element, in vWords.
+        uint32_t nWordsBegin;
+        uint32_t nWordsEnd;
+        //! The mixed tail, or 0 if the size is a multiple of 4.
+        uint32_t nTail;
+        uint32_t nSize;
+    };
+    struct Output {
+        //! The data pushes of the script, in vElements.
+        uint32_t nPushesBegin;
+        uint32_t nPushesEnd;
+    };
+    struct Input {
+        //! The spent outpoint, followed by the data pushes of the script.
+        uint32_t nPrevOut;
+        uint32_t nPushesEnd;
+    };
+    struct Tx {
+        CTransactionRef tx;
+        uint32_t nTxId;
+        uint32_t nOutputsBegin;
+        uint32_t nInputsBegin;
+    };
+
+    std::vector<uint32_t> vWords;
+    std::vector<Element> vElements;
+    std::vector<Output> vOutputs;
+    std::vector<Input> vInputs;
+    std::vector<Tx> vTx;
+
+    void AddElement(const uint8_t *begin, const uint8_t *end);
+    void AddPushes(const CScript &script);
+
+    friend class CBloomFilter;
+
+public:
+    explicit CBloomTxElements(const std::vector<CTransactionRef> &vtx);
+
+    size_t GetNumTransactions() const { return vTx.size(); }
+    const CTransaction &GetTransaction(size_t nTx) const {
+        return *vTx[nTx].tx;
+    }
+};
+
+typedef std::shared_ptr<const CBloomTxElements> CBloomTxElementsRef;
+
 /**
  * BloomFilter is a probabilistic filter which SPV clients provide so that we
  * can filter the transactions we send them.
@@ -54,6 +115,9 @@ private:
     uint32_t Hash(uint32_t nHashNum,
                   const std::vector<uint8_t> &vDataToHash) const;
 
+    //! contains() for an element whose words are already mixed.
+    bool contains(const CBloomTxElements &elements, uint32_t nElement) const;
+
     // Private constructor for CRollingBloomFilter, no restrictions on size
     CBloomFilter(const uint32_t nElements, const double nFPRate,
                  const uint32_t nTweak);
@@ -118,6 +182,11 @@ public:
         return MatchAndInsertOutputs(tx) || MatchInputs(tx);
     }
 
+    //! The same as MatchAndInsertOutputs and MatchInputs, for a transaction
+    //! whose elements were extracted ahead of time.
+    bool MatchAndInsertOutputs(const CBloomTxElements &elements, size_t nTx);
+    bool MatchInputs(const CBloomTxElements &elements, size_t nTx);
+
     //! Checks for empty and full filters to avoid wasting cpu
     void UpdateEmptyFull();
 };
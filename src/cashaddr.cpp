@@ -27,19 +27,80 @@ const int8_t CHARSET_REV[128] = {
     3,  16, 11, 28, 12, 14, 6,  4,  2,  -1, -1, -1, -1, -1};
 
 /**
- * Concatenate two byte arrays.
+ * {c0}k(x) for every value of c0, where k(x) is the polynomial PolyModStep
+ * adds for the coefficient c0 it shifts out. As multiplication distributes
+ * over addition, each entry is the sum of {2^n}k(x) for every set bit n of c0:
+ *  k(x) = {19}*x^7 + {3}*x^6 + {25}*x^5 + {11}*x^4 + {25}*x^3 +
+ *         {3}*x^2 + {19}*x + {1}                             = 0x98f2bc8e61
+ *  {2}k(x) = {15}*x^7 + {6}*x^6 + {27}*x^5 + {22}*x^4 + {27}*x^3 +
+ *            {6}*x^2 + {15}*x + {2}                          = 0x79b76d99e2
+ *  {4}k(x) = {30}*x^7 + {12}*x^6 + {31}*x^5 + {5}*x^4 + {31}*x^3 +
+ *            {12}*x^2 + {30}*x + {4}                         = 0xf33e5fb3c4
+ *  {8}k(x) = {21}*x^7 + {24}*x^6 + {23}*x^5 + {10}*x^4 + {23}*x^3 +
+ *            {24}*x^2 + {21}*x + {8}                         = 0xae2eabe2a8
+ *  {16}k(x) = {3}*x^7 + {25}*x^6 + {7}*x^5 + {20}*x^4 + {7}*x^3 +
+ *             {25}*x^2 + {3}*x + {16}                        = 0x1e4f43e470
  */
-data Cat(data x, const data &y) {
-    x.insert(x.end(), y.begin(), y.end());
-    return x;
+const uint64_t POLYMOD_TABLE[32] = {
+    0x0000000000, 0x98f2bc8e61, 0x79b76d99e2, 0xe145d11783, 0xf33e5fb3c4,
+    0x6bcce33da5, 0x8a89322a26, 0x127b8ea447, 0xae2eabe2a8, 0x36dc176cc9,
+    0xd799c67b4a, 0x4f6b7af52b, 0x5d10f4516c, 0xc5e248df0d, 0x24a799c88e,
+    0xbc552546ef, 0x1e4f43e470, 0x86bdff6a11, 0x67f82e7d92, 0xff0a92f3f3,
+    0xed711c57b4, 0x7583a0d9d5, 0x94c671ce56, 0x0c34cd4037, 0xb061e806d8,
+    0x28935488b9, 0xc9d6859f3a, 0x512439115b, 0x435fb7b51c, 0xdbad0b3b7d,
+    0x3ae8da2cfe, 0xa21a66a29f};
+
+/**
+ * Process one more value of the input of PolyMod. `c` is the state of the
+ * computation so far, see below.
+ */
+inline uint64_t PolyModStep(uint64_t c, uint8_t d) {
+    /**
+     * We want to update `c` to correspond to a polynomial with one extra
+     * term. If the initial value of `c` consists of the coefficients of
+     * c(x) = f(x) mod g(x), we modify it to correspond to
+     * c'(x) = (f(x) * x + d) mod g(x), where d is the next input to
+     * process.
+     *
+     * Simplifying:
+     * c'(x) = (f(x) * x + d) mod g(x)
+     *         ((f(x) mod g(x)) * x + d) mod g(x)
+     *         (c(x) * x + d) mod g(x)
+     * If c(x) = c0*x^5 + c1*x^4 + c2*x^3 + c3*x^2 + c4*x + c5, we want to
+     * compute
+     * c'(x) = (c0*x^5 + c1*x^4 + c2*x^3 + c3*x^2 + c4*x + c5) * x + d
+     *                                                             mod g(x)
+     *       = c0*x^6 + c1*x^5 + c2*x^4 + c3*x^3 + c4*x^2 + c5*x + d
+     *                                                             mod g(x)
+     *       = c0*(x^6 mod g(x)) + c1*x^5 + c2*x^4 + c3*x^3 + c4*x^2 +
+     *                                                             c5*x + d
+     * If we call (x^6 mod g(x)) = k(x), this can be written as
+     * c'(x) = (c1*x^5 + c2*x^4 + c3*x^3 + c4*x^2 + c5*x + d) + c0*k(x)
+     */
+
+    // First, determine the value of c0:
+    const uint8_t c0 = c >> 35;
+
+    // Then compute c1*x^5 + c2*x^4 + c3*x^3 + c4*x^2 + c5*x + d, and add
+    // c0*k(x):
+    return (((c & 0x07ffffffff) << 5) ^ d) ^ POLYMOD_TABLE[c0];
 }
 
+/**
+ * The initial state of PolyMod, before any value is processed.
+ */
+const uint64_t POLYMOD_INIT = 1;
+
 /**
  * This function will compute what 8 5-bit values to XOR into the last 8 input
  * values, in order to make the checksum 0. These 8 values are packed together
  * in a single 40-bit integer. The higher bits correspond to earlier values.
+ *
+ * The values are processed on top of the state `c`, which is POLYMOD_INIT to
+ * start from scratch, or the result of PolyModUpdate for the values before
+ * them, such as the expanded prefix.
  */
-uint64_t PolyMod(const data &v) {
+uint64_t PolyModUpdate(uint64_t c, const uint8_t *begin, const uint8_t *end) {
     /**
      * The input is interpreted as a list of coefficients of a polynomial over F
      * = GF(32), with an implicit 1 in front. If the input is [v0,v1,v2,v3,v4],
@@ -73,77 +134,10 @@ uint64_t PolyMod(const data &v) {
      * corresponds to x^2 + v0*x + v1 mod g(x). As 1 mod g(x) = 1, that is the
      * starting value for `c`.
      */
-    uint64_t c = 1;
-    for (uint8_t d : v) {
-        /**
-         * We want to update `c` to correspond to a polynomial with one extra
-         * term. If the initial value of `c` consists of the coefficients of
-         * c(x) = f(x) mod g(x), we modify it to correspond to
-         * c'(x) = (f(x) * x + d) mod g(x), where d is the next input to
-         * process.
-         *
-         * Simplifying:
-         * c'(x) = (f(x) * x + d) mod g(x)
-         *         ((f(x) mod g(x)) * x + d) mod g(x)
-         *         (c(x) * x + d) mod g(x)
-         * If c(x) = c0*x^5 + c1*x^4 + c2*x^3 + c3*x^2 + c4*x + c5, we want to
-         * compute
-         * c'(x) = (c0*x^5 + c1*x^4 + c2*x^3 + c3*x^2 + c4*x + c5) * x + d
-         *                                                             mod g(x)
-         *       = c0*x^6 + c1*x^5 + c2*x^4 + c3*x^3 + c4*x^2 + c5*x + d
-         *                                                             mod g(x)
-         *       = c0*(x^6 mod g(x)) + c1*x^5 + c2*x^4 + c3*x^3 + c4*x^2 +
-         *                                                             c5*x + d
-         * If we call (x^6 mod g(x)) = k(x), this can be written as
-         * c'(x) = (c1*x^5 + c2*x^4 + c3*x^3 + c4*x^2 + c5*x + d) + c0*k(x)
-         */
-
-        // First, determine the value of c0:
-        uint8_t c0 = c >> 35;
-
-        // Then compute c1*x^5 + c2*x^4 + c3*x^3 + c4*x^2 + c5*x + d:
-        c = ((c & 0x07ffffffff) << 5) ^ d;
-
-        // Finally, for each set bit n in c0, conditionally add {2^n}k(x):
-        if (c0 & 0x01) {
-            // k(x) = {19}*x^7 + {3}*x^6 + {25}*x^5 + {11}*x^4 + {25}*x^3 +
-            //        {3}*x^2 + {19}*x + {1}
-            c ^= 0x98f2bc8e61;
-        }
-
-        if (c0 & 0x02) {
-            // {2}k(x) = {15}*x^7 + {6}*x^6 + {27}*x^5 + {22}*x^4 + {27}*x^3 +
-            //           {6}*x^2 + {15}*x + {2}
-            c ^= 0x79b76d99e2;
-        }
-
-        if (c0 & 0x04) {
-            // {4}k(x) = {30}*x^7 + {12}*x^6 + {31}*x^5 + {5}*x^4 + {31}*x^3 +
-            //           {12}*x^2 + {30}*x + {4}
-            c ^= 0xf33e5fb3c4;
-        }
-
-        if (c0 & 0x08) {
-            // {8}k(x) = {21}*x^7 + {24}*x^6 + {23}*x^5 + {10}*x^4 + {23}*x^3 +
-            //           {24}*x^2 + {21}*x + {8}
-            c ^= 0xae2eabe2a8;
-        }
-
-        if (c0 & 0x10) {
-            // {16}k(x) = {3}*x^7 + {25}*x^6 + {7}*x^5 + {20}*x^4 + {7}*x^3 +
-            //            {25}*x^2 + {3}*x + {16}
-            c ^= 0x1e4f43e470;
-        }
+    for (const uint8_t *it = begin; it != end; ++it) {
+        c = PolyModStep(c, *it);
     }
-
-    /**
-     * PolyMod computes what value to xor into the final values to make the
-     * checksum 0. However, if we required that the checksum was 0, it would be
-     * the case that appending a 0 to a valid list of values would result in a
-     * new valid list. For that reason, cashaddr requires the resulting checksum
-     * to be 1 instead.
-     */
-    return c ^ 1;
+    return c;
 }
 
 /**
@@ -157,69 +151,72 @@ inline uint8_t LowerCase(uint8_t c) {
 }
 
 /**
- * Expand the address prefix for the checksum computation.
+ * The state of PolyMod after the expanded prefix: the lower 5 bits of each
+ * character of the prefix, followed by a zero for the separator.
  */
-data ExpandPrefix(const std::string &prefix) {
-    data ret;
-    ret.resize(prefix.size() + 1);
-    for (size_t i = 0; i < prefix.size(); ++i) {
-        ret[i] = prefix[i] & 0x1f;
+uint64_t PrefixPolyMod(const std::string &prefix) {
+    uint64_t c = POLYMOD_INIT;
+    for (char ch : prefix) {
+        c = PolyModStep(c, ch & 0x1f);
     }
-
-    ret[prefix.size()] = 0;
-    return ret;
+    return PolyModStep(c, 0);
 }
 
 /**
- * Verify a checksum.
+ * Verify a checksum, given the state of PolyMod after the prefix.
  */
-bool VerifyChecksum(const std::string &prefix, const data &payload) {
-    return PolyMod(Cat(ExpandPrefix(prefix), payload)) == 0;
+bool VerifyChecksum(uint64_t prefix_mod, const data &payload) {
+    return (PolyModUpdate(prefix_mod, payload.data(),
+                          payload.data() + payload.size()) ^
+            1) == 0;
 }
 
 /**
- * Create a checksum.
+ * Create a checksum, given the state of PolyMod after the prefix.
  */
-data CreateChecksum(const std::string &prefix, const data &payload) {
-    data enc = Cat(ExpandPrefix(prefix), payload);
+uint64_t CreateChecksum(uint64_t prefix_mod, const data &payload) {
+    uint64_t c = PolyModUpdate(prefix_mod, payload.data(),
+                               payload.data() + payload.size());
     // Append 8 zeroes.
-    enc.resize(enc.size() + 8);
-    // Determine what to XOR into those 8 zeroes.
-    uint64_t mod = PolyMod(enc);
-    data ret(8);
     for (size_t i = 0; i < 8; ++i) {
-        // Convert the 5-bit groups in mod to checksum values.
-        ret[i] = (mod >> (5 * (7 - i))) & 0x1f;
+        c = PolyModStep(c, 0);
     }
 
-    return ret;
+    /**
+     * This computes what value to xor into the final values to make the
+     * checksum 0. However, if we required that the checksum was 0, it would be
+     * the case that appending a 0 to a valid list of values would result in a
+     * new valid list. For that reason, cashaddr requires the resulting checksum
+     * to be 1 instead.
+     */
+    return c ^ 1;
 }
 
-} // namespace
-
-namespace cashaddr {
-
 /**
- * Encode a cashaddr string.
+ * Append the cashaddr string of a payload to ret, which already holds the
+ * prefix and separator.
  */
-std::string Encode(const std::string &prefix, const data &payload) {
-    data checksum = CreateChecksum(prefix, payload);
-    data combined = Cat(payload, checksum);
-    std::string ret = prefix + ':';
+void EncodeTo(std::string &ret, uint64_t prefix_mod, const data &payload) {
+    // Determine what to XOR into the 8 zeroes after the payload.
+    const uint64_t mod = CreateChecksum(prefix_mod, payload);
 
-    ret.reserve(ret.size() + combined.size());
-    for (uint8_t c : combined) {
+    ret.reserve(ret.size() + payload.size() + 8);
+    for (uint8_t c : payload) {
         ret += CHARSET[c];
     }
-
-    return ret;
+    for (size_t i = 0; i < 8; ++i) {
+        // Convert the 5-bit groups in mod to checksum values.
+        ret += CHARSET[(mod >> (5 * (7 - i))) & 0x1f];
+    }
 }
 
 /**
- * Decode a cashaddr string.
+ * Decode a cashaddr string, given the state of PolyMod after the default
+ * prefix, which is the most likely one.
  */
-std::pair<std::string, data> Decode(const std::string &str,
-                                    const std::string &default_prefix) {
+std::pair<std::string, data>
+DecodeWithPrefixMod(const std::string &str, const std::string &default_prefix,
+                    uint64_t default_prefix_mod) {
     // Go over the string and do some sanity checks.
     bool lower = false, upper = false, hasNumber = false;
     size_t prefixSize = 0;
@@ -289,11 +286,61 @@ std::pair<std::string, data> Decode(const std::string &str,
     }
 
     // Verify the checksum.
-    if (!VerifyChecksum(prefix, values)) {
+    const uint64_t prefix_mod = prefix == default_prefix
+                                    ? default_prefix_mod
+                                    : PrefixPolyMod(prefix);
+    if (!VerifyChecksum(prefix_mod, values)) {
         return {};
     }
 
     return {std::move(prefix), data(values.begin(), values.end() - 8)};
 }
 
+} // namespace
+
+namespace cashaddr {
+
+/**
+ * Encode a cashaddr string.
+ */
+std::string Encode(const std::string &prefix, const data &payload) {
+    std::string ret = prefix + ':';
+    EncodeTo(ret, PrefixPolyMod(prefix), payload);
+    return ret;
+}
+
+std::vector<std::string> Encode(const std::string &prefix,
+                                const std::vector<data> &payloads) {
+    const uint64_t prefix_mod = PrefixPolyMod(prefix);
+    std::vector<std::string> ret;
+    ret.reserve(payloads.size());
+    for (const data &payload : payloads) {
+        ret.push_back(prefix + ':');
+        EncodeTo(ret.back(), prefix_mod, payload);
+    }
+    return ret;
+}
+
+/**
+ * Decode a cashaddr string.
+ */
+std::pair<std::string, data> Decode(const std::string &str,
+                                    const std::string &default_prefix) {
+    return DecodeWithPrefixMod(str, default_prefix,
+                               PrefixPolyMod(default_prefix));
+}
+
+std::vector<std::pair<std::string, data>>
+Decode(const std::vector<std::string> &strs,
+       const std::string &default_prefix) {
+    const uint64_t default_prefix_mod = PrefixPolyMod(default_prefix);
+    std::vector<std::pair<std::string, data>> ret;
+    ret.reserve(strs.size());
+    for (const std::string &str : strs) {
+        ret.push_back(
+            DecodeWithPrefixMod(str, default_prefix, default_prefix_mod));
+    }
+    return ret;
+}
+
 } // namespace cashaddr
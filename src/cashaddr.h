@@ -20,12 +20,26 @@ namespace cashaddr {
 std::string Encode(const std::string &prefix,
                    const std::vector<uint8_t> &values);
 
+/**
+ * Encode several cashaddr strings with the same prefix, whose part of the
+ * checksum is only computed once.
+ */
+std::vector<std::string>
+Encode(const std::string &prefix,
+       const std::vector<std::vector<uint8_t>> &values);
+
 /**
  * Decode a cashaddr string. Returns (prefix, data). Empty prefix means failure.
  */
 std::pair<std::string, std::vector<uint8_t>>
 Decode(const std::string &str, const std::string &default_prefix);
 
+/**
+ * Decode several cashaddr strings, as Decode does for each of them.
+ */
+std::vector<std::pair<std::string, std::vector<uint8_t>>>
+Decode(const std::vector<std::string> &strs, const std::string &default_prefix);
+
 } // namespace cashaddr
 
 #endif // BITCOIN_CASHADDR_H
@@ -85,38 +85,10 @@ private:
     const CChainParams &params;
 };
 
-} // namespace
-
-std::string EncodeCashAddr(const CTxDestination &dst,
-                           const CChainParams &params) {
-    return boost::apply_visitor(CashAddrEncoder(params), dst);
-}
-
-std::string EncodeCashAddr(const std::string &prefix,
-                           const CashAddrContent &content) {
-    std::vector<uint8_t> data = PackAddrData(content.hash, content.type);
-    return cashaddr::Encode(prefix, data);
-}
-
-CTxDestination DecodeCashAddr(const std::string &addr,
-                              const CChainParams &params) {
-    //throw std::runtime_error("DecodeCashAddr:  1");
-    CashAddrContent content =
-        DecodeCashAddrContent(addr, params.CashAddrPrefix());
-    //throw std::runtime_error("DecodeCashAddr:  2");
-    if (content.hash.size() == 0) {
-        return CNoDestination{};
-    }
-
-    return DecodeCashAddrDestination(content);
-}
-
-CashAddrContent DecodeCashAddrContent(const std::string &addr,
+// Check and unpack the payload of a decoded cashaddr.
+CashAddrContent DecodeCashAddrPayload(const std::string &prefix,
+                                      const std::vector<uint8_t> &payload,
                                       const std::string &expectedPrefix) {
-    std::string prefix;
-    std::vector<uint8_t> payload;
-    std::tie(prefix, payload) = cashaddr::Decode(addr, expectedPrefix);
-    //throw std::runtime_error("DecodeCashAddrContent:  1");
     if (prefix != expectedPrefix) {
         return {};
     }
@@ -166,6 +138,88 @@ CashAddrContent DecodeCashAddrContent(const std::string &addr,
     return {type, std::move(data)};
 }
 
+} // namespace
+
+std::string EncodeCashAddr(const CTxDestination &dst,
+                           const CChainParams &params) {
+    return boost::apply_visitor(CashAddrEncoder(params), dst);
+}
+
+std::string EncodeCashAddr(const std::string &prefix,
+                           const CashAddrContent &content) {
+    std::vector<uint8_t> data = PackAddrData(content.hash, content.type);
+    return cashaddr::Encode(prefix, data);
+}
+
+std::vector<std::string>
+EncodeCashAddrs(const std::vector<CTxDestination> &dsts,
+                const CChainParams &params) {
+    std::vector<std::vector<uint8_t>> payloads;
+    payloads.reserve(dsts.size());
+    for (const CTxDestination &dst : dsts) {
+        if (const CKeyID *id = boost::get<CKeyID>(&dst)) {
+            payloads.push_back(PackAddrData(*id, PUBKEY_TYPE));
+        } else if (const CScriptID *id = boost::get<CScriptID>(&dst)) {
+            payloads.push_back(PackAddrData(*id, SCRIPT_TYPE));
+        } else {
+            payloads.emplace_back();
+        }
+    }
+
+    std::vector<std::string> ret =
+        cashaddr::Encode(params.CashAddrPrefix(), payloads);
+    for (size_t i = 0; i < ret.size(); i++) {
+        if (payloads[i].empty()) {
+            ret[i].clear();
+        }
+    }
+    return ret;
+}
+
+CTxDestination DecodeCashAddr(const std::string &addr,
+                              const CChainParams &params) {
+    //throw std::runtime_error("DecodeCashAddr:  1");
+    CashAddrContent content =
+        DecodeCashAddrContent(addr, params.CashAddrPrefix());
+    //throw std::runtime_error("DecodeCashAddr:  2");
+    if (content.hash.size() == 0) {
+        return CNoDestination{};
+    }
+
+    return DecodeCashAddrDestination(content);
+}
+
+std::vector<CTxDestination>
+DecodeCashAddrs(const std::vector<std::string> &addrs,
+                const CChainParams &params) {
+    const std::string &expectedPrefix = params.CashAddrPrefix();
+    std::vector<std::pair<std::string, std::vector<uint8_t>>> decoded =
+        cashaddr::Decode(addrs, expectedPrefix);
+
+    std::vector<CTxDestination> ret;
+    ret.reserve(decoded.size());
+    for (const auto &prefix_and_payload : decoded) {
+        CashAddrContent content = DecodeCashAddrPayload(
+            prefix_and_payload.first, prefix_and_payload.second,
+            expectedPrefix);
+        if (content.hash.size() == 0) {
+            ret.push_back(CNoDestination{});
+        } else {
+            ret.push_back(DecodeCashAddrDestination(content));
+        }
+    }
+    return ret;
+}
+
+CashAddrContent DecodeCashAddrContent(const std::string &addr,
+                                      const std::string &expectedPrefix) {
+    std::string prefix;
+    std::vector<uint8_t> payload;
+    std::tie(prefix, payload) = cashaddr::Decode(addr, expectedPrefix);
+    //throw std::runtime_error("DecodeCashAddrContent:  1");
+    return DecodeCashAddrPayload(prefix, payload, expectedPrefix);
+}
+
 CTxDestination DecodeCashAddrDestination(const CashAddrContent &content) {
     if (content.hash.size() != 20) {
         // Only 20 bytes hash are supported now.
@@ -21,9 +21,21 @@ struct CashAddrContent {
 std::string EncodeCashAddr(const CTxDestination &, const CChainParams &);
 std::string EncodeCashAddr(const std::string &prefix,
                            const CashAddrContent &content);
+/**
+ * Encode several destinations, which is faster than encoding them one at a
+ * time. Destinations that can't be encoded give an empty string.
+ */
+std::vector<std::string> EncodeCashAddrs(const std::vector<CTxDestination> &,
+                                         const CChainParams &);
 
 CTxDestination DecodeCashAddr(const std::string &addr,
                               const CChainParams &params);
+/**
+ * Decode several addresses, which is faster than decoding them one at a time.
+ */
+std::vector<CTxDestination>
+DecodeCashAddrs(const std::vector<std::string> &addrs,
+                const CChainParams &params);
 CashAddrContent DecodeCashAddrContent(const std::string &addr,
                                       const std::string &prefix);
 CTxDestination DecodeCashAddrDestination(const CashAddrContent &content);
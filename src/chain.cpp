@@ -5,6 +5,10 @@
 
 #include <chain.h>
 
+#include <algorithm>
+#include <functional>
+#include <iterator>
+
 /**
  * CChain implementation
  */
@@ -192,3 +196,43 @@ bool AreOnTheSameFork(const CBlockIndex *pa, const CBlockIndex *pb) {
     const CBlockIndex *pindexCommon = LastCommonAncestor(pa, pb);
     return pindexCommon == pa || pindexCommon == pb;
 }
+
+void BlockIndexArena::AddChunk(std::unique_ptr<CBlockIndex[]> chunk) {
+    const CBlockIndex *begin = chunk.get();
+    m_chunk_begins.insert(std::upper_bound(m_chunk_begins.begin(),
+                                           m_chunk_begins.end(), begin,
+                                           std::less<const CBlockIndex *>()),
+                          begin);
+    m_chunks.push_back(std::move(chunk));
+}
+
+CBlockIndex *BlockIndexArena::New() {
+    if (m_last_chunk_used == CHUNK_SIZE) {
+        AddChunk(std::unique_ptr<CBlockIndex[]>(new CBlockIndex[CHUNK_SIZE]));
+        m_last_chunk_used = 0;
+    }
+    return &m_chunks.back()[m_last_chunk_used++];
+}
+
+void BlockIndexArena::Merge(BlockIndexArena &&other) {
+    for (std::unique_ptr<CBlockIndex[]> &chunk : other.m_chunks) {
+        AddChunk(std::move(chunk));
+    }
+    other.Clear();
+    // The last chunk is now one of the other arena, which may be in use.
+    m_last_chunk_used = CHUNK_SIZE;
+}
+
+bool BlockIndexArena::Owns(const CBlockIndex *pindex) const {
+    const std::less<const CBlockIndex *> less;
+    auto it = std::upper_bound(m_chunk_begins.begin(), m_chunk_begins.end(),
+                               pindex, less);
+    return it != m_chunk_begins.begin() &&
+           less(pindex, *std::prev(it) + CHUNK_SIZE);
+}
+
+void BlockIndexArena::Clear() {
+    m_chunks.clear();
+    m_chunk_begins.clear();
+    m_last_chunk_used = CHUNK_SIZE;
+}
@@ -17,6 +17,7 @@
 #include <tinyformat.h>
 #include <uint256.h>
 
+#include <memory>
 #include <unordered_map>
 #include <vector>
 
@@ -253,6 +254,37 @@ struct BlockHasher {
 };
 
 typedef std::unordered_map<uint256, CBlockIndex *, BlockHasher> BlockMap;
+
+/**
+ * Allocates block index entries in large chunks, rather than one at a time, as
+ * when the whole block index is loaded at startup. The entries are freed with
+ * the arena.
+ */
+class BlockIndexArena {
+private:
+    static constexpr size_t CHUNK_SIZE = 4096;
+
+    std::vector<std::unique_ptr<CBlockIndex[]>> m_chunks;
+    //! The start of every chunk, sorted by address.
+    std::vector<const CBlockIndex *> m_chunk_begins;
+    //! The number of entries handed out from the last chunk.
+    size_t m_last_chunk_used = CHUNK_SIZE;
+
+    void AddChunk(std::unique_ptr<CBlockIndex[]> chunk);
+
+public:
+    /** Allocate a null block index entry. */
+    CBlockIndex *New();
+
+    /** Take over the entries allocated from another arena. */
+    void Merge(BlockIndexArena &&other);
+
+    /** Whether an entry was allocated from this arena. */
+    bool Owns(const CBlockIndex *pindex) const;
+
+    /** Free all the entries allocated from this arena. */
+    void Clear();
+};
 extern BlockMap &mapBlockIndex;
 extern CCriticalSection cs_main;
 
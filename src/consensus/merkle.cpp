@@ -6,6 +6,12 @@
 #include <hash.h>
 #include <util/strencodings.h>
 
+#include <algorithm>
+#if !defined(BUILD_BITCOIN_INTERNAL)
+#include <system_error>
+#include <thread>
+#endif
+
 /*     WARNING! If you're reading this because you're learning about crypto
        and/or designing a new system that will use merkle trees, keep in mind
        that the following merkle tree algorithm has a serious flaw related to
@@ -42,7 +48,28 @@
        root.
 */
 
-uint256 ComputeMerkleRoot(std::vector<uint256> hashes, bool *mutated) {
+/**
+ * Hash the given number of levels of a tree in place, leaving the nodes of the
+ * top level at the front of the vector. Returns whether two identical sibling
+ * hashes were found.
+ */
+static bool HashMerkleLevels(std::vector<uint256> &hashes, int levels) {
+    bool mutation = false;
+    for (int level = 0; level < levels && !hashes.empty(); level++) {
+        for (size_t pos = 0; pos + 1 < hashes.size(); pos += 2) {
+            if (hashes[pos] == hashes[pos + 1]) mutation = true;
+        }
+        if (hashes.size() & 1) {
+            hashes.push_back(hashes.back());
+        }
+        SHA256D64(hashes[0].begin(), hashes[0].begin(), hashes.size() / 2);
+        hashes.resize(hashes.size() / 2);
+    }
+    return mutation;
+}
+
+static uint256 ComputeMerkleRootSerial(std::vector<uint256> hashes,
+                                       bool *mutated) {
     bool mutation = false;
     while (hashes.size() > 1) {
         if (mutated) {
@@ -61,6 +88,99 @@ uint256 ComputeMerkleRoot(std::vector<uint256> hashes, bool *mutated) {
     return hashes[0];
 }
 
+uint256 ComputeMerkleRoot(std::vector<uint256> hashes, bool *mutated) {
+#if !defined(BUILD_BITCOIN_INTERNAL)
+    if (hashes.size() >= MERKLE_PARALLEL_MIN_LEAVES) {
+        return ComputeMerkleRootParallel(std::move(hashes), mutated,
+                                         std::thread::hardware_concurrency());
+    }
+#endif
+    return ComputeMerkleRootSerial(std::move(hashes), mutated);
+}
+
+#if !defined(BUILD_BITCOIN_INTERNAL)
+uint256 ComputeMerkleRootParallel(std::vector<uint256> hashes, bool *mutated,
+                                  unsigned int num_threads) {
+    if (num_threads < 2) {
+        return ComputeMerkleRootSerial(std::move(hashes), mutated);
+    }
+
+    // Split the leaves into aligned subtrees of 2^levels leaves, at least
+    // MERKLE_PARALLEL_MIN_SUBTREE of them, about one per thread. Every
+    // subtree but the last one is complete, so the levels of the whole tree
+    // only duplicate nodes within the last one and each subtree can be hashed
+    // on its own. Their roots are then the leaves of the top of the tree.
+    int levels = 0;
+    while ((size_t(1) << levels) < MERKLE_PARALLEL_MIN_SUBTREE ||
+           (size_t(num_threads) << levels) < hashes.size()) {
+        levels++;
+    }
+    const size_t subtree_size = size_t(1) << levels;
+    const size_t num_subtrees = (hashes.size() + subtree_size - 1) >> levels;
+    if (num_subtrees < 2) {
+        return ComputeMerkleRootSerial(std::move(hashes), mutated);
+    }
+
+    std::vector<std::vector<uint256>> subtrees(num_subtrees);
+    for (size_t i = 0; i < num_subtrees; i++) {
+        auto begin = hashes.begin() + i * subtree_size;
+        auto end = hashes.begin() +
+                   std::min(hashes.size(), (i + 1) * subtree_size);
+        subtrees[i].assign(begin, end);
+    }
+    std::vector<uint256>().swap(hashes);
+
+    // Bool vectors are bit packed, so each subtree reports in its own byte.
+    std::vector<uint8_t> mutations(num_subtrees);
+    std::vector<std::thread> threads;
+    threads.reserve(num_subtrees - 1);
+    {
+        // Whatever was started is joined before leaving, even if hashing on
+        // this thread throws.
+        struct Joiner {
+            std::vector<std::thread> &threads;
+            ~Joiner() {
+                for (std::thread &thread : threads) {
+                    thread.join();
+                }
+            }
+        } joiner{threads};
+
+        // When no more threads can be created, e.g. because of resource
+        // limits, the subtrees left are hashed on this thread.
+        size_t num_started = 1;
+        try {
+            for (; num_started < num_subtrees; num_started++) {
+                const size_t i = num_started;
+                threads.emplace_back([&subtrees, &mutations, levels, i] {
+                    mutations[i] = HashMerkleLevels(subtrees[i], levels);
+                });
+            }
+        } catch (const std::system_error &) {
+        }
+
+        mutations[0] = HashMerkleLevels(subtrees[0], levels);
+        for (size_t i = num_started; i < num_subtrees; i++) {
+            mutations[i] = HashMerkleLevels(subtrees[i], levels);
+        }
+    }
+
+    std::vector<uint256> roots;
+    roots.reserve(num_subtrees);
+    for (const std::vector<uint256> &subtree : subtrees) {
+        roots.push_back(subtree[0]);
+    }
+
+    bool mutation = false;
+    uint256 root = ComputeMerkleRootSerial(std::move(roots), &mutation);
+    if (mutated) {
+        *mutated = mutation || std::find(mutations.begin(), mutations.end(),
+                                         true) != mutations.end();
+    }
+    return root;
+}
+#endif
+
 uint256 BlockMerkleRoot(const CBlock &block, bool *mutated) {
     std::vector<uint256> leaves;
     leaves.resize(block.vtx.size());
@@ -12,8 +12,23 @@
 #include <primitives/transaction.h>
 #include <uint256.h>
 
+/**
+ * Trees with at least this many leaves are hashed by ComputeMerkleRoot on
+ * several threads.
+ */
+static const size_t MERKLE_PARALLEL_MIN_LEAVES = 16384;
+/** The minimum number of leaves hashed by each thread. */
+static const size_t MERKLE_PARALLEL_MIN_SUBTREE = 4096;
+
 uint256 ComputeMerkleRoot(std::vector<uint256> hashes, bool *mutated = nullptr);
 
+/**
+ * Compute the same root as ComputeMerkleRoot, splitting the leaves between up
+ * to num_threads threads. Not available in libbitcoinconsensus.
+ */
+uint256 ComputeMerkleRootParallel(std::vector<uint256> hashes, bool *mutated,
+                                  unsigned int num_threads);
+
 /**
  * Compute the Merkle root of the transactions in a block.
  * *mutated is set to true if a duplicated subtree was found.
@@ -15,6 +15,7 @@ class CBlockHeader;
 class CMutableTransaction;
 class CScript;
 class CTransaction;
+class JSONWriter;
 struct PartiallySignedTransaction;
 class uint256;
 class UniValue;
@@ -43,4 +44,14 @@ void ScriptToUniv(const CScript &script, UniValue &out, bool include_address);
 void TxToUniv(const CTransaction &tx, const uint256 &hashBlock, UniValue &entry,
               bool include_hex = true, int serialize_flags = 0);
 
+/**
+ * The same as ScriptPubKeyToUniv and TxToUniv, writing the fields into the
+ * object the writer is in rather than building a UniValue.
+ */
+void WriteScriptPubKeyJSON(const CScript &scriptPubKey, JSONWriter &writer,
+                           bool fIncludeHex);
+void WriteTxJSON(const CTransaction &tx, const uint256 &hashBlock,
+                 JSONWriter &writer, bool include_hex = true,
+                 int serialize_flags = 0);
+
 #endif // BITCOIN_CORE_IO_H
@@ -13,18 +13,22 @@
 #include <serialize.h>
 #include <streams.h>
 #include <util/moneystr.h>
+#include <util/jsonwriter.h>
 #include <util/strencodings.h>
 #include <util/system.h>
 
 #include <univalue.h>
 
-UniValue ValueFromAmount(const Amount &amount) {
+static std::string FormatAmountNumber(const Amount &amount) {
     bool sign = amount < Amount::zero();
     Amount n_abs(sign ? -amount : amount);
     int64_t quotient = n_abs / COIN;
     int64_t remainder = (n_abs % COIN) / SATOSHI;
-    return UniValue(UniValue::VNUM, strprintf("%s%d.%08d", sign ? "-" : "",
-                                              quotient, remainder));
+    return strprintf("%s%d.%08d", sign ? "-" : "", quotient, remainder);
+}
+
+UniValue ValueFromAmount(const Amount &amount) {
+    return UniValue(UniValue::VNUM, FormatAmountNumber(amount));
 }
 
 std::string FormatScript(const CScript &script) {
@@ -224,6 +228,35 @@ void ScriptPubKeyToUniv(const CScript &scriptPubKey, UniValue &out,
     out.pushKV("addresses", a);
 }
 
+void WriteScriptPubKeyJSON(const CScript &scriptPubKey, JSONWriter &writer,
+                           bool fIncludeHex) {
+    txnouttype type;
+    std::vector<CTxDestination> addresses;
+    int nRequired;
+
+    writer.KV("asm", ScriptToAsmStr(scriptPubKey));
+    if (fIncludeHex) {
+        writer.Key("hex");
+        writer.Hex(scriptPubKey.data(),
+                   scriptPubKey.data() + scriptPubKey.size());
+    }
+
+    if (!ExtractDestinations(scriptPubKey, type, addresses, nRequired)) {
+        writer.KV("type", GetTxnOutputType(type));
+        return;
+    }
+
+    writer.KV("reqSigs", nRequired);
+    writer.KV("type", GetTxnOutputType(type));
+
+    writer.Key("addresses");
+    writer.BeginArray();
+    for (const CTxDestination &addr : addresses) {
+        writer.String(EncodeDestination(addr, GetConfig()));
+    }
+    writer.EndArray();
+}
+
 void TxToUniv(const CTransaction &tx, const uint256 &hashBlock, UniValue &entry,
               bool include_hex, int serialize_flags) {
     entry.pushKV("txid", tx.GetId().GetHex());
@@ -283,3 +316,67 @@ void TxToUniv(const CTransaction &tx, const uint256 &hashBlock, UniValue &entry,
         entry.pushKV("hex", EncodeHexTx(tx, serialize_flags));
     }
 }
+
+void WriteTxJSON(const CTransaction &tx, const uint256 &hashBlock,
+                 JSONWriter &writer, bool include_hex, int serialize_flags) {
+    writer.KV("txid", tx.GetId().GetHex());
+    writer.KV("hash", tx.GetHash().GetHex());
+    writer.KV("version", tx.nVersion);
+    writer.KV("size",
+              (int)::GetSerializeSize(tx, SER_NETWORK, PROTOCOL_VERSION));
+    writer.KV("locktime", (int64_t)tx.nLockTime);
+
+    writer.Key("vin");
+    writer.BeginArray();
+    for (const CTxIn &txin : tx.vin) {
+        writer.BeginObject();
+        const CScript &scriptSig = txin.scriptSig;
+        if (tx.IsCoinBase()) {
+            writer.Key("coinbase");
+            writer.Hex(scriptSig.data(), scriptSig.data() + scriptSig.size());
+        } else {
+            writer.KV("txid", txin.prevout.GetTxId().GetHex());
+            writer.KV("vout", int64_t(txin.prevout.GetN()));
+            writer.Key("scriptSig");
+            writer.BeginObject();
+            writer.KV("asm", ScriptToAsmStr(scriptSig, true));
+            writer.Key("hex");
+            writer.Hex(scriptSig.data(), scriptSig.data() + scriptSig.size());
+            writer.EndObject();
+        }
+
+        writer.KV("sequence", (int64_t)txin.nSequence);
+        writer.EndObject();
+    }
+    writer.EndArray();
+
+    writer.Key("vout");
+    writer.BeginArray();
+    for (unsigned int i = 0; i < tx.vout.size(); i++) {
+        const CTxOut &txout = tx.vout[i];
+
+        writer.BeginObject();
+        writer.Key("value");
+        writer.Raw(FormatAmountNumber(txout.nValue));
+        writer.KV("n", int64_t(i));
+
+        writer.Key("scriptPubKey");
+        writer.BeginObject();
+        WriteScriptPubKeyJSON(txout.scriptPubKey, writer, true);
+        writer.EndObject();
+        writer.EndObject();
+    }
+    writer.EndArray();
+
+    if (!hashBlock.IsNull()) {
+        writer.KV("blockhash", hashBlock.GetHex());
+    }
+
+    if (include_hex) {
+        CDataStream ssTx(SER_NETWORK, PROTOCOL_VERSION | serialize_flags);
+        ssTx << tx;
+        writer.Key("hex");
+        const uint8_t *begin = reinterpret_cast<const uint8_t *>(ssTx.data());
+        writer.Hex(begin, begin + ssTx.size());
+    }
+}
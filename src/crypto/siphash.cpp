@@ -4,6 +4,13 @@
 
 #include <crypto/siphash.h>
 
+#include <crypto/common.h>
+
+#if defined(USE_ASM) &&                                                        \
+    (defined(__x86_64__) || defined(__amd64__) || defined(__i386__))
+#include <cpuid.h>
+#endif
+
 #define ROTL(x, b) (uint64_t)(((x) << (b)) | ((x) >> (64 - (b))))
 
 #define SIPROUND                                                               \
@@ -175,3 +182,60 @@ uint64_t SipHashUint256Extra(uint64_t k0, uint64_t k1, const uint256 &val,
     SIPROUND;
     return v0 ^ v1 ^ v2 ^ v3;
 }
+
+namespace {
+typedef void (*SipHash4WayFunction)(uint64_t k0, uint64_t k1,
+                                    const uint256 *const *vals, uint64_t *out);
+
+/** The 4 way implementation for this CPU, nullptr if there is none. */
+SipHash4WayFunction SipHash4WayAutoDetect() {
+#if defined(ENABLE_AVX2) && !defined(BUILD_BITCOIN_INTERNAL) &&               \
+    defined(USE_ASM) &&                                                        \
+    (defined(__x86_64__) || defined(__amd64__) || defined(__i386__))
+    uint32_t eax, ebx, ecx, edx;
+    __cpuid_count(1, 0, eax, ebx, ecx, edx);
+    const bool have_xsave = (ecx >> 27) & 1;
+    const bool have_avx = (ecx >> 28) & 1;
+    if (!have_xsave || !have_avx) {
+        return nullptr;
+    }
+
+    // Check whether the OS has enabled AVX registers.
+    uint32_t a, d;
+    __asm__("xgetbv" : "=a"(a), "=d"(d) : "c"(0));
+    if ((a & 6) != 6) {
+        return nullptr;
+    }
+
+    __cpuid_count(7, 0, eax, ebx, ecx, edx);
+    if ((ebx >> 5) & 1) {
+        return siphash_avx2::SipHashUint256_4way;
+    }
+#endif
+    return nullptr;
+}
+
+SipHash4WayFunction GetSipHash4Way() {
+    static const SipHash4WayFunction hash_4way = SipHash4WayAutoDetect();
+    return hash_4way;
+}
+} // namespace
+
+void SipHashUint256Batch(uint64_t k0, uint64_t k1, const uint256 *const *vals,
+                         size_t n, uint64_t *out) {
+    const SipHash4WayFunction hash_4way = GetSipHash4Way();
+
+    size_t i = 0;
+    if (hash_4way) {
+        for (; i + 4 <= n; i += 4) {
+            hash_4way(k0, k1, vals + i, out + i);
+        }
+    }
+    for (; i < n; i++) {
+        out[i] = SipHashUint256(k0, k1, *vals[i]);
+    }
+}
+
+std::string SipHashUint256BatchImplementation() {
+    return GetSipHash4Way() ? "avx2(4way)" : "standard";
+}
@@ -7,7 +7,9 @@
 
 #include <uint256.h>
 
+#include <cstddef>
 #include <cstdint>
+#include <string>
 
 /** SipHash-2-4 */
 class CSipHasher {
@@ -47,4 +49,25 @@ uint64_t SipHashUint256(uint64_t k0, uint64_t k1, const uint256 &val);
 uint64_t SipHashUint256Extra(uint64_t k0, uint64_t k1, const uint256 &val,
                              uint32_t extra);
 
+/**
+ * SipHashUint256 of n values with the same key, out[i] being the hash of
+ * *vals[i]. Groups of 4 values are hashed at once on CPUs supporting AVX2.
+ */
+void SipHashUint256Batch(uint64_t k0, uint64_t k1, const uint256 *const *vals,
+                         size_t n, uint64_t *out);
+/**
+ * The implementation SipHashUint256Batch uses on this CPU, "standard" or
+ * "avx2(4way)".
+ */
+std::string SipHashUint256BatchImplementation();
+
+namespace siphash_avx2 {
+/**
+ * SipHashUint256 of 4 values with the same key. Only built with AVX2 support
+ * enabled, and only to be called on CPUs supporting it.
+ */
+void SipHashUint256_4way(uint64_t k0, uint64_t k1, const uint256 *const *vals,
+                         uint64_t *out);
+} // namespace siphash_avx2
+
 #endif // BITCOIN_CRYPTO_SIPHASH_H
@@ -0,0 +1,89 @@
+// Copyright (c) 2019 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifdef ENABLE_AVX2
+
+#include <cstdint>
+#include <immintrin.h>
+
+#include <crypto/siphash.h>
+
+namespace siphash_avx2 {
+namespace {
+
+    __m256i inline K(uint64_t x) { return _mm256_set1_epi64x(x); }
+
+    __m256i inline Add(__m256i x, __m256i y) { return _mm256_add_epi64(x, y); }
+    __m256i inline Xor(__m256i x, __m256i y) { return _mm256_xor_si256(x, y); }
+
+    template <int b> __m256i inline Rotl(__m256i x) {
+        return _mm256_or_si256(_mm256_slli_epi64(x, b),
+                               _mm256_srli_epi64(x, 64 - b));
+    }
+    /** Rotating by 32 bits swaps the halves of each word. */
+    template <> __m256i inline Rotl<32>(__m256i x) {
+        return _mm256_shuffle_epi32(x, 0xb1);
+    }
+
+    void inline SipRound(__m256i &v0, __m256i &v1, __m256i &v2, __m256i &v3) {
+        v0 = Add(v0, v1);
+        v1 = Rotl<13>(v1);
+        v1 = Xor(v1, v0);
+        v0 = Rotl<32>(v0);
+        v2 = Add(v2, v3);
+        v3 = Rotl<16>(v3);
+        v3 = Xor(v3, v2);
+        v0 = Add(v0, v3);
+        v3 = Rotl<21>(v3);
+        v3 = Xor(v3, v0);
+        v2 = Add(v2, v1);
+        v1 = Rotl<17>(v1);
+        v1 = Xor(v1, v2);
+        v2 = Rotl<32>(v2);
+    }
+
+    /** Gather word i of each of the 4 values into one vector. */
+    __m256i inline Read(const uint256 *const *vals, int i) {
+        return _mm256_set_epi64x(vals[3]->GetUint64(i), vals[2]->GetUint64(i),
+                                 vals[1]->GetUint64(i), vals[0]->GetUint64(i));
+    }
+
+} // namespace
+
+/**
+ * SipHashUint256 of 4 values with the same key, one value in each 64 bit lane.
+ */
+void SipHashUint256_4way(uint64_t k0, uint64_t k1, const uint256 *const *vals,
+                         uint64_t *out) {
+    __m256i v0 = K(0x736f6d6570736575ULL ^ k0);
+    __m256i v1 = K(0x646f72616e646f6dULL ^ k1);
+    __m256i v2 = K(0x6c7967656e657261ULL ^ k0);
+    __m256i v3 = K(0x7465646279746573ULL ^ k1);
+
+    for (int i = 0; i < 4; i++) {
+        const __m256i d = Read(vals, i);
+        v3 = Xor(v3, d);
+        SipRound(v0, v1, v2, v3);
+        SipRound(v0, v1, v2, v3);
+        v0 = Xor(v0, d);
+    }
+
+    const __m256i len = K(uint64_t(4) << 59);
+    v3 = Xor(v3, len);
+    SipRound(v0, v1, v2, v3);
+    SipRound(v0, v1, v2, v3);
+    v0 = Xor(v0, len);
+    v2 = Xor(v2, K(0xFF));
+    SipRound(v0, v1, v2, v3);
+    SipRound(v0, v1, v2, v3);
+    SipRound(v0, v1, v2, v3);
+    SipRound(v0, v1, v2, v3);
+
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(out),
+                        Xor(Xor(v0, v1), Xor(v2, v3)));
+}
+
+} // namespace siphash_avx2
+
+#endif
@@ -152,7 +152,13 @@ CDBWrapper::CDBWrapper(const fs::path &path, size_t nCacheSize, bool fMemory,
     // The base-case obfuscation key, which is a noop.
     obfuscate_key = std::vector<uint8_t>(OBFUSCATE_KEY_NUM_BYTES, '\000');
 
-    bool key_exists = Read(OBFUSCATE_KEY_KEY, obfuscate_key);
+    // Values are deobfuscated as they are read, so the key cannot be read
+    // into itself.
+    std::vector<uint8_t> stored_key;
+    bool key_exists = Read(OBFUSCATE_KEY_KEY, stored_key);
+    if (key_exists) {
+        obfuscate_key = stored_key;
+    }
 
     if (!key_exists && obfuscate && IsEmpty()) {
         // Initialize non-degenerate obfuscation if it won't upset existing,
@@ -45,6 +45,52 @@ void HandleError(const leveldb::Status &status);
 const std::vector<uint8_t> &GetObfuscateKey(const CDBWrapper &w);
 }; // namespace dbwrapper_private
 
+/**
+ * Stream deserializing a value straight from the buffer it was read into,
+ * removing the obfuscation as bytes are read rather than on a copy of the
+ * value.
+ */
+class CDBValueReader {
+private:
+    const char *m_data;
+    const size_t m_size;
+    size_t m_pos = 0;
+    const std::vector<uint8_t> &m_key;
+
+public:
+    CDBValueReader(const leveldb::Slice &slice, const std::vector<uint8_t> &key)
+        : m_data(slice.data()), m_size(slice.size()), m_key(key) {}
+
+    template <typename T> CDBValueReader &operator>>(T &&obj) {
+        // Unserialize from this stream
+        ::Unserialize(*this, obj);
+        return (*this);
+    }
+
+    int GetVersion() const { return CLIENT_VERSION; }
+    int GetType() const { return SER_DISK; }
+
+    size_t size() const { return m_size - m_pos; }
+    bool empty() const { return m_size == m_pos; }
+
+    void read(char *dst, size_t n) {
+        if (n > m_size - m_pos) {
+            throw std::ios_base::failure("CDBValueReader::read(): end of data");
+        }
+        memcpy(dst, m_data + m_pos, n);
+        XorWithKey(reinterpret_cast<uint8_t *>(dst), n, m_key, m_pos);
+        m_pos += n;
+    }
+
+    void ignore(size_t n) {
+        if (n > m_size - m_pos) {
+            throw std::ios_base::failure(
+                "CDBValueReader::ignore(): end of data");
+        }
+        m_pos += n;
+    }
+};
+
 /** Batch of changes queued to be written to a CDBWrapper */
 class CDBBatch {
     friend class CDBWrapper;
@@ -154,12 +200,10 @@ public:
     }
 
     template <typename V> bool GetValue(V &value) {
-        leveldb::Slice slValue = piter->value();
         try {
-            CDataStream ssValue(slValue.data(), slValue.data() + slValue.size(),
-                                SER_DISK, CLIENT_VERSION);
-            ssValue.Xor(dbwrapper_private::GetObfuscateKey(parent));
-            ssValue >> value;
+            CDBValueReader reader(piter->value(),
+                                  dbwrapper_private::GetObfuscateKey(parent));
+            reader >> value;
         } catch (const std::exception &) {
             return false;
         }
@@ -242,11 +286,8 @@ public:
             dbwrapper_private::HandleError(status);
         }
         try {
-            CDataStream ssValue(strValue.data(),
-                                strValue.data() + strValue.size(), SER_DISK,
-                                CLIENT_VERSION);
-            ssValue.Xor(obfuscate_key);
-            ssValue >> value;
+            CDBValueReader reader(strValue, obfuscate_key);
+            reader >> value;
         } catch (const std::exception &) {
             return false;
         }
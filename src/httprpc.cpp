@@ -319,6 +319,8 @@ bool HTTPRPCRequestProcessor::ProcessHTTPRequest(HTTPRequest *req) {
 
         // Set the URI
         jreq.URI = req->GetURI();
+        // The results are only written into the reply.
+        jreq.fRawJSONAllowed = true;
 
         std::string strReply;
         // singleton request
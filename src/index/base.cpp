@@ -191,6 +191,33 @@ void BaseIndex::BlockConnected(
     }
 }
 
+void BaseIndex::BlockDisconnected(const std::shared_ptr<const CBlock> &block) {
+    if (!m_synced) {
+        return;
+    }
+
+    // Only the best block can be unwound. It may not be the disconnected block
+    // if the latter is still in the ValidationInterface queue backlog after the
+    // sync thread caught up to the new chain tip, in which case it was never
+    // indexed.
+    const CBlockIndex *best_block_index = m_best_block_index.load();
+    if (!best_block_index ||
+        best_block_index->GetBlockHash() != block->GetHash()) {
+        LogPrintf("%s: WARNING: Block %s is not the best block of the index; "
+                  "not updating index\n",
+                  __func__, block->GetHash().ToString());
+        return;
+    }
+
+    if (RewindBlock(*block, best_block_index)) {
+        m_best_block_index = best_block_index->pprev;
+    } else {
+        FatalError("%s: Failed to rewind block %s from index", __func__,
+                   best_block_index->GetBlockHash().ToString());
+        return;
+    }
+}
+
 void BaseIndex::ChainStateFlushed(const CBlockLocator &locator) {
     if (!m_synced) {
         return;
@@ -61,6 +61,8 @@ protected:
                    const CBlockIndex *pindex,
                    const std::vector<CTransactionRef> &txn_conflicted) override;
 
+    void BlockDisconnected(const std::shared_ptr<const CBlock> &block) override;
+
     void ChainStateFlushed(const CBlockLocator &locator) override;
 
     /// Initialize internal state from the database and block index.
@@ -71,6 +73,12 @@ protected:
         return true;
     }
 
+    /// Erase the index entries of a block disconnected from the tip, which
+    /// is also the best block of the index.
+    virtual bool RewindBlock(const CBlock &block, const CBlockIndex *pindex) {
+        return true;
+    }
+
     virtual DB &GetDB() const = 0;
 
     /// Get the name of the index for display in logs.
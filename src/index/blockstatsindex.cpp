@@ -0,0 +1,249 @@
+// Copyright (c) 2019 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <index/blockstatsindex.h>
+
+#include <chain.h>
+#include <undo.h>
+#include <util/system.h>
+#include <validation.h>
+#include <version.h>
+
+#include <limits>
+
+constexpr char DB_BLOCK_STATS = 's';
+
+std::unique_ptr<BlockStatsIndex> g_blockstatsindex;
+
+/**
+ * The key of the statistics of the block at a given height. The height is
+ * stored big-endian so that LevelDB iterates over the blocks in height order.
+ */
+struct DBHeightKey {
+    int height;
+
+    DBHeightKey() : height(0) {}
+    explicit DBHeightKey(int height_in) : height(height_in) {}
+
+    template <typename Stream> void Serialize(Stream &s) const {
+        ser_writedata8(s, DB_BLOCK_STATS);
+        ser_writedata32be(s, height);
+    }
+
+    template <typename Stream> void Unserialize(Stream &s) {
+        char prefix = ser_readdata8(s);
+        if (prefix != DB_BLOCK_STATS) {
+            throw std::ios_base::failure(
+                "Invalid format for block stats index DB height key");
+        }
+        height = ser_readdata32be(s);
+    }
+};
+
+/**
+ * Access to the block stats index database (indexes/blockstats/)
+ *
+ * Each entry holds the hash of the block the statistics are for, as entries
+ * for blocks of a stale branch can be left behind if the node stopped before
+ * they were unwound.
+ */
+class BlockStatsIndex::DB : public BaseIndex::DB {
+public:
+    explicit DB(size_t n_cache_size, bool f_memory = false,
+                bool f_wipe = false);
+
+    /// Read the statistics of the block at the given height, which must be
+    /// the block with the given hash.
+    bool ReadStats(int height, const uint256 &hash, CBlockStats &stats) const;
+
+    /// Read the statistics of the blocks from start_height up to stop_index.
+    bool ReadStatsRange(int start_height, const CBlockIndex *stop_index,
+                        std::vector<CBlockStats> &stats);
+
+    bool WriteStats(int height, const uint256 &hash, const CBlockStats &stats);
+
+    bool EraseStats(int height);
+};
+
+BlockStatsIndex::DB::DB(size_t n_cache_size, bool f_memory, bool f_wipe)
+    : BaseIndex::DB(GetDataDir() / "indexes" / "blockstats", n_cache_size,
+                    f_memory, f_wipe) {}
+
+bool BlockStatsIndex::DB::ReadStats(int height, const uint256 &hash,
+                                    CBlockStats &stats) const {
+    std::pair<uint256, CBlockStats> value;
+    if (!Read(DBHeightKey(height), value) || value.first != hash) {
+        return false;
+    }
+
+    stats = std::move(value.second);
+    return true;
+}
+
+bool BlockStatsIndex::DB::ReadStatsRange(
+    int start_height, const CBlockIndex *stop_index,
+    std::vector<CBlockStats> &stats) {
+    if (start_height < 0 || start_height > stop_index->nHeight) {
+        return false;
+    }
+
+    stats.clear();
+    stats.reserve(stop_index->nHeight - start_height + 1);
+
+    std::unique_ptr<CDBIterator> db_it(NewIterator());
+    db_it->Seek(DBHeightKey(start_height));
+
+    // The hashes are checked from the top, as the blocks are linked by their
+    // parent.
+    std::vector<uint256> hashes;
+    hashes.reserve(stats.capacity());
+    for (int height = start_height; height <= stop_index->nHeight; height++) {
+        DBHeightKey key;
+        std::pair<uint256, CBlockStats> value;
+        if (!db_it->Valid() || !db_it->GetKey(key) || key.height != height ||
+            !db_it->GetValue(value)) {
+            return false;
+        }
+
+        hashes.push_back(value.first);
+        stats.push_back(std::move(value.second));
+        db_it->Next();
+    }
+
+    const CBlockIndex *pindex = stop_index;
+    for (auto it = hashes.rbegin(); it != hashes.rend(); ++it) {
+        if (*it != pindex->GetBlockHash()) {
+            return false;
+        }
+        pindex = pindex->pprev;
+    }
+
+    return true;
+}
+
+bool BlockStatsIndex::DB::WriteStats(int height, const uint256 &hash,
+                                     const CBlockStats &stats) {
+    return Write(DBHeightKey(height), std::make_pair(hash, stats));
+}
+
+bool BlockStatsIndex::DB::EraseStats(int height) {
+    return Erase(DBHeightKey(height));
+}
+
+BlockStatsIndex::BlockStatsIndex(size_t n_cache_size, bool f_memory,
+                                 bool f_wipe)
+    : m_db(std::make_unique<BlockStatsIndex::DB>(n_cache_size, f_memory,
+                                                 f_wipe)) {}
+
+BlockStatsIndex::~BlockStatsIndex() {}
+
+CBlockStats ComputeBlockStats(const CBlock &block,
+                              const CBlockUndo &blockundo) {
+    CBlockStats stats;
+    stats.nTxs = block.vtx.size();
+    stats.minFee = MAX_MONEY;
+    stats.minFeeRate = MAX_MONEY;
+    stats.nMinTxSize = std::numeric_limits<uint64_t>::max();
+
+    std::vector<Amount> fee_array;
+    std::vector<Amount> feerate_array;
+    std::vector<uint64_t> txsize_array;
+
+    for (size_t i = 0; i < block.vtx.size(); i++) {
+        const CTransaction &tx = *block.vtx[i];
+        stats.nOutputs += tx.vout.size();
+
+        Amount tx_total_out = Amount::zero();
+        for (const CTxOut &out : tx.vout) {
+            tx_total_out += out.nValue;
+            stats.nUtxoSizeInc +=
+                GetSerializeSize(out, SER_NETWORK, PROTOCOL_VERSION) +
+                PER_UTXO_OVERHEAD;
+        }
+
+        if (tx.IsCoinBase()) {
+            continue;
+        }
+
+        // Don't count coinbase's fake input
+        stats.nInputs += tx.vin.size();
+        // Don't count coinbase reward
+        stats.totalOut += tx_total_out;
+
+        const uint64_t tx_size = tx.GetTotalSize();
+        txsize_array.push_back(tx_size);
+        stats.nMaxTxSize = std::max(stats.nMaxTxSize, tx_size);
+        stats.nMinTxSize = std::min(stats.nMinTxSize, tx_size);
+        stats.nTotalSize += tx_size;
+
+        Amount tx_total_in = Amount::zero();
+        for (const Coin &coin : blockundo.vtxundo[i - 1].vprevout) {
+            const CTxOut &prevoutput = coin.GetTxOut();
+            tx_total_in += prevoutput.nValue;
+            stats.nUtxoSizeInc -=
+                GetSerializeSize(prevoutput, SER_NETWORK, PROTOCOL_VERSION) +
+                PER_UTXO_OVERHEAD;
+        }
+
+        const Amount txfee = tx_total_in - tx_total_out;
+        assert(MoneyRange(txfee));
+        fee_array.push_back(txfee);
+        stats.maxFee = std::max(stats.maxFee, txfee);
+        stats.minFee = std::min(stats.minFee, txfee);
+        stats.totalFee += txfee;
+
+        const Amount feerate = txfee / int64_t(tx_size);
+        feerate_array.push_back(feerate);
+        stats.maxFeeRate = std::max(stats.maxFeeRate, feerate);
+        stats.minFeeRate = std::min(stats.minFeeRate, feerate);
+    }
+
+    // Blocks with only a coinbase report zero for the minimums.
+    if (block.vtx.size() <= 1) {
+        stats.minFee = Amount::zero();
+        stats.minFeeRate = Amount::zero();
+        stats.nMinTxSize = 0;
+    }
+
+    stats.medianFee = CalculateTruncatedMedian(fee_array);
+    stats.medianFeeRate = CalculateTruncatedMedian(feerate_array);
+    stats.nMedianTxSize = CalculateTruncatedMedian(txsize_array);
+    return stats;
+}
+
+bool BlockStatsIndex::WriteBlock(const CBlock &block,
+                                 const CBlockIndex *pindex) {
+    CBlockUndo blockundo;
+    // The genesis block has no undo data, it spends nothing.
+    if (pindex->nHeight > 0 && !UndoReadFromDisk(blockundo, pindex)) {
+        return false;
+    }
+    if (blockundo.vtxundo.size() + 1 != block.vtx.size()) {
+        return error("%s: undo data of block %s does not match the block",
+                     __func__, pindex->GetBlockHash().ToString());
+    }
+
+    return m_db->WriteStats(pindex->nHeight, pindex->GetBlockHash(),
+                            ComputeBlockStats(block, blockundo));
+}
+
+bool BlockStatsIndex::RewindBlock(const CBlock &block,
+                                  const CBlockIndex *pindex) {
+    return m_db->EraseStats(pindex->nHeight);
+}
+
+BaseIndex::DB &BlockStatsIndex::GetDB() const {
+    return *m_db;
+}
+
+bool BlockStatsIndex::LookupStats(const CBlockIndex *pindex,
+                                  CBlockStats &stats) const {
+    return m_db->ReadStats(pindex->nHeight, pindex->GetBlockHash(), stats);
+}
+
+bool BlockStatsIndex::LookupStatsRange(int start_height,
+                                       const CBlockIndex *stop_index,
+                                       std::vector<CBlockStats> &stats) const {
+    return m_db->ReadStatsRange(start_height, stop_index, stats);
+}
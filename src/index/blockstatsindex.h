@@ -0,0 +1,146 @@
+// Copyright (c) 2019 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_INDEX_BLOCKSTATSINDEX_H
+#define BITCOIN_INDEX_BLOCKSTATSINDEX_H
+
+#include <amount.h>
+#include <index/base.h>
+#include <primitives/transaction.h>
+#include <serialize.h>
+
+#include <algorithm>
+#include <vector>
+
+class CBlockUndo;
+
+static const bool DEFAULT_BLOCKSTATSINDEX = false;
+
+// outpoint (needed for the utxo index) + nHeight + fCoinBase
+static constexpr size_t PER_UTXO_OVERHEAD =
+    sizeof(COutPoint) + sizeof(uint32_t) + sizeof(bool);
+
+template <typename T> T CalculateTruncatedMedian(std::vector<T> &scores) {
+    size_t size = scores.size();
+    if (size == 0) {
+        return T();
+    }
+
+    std::sort(scores.begin(), scores.end());
+    if (size % 2 == 0) {
+        return (scores[size / 2 - 1] + scores[size / 2]) / 2;
+    } else {
+        return scores[size / 2];
+    }
+}
+
+/**
+ * The statistics of a block reported by getblockstats, except for the ones
+ * which can be derived from the block index. Sizes, fees and fee rates only
+ * cover the transactions other than the coinbase.
+ */
+struct CBlockStats {
+    uint64_t nTxs = 0;
+    uint64_t nInputs = 0;
+    uint64_t nOutputs = 0;
+    uint64_t nTotalSize = 0;
+    uint64_t nMinTxSize = 0;
+    uint64_t nMaxTxSize = 0;
+    uint64_t nMedianTxSize = 0;
+    Amount totalOut = Amount::zero();
+    Amount totalFee = Amount::zero();
+    Amount minFee = Amount::zero();
+    Amount maxFee = Amount::zero();
+    Amount medianFee = Amount::zero();
+    Amount minFeeRate = Amount::zero();
+    Amount maxFeeRate = Amount::zero();
+    Amount medianFeeRate = Amount::zero();
+    int64_t nUtxoSizeInc = 0;
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream &s, Operation ser_action) {
+        READWRITE(VARINT(nTxs));
+        READWRITE(VARINT(nInputs));
+        READWRITE(VARINT(nOutputs));
+        READWRITE(VARINT(nTotalSize));
+        READWRITE(VARINT(nMinTxSize));
+        READWRITE(VARINT(nMaxTxSize));
+        READWRITE(VARINT(nMedianTxSize));
+        ReadWriteAmount(s, ser_action, totalOut);
+        ReadWriteAmount(s, ser_action, totalFee);
+        ReadWriteAmount(s, ser_action, minFee);
+        ReadWriteAmount(s, ser_action, maxFee);
+        ReadWriteAmount(s, ser_action, medianFee);
+        ReadWriteAmount(s, ser_action, minFeeRate);
+        ReadWriteAmount(s, ser_action, maxFeeRate);
+        ReadWriteAmount(s, ser_action, medianFeeRate);
+        // The only statistic which can be negative.
+        READWRITE(nUtxoSizeInc);
+    }
+
+private:
+    // None of the amounts are negative, so they are stored as varints.
+    template <typename Stream, typename Operation>
+    static void ReadWriteAmount(Stream &s, Operation ser_action,
+                                Amount &amount) {
+        int64_t nSatoshis = amount / SATOSHI;
+        READWRITE(VARINT(nSatoshis, VarIntMode::NONNEGATIVE_SIGNED));
+        amount = nSatoshis * SATOSHI;
+    }
+};
+
+/**
+ * Compute the statistics of a block, using its undo data for the values of the
+ * coins spent.
+ */
+CBlockStats ComputeBlockStats(const CBlock &block, const CBlockUndo &blockundo);
+
+/**
+ * BlockStatsIndex stores the statistics of each block of the active chain, so
+ * that getblockstats does not have to read the block and its undo data again
+ * for every call. The index is written to a LevelDB database, keyed by height,
+ * and the entry of a block is erased when it is disconnected.
+ */
+class BlockStatsIndex final : public BaseIndex {
+protected:
+    class DB;
+
+private:
+    const std::unique_ptr<DB> m_db;
+
+protected:
+    bool WriteBlock(const CBlock &block, const CBlockIndex *pindex) override;
+
+    bool RewindBlock(const CBlock &block, const CBlockIndex *pindex) override;
+
+    BaseIndex::DB &GetDB() const override;
+
+    const char *GetName() const override { return "blockstatsindex"; }
+
+public:
+    /// Constructs the index, which becomes available to be queried.
+    explicit BlockStatsIndex(size_t n_cache_size, bool f_memory = false,
+                             bool f_wipe = false);
+
+    // Destructor is declared because this class contains a unique_ptr to an
+    // incomplete type.
+    virtual ~BlockStatsIndex() override;
+
+    /// Look up the statistics of a block.
+    /// @return  false if the block has not been indexed.
+    bool LookupStats(const CBlockIndex *pindex, CBlockStats &stats) const;
+
+    /// Look up the statistics of the blocks from start_height up to and
+    /// including stop_index, in one pass over the database.
+    /// @return  false if any of these blocks has not been indexed.
+    bool LookupStatsRange(int start_height, const CBlockIndex *stop_index,
+                          std::vector<CBlockStats> &stats) const;
+};
+
+/// The global block statistics index, used in getblockstats. May be null.
+extern std::unique_ptr<BlockStatsIndex> g_blockstatsindex;
+
+#endif // BITCOIN_INDEX_BLOCKSTATSINDEX_H
@@ -22,6 +22,7 @@
 #include <fs.h>
 #include <httprpc.h>
 #include <httpserver.h>
+#include <index/blockstatsindex.h>
 #include <index/txindex.h>
 #include <key.h>
 #include <miner.h>
@@ -180,6 +181,9 @@ static std::unique_ptr<ECCVerifyHandle> globalVerifyHandle;
 static boost::thread_group threadGroup;
 static CScheduler scheduler;
 
+//! How often the scheduler load is reported, in seconds
+static const int SCHEDULER_STATS_INTERVAL = 60;
+
 void Interrupt() {
     InterruptHTTPServer();
     InterruptHTTPRPC();
@@ -193,6 +197,9 @@ void Interrupt() {
     if (g_txindex) {
         g_txindex->Interrupt();
     }
+    if (g_blockstatsindex) {
+        g_blockstatsindex->Interrupt();
+    }
 }
 
 void Shutdown() {
@@ -228,6 +235,9 @@ void Shutdown() {
     if (g_txindex) {
         g_txindex->Stop();
     }
+    if (g_blockstatsindex) {
+        g_blockstatsindex->Stop();
+    }
 
     StopTorControl();
 
@@ -242,6 +252,8 @@ void Shutdown() {
     g_connman.reset();
     g_banman.reset();
     g_txindex.reset();
+    g_blockstatsindex.reset();
+    g_block_template_cache.reset();
 
     if (::g_mempool.IsLoaded() &&
         gArgs.GetArg("-persistmempool", DEFAULT_PERSIST_MEMPOOL)) {
@@ -385,6 +397,12 @@ void SetupServerArgs() {
         strprintf(_("Whether to operate in a blocks only mode (default: %d)"),
                   DEFAULT_BLOCKSONLY),
         true, OptionsCategory::OPTIONS);
+    gArgs.AddArg("-blockstatsindex",
+                 strprintf(_("Maintain an index of per block statistics, used "
+                             "by the getblockstats and getblockstatsrange rpc "
+                             "calls (default: %d)"),
+                           DEFAULT_BLOCKSTATSINDEX),
+                 false, OptionsCategory::OPTIONS);
     gArgs.AddArg("-conf=<file>",
                  strprintf(_("Specify configuration file. Relative paths will "
                              "be prefixed by datadir location. (default: %s)"),
@@ -500,6 +518,13 @@ void SetupServerArgs() {
                  _("Rebuild chain state and block index from the blk*.dat "
                    "files on disk"),
                  false, OptionsCategory::OPTIONS);
+    gArgs.AddArg(
+        "-schedulerthreads=<n>",
+        strprintf(_("Set the number of threads running background tasks, "
+                    "such as validation notifications (1 to %d, default: "
+                    "%d)"),
+                  MAX_SCHEDULER_THREADS, DEFAULT_SCHEDULER_THREADS),
+        false, OptionsCategory::OPTIONS);
 #ifndef WIN32
     gArgs.AddArg(
         "-sysperms",
@@ -1479,11 +1504,15 @@ bool AppInitParameterInteraction(Config &config) {
                       gArgs.GetArg("-blocksdir", "").c_str()));
     }
 
-    // if using block pruning, then disallow txindex
+    // if using block pruning, then disallow txindex and blockstatsindex
     if (gArgs.GetArg("-prune", 0)) {
         if (gArgs.GetBoolArg("-txindex", DEFAULT_TXINDEX)) {
             return InitError(_("Prune mode is incompatible with -txindex."));
         }
+        if (gArgs.GetBoolArg("-blockstatsindex", DEFAULT_BLOCKSTATSINDEX)) {
+            return InitError(
+                _("Prune mode is incompatible with -blockstatsindex."));
+        }
     }
 
     // if space reserved for high priority transactions is misconfigured
@@ -1909,14 +1938,40 @@ bool AppInitMain(Config &config, RPCServer &rpcServer,
         }
     }
 
-    // Start the lightweight task scheduler thread
+    // Start the lightweight task scheduler threads
+    int nSchedulerThreads =
+        gArgs.GetArg("-schedulerthreads", DEFAULT_SCHEDULER_THREADS);
+    nSchedulerThreads =
+        std::max(1, std::min(nSchedulerThreads, MAX_SCHEDULER_THREADS));
+    LogPrintf("Using %d threads for the scheduler\n", nSchedulerThreads);
     CScheduler::Function serviceLoop =
         std::bind(&CScheduler::serviceQueue, &scheduler);
-    threadGroup.create_thread(std::bind(&TraceThread<CScheduler::Function>,
-                                        "scheduler", serviceLoop));
+    for (int i = 0; i < nSchedulerThreads; i++) {
+        threadGroup.create_thread(std::bind(&TraceThread<CScheduler::Function>,
+                                            "scheduler", serviceLoop));
+    }
+
+    // Report the scheduler load, with -debug=bench.
+    scheduler.scheduleEvery(
+        [] {
+            const CSchedulerStats stats = scheduler.getStats();
+            const double nTasksRun = std::max<uint64_t>(stats.nTasksRun, 1);
+            LogPrint(BCLog::BENCH,
+                     "Scheduler: %u tasks queued (%u due) on %d threads, %u "
+                     "run, delay %.2fms avg %.2fms max, run time %.2fms avg "
+                     "%.2fms max\n",
+                     stats.nQueued, stats.nDue, stats.nThreads,
+                     stats.nTasksRun, stats.nTotalDelay / nTasksRun * 0.001,
+                     stats.nMaxDelay * 0.001,
+                     stats.nTotalRunTime / nTasksRun * 0.001,
+                     stats.nMaxRunTime * 0.001);
+            return true;
+        },
+        SCHEDULER_STATS_INTERVAL * 1000);
 
     GetMainSignals().RegisterBackgroundSignalScheduler(scheduler);
     GetMainSignals().RegisterWithMempoolSignals(g_mempool);
+    g_block_template_cache.reset(new BlockTemplateCache(config, g_mempool));
 
     /**
      * Register RPC commands regardless of -server setting so they will be
@@ -2106,6 +2161,12 @@ bool AppInitMain(Config &config, RPCServer &rpcServer,
                                       ? nMaxTxIndexCache << 20
                                       : 0);
     nTotalCache -= nTxIndexCache;
+    int64_t nBlockStatsIndexCache =
+        std::min(nTotalCache / 8,
+                 gArgs.GetBoolArg("-blockstatsindex", DEFAULT_BLOCKSTATSINDEX)
+                     ? nMaxBlockStatsIndexCache << 20
+                     : 0);
+    nTotalCache -= nBlockStatsIndexCache;
     // use 25%-50% of the remainder for disk cache
     int64_t nCoinDBCache =
         std::min(nTotalCache / 2, (nTotalCache / 4) + (1 << 23));
@@ -2123,6 +2184,10 @@ bool AppInitMain(Config &config, RPCServer &rpcServer,
         LogPrintf("* Using %.1fMiB for transaction index database\n",
                   nTxIndexCache * (1.0 / 1024 / 1024));
     }
+    if (gArgs.GetBoolArg("-blockstatsindex", DEFAULT_BLOCKSTATSINDEX)) {
+        LogPrintf("* Using %.1fMiB for block statistics index database\n",
+                  nBlockStatsIndexCache * (1.0 / 1024 / 1024));
+    }
     LogPrintf("* Using %.1fMiB for chain state database\n",
               nCoinDBCache * (1.0 / 1024 / 1024));
     LogPrintf("* Using %.1fMiB for in-memory UTXO set (plus up to %.1fMiB of "
@@ -2341,7 +2406,11 @@ bool AppInitMain(Config &config, RPCServer &rpcServer,
     // Encoded addresses using cashaddr instead of base58.
     // We do this by default to avoid confusion with BTC addresses.
     config.SetCashAddrEncoding(gArgs.GetBoolArg("-usecashaddr", true));
-    mastercore_init();
+    if (mastercore_init() < 0) {
+        return InitError(
+            _("Omni Core has to parse blocks which were pruned. Disable "
+              "pruning and restart with -reindex to download them again."));
+    }
 
     // Step 8: load indexers
     if (gArgs.GetBoolArg("-txindex", DEFAULT_TXINDEX)) {
@@ -2349,6 +2418,12 @@ bool AppInitMain(Config &config, RPCServer &rpcServer,
         g_txindex->Start();
     }
 
+    if (gArgs.GetBoolArg("-blockstatsindex", DEFAULT_BLOCKSTATSINDEX)) {
+        g_blockstatsindex = std::make_unique<BlockStatsIndex>(
+            nBlockStatsIndexCache, false, fReindex);
+        g_blockstatsindex->Start();
+    }
+
     // Step 9: load wallet
     if (!g_wallet_init_interface.Open(chainparams)) {
         return false;
@@ -7,100 +7,192 @@
 
 #include <consensus/consensus.h>
 #include <hash.h>
+#include <sync.h>
 #include <util/strencodings.h>
 
-CMerkleBlock::CMerkleBlock(const CBlock &block, CBloomFilter &filter) {
-    header = block.GetBlockHeader();
+#include <algorithm>
+#include <list>
 
-    std::vector<bool> vMatch;
-    std::vector<uint256> vHashes;
+CMerkleTree::CMerkleTree(std::vector<uint256> vTxid) : fMutated(false) {
+    vLevels.push_back(std::move(vTxid));
+    while (vLevels.back().size() > 1) {
+        const std::vector<uint256> &level = vLevels.back();
+        for (size_t pos = 0; pos + 1 < level.size(); pos += 2) {
+            if (level[pos] == level[pos + 1]) fMutated = true;
+        }
+        // An odd node out is hashed with itself.
+        std::vector<uint256> parents((level.size() + 1) / 2);
+        SHA256D64(parents[0].begin(), level[0].begin(), level.size() / 2);
+        if (level.size() & 1) {
+            const uint256 &last = level.back();
+            parents.back() =
+                Hash(BEGIN(last), END(last), BEGIN(last), END(last));
+        }
+        vLevels.push_back(std::move(parents));
+    }
+}
 
-    vMatch.reserve(block.vtx.size());
-    vHashes.reserve(block.vtx.size());
+/**
+ * Something computed from the transactions of a block, for the few blocks it
+ * was last asked for, most recent first.
+ */
+template <typename T> class RecentBlockCache {
+private:
+    typedef std::shared_ptr<const T> Ref;
+
+    const size_t nMaxSize;
+    Mutex cs;
+    std::list<std::pair<uint256, Ref>> entries GUARDED_BY(cs);
+
+public:
+    explicit RecentBlockCache(size_t nMaxSizeIn) : nMaxSize(nMaxSizeIn) {}
+
+    Ref Lookup(const uint256 &hash) {
+        LOCK(cs);
+        auto it = std::find_if(entries.begin(), entries.end(),
+                               [&hash](const std::pair<uint256, Ref> &entry) {
+                                   return entry.first == hash;
+                               });
+        if (it == entries.end()) {
+            return nullptr;
+        }
+        entries.splice(entries.begin(), entries, it);
+        return it->second;
+    }
+
+    void Insert(const uint256 &hash, Ref value) {
+        LOCK(cs);
+        entries.remove_if([&hash](const std::pair<uint256, Ref> &entry) {
+            return entry.first == hash;
+        });
+        entries.emplace_front(hash, std::move(value));
+        if (entries.size() > nMaxSize) {
+            entries.pop_back();
+        }
+    }
+};
+
+static RecentBlockCache<CMerkleTree>
+    g_merkle_tree_cache(MERKLE_TREE_CACHE_SIZE);
+static RecentBlockCache<CBloomTxElements>
+    g_bloom_elements_cache(BLOOM_ELEMENTS_CACHE_SIZE);
+
+CMerkleTreeRef LookupBlockMerkleTree(const uint256 &hash) {
+    return g_merkle_tree_cache.Lookup(hash);
+}
+
+CMerkleTreeRef GetBlockMerkleTree(const CBlock &block) {
+    const uint256 hash = block.GetHash();
+    CMerkleTreeRef tree = LookupBlockMerkleTree(hash);
+    // A block can be mutated without changing its hash, so only a tree that
+    // matches the transactions of this one is used.
+    if (tree && tree->GetNumLeaves() == block.vtx.size() &&
+        std::equal(block.vtx.begin(), block.vtx.end(),
+                   tree->GetLeaves().begin(),
+                   [](const CTransactionRef &tx, const uint256 &txid) {
+                       return tx->GetId() == txid;
+                   })) {
+        return tree;
+    }
 
+    std::vector<uint256> vTxid;
+    vTxid.reserve(block.vtx.size());
     for (const auto &tx : block.vtx) {
-        vMatch.push_back(filter.MatchAndInsertOutputs(*tx));
+        vTxid.push_back(tx->GetId());
     }
+    tree = std::make_shared<const CMerkleTree>(std::move(vTxid));
 
-    for (size_t i = 0; i < block.vtx.size(); i++) {
-        const CTransaction *tx = block.vtx[i].get();
-        const TxId &txid = tx->GetId();
-        if (!vMatch[i]) {
-            vMatch[i] = filter.MatchInputs(*tx);
+    // Only cache trees of blocks that can be valid.
+    if (tree->GetRoot() == block.hashMerkleRoot && !tree->IsMutated()) {
+        g_merkle_tree_cache.Insert(hash, tree);
+    }
+    return tree;
+}
+
+CBloomTxElementsRef GetBlockBloomElements(const CBlock &block) {
+    const uint256 hash = block.GetHash();
+    CBloomTxElementsRef elements = g_bloom_elements_cache.Lookup(hash);
+    // As for the Merkle tree, the elements must be of the same transactions.
+    if (elements && elements->GetNumTransactions() == block.vtx.size()) {
+        bool fSame = true;
+        for (size_t i = 0; fSame && i < block.vtx.size(); i++) {
+            fSame = elements->GetTransaction(i).GetId() ==
+                    block.vtx[i]->GetId();
         }
-        if (vMatch[i]) {
-            vMatchedTxn.push_back(std::make_pair(i, txid));
+        if (fSame) {
+            return elements;
         }
-
-        vHashes.push_back(txid);
     }
 
-    txn = CPartialMerkleTree(vHashes, vMatch);
+    elements = std::make_shared<const CBloomTxElements>(block.vtx);
+    g_bloom_elements_cache.Insert(hash, elements);
+    return elements;
 }
 
-CMerkleBlock::CMerkleBlock(const CBlock &block, const std::set<TxId> &txids) {
+CMerkleBlock::CMerkleBlock(const CBlock &block, CBloomFilter &filter) {
     header = block.GetBlockHeader();
 
-    std::vector<bool> vMatch;
-    std::vector<uint256> vHashes;
+    // The elements are shared by all the peers the block is sent to.
+    CBloomTxElementsRef elements = GetBlockBloomElements(block);
 
+    std::vector<bool> vMatch;
     vMatch.reserve(block.vtx.size());
-    vHashes.reserve(block.vtx.size());
 
-    for (const auto &tx : block.vtx) {
-        const TxId &txid = tx->GetId();
-        vMatch.push_back(txids.count(txid));
-        vHashes.push_back(txid);
+    for (size_t i = 0; i < block.vtx.size(); i++) {
+        vMatch.push_back(filter.MatchAndInsertOutputs(*elements, i));
     }
 
-    txn = CPartialMerkleTree(vHashes, vMatch);
+    for (size_t i = 0; i < block.vtx.size(); i++) {
+        const TxId &txid = block.vtx[i]->GetId();
+        if (!vMatch[i]) {
+            vMatch[i] = filter.MatchInputs(*elements, i);
+        }
+        if (vMatch[i]) {
+            vMatchedTxn.push_back(std::make_pair(i, txid));
+        }
+    }
+
+    txn = CPartialMerkleTree(*GetBlockMerkleTree(block), vMatch);
 }
 
-uint256 CPartialMerkleTree::CalcHash(int height, size_t pos,
-                                     const std::vector<uint256> &vTxid) {
-    // we can never have zero txs in a merkle block, we always need the
-    // coinbase tx if we do not have this assert, we can hit a memory
-    // access violation when indexing into vTxid
-    assert(vTxid.size() != 0);
-    if (height == 0) {
-        // hash at height 0 is the txids themself.
-        return vTxid[pos];
-    }
+CMerkleBlock::CMerkleBlock(const CBlock &block, const std::set<TxId> &txids)
+    : CMerkleBlock(block.GetBlockHeader(), *GetBlockMerkleTree(block), txids) {
+}
 
-    // Calculate left hash.
-    uint256 left = CalcHash(height - 1, pos * 2, vTxid), right;
-    // Calculate right hash if not beyond the end of the array - copy left hash
-    // otherwise.
-    if (pos * 2 + 1 < CalcTreeWidth(height - 1)) {
-        right = CalcHash(height - 1, pos * 2 + 1, vTxid);
-    } else {
-        right = left;
+CMerkleBlock::CMerkleBlock(const CBlockHeader &blockHeader,
+                           const CMerkleTree &tree,
+                           const std::set<TxId> &txids) {
+    header = blockHeader;
+
+    std::vector<bool> vMatch;
+    vMatch.reserve(tree.GetNumLeaves());
+
+    for (const uint256 &txid : tree.GetLeaves()) {
+        vMatch.push_back(txids.count(TxId(txid)));
     }
 
-    // Combine subhashes.
-    return Hash(BEGIN(left), END(left), BEGIN(right), END(right));
+    txn = CPartialMerkleTree(tree, vMatch);
 }
 
-void CPartialMerkleTree::TraverseAndBuild(int height, size_t pos,
-                                          const std::vector<uint256> &vTxid,
-                                          const std::vector<bool> &vMatch) {
+void CPartialMerkleTree::TraverseAndBuild(
+    int height, size_t pos, const CMerkleTree &tree,
+    const std::vector<size_t> &vMatchPos) {
     // Determine whether this node is the parent of at least one matched txid.
-    bool fParentOfMatch = false;
-    for (size_t p = pos << height; p < (pos + 1) << height && p < nTransactions;
-         p++) {
-        fParentOfMatch |= vMatch[p];
-    }
+    auto it = std::lower_bound(vMatchPos.begin(), vMatchPos.end(),
+                               pos << height);
+    bool fParentOfMatch =
+        it != vMatchPos.end() && *it < ((pos + 1) << height);
 
     // Store as flag bit.
     vBits.push_back(fParentOfMatch);
     if (height == 0 || !fParentOfMatch) {
         // If at height 0, or nothing interesting below, store hash and stop.
-        vHash.push_back(CalcHash(height, pos, vTxid));
+        vHash.push_back(tree.GetHash(height, pos));
     } else {
         // Otherwise, don't store any hash, but descend into the subtrees.
-        TraverseAndBuild(height - 1, pos * 2, vTxid, vMatch);
+        TraverseAndBuild(height - 1, pos * 2, tree, vMatchPos);
         if (pos * 2 + 1 < CalcTreeWidth(height - 1)) {
-            TraverseAndBuild(height - 1, pos * 2 + 1, vTxid, vMatch);
+            TraverseAndBuild(height - 1, pos * 2 + 1, tree, vMatchPos);
         }
     }
 }
@@ -156,7 +248,16 @@ uint256 CPartialMerkleTree::TraverseAndExtract(int height, size_t pos,
 
 CPartialMerkleTree::CPartialMerkleTree(const std::vector<uint256> &vTxid,
                                        const std::vector<bool> &vMatch)
-    : nTransactions(vTxid.size()), fBad(false) {
+    : CPartialMerkleTree(CMerkleTree(vTxid), vMatch) {}
+
+CPartialMerkleTree::CPartialMerkleTree(const CMerkleTree &tree,
+                                       const std::vector<bool> &vMatch)
+    : nTransactions(tree.GetNumLeaves()), fBad(false) {
+    // we can never have zero txs in a merkle block, we always need the
+    // coinbase tx if we do not have this assert, we can hit a memory
+    // access violation when looking up the hashes of the tree
+    assert(nTransactions != 0);
+
     // reset state
     vBits.clear();
     vHash.clear();
@@ -167,8 +268,15 @@ CPartialMerkleTree::CPartialMerkleTree(const std::vector<uint256> &vTxid,
         nHeight++;
     }
 
+    std::vector<size_t> vMatchPos;
+    for (size_t p = 0; p < nTransactions; p++) {
+        if (vMatch[p]) {
+            vMatchPos.push_back(p);
+        }
+    }
+
     // traverse the partial tree
-    TraverseAndBuild(nHeight, 0, vTxid, vMatch);
+    TraverseAndBuild(nHeight, 0, tree, vMatchPos);
 }
 
 CPartialMerkleTree::CPartialMerkleTree() : nTransactions(0), fBad(true) {}
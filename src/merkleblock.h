@@ -11,8 +11,81 @@
 #include <serialize.h>
 #include <uint256.h>
 
+#include <memory>
+#include <set>
 #include <vector>
 
+/**
+ * All the levels of the Merkle tree of a list of transaction ids, from the
+ * txids themselves up to the root, so that any node can be looked up without
+ * hashing. Each level is as wide as CPartialMerkleTree::CalcTreeWidth.
+ */
+class CMerkleTree {
+private:
+    std::vector<std::vector<uint256>> vLevels;
+    bool fMutated;
+
+public:
+    explicit CMerkleTree(std::vector<uint256> vTxid);
+
+    /** The number of transactions, i.e. the width of the bottom level. */
+    size_t GetNumLeaves() const { return vLevels[0].size(); }
+
+    /** The height of the root, 0 for a tree of a single transaction. */
+    int GetHeight() const { return vLevels.size() - 1; }
+
+    const std::vector<uint256> &GetLeaves() const { return vLevels[0]; }
+
+    /** The hash of the node at the given position of the given level. */
+    const uint256 &GetHash(int height, size_t pos) const {
+        return vLevels[height][pos];
+    }
+
+    /** The Merkle root, or 0 for an empty tree. */
+    uint256 GetRoot() const {
+        return vLevels.back().empty() ? uint256() : vLevels.back()[0];
+    }
+
+    /**
+     * Whether two identical sibling hashes were found, as in a block mutated
+     * by duplicating transactions (see consensus/merkle.cpp).
+     */
+    bool IsMutated() const { return fMutated; }
+};
+
+typedef std::shared_ptr<const CMerkleTree> CMerkleTreeRef;
+
+/**
+ * The number of recent blocks whose Merkle tree is kept around, so that
+ * repeated proofs for them only look up the branches they need.
+ */
+static const size_t MERKLE_TREE_CACHE_SIZE = 4;
+
+/**
+ * Get the Merkle tree of a block, computing it if it is not in the cache of
+ * recent blocks.
+ */
+CMerkleTreeRef GetBlockMerkleTree(const CBlock &block);
+
+/**
+ * Get the Merkle tree of the block with the given hash, or nullptr if it is
+ * not in the cache of recent blocks.
+ */
+CMerkleTreeRef LookupBlockMerkleTree(const uint256 &hash);
+
+/**
+ * The number of recent blocks whose bloom filter elements are kept around, so
+ * that serving a filtered block to many peers only extracts them once. They
+ * take about as much memory as the block itself.
+ */
+static const size_t BLOOM_ELEMENTS_CACHE_SIZE = 2;
+
+/**
+ * Get the bloom filter elements of the transactions of a block, extracting
+ * them if they are not in the cache of recent blocks.
+ */
+CBloomTxElementsRef GetBlockBloomElements(const CBlock &block);
+
 /**
  * Data structure that represents a partial merkle tree.
  *
@@ -71,19 +144,13 @@ protected:
         return (nTransactions + (1 << height) - 1) >> height;
     }
 
-    /**
-     * Calculate the hash of a node in the merkle tree (at leaf level: the
-     * txid's themselves)
-     */
-    uint256 CalcHash(int height, size_t pos, const std::vector<uint256> &vTxid);
-
     /**
      * Recursive function that traverses tree nodes, storing the data as bits
-     * and hashes.
+     * and hashes. vMatchPos holds the positions of the matched txids, in
+     * increasing order.
      */
-    void TraverseAndBuild(int height, size_t pos,
-                          const std::vector<uint256> &vTxid,
-                          const std::vector<bool> &vMatch);
+    void TraverseAndBuild(int height, size_t pos, const CMerkleTree &tree,
+                          const std::vector<size_t> &vMatchPos);
 
     /**
      * Recursive function that traverses tree nodes, consuming the bits and
@@ -127,6 +194,13 @@ public:
     CPartialMerkleTree(const std::vector<uint256> &vTxid,
                        const std::vector<bool> &vMatch);
 
+    /**
+     * Construct a partial merkle tree from the full tree of a block, and a
+     * mask that selects a subset of its transactions.
+     */
+    CPartialMerkleTree(const CMerkleTree &tree,
+                       const std::vector<bool> &vMatch);
+
     CPartialMerkleTree();
 
     /**
@@ -177,6 +251,13 @@ public:
      */
     CMerkleBlock(const CBlock &block, const std::set<TxId> &txids);
 
+    /**
+     * Create a Merkle proof for a set of transactions of the block with the
+     * given header and Merkle tree.
+     */
+    CMerkleBlock(const CBlockHeader &blockHeader, const CMerkleTree &tree,
+                 const std::set<TxId> &txids);
+
     CMerkleBlock() {}
 
     ADD_SERIALIZE_METHODS;
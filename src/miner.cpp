@@ -58,6 +58,27 @@ int64_t UpdateTime(CBlockHeader *pblock, const Consensus::Params &params,
     return nNewTime - nOldTime;
 }
 
+static CTransactionRef CreateCoinbase(const CScript &scriptPubKeyIn,
+                                      int nHeight, const Amount nValue) {
+    CMutableTransaction coinbaseTx;
+    coinbaseTx.vin.resize(1);
+    coinbaseTx.vin[0].prevout = COutPoint();
+    coinbaseTx.vout.resize(1);
+    coinbaseTx.vout[0].scriptPubKey = scriptPubKeyIn;
+    coinbaseTx.vout[0].nValue = nValue;
+    coinbaseTx.vin[0].scriptSig = CScript() << nHeight << OP_0;
+
+    // Make sure the coinbase is big enough.
+    uint64_t coinbaseSize =
+        ::GetSerializeSize(coinbaseTx, SER_NETWORK, PROTOCOL_VERSION);
+    if (coinbaseSize < MIN_TX_SIZE) {
+        coinbaseTx.vin[0].scriptSig
+            << std::vector<uint8_t>(MIN_TX_SIZE - coinbaseSize - 1, 0);
+    }
+
+    return MakeTransactionRef(std::move(coinbaseTx));
+}
+
 BlockAssembler::Options::Options()
     : nExcessiveBlockSize(DEFAULT_MAX_BLOCK_SIZE),
       nMaxGeneratedBlockSize(DEFAULT_MAX_GENERATED_BLOCK_SIZE),
@@ -178,24 +199,9 @@ BlockAssembler::CreateNewBlock(const CScript &scriptPubKeyIn) {
     nLastBlockSize = nBlockSize;
 
     // Create coinbase transaction.
-    CMutableTransaction coinbaseTx;
-    coinbaseTx.vin.resize(1);
-    coinbaseTx.vin[0].prevout = COutPoint();
-    coinbaseTx.vout.resize(1);
-    coinbaseTx.vout[0].scriptPubKey = scriptPubKeyIn;
-    coinbaseTx.vout[0].nValue =
-        nFees + GetBlockSubsidy(nHeight, chainparams.GetConsensus());
-    coinbaseTx.vin[0].scriptSig = CScript() << nHeight << OP_0;
-
-    // Make sure the coinbase is big enough.
-    uint64_t coinbaseSize =
-        ::GetSerializeSize(coinbaseTx, SER_NETWORK, PROTOCOL_VERSION);
-    if (coinbaseSize < MIN_TX_SIZE) {
-        coinbaseTx.vin[0].scriptSig
-            << std::vector<uint8_t>(MIN_TX_SIZE - coinbaseSize - 1, 0);
-    }
-
-    pblocktemplate->entries[0].tx = MakeTransactionRef(coinbaseTx);
+    pblocktemplate->entries[0].tx = CreateCoinbase(
+        scriptPubKeyIn, nHeight,
+        nFees + GetBlockSubsidy(nHeight, chainparams.GetConsensus()));
     // Note: For the Coinbase, the template entry fields aside from the `tx` are
     // not used anywhere at the time of writing.  The mining rpc throws out the
     // entire transaction in fact. The tx itself is only used during regtest
@@ -681,6 +687,239 @@ void BlockAssembler::addPriorityTxs() {
     }
 }
 
+std::unique_ptr<BlockTemplateCache> g_block_template_cache;
+
+BlockTemplateCache::BlockTemplateCache(const Config &config,
+                                       CTxMemPool &_mempool,
+                                       size_t nMaxJournalIn)
+    : chainparams(config.GetChainParams()), mempool(_mempool),
+      assembler(config, _mempool), pindexCandidate(nullptr),
+      nCandidateTime(0), nBlockSize(0), nBlockSigOps(0),
+      nFees(Amount::zero()), nHeight(0), nLockTimeCutoff(0),
+      nMedianTimePast(0), nMaxJournal(nMaxJournalIn) {
+    connAdded = mempool.NotifyEntryAdded.connect(std::bind(
+        &BlockTemplateCache::TransactionAdded, this, std::placeholders::_1));
+    connRemoved = mempool.NotifyEntryRemoved.connect(
+        std::bind(&BlockTemplateCache::TransactionRemoved, this,
+                  std::placeholders::_1, std::placeholders::_2));
+}
+
+void BlockTemplateCache::TransactionAdded(CTransactionRef tx) {
+    LOCK(cs);
+    if (!pindexCandidate) {
+        return;
+    }
+
+    // Nobody may be asking for templates anymore. Rather than pinning every
+    // transaction that goes through the mempool, give up on the candidate: the
+    // next request rebuilds it and additions are not journaled until then.
+    if (vAdded.size() >= nMaxJournal) {
+        pindexCandidate = nullptr;
+        vAdded.clear();
+        setRemoved.clear();
+        return;
+    }
+
+    vAdded.push_back(std::move(tx));
+}
+
+void BlockTemplateCache::TransactionRemoved(CTransactionRef tx,
+                                            MemPoolRemovalReason reason) {
+    LOCK(cs);
+    if (pindexCandidate && inCandidate.count(tx->GetId())) {
+        setRemoved.insert(tx->GetId());
+    }
+}
+
+void BlockTemplateCache::Invalidate() {
+    LOCK(cs);
+    pindexCandidate = nullptr;
+    vAdded.clear();
+    setRemoved.clear();
+}
+
+size_t BlockTemplateCache::size() const {
+    LOCK(cs);
+    return entries.empty() ? 0 : entries.size() - 1;
+}
+
+void BlockTemplateCache::Rebuild(const CBlockIndex *pindexPrev) {
+    // Make sure a failed rebuild is retried on the next request.
+    Invalidate();
+
+    // The coinbase is regenerated every time the template is served, so the
+    // script used here does not matter.
+    std::unique_ptr<CBlockTemplate> pblocktemplate =
+        assembler.CreateNewBlock(CScript() << OP_TRUE);
+
+    entries = std::move(pblocktemplate->entries);
+    header = pblocktemplate->block.GetBlockHeader();
+
+    // Same reservations for the coinbase as BlockAssembler::resetBlock.
+    nBlockSize = 1000;
+    nBlockSigOps = 100;
+    nFees = Amount::zero();
+    inCandidate.clear();
+    for (size_t i = 1; i < entries.size(); i++) {
+        const CBlockTemplateEntry &entry = entries[i];
+        inCandidate.insert(entry.tx->GetId());
+        nBlockSize += entry.txSize;
+        nBlockSigOps += entry.txSigOps;
+        nFees += entry.txFee;
+    }
+
+    nHeight = pindexPrev->nHeight + 1;
+    nMedianTimePast = pindexPrev->GetMedianTimePast();
+    nLockTimeCutoff =
+        (STANDARD_LOCKTIME_VERIFY_FLAGS & LOCKTIME_MEDIAN_TIME_PAST)
+            ? nMedianTimePast
+            : header.GetBlockTime();
+
+    nCandidateTime = GetTime();
+    pindexCandidate = pindexPrev;
+}
+
+bool BlockTemplateCache::TryAppend(CTxMemPool::txiter it) {
+    const CTransaction &tx = it->GetTx();
+    if (inCandidate.count(tx.GetId())) {
+        return false;
+    }
+
+    // All unconfirmed parents must already be in the candidate.
+    for (CTxMemPool::txiter parent : mempool.GetMemPoolParents(it)) {
+        if (!inCandidate.count(parent->GetTx().GetId())) {
+            return false;
+        }
+    }
+
+    if (it->GetModifiedFee() <
+        assembler.GetBlockMinFeeRate().GetFee(it->GetTxSize())) {
+        return false;
+    }
+
+    uint64_t nNewBlockSize = nBlockSize + it->GetTxSize();
+    if (nNewBlockSize >= assembler.GetMaxGeneratedBlockSize()) {
+        return false;
+    }
+
+    if (nBlockSigOps + it->GetSigOpCount() >=
+        GetMaxBlockSigOpsCount(nNewBlockSize)) {
+        return false;
+    }
+
+    CValidationState state;
+    if (!ContextualCheckTransaction(chainparams.GetConsensus(), tx, state,
+                                    nHeight, nLockTimeCutoff,
+                                    nMedianTimePast)) {
+        return false;
+    }
+
+    entries.emplace_back(it->GetSharedTx(), it->GetFee(), it->GetTxSize(),
+                         it->GetSigOpCount());
+    inCandidate.insert(tx.GetId());
+    nBlockSize = nNewBlockSize;
+    nBlockSigOps += it->GetSigOpCount();
+    nFees += it->GetFee();
+    return true;
+}
+
+void BlockTemplateCache::ApplyJournal() {
+    // Transactions leaving the mempool for any other reason than a block being
+    // connected take their in-mempool descendants with them, so dropping every
+    // removed transaction keeps the candidate free of orphans. Connected
+    // blocks change the tip and cause a full rebuild instead.
+    if (!setRemoved.empty()) {
+        auto itRemoved = std::remove_if(
+            entries.begin() + 1, entries.end(),
+            [this](const CBlockTemplateEntry &entry) {
+                if (!setRemoved.count(entry.tx->GetId())) {
+                    return false;
+                }
+
+                inCandidate.erase(entry.tx->GetId());
+                nBlockSize -= entry.txSize;
+                nBlockSigOps -= entry.txSigOps;
+                nFees -= entry.txFee;
+                return true;
+            });
+        entries.erase(itRemoved, entries.end());
+        setRemoved.clear();
+    }
+
+    // Transactions are appended in the order they entered the mempool, which
+    // is a valid topological order.
+    bool fAppended = false;
+    for (const CTransactionRef &tx : vAdded) {
+        CTxMemPool::txiter it = mempool.mapTx.find(tx->GetId());
+        if (it != mempool.mapTx.end() && TryAppend(it)) {
+            fAppended = true;
+        }
+    }
+    vAdded.clear();
+
+    if (fAppended &&
+        IsMagneticAnomalyEnabled(chainparams.GetConsensus(), pindexCandidate)) {
+        std::sort(std::begin(entries) + 1, std::end(entries),
+                  [](const CBlockTemplateEntry &a, const CBlockTemplateEntry &b)
+                      -> bool { return a.tx->GetId() < b.tx->GetId(); });
+    }
+}
+
+std::unique_ptr<CBlockTemplate>
+BlockTemplateCache::GetBlockTemplate(const CScript &scriptPubKeyIn) {
+    int64_t nTimeStart = GetTimeMicros();
+
+    LOCK2(cs_main, mempool.cs);
+    LOCK(cs);
+    const CBlockIndex *pindexPrev = chainActive.Tip();
+    assert(pindexPrev != nullptr);
+
+    bool fRebuild = pindexCandidate != pindexPrev ||
+                    GetTime() - nCandidateTime > BLOCK_TEMPLATE_CACHE_MAX_AGE;
+    if (fRebuild) {
+        Rebuild(pindexPrev);
+    } else {
+        ApplyJournal();
+    }
+
+    int64_t nTime1 = GetTimeMicros();
+
+    std::unique_ptr<CBlockTemplate> pblocktemplate(new CBlockTemplate());
+    pblocktemplate->entries = entries;
+
+    CBlockTemplateEntry &coinbase = pblocktemplate->entries[0];
+    coinbase.tx = CreateCoinbase(
+        scriptPubKeyIn, nHeight,
+        nFees + GetBlockSubsidy(nHeight, chainparams.GetConsensus()));
+    coinbase.txFee = -1 * nFees;
+    coinbase.txSigOps =
+        GetSigOpCountWithoutP2SH(*coinbase.tx, STANDARD_SCRIPT_VERIFY_FLAGS);
+
+    CBlock *pblock = &pblocktemplate->block;
+    pblock->nVersion = header.nVersion;
+    pblock->hashPrevBlock = header.hashPrevBlock;
+    pblock->nTime = header.nTime;
+    pblock->nBits = header.nBits;
+    pblock->nNonce = 0;
+    UpdateTime(pblock, chainparams.GetConsensus(), pindexPrev);
+
+    pblock->vtx.reserve(pblocktemplate->entries.size());
+    for (const CBlockTemplateEntry &entry : pblocktemplate->entries) {
+        pblock->vtx.push_back(entry.tx);
+    }
+
+    int64_t nTime2 = GetTimeMicros();
+
+    LogPrint(BCLog::BENCH,
+             "BlockTemplateCache: %s: %.2fms (%u txs), serve: %.2fms (total "
+             "%.2fms)\n",
+             fRebuild ? "rebuild" : "update", 0.001 * (nTime1 - nTimeStart),
+             entries.size() - 1, 0.001 * (nTime2 - nTime1),
+             0.001 * (nTime2 - nTimeStart));
+
+    return pblocktemplate;
+}
+
 static const std::vector<uint8_t>
 getExcessiveBlockSizeSig(uint64_t nExcessiveBlockSize) {
     std::string cbmsg = "/EB" + getSubVersionEB(nExcessiveBlockSize) + "/";
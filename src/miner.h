@@ -11,9 +11,12 @@
 
 #include <boost/multi_index/ordered_index.hpp>
 #include <boost/multi_index_container.hpp>
+#include <boost/signals2/connection.hpp>
 
 #include <cstdint>
 #include <memory>
+#include <unordered_set>
+#include <vector>
 
 class CBlockIndex;
 class CChainParams;
@@ -25,6 +28,17 @@ struct Params;
 }
 
 static const bool DEFAULT_PRINTPRIORITY = false;
+/**
+ * Maximum age in seconds of an incrementally maintained block template before
+ * it is rebuilt from scratch.
+ */
+static const int64_t BLOCK_TEMPLATE_CACHE_MAX_AGE = 30;
+/**
+ * Maximum number of mempool additions journaled between two block template
+ * requests. Past that, the journal is dropped and the next request rebuilds the
+ * candidate from scratch.
+ */
+static const size_t BLOCK_TEMPLATE_CACHE_MAX_JOURNAL = 10000;
 
 struct CBlockTemplateEntry {
     CTransactionRef tx;
@@ -181,6 +195,7 @@ public:
     CreateNewBlock(const CScript &scriptPubKeyIn);
 
     uint64_t GetMaxGeneratedBlockSize() const { return nMaxGeneratedBlockSize; }
+    CFeeRate GetBlockMinFeeRate() const { return blockMinFeeRate; }
 
 private:
     // utility functions
@@ -247,6 +262,81 @@ private:
         EXCLUSIVE_LOCKS_REQUIRED(mempool->cs);
 };
 
+/**
+ * Keeps a candidate block template alive between getblocktemplate calls.
+ *
+ * Mempool additions and removals are journaled as they happen (the mempool
+ * signals fire under mempool.cs, so the journal is always consistent with the
+ * mempool) and folded into the candidate on the next request. Removed
+ * transactions are dropped from the candidate, and added transactions are
+ * appended if all of their in-mempool parents are already part of it and they
+ * fit. A full BlockAssembler pass, including TestBlockValidity, is only done
+ * when the tip changes or the candidate becomes older than
+ * BLOCK_TEMPLATE_CACHE_MAX_AGE, as appended transactions are not selected by
+ * ancestor fee rate.
+ */
+class BlockTemplateCache {
+private:
+    mutable CCriticalSection cs;
+
+    const CChainParams &chainparams;
+    CTxMemPool &mempool;
+    BlockAssembler assembler;
+
+    // The candidate template, entries[0] being the coinbase placeholder.
+    std::vector<CBlockTemplateEntry> entries GUARDED_BY(cs);
+    std::unordered_set<uint256, SaltedTxidHasher> inCandidate GUARDED_BY(cs);
+    const CBlockIndex *pindexCandidate GUARDED_BY(cs);
+    CBlockHeader header GUARDED_BY(cs);
+    int64_t nCandidateTime GUARDED_BY(cs);
+    uint64_t nBlockSize GUARDED_BY(cs);
+    uint64_t nBlockSigOps GUARDED_BY(cs);
+    Amount nFees GUARDED_BY(cs);
+    int nHeight GUARDED_BY(cs);
+    int64_t nLockTimeCutoff GUARDED_BY(cs);
+    int64_t nMedianTimePast GUARDED_BY(cs);
+
+    // Mempool changes not yet folded into the candidate.
+    const size_t nMaxJournal;
+    std::vector<CTransactionRef> vAdded GUARDED_BY(cs);
+    std::unordered_set<uint256, SaltedTxidHasher> setRemoved GUARDED_BY(cs);
+
+    boost::signals2::scoped_connection connAdded;
+    boost::signals2::scoped_connection connRemoved;
+
+    void TransactionAdded(CTransactionRef tx);
+    void TransactionRemoved(CTransactionRef tx, MemPoolRemovalReason reason);
+
+    /** Rebuild the candidate from scratch using BlockAssembler. */
+    void Rebuild(const CBlockIndex *pindexPrev)
+        EXCLUSIVE_LOCKS_REQUIRED(cs_main, mempool.cs, cs);
+    /** Fold the journaled mempool changes into the candidate. */
+    void ApplyJournal() EXCLUSIVE_LOCKS_REQUIRED(cs_main, mempool.cs, cs);
+    /** Append a mempool transaction to the candidate if it fits. */
+    bool TryAppend(CTxMemPool::txiter it)
+        EXCLUSIVE_LOCKS_REQUIRED(mempool.cs, cs);
+
+public:
+    BlockTemplateCache(
+        const Config &config, CTxMemPool &mempool,
+        size_t nMaxJournalIn = BLOCK_TEMPLATE_CACHE_MAX_JOURNAL);
+
+    /**
+     * Return a block template with coinbase to scriptPubKeyIn built from the
+     * current candidate, updating or rebuilding the candidate first.
+     */
+    std::unique_ptr<CBlockTemplate>
+    GetBlockTemplate(const CScript &scriptPubKeyIn);
+
+    /** Force the next request to rebuild the candidate from scratch. */
+    void Invalidate();
+
+    /** Number of transactions in the candidate, excluding the coinbase. */
+    size_t size() const;
+};
+
+extern std::unique_ptr<BlockTemplateCache> g_block_template_cache;
+
 /** Modify the extranonce in a block */
 void IncrementExtraNonce(CBlock *pblock, const CBlockIndex *pindexPrev,
                          uint64_t nExcessiveBlockSize,
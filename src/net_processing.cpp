@@ -1397,6 +1397,16 @@ static void ProcessGetBlockData(const Config &config, CNode *pfrom,
         if (a_recent_block &&
             a_recent_block->GetHash() == pindex->GetBlockHash()) {
             pblock = a_recent_block;
+        } else if (inv.type == MSG_BLOCK) {
+            // The block is serialized the same way on disk and on the wire,
+            // so send the bytes from disk as they are.
+            CSerializedNetMsg msg;
+            msg.command = NetMsgType::BLOCK;
+            if (!ReadRawBlockFromDisk(msg.data, pindex,
+                                      config.GetChainParams().DiskMagic())) {
+                assert(!"cannot load block from disk");
+            }
+            connman->PushMessage(pfrom, std::move(msg));
         } else {
             // Send block from disk
             std::shared_ptr<CBlock> pblockRead = std::make_shared<CBlock>();
@@ -1405,7 +1415,7 @@ static void ProcessGetBlockData(const Config &config, CNode *pfrom,
             }
             pblock = pblockRead;
         }
-        if (inv.type == MSG_BLOCK) {
+        if (inv.type == MSG_BLOCK && pblock) {
             connman->PushMessage(pfrom,
                                  msgMaker.Make(NetMsgType::BLOCK, *pblock));
         } else if (inv.type == MSG_FILTERED_BLOCK) {
@@ -2544,6 +2554,18 @@ static bool ProcessMessage(const Config &config, CNode *pfrom,
         CInv inv(MSG_TX, tx.GetId());
         pfrom->AddInventoryKnown(inv);
 
+        // Verify the scripts before taking cs_main for the rest of the
+        // processing, so AcceptToMemoryPool only has to check the inputs are
+        // still available.
+        bool fAlreadyHave;
+        {
+            LOCK(cs_main);
+            fAlreadyHave = AlreadyHave(inv);
+        }
+        if (!fAlreadyHave) {
+            PreValidateTransaction(config, g_mempool, ptx);
+        }
+
         LOCK2(cs_main, g_cs_orphans);
 
         bool fMissingInputs = false;
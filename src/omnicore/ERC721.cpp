@@ -154,7 +154,7 @@ void CMPSPERC721Info::setWatermark(const uint256& watermark)
     batch.Delete(slKey);
     batch.Put(slKey, slValue);
 
-    leveldb::Status status = pdb->Write(syncoptions, &batch);
+    leveldb::Status status = Write(batch, true);
     if (!status.ok()) {
         PrintToLog("%s(): ERROR: failed to write watermark: %s\n", __func__, status.ToString());
     }
@@ -250,7 +250,7 @@ bool CMPSPERC721Info::popBlock(const uint256& block_hash){
     // clean up the iterator
     delete iter;
 
-    leveldb::Status status = pdb->Write(syncoptions, &commitBatch);
+    leveldb::Status status = Write(commitBatch, true);
     if (!status.ok()) {
         PrintToLog("%s(): ERROR: %s\n", __func__, status.ToString());
         return false;
@@ -259,7 +259,7 @@ bool CMPSPERC721Info::popBlock(const uint256& block_hash){
     return true;
 }
 
-bool CMPSPERC721Info::flush(const uint256& watermark){
+bool CMPSPERC721Info::flush(const uint256& watermark, bool fSync){
     // atomically write both the the SP and the index to the database
     leveldb::WriteBatch batch;
 
@@ -331,7 +331,7 @@ bool CMPSPERC721Info::flush(const uint256& watermark){
     batch.Delete(slKey);
     batch.Put(slKey, slValue);
 
-    leveldb::Status status = pdb->Write(syncoptions, &batch);
+    leveldb::Status status = Write(batch, fSync);
     if (!status.ok()) {
         PrintToLog("%s(): ERROR for fluash %s\n", __func__,  status.ToString());
         return false;
@@ -502,7 +502,7 @@ void ERC721TokenInfos::setWatermark(const uint256& watermark)
     batch.Delete(slKey);
     batch.Put(slKey, slValue);
 
-    leveldb::Status status = pdb->Write(syncoptions, &batch);
+    leveldb::Status status = Write(batch, true);
     if (!status.ok()) {
         PrintToLog("%s(): ERROR: failed to write watermark: %s\n", __func__, status.ToString());
     }
@@ -533,7 +533,7 @@ bool ERC721TokenInfos::getWatermark(uint256& watermark) const{
     return true;
 }
 
-bool ERC721TokenInfos::flush(const uint256& block_hash){
+bool ERC721TokenInfos::flush(const uint256& block_hash, bool fSync){
     leveldb::WriteBatch batch;
 
     for(auto propertyIter : cacheProperty){
@@ -609,7 +609,7 @@ bool ERC721TokenInfos::flush(const uint256& block_hash){
     batch.Delete(slKey);
     batch.Put(slKey, slValue);
 
-    leveldb::Status status = pdb->Write(syncoptions, &batch);
+    leveldb::Status status = Write(batch, fSync);
     if (!status.ok()) {
         PrintToLog("%s(): ERROR for flush %s\n", __func__,  status.ToString());
         return false;
@@ -682,7 +682,7 @@ bool ERC721TokenInfos::popBlock(const uint256& block_hash){
 
     delete iter;
 
-    leveldb::Status status = pdb->Write(syncoptions, &commitBatch);
+    leveldb::Status status = Write(commitBatch, true);
     if(!status.ok()){
         PrintToLog("%s(): ERROR: %s\n", __func__, status.ToString());
         return false;
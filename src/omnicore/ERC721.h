@@ -88,8 +88,8 @@ public:
     void setWatermark(const uint256& watermark);
 
     // Flush flush cacheMapPropertyInfo struct data with DIRTY flag to database.
-    // Then clear the cacheMapPropertyInfo struct.
-    bool flush(const uint256& watermark);
+    // Then clear the cacheMapPropertyInfo struct. The write is only synced to disk with fSync.
+    bool flush(const uint256& watermark, bool fSync);
 
     // Delete database data with the param block hash. Then rollback the latest information
     // and historical information of all properties to the previous status.
@@ -167,7 +167,8 @@ public:
     void setWatermark(const uint256& watermark);
 
     // Flush all tokens info of all property to the database. And write success will clear these cacheMap.
-    bool flush(const uint256& block_hash);
+    // The write is only synced to disk with fSync.
+    bool flush(const uint256& block_hash, bool fSync);
 
     // // Delete database data with the param block hash. Then rollback the latest information
     // and historical information of all properties's tokens to the previous status.
@@ -50,6 +50,7 @@
 #include "tinyformat.h"
 #include "uint256.h"
 #include "ui_interface.h"
+#include "undo.h"
 
 #include "util/strencodings.h"
 #include "util/time.h"
@@ -72,12 +73,14 @@
 #include <openssl/sha.h>
 
 #include "leveldb/db.h"
+#include "leveldb/write_batch.h"
 
 #include <assert.h>
 #include <stdint.h>
 #include <stdio.h>
 
 #include <fstream>
+#include <limits>
 #include <map>
 #include <set>
 #include <string>
@@ -138,12 +141,20 @@ static boost::filesystem::path MPPersistencePath;
 static int mastercoreInitialized = 0;
 
 static int reorgRecoveryMode = 0;
+
+//! Height of the block being processed, or of the last block processed, recorded with balance changes
+static int nTallyChangeHeight = 0;
+//! Balance changes up to this height are unknown, as the tally map was rebuilt
+static int nTallyRebuildHeight = 0;
+//! Whether the tally map was rebuilt, and the next block processed is not known yet
+static bool fTallyRebuilt = true;
 static int reorgRecoveryMaxHeight = 0;
 
 CMPTxList *mastercore::p_txlistdb;
 CMPTradeList *mastercore::t_tradelistdb;
 CMPSTOList *mastercore::s_stolistdb;
 COmniTransactionDB *mastercore::p_OmniTXDB;
+COmniPrevoutDB *mastercore::p_prevoutdb;
 COmniFeeCache *mastercore::p_feecache;
 COmniFeeHistory *mastercore::p_feehistory;
 
@@ -583,6 +594,7 @@ bool mastercore::update_tally_map(const std::string& who, uint32_t propertyId, i
 
     CMPTally& tally = my_it->second;
     bRet = tally.updateMoney(propertyId, amount, ttype);
+    if (bRet) tally.setLastChange(propertyId, nTallyChangeHeight);
 
     after = getMPbalance(who, propertyId, ttype);
     if (!bRet) {
@@ -596,6 +608,29 @@ bool mastercore::update_tally_map(const std::string& who, uint32_t propertyId, i
     return bRet;
 }
 
+/**
+ * Marks all balances as changed, when the tally map is rebuilt, for example after a reorganization.
+ */
+static void MarkTallyRebuilt()
+{
+    nTallyRebuildHeight = std::max(nTallyRebuildHeight, nTallyChangeHeight);
+    fTallyRebuilt = true;
+}
+
+int mastercore::GetTallyChangeHeight()
+{
+    LOCK(cs_tally);
+
+    return nTallyChangeHeight;
+}
+
+bool mastercore::IsTallyTrackedSince(int nHeight)
+{
+    LOCK(cs_tally);
+
+    return !fTallyRebuilt && nTallyRebuildHeight < nHeight;
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////
 //
 // some old TODOs
@@ -862,6 +897,12 @@ static bool FillTxInputCache(const CTransaction& tx)
                 ++nCacheMiss;
         }
 
+        Coin coinPrev;
+        if (p_prevoutdb->GetPrevout(txIn.prevout, coinPrev)) {
+            view.AddCoin(txIn.prevout, std::move(coinPrev), false);
+            continue;
+        }
+
         CTransactionRef txPrev;
         uint256 hashBlock;
         if (!GetTransaction(GetConfig(), txIn.prevout.GetTxId(), txPrev, hashBlock, true)) {
@@ -966,11 +1007,12 @@ static int parseTransaction(bool bRPConly, const CTransaction& wtx, int nBlock,
 
     // ### DATA POPULATION ### - save output addresses, values and scripts
     std::string strReference;
-    unsigned char single_pkt[MAX_PACKETS * PACKET_SIZE];
+    std::vector<unsigned char> single_pkt;
     unsigned int packet_size = 0;
     std::vector<std::string> script_data;
     std::vector<std::string> address_data;
     std::vector<int64_t> value_data;
+    std::vector<CTxDestination> dest_data;
 
     for (unsigned int n = 0; n < wtx.vout.size(); ++n) {
         txnouttype whichType;
@@ -985,13 +1027,14 @@ static int parseTransaction(bool bRPConly, const CTransaction& wtx, int nBlock,
             if (!(dest == ExodusAddress())) {
                 // saving for Class A processing or reference
                 GetScriptPushes(wtx.vout[n].scriptPubKey, script_data);
-		        std::string address = EncodeCashAddr(dest, params);
-                address_data.push_back(address);
+                dest_data.push_back(dest);
                 value_data.push_back(wtx.vout[n].nValue.GetSatoshis());
-                if (msc_debug_parser_data) PrintToLog("saving address_data #%d: %s:%s\n", n, address, ScriptToAsmStr(wtx.vout[n].scriptPubKey));
+                if (msc_debug_parser_data) PrintToLog("saving address_data #%d: %s:%s\n", n, EncodeCashAddr(dest, params), ScriptToAsmStr(wtx.vout[n].scriptPubKey));
             }
         }
     }
+    // encode the output addresses in one batch
+    address_data = EncodeCashAddrs(dest_data, params);
     if (msc_debug_parser_data) PrintToLog(" address_data.size=%lu\n script_data.size=%lu\n value_data.size=%lu\n", address_data.size(), script_data.size(), value_data.size());
 
     // CLASS C PARSING ###
@@ -1078,7 +1121,7 @@ static int parseTransaction(bool bRPConly, const CTransaction& wtx, int nBlock,
                         PrintToLog("limiting payload size to %d byte\n", packet_size + payload_size);
                     }
                     if (payload_size > 0) {
-                        memcpy(single_pkt+packet_size, &vch[0], payload_size);
+                        single_pkt.insert(single_pkt.end(), vch.begin(), vch.begin() + payload_size);
                         packet_size += payload_size;
                     }
                     if (MAX_PACKETS * PACKET_SIZE == packet_size) {
@@ -1090,8 +1133,8 @@ static int parseTransaction(bool bRPConly, const CTransaction& wtx, int nBlock,
     }
 
     // ### SET MP TX INFO ###
-    if (msc_debug_verbose) PrintToLog("single_pkt: %s\n", HexStr(single_pkt, packet_size + single_pkt));
-    mp_tx.Set(strSender, strReference, 0, wtx.GetHash(), nBlock, idx, (unsigned char *)&single_pkt, packet_size, omniClass, (inAll-outAll));
+    if (msc_debug_verbose) PrintToLog("single_pkt: %s\n", HexStr(single_pkt));
+    mp_tx.Set(strSender, strReference, 0, wtx.GetHash(), nBlock, idx, std::move(single_pkt), omniClass, (inAll-outAll));
 
     // extra iteration of the outputs for every transaction, not needed on mainnet after Exodus closed
     const CConsensusParams& omniParams = ConsensusParams();
@@ -1185,6 +1228,22 @@ public:
     }
 };
 
+/**
+ * Returns the height of the first block from nFirstBlock to the tip whose data was pruned, or
+ * -1, if all of them can be read.
+ */
+static int GetFirstPrunedBlock(int nFirstBlock)
+{
+    LOCK(cs_main);
+
+    if (!fHavePruned) return -1;
+
+    for (int nBlock = std::max(nFirstBlock, 0); nBlock <= chainActive.Height(); ++nBlock) {
+        if (!chainActive[nBlock]->nStatus.hasData()) return nBlock;
+    }
+    return -1;
+}
+
 /**
  * Scans the blockchain for meta transactions.
  *
@@ -1248,7 +1307,10 @@ static int msc_initial_scan(int nFirstBlock)
 
         if (!seedBlockFilterEnabled || !SkipBlock(nBlock)) {
             CBlock block;
-            if (!ReadBlockFromDisk(block, pblockindex, GetConfig().GetChainParams().GetConsensus())) break;
+            if (!ReadBlockFromDisk(block, pblockindex, GetConfig().GetChainParams().GetConsensus())) {
+                PrintToLog("ERROR: failed to read block %d (%s), the Omni state is incomplete\n", nBlock, strBlockHash);
+                break;
+            }
 		    for(CTransactionRef& tx : block.vtx){
                 if (mastercore_handler_tx(*(tx.get()), nBlock, nTxNum, pblockindex)) ++nTxsFoundInBlock;
                 ++nTxNum;
@@ -1535,6 +1597,7 @@ static int msc_file_load(const string &filename, int what, bool verifyHash = fal
   {
       case FILETYPE_BALANCES:
           mp_tally_map.clear();
+          MarkTallyRebuilt();
           inputLineFunc = input_msc_balances_string;
           break;
 
@@ -1641,6 +1704,34 @@ static char const * const statePrefix[NUM_FILETYPES] = {
     //"mdexorders",
 };
 
+/**
+ * Rolls an ERC721 store back to the SP watermark, if the store was flushed for the block after it.
+ *
+ * The ERC721 stores are synced before the SP watermark, so a crash in between leaves them one
+ * block ahead.
+ *
+ * @return True, if the store is at the SP watermark
+ */
+template <typename Store>
+static bool RollBackToWatermark(Store* store, const uint256& storeWatermark, CBlockIndex const *spBlockIndex)
+{
+  if (storeWatermark == spBlockIndex->GetBlockHash()) {
+    return true;
+  }
+
+  CBlockIndex const *storeBlockIndex = GetBlockIndex(storeWatermark);
+  if (NULL == storeBlockIndex || storeBlockIndex->pprev != spBlockIndex) {
+    return false;
+  }
+
+  PrintToLog("%s(): rolling back block %s\n", __func__, storeWatermark.GetHex());
+  if (!store->popBlock(storeWatermark)) {
+    return false;
+  }
+  store->setWatermark(spBlockIndex->GetBlockHash());
+  return true;
+}
+
 // returns the height of the state loaded
 static int load_most_relevant_state()
 {
@@ -1669,7 +1760,8 @@ static int load_most_relevant_state()
           return  -1;
       }
 
-      if (spWatermark != erc721tokenswatermark || spWatermark != erc721SPwatermark){
+      if (!RollBackToWatermark(my_erc721tokens, erc721tokenswatermark, spBlockIndex) ||
+          !RollBackToWatermark(my_erc721sps, erc721SPwatermark, spBlockIndex)) {
           return -1;
       }
   }
@@ -2052,6 +2144,7 @@ void clear_all_state()
 
     // Memory based storage
     mp_tally_map.clear();
+    MarkTallyRebuilt();
     my_offers.clear();
     my_accepts.clear();
     my_crowds.clear();
@@ -2149,6 +2242,7 @@ int mastercore_init()
     p_txlistdb = new CMPTxList(GetDataDir() / "MP_txlist", fReindex);
     _my_sps = new CMPSPInfo(GetDataDir() / "MP_spinfo", fReindex);
     p_OmniTXDB = new COmniTransactionDB(GetDataDir() / "Omni_TXDB", fReindex);
+    p_prevoutdb = new COmniPrevoutDB(GetDataDir() / "OMNI_prevouts", fReindex);
     p_feecache = new COmniFeeCache(GetDataDir() / "OMNI_feecache", fReindex);
     p_feehistory = new COmniFeeHistory(GetDataDir() / "OMNI_feehistory", fReindex);
     my_erc721sps = new CMPSPERC721Info(GetDataDir() / "OMNI_ERC721property", fReindex);
@@ -2197,6 +2291,15 @@ int mastercore_init()
     // advance the waterline so that we start on the next unaccounted for block
     nWaterlineBlock += 1;
 
+    // the initial scan reads every block from the waterline on, e.g. all of them since the
+    // Omni genesis block after -reindex, -startclean or a version change, so they must not be pruned
+    int nPrunedBlock = GetFirstPrunedBlock(nWaterlineBlock);
+    if (nPrunedBlock >= 0) {
+        PrintToLog("ERROR: the Omni state must be parsed from block %d, but block %d was pruned\n", nWaterlineBlock, nPrunedBlock);
+        PrintToConsole("ERROR: the Omni state must be parsed from block %d, but block %d was pruned\n", nWaterlineBlock, nPrunedBlock);
+        return -1;
+    }
+
     // collect the real Exodus balances available at the snapshot time
     // redundant? do we need to show it both pre-parse and post-parse?  if so let's label the printfs accordingly
     if (msc_debug_exo) {
@@ -2251,6 +2354,10 @@ int mastercore_shutdown()
         delete p_OmniTXDB;
         p_OmniTXDB = NULL;
     }
+    if (p_prevoutdb) {
+        delete p_prevoutdb;
+        p_prevoutdb = NULL;
+    }
     if (p_feecache) {
         delete p_feecache;
         p_feecache = NULL;
@@ -2270,6 +2377,34 @@ int mastercore_shutdown()
     return 0;
 }
 
+/**
+ * Records the outputs spent by a transaction of a block, as found in the undo data of the block.
+ *
+ * The undo data of the last block read is kept, as the transactions of a block are handled one
+ * after another.
+ */
+static void RecordPrevoutsFromUndo(const CTransaction& tx, unsigned int idx, const CBlockIndex* pBlockIndex)
+{
+    static uint256 hashUndoBlock;
+    static CBlockUndo blockUndo;
+
+    if (hashUndoBlock != pBlockIndex->GetBlockHash()) {
+        hashUndoBlock = pBlockIndex->GetBlockHash();
+        blockUndo.vtxundo.clear();
+        if (!pBlockIndex->nStatus.hasUndo() || !UndoReadFromDisk(blockUndo, pBlockIndex)) {
+            PrintToLog("%s(): no undo data for block %s\n", __func__, hashUndoBlock.GetHex());
+            blockUndo.vtxundo.clear();
+            return;
+        }
+    }
+
+    // the coinbase has no undo data
+    if (idx == 0 || idx > blockUndo.vtxundo.size()) {
+        return;
+    }
+    p_prevoutdb->RecordPrevouts(tx, blockUndo.vtxundo[idx - 1]);
+}
+
 /**
  * This handler is called for every new transaction that comes in (actually in block parsing loop).
  *
@@ -2293,6 +2428,12 @@ bool mastercore_handler_tx(const CTransaction& tx, int nBlock, unsigned int idx,
     if (nBlock < nWaterlineBlock) return false;
     int64_t nBlockTime = pBlockIndex->GetBlockTime();
 
+    // keep the outputs spent by candidate Omni transactions, which are needed to resolve the
+    // sender, once the block is pruned or without transaction index
+    if (!tx.IsCoinBase() && GetEncodingClass(tx, nBlock) == OMNI_CLASS_C) {
+        RecordPrevoutsFromUndo(tx, idx, pBlockIndex);
+    }
+
     CMPTransaction mp_obj;
     mp_obj.unlockLogic();
 
@@ -2489,151 +2630,280 @@ std::string COmniTransactionDB::FetchInvalidReason(const uint256& txid)
     return error_str(processingResult);
 }
 
-std::set<int> CMPTxList::GetSeedBlocks(int startHeight, int endHeight)
+void COmniPrevoutDB::RecordPrevouts(const CTransaction& tx, const CTxUndo& txundo)
 {
-    std::set<int> setSeedBlocks;
+    assert(pdb);
 
-    if (!pdb) return setSeedBlocks;
+    if (txundo.vprevout.size() != tx.vin.size()) {
+        PrintToLog("%s(): ERROR: undo data of %s does not match its inputs\n", __func__, tx.GetId().GetHex());
+        return;
+    }
 
-    Iterator* it = NewIterator();
+    leveldb::WriteBatch batch;
+    for (size_t i = 0; i < tx.vin.size(); ++i) {
+        CDataStream ssKey(SER_DISK, CLIENT_VERSION);
+        ssKey << tx.vin[i].prevout;
+        CDataStream ssValue(SER_DISK, CLIENT_VERSION);
+        ssValue << txundo.vprevout[i];
+        batch.Put(leveldb::Slice(&ssKey[0], ssKey.size()), leveldb::Slice(&ssValue[0], ssValue.size()));
+    }
 
-    for (it->SeekToFirst(); it->Valid(); it->Next()) {
-        std::string itData = it->value().ToString();
-        std::vector<std::string> vstr;
-        boost::split(vstr, itData, boost::is_any_of(":"), boost::token_compress_on);
-        if (4 != vstr.size()) continue; // unexpected number of tokens
-        int block = atoi(vstr[1]);
-        if (block >= startHeight && block <= endHeight) {
-            setSeedBlocks.insert(block);
-        }
+    leveldb::Status status = Write(batch, false);
+    if (!status.ok()) {
+        PrintToLog("%s(): ERROR for %s: %s\n", __func__, tx.GetId().GetHex(), status.ToString());
+        return;
+    }
+    nWritten += tx.vin.size();
+}
+
+bool COmniPrevoutDB::GetPrevout(const COutPoint& outpoint, Coin& coin)
+{
+    assert(pdb);
+
+    CDataStream ssKey(SER_DISK, CLIENT_VERSION);
+    ssKey << outpoint;
+    std::string strValue;
+    leveldb::Status status = pdb->Get(readoptions, leveldb::Slice(&ssKey[0], ssKey.size()), &strValue);
+    if (!status.ok()) {
+        return false;
     }
+    ++nRead;
 
+    try {
+        CDataStream ssValue(strValue.data(), strValue.data() + strValue.size(), SER_DISK, CLIENT_VERSION);
+        ssValue >> coin;
+    } catch (const std::exception& e) {
+        PrintToLog("%s(): ERROR for %s: %s\n", __func__, outpoint.GetTxId().GetHex(), e.what());
+        return false;
+    }
+    return true;
+}
+
+//! Prefix of the keys of the (type, height) index of the tx list
+static const std::string TXLIST_INDEX_PREFIX = "t";
+//! Key marking the tx list as fully indexed
+static const std::string TXLIST_INDEX_MARKER = "dbtypeindex";
+//! Length of the index key before the key of the record
+static const size_t TXLIST_INDEX_HEADER_LEN = 21;
+
+/** Returns whether a key of the tx list belongs to the index rather than to a record. */
+static bool IsTxListIndexKey(const Slice& skey)
+{
+    return skey.starts_with(TXLIST_INDEX_PREFIX) || skey == TXLIST_INDEX_MARKER;
+}
+
+/** Returns the index key of a record, or its start when the record key is empty. */
+static std::string TxListIndexKey(unsigned int type, int block, const std::string& key)
+{
+    return strprintf("%s%010u%010d%s", TXLIST_INDEX_PREFIX, type, std::max(block, 0), key);
+}
+
+/** Parses the validity, block and type of a record of the form "valid:block:type:value". */
+static bool ParseTxListValue(const std::string& value, bool& fValid, int& block, unsigned int& type)
+{
+    std::vector<std::string> vstr;
+    boost::split(vstr, value, boost::is_any_of(":"), token_compress_on);
+    if (4 != vstr.size()) return false;
+    fValid = atoi(vstr[0]) == 1;
+    block = atoi(vstr[1]);
+    type = strtoul(vstr[2].c_str(), NULL, 10);
+    return true;
+}
+
+/** Parses an index key, returns false once past the index. */
+static bool ParseTxListIndexKey(const Slice& skey, CMPTxListEntry& entry)
+{
+    if (!skey.starts_with(TXLIST_INDEX_PREFIX) || skey.size() < TXLIST_INDEX_HEADER_LEN) return false;
+    const std::string strKey = skey.ToString();
+    for (size_t i = TXLIST_INDEX_PREFIX.size(); i < TXLIST_INDEX_HEADER_LEN; ++i) {
+        if (strKey[i] < '0' || strKey[i] > '9') return false;
+    }
+    entry.type = strtoul(strKey.substr(1, 10).c_str(), NULL, 10);
+    entry.block = atoi(strKey.substr(11, 10));
+    entry.key = strKey.substr(TXLIST_INDEX_HEADER_LEN);
+    return true;
+}
+
+/**
+ * Writes a record of the form "valid:block:type:value" along with its index entry, which
+ * carries the same value. The entry of an overwritten record of another type or block is
+ * removed.
+ */
+Status CMPTxList::writeIndexedRecord(const std::string& key, const std::string& value)
+{
+    bool fValid;
+    int block;
+    unsigned int type;
+    leveldb::WriteBatch batch;
+    std::string strOldValue;
+    if (pdb->Get(readoptions, key, &strOldValue).ok() && ParseTxListValue(strOldValue, fValid, block, type)) {
+        batch.Delete(TxListIndexKey(type, block, key));
+    }
+    batch.Put(key, value);
+    if (ParseTxListValue(value, fValid, block, type)) {
+        batch.Put(TxListIndexKey(type, block, key), value);
+    }
+    return pdb->Write(writeoptions, &batch);
+}
+
+/**
+ * Indexes the records of a tx list written before the index existed, once.
+ */
+void CMPTxList::buildTypeIndex()
+{
+    std::string strValue;
+    if (pdb->Get(readoptions, TXLIST_INDEX_MARKER, &strValue).ok()) return;
+
+    leveldb::WriteBatch batch;
+    unsigned int n = 0;
+    Iterator* it = NewIterator();
+    for (it->SeekToFirst(); it->Valid(); it->Next()) {
+        if (IsTxListIndexKey(it->key())) continue;
+        bool fValid;
+        int block;
+        unsigned int type;
+        const std::string value = it->value().ToString();
+        if (!ParseTxListValue(value, fValid, block, type)) continue;
+        batch.Put(TxListIndexKey(type, block, it->key().ToString()), value);
+        ++n;
+    }
     delete it;
 
-    return setSeedBlocks;
+    batch.Put(TXLIST_INDEX_MARKER, "1");
+    Status status = pdb->Write(syncoptions, &batch);
+    PrintToLog("%s(): indexed %d tx list records: %s\n", __func__, n, status.ToString());
 }
 
-bool CMPTxList::CheckForFreezeTxs(int blockHeight)
+/**
+ * Returns the records of a type with a height in [startHeight, endHeight], by height.
+ */
+std::vector<CMPTxListEntry> CMPTxList::getIndexedRecords(unsigned int type, int startHeight, int endHeight)
 {
-    assert(pdb);
+    std::vector<CMPTxListEntry> entries;
+    if (!pdb) return entries;
+
+    CMPTxListEntry entry;
     Iterator* it = NewIterator();
-    const CConsensusParams& params = ConsensusParams();
+    for (it->Seek(TxListIndexKey(type, startHeight, "")); it->Valid(); it->Next()) {
+        if (!ParseTxListIndexKey(it->key(), entry) || entry.type != type || entry.block > endHeight) break;
+        entry.fValid = it->value().starts_with("1:");
+        entries.push_back(entry);
+    }
+    delete it;
 
-    for (it->SeekToFirst(); it->Valid(); it->Next()) {
-        std::string itData = it->value().ToString();
-        std::vector<std::string> vstr;
-        boost::split(vstr, itData, boost::is_any_of(":"), token_compress_on);
-        if (4 != vstr.size()) continue;
-        int block = atoi(vstr[1]);
-        if (block < blockHeight) continue;
-        if(block < params.WHC_FREEZENACTIVATE_BLOCK) continue;
-        uint16_t txtype = atoi(vstr[2]);
-        if (txtype == MSC_TYPE_FREEZE_PROPERTY_TOKENS || txtype == MSC_TYPE_UNFREEZE_PROPERTY_TOKENS) {
-            delete it;
-            return true;
-        }
-        if(txtype == MSC_TYPE_CREATE_PROPERTY_MANUAL)
-        {
-            uint256 txid = uint256S(it->key().ToString());
-            uint256 blockHash;
-            CTransactionRef wtx;
-            CMPTransaction mp_obj;
-            if (!GetTransaction(GetConfig(), TxId(const_cast<const uint256&>(txid)), wtx, blockHash, true)) {
-                PrintToLog("ERROR: While check for freeze transaction %s: tx in levelDB but does not exist.\n", txid.GetHex());
-                delete it;
-                return true;
-            }
-            if (0 != ParseTransaction(*(wtx.get()), block, 0, mp_obj)) {
-                PrintToLog("ERROR: While check for freeze transaction %s: failed ParseTransaction.\n", txid.GetHex());
-                delete it;
-                return true;
-            }
-            if (mp_obj.isFreezeEnable()) {
-                PrintToLog("ERROR: While check for freeze transaction %s: failed interpret_Transaction.\n", txid.GetHex());
-                delete it;
-                return true;
-            }
+    return entries;
+}
+
+/**
+ * Returns the records of all types with a height in [startHeight, endHeight], by type and
+ * height. Past the range of a type, the scan jumps to the range of the next one.
+ */
+std::vector<CMPTxListEntry> CMPTxList::getIndexedRecords(int startHeight, int endHeight)
+{
+    std::vector<CMPTxListEntry> entries;
+    if (!pdb) return entries;
+
+    CMPTxListEntry entry;
+    Iterator* it = NewIterator();
+    it->Seek(TxListIndexKey(0, startHeight, ""));
+    while (it->Valid() && ParseTxListIndexKey(it->key(), entry)) {
+        if (entry.block < startHeight) {
+            it->Seek(TxListIndexKey(entry.type, startHeight, ""));
+        } else if (entry.block > endHeight) {
+            if (entry.type == std::numeric_limits<unsigned int>::max()) break;
+            it->Seek(TxListIndexKey(entry.type + 1, startHeight, ""));
+        } else {
+            entry.fValid = it->value().starts_with("1:");
+            entries.push_back(entry);
+            it->Next();
         }
     }
     delete it;
-    return false;
+
+    return entries;
 }
 
-bool CMPTxList::CheckForFreezeTxsBelowBlock(int blockHeight)
+std::set<int> CMPTxList::GetSeedBlocks(int startHeight, int endHeight)
 {
-    assert(pdb);
-    Iterator* it = NewIterator();
-    const CConsensusParams& params = ConsensusParams();
+    std::set<int> setSeedBlocks;
 
-    for (it->SeekToFirst(); it->Valid(); it->Next()) {
-        std::string itData = it->value().ToString();
-        std::vector<std::string> vstr;
-        boost::split(vstr, itData, boost::is_any_of(":"), token_compress_on);
-        if (4 != vstr.size()) continue;
-        int block = atoi(vstr[1]);
-        if (block > blockHeight) continue;
-        if(block < params.WHC_FREEZENACTIVATE_BLOCK) continue;
-        uint16_t txtype = atoi(vstr[2]);
-        if (txtype == MSC_TYPE_FREEZE_PROPERTY_TOKENS || txtype == MSC_TYPE_UNFREEZE_PROPERTY_TOKENS) {
-            delete it;
+    for (const CMPTxListEntry& entry : getIndexedRecords(startHeight, endHeight)) {
+        setSeedBlocks.insert(entry.block);
+    }
+
+    return setSeedBlocks;
+}
+
+/**
+ * Checks for freeze transactions, or managed properties created with freezing enabled, in
+ * [startHeight, endHeight] from the activation of freezing on.
+ */
+bool CMPTxList::checkForFreezeTxsInRange(int startHeight, int endHeight)
+{
+    startHeight = std::max(startHeight, ConsensusParams().WHC_FREEZENACTIVATE_BLOCK);
+    if (startHeight > endHeight) return false;
+
+    if (!getIndexedRecords(MSC_TYPE_FREEZE_PROPERTY_TOKENS, startHeight, endHeight).empty() ||
+        !getIndexedRecords(MSC_TYPE_UNFREEZE_PROPERTY_TOKENS, startHeight, endHeight).empty()) {
+        return true;
+    }
+
+    for (const CMPTxListEntry& entry : getIndexedRecords(MSC_TYPE_CREATE_PROPERTY_MANUAL, startHeight, endHeight)) {
+        uint256 txid = uint256S(entry.key);
+        uint256 blockHash;
+        CTransactionRef wtx;
+        CMPTransaction mp_obj;
+        if (!GetTransaction(GetConfig(), TxId(const_cast<const uint256&>(txid)), wtx, blockHash, true)) {
+            PrintToLog("ERROR: While check for freeze transaction %s: tx in levelDB but does not exist.\n", txid.GetHex());
             return true;
         }
-        if(txtype == MSC_TYPE_CREATE_PROPERTY_MANUAL)
-        {
-            uint256 txid = uint256S(it->key().ToString());
-            uint256 blockHash;
-            CTransactionRef wtx;
-            CMPTransaction mp_obj;
-            if (!GetTransaction(GetConfig(), TxId(const_cast<const uint256&>(txid)), wtx, blockHash, true)) {
-                PrintToLog("ERROR: While check for freeze transaction %s: tx in levelDB but does not exist.\n", txid.GetHex());
-                delete it;
-                return true;
-            }
-            if (0 != ParseTransaction(*(wtx.get()), block, 0, mp_obj)) {
-                PrintToLog("ERROR: While check for freeze transaction %s: failed ParseTransaction.\n", txid.GetHex());
-                delete it;
-                return true;
-            }
-            if (mp_obj.isFreezeEnable()) {
-                PrintToLog("ERROR: While check for freeze transaction %s: failed interpret_Transaction.\n", txid.GetHex());
-                delete it;
-                return true;
-            }
+        if (0 != ParseTransaction(*(wtx.get()), entry.block, 0, mp_obj)) {
+            PrintToLog("ERROR: While check for freeze transaction %s: failed ParseTransaction.\n", txid.GetHex());
+            return true;
+        }
+        if (mp_obj.isFreezeEnable()) {
+            PrintToLog("ERROR: While check for freeze transaction %s: failed interpret_Transaction.\n", txid.GetHex());
+            return true;
         }
     }
-    delete it;
     return false;
 }
 
+bool CMPTxList::CheckForFreezeTxs(int blockHeight)
+{
+    assert(pdb);
+    return checkForFreezeTxsInRange(blockHeight, std::numeric_limits<int>::max());
+}
+
+bool CMPTxList::CheckForFreezeTxsBelowBlock(int blockHeight)
+{
+    assert(pdb);
+    return checkForFreezeTxsInRange(0, blockHeight);
+}
+
 bool CMPTxList::LoadFreezeState(int blockHeight)
 {
     assert(pdb);
     std::vector<std::pair<std::string, uint256> > loadOrder;
     const CConsensusParams& params = ConsensusParams();
-    Iterator* it = NewIterator();
     PrintToLog("Loading freeze state from levelDB\n");
 
-    for (it->SeekToFirst(); it->Valid(); it->Next()) {
-        std::string itData = it->value().ToString();
-        std::vector<std::string> vstr;
-        boost::split(vstr, itData, boost::is_any_of(":"), token_compress_on);
-        if (4 != vstr.size()) continue;
-        uint16_t txtype = atoi(vstr[2]);
-        /*
-         * if (txtype != MSC_TYPE_FREEZE_PROPERTY_TOKENS && txtype != MSC_TYPE_UNFREEZE_PROPERTY_TOKENS &&
-                txtype != MSC_TYPE_ENABLE_FREEZING && txtype != MSC_TYPE_DISABLE_FREEZING) continue;
-        */
-        if (txtype != MSC_TYPE_FREEZE_PROPERTY_TOKENS && txtype != MSC_TYPE_UNFREEZE_PROPERTY_TOKENS &&
-            txtype != MSC_TYPE_CREATE_PROPERTY_MANUAL) continue;
-        if (atoi(vstr[0]) != 1) continue; // invalid, ignore
-        uint256 txid = uint256S(it->key().ToString());
-        int txPosition = p_OmniTXDB->FetchTransactionPosition(txid);
-        std::string sortKey = strprintf("%06d%010d", atoi(vstr[1]), txPosition);
-        loadOrder.push_back(std::make_pair(sortKey, txid));
+    /*
+     * const uint16_t types[] = {MSC_TYPE_FREEZE_PROPERTY_TOKENS, MSC_TYPE_UNFREEZE_PROPERTY_TOKENS,
+     *                           MSC_TYPE_ENABLE_FREEZING, MSC_TYPE_DISABLE_FREEZING};
+     */
+    const uint16_t types[] = {MSC_TYPE_FREEZE_PROPERTY_TOKENS, MSC_TYPE_UNFREEZE_PROPERTY_TOKENS,
+                              MSC_TYPE_CREATE_PROPERTY_MANUAL};
+    for (uint16_t txtype : types) {
+        for (const CMPTxListEntry& entry : getIndexedRecords(txtype, 0, std::numeric_limits<int>::max())) {
+            if (!entry.fValid) continue; // invalid, ignore
+            uint256 txid = uint256S(entry.key);
+            int txPosition = p_OmniTXDB->FetchTransactionPosition(txid);
+            std::string sortKey = strprintf("%06d%010d", entry.block, txPosition);
+            loadOrder.push_back(std::make_pair(sortKey, txid));
+        }
     }
 
-    delete it;
-
     std::sort (loadOrder.begin(), loadOrder.end());
 
     for (std::vector<std::pair<std::string, uint256> >::iterator itOrder = loadOrder.begin(); itOrder != loadOrder.end(); ++itOrder) {
@@ -2688,21 +2958,13 @@ void CMPTxList::LoadActivations(int blockHeight)
 {
     if (!pdb) return;
 
-    Slice skey, svalue;
-    Iterator* it = NewIterator();
-
     PrintToLog("Loading feature activations from levelDB\n");
 
     std::vector<std::pair<int64_t, uint256> > loadOrder;
 
-    for (it->SeekToFirst(); it->Valid(); it->Next()) {
-        std::string itData = it->value().ToString();
-        std::vector<std::string> vstr;
-        boost::split(vstr, itData, boost::is_any_of(":"), token_compress_on);
-        if (4 != vstr.size()) continue; // unexpected number of tokens
-        if (atoi(vstr[2]) != OMNICORE_MESSAGE_TYPE_ACTIVATION || atoi(vstr[0]) != 1) continue; // we only care about valid activations
-        uint256 txid = uint256S(it->key().ToString());;
-        loadOrder.push_back(std::make_pair(atoi(vstr[1]), txid));
+    for (const CMPTxListEntry& entry : getIndexedRecords(OMNICORE_MESSAGE_TYPE_ACTIVATION, 0, std::numeric_limits<int>::max())) {
+        if (!entry.fValid) continue; // we only care about valid activations
+        loadOrder.push_back(std::make_pair(entry.block, uint256S(entry.key)));
     }
 
     std::sort (loadOrder.begin(), loadOrder.end());
@@ -2745,7 +3007,6 @@ void CMPTxList::LoadActivations(int blockHeight)
             continue;
         }
     }
-    delete it;
     CheckLiveActivations(blockHeight);
 
     // This alert never expires as long as custom activations are used
@@ -2758,19 +3019,12 @@ void CMPTxList::LoadActivations(int blockHeight)
 void CMPTxList::LoadAlerts(int blockHeight)
 {
     if (!pdb) return;
-    Slice skey, svalue;
-    Iterator* it = NewIterator();
 
     std::vector<std::pair<int64_t, uint256> > loadOrder;
 
-    for (it->SeekToFirst(); it->Valid(); it->Next()) {
-        std::string itData = it->value().ToString();
-        std::vector<std::string> vstr;
-        boost::split(vstr, itData, boost::is_any_of(":"), token_compress_on);
-        if (4 != vstr.size()) continue; // unexpected number of tokens
-        if (atoi(vstr[2]) != OMNICORE_MESSAGE_TYPE_ALERT || atoi(vstr[0]) != 1) continue; // not a valid alert
-        uint256 txid = uint256S(it->key().ToString());;
-        loadOrder.push_back(std::make_pair(atoi(vstr[1]), txid));
+    for (const CMPTxListEntry& entry : getIndexedRecords(OMNICORE_MESSAGE_TYPE_ALERT, 0, std::numeric_limits<int>::max())) {
+        if (!entry.fValid) continue; // not a valid alert
+        loadOrder.push_back(std::make_pair(entry.block, uint256S(entry.key)));
     }
 
     std::sort (loadOrder.begin(), loadOrder.end());
@@ -2808,7 +3062,6 @@ void CMPTxList::LoadAlerts(int blockHeight)
         }
     }
 
-    delete it;
     int64_t blockTime = 0;
     {
         LOCK(cs_main);
@@ -2832,6 +3085,7 @@ uint256 CMPTxList::findMetaDExCancel(const uint256 txid)
   for(it->SeekToFirst(); it->Valid(); it->Next())
   {
       skey = it->key();
+      if (IsTxListIndexKey(skey)) continue;
       svalue = it->value();
       string svalueStr = svalue.ToString();
       boost::split(vstr, svalueStr, boost::is_any_of(":"), token_compress_on);
@@ -2938,24 +3192,9 @@ int CMPTxList::getMPTransactionCountTotal()
 int CMPTxList::getMPTransactionCountBlock(int block)
 {
     int count = 0;
-    Slice skey, svalue;
-    Iterator* it = NewIterator();
-    for(it->SeekToFirst(); it->Valid(); it->Next())
-    {
-        skey = it->key();
-        svalue = it->value();
-        if (skey.ToString().length() == 64)
-        {
-            string strValue = svalue.ToString();
-            std::vector<std::string> vstr;
-            boost::split(vstr, strValue, boost::is_any_of(":"), token_compress_on);
-            if (4 == vstr.size())
-            {
-                if (atoi(vstr[1]) == block) { ++count; }
-            }
-        }
+    for (const CMPTxListEntry& entry : getIndexedRecords(block, block)) {
+        if (entry.key.length() == 64) { ++count; } //extra entries for cancels are more than 64 chars long
     }
-    delete it;
     return count;
 }
 
@@ -3046,7 +3285,7 @@ void CMPTxList::recordMetaDExCancelTX(const uint256 &txidMaster, const uint256 &
        PrintToLog("METADEXCANCELDEBUG : Writing master record %s(%s, valid=%s, block= %d, type= %d, number of affected transactions= %d)\n", __FUNCTION__, txidMaster.ToString(), fValid ? "YES":"NO", nBlock, type, refNumber);
        if (pdb)
        {
-           status = pdb->Put(writeoptions, key, value);
+           status = writeIndexedRecord(key, value);
            PrintToLog("METADEXCANCELDEBUG : %s(): %s, line %d, file: %s\n", __FUNCTION__, status.ToString(), __LINE__, __FILE__);
        }
 
@@ -3119,7 +3358,7 @@ void CMPTxList::recordPaymentTX(const uint256 &txid, bool fValid, int nBlock, un
        PrintToLog("DEXPAYDEBUG : Writing master record %s(%s, valid=%s, block= %d, type= %d, number of payments= %lu)\n", __FUNCTION__, txid.ToString(), fValid ? "YES":"NO", nBlock, type, numberOfPayments);
        if (pdb)
        {
-           status = pdb->Put(writeoptions, key, value);
+           status = writeIndexedRecord(key, value);
            PrintToLog("DEXPAYDEBUG : %s(): %s, line %d, file: %s\n", __FUNCTION__, status.ToString(), __LINE__, __FILE__);
        }
 
@@ -3153,7 +3392,7 @@ Status status;
 
   if (pdb)
   {
-    status = pdb->Put(writeoptions, key, value);
+    status = writeIndexedRecord(key, value);
     ++nWritten;
     if (msc_debug_txdb) PrintToLog("%s(): %s, line %d, file: %s\n", __FUNCTION__, status.ToString(), __LINE__, __FILE__);
   }
@@ -3202,6 +3441,7 @@ Slice skey, svalue;
   for(it->SeekToFirst(); it->Valid(); it->Next())
   {
     skey = it->key();
+    if (IsTxListIndexKey(skey)) continue;
     svalue = it->value();
     ++count;
     PrintToConsole("entry #%8d= %s:%s\n", count, skey.ToString(), svalue.ToString());
@@ -3226,6 +3466,8 @@ unsigned int n_found = 0;
   for(it->SeekToFirst(); it->Valid(); it->Next())
   {
     skey = it->key();
+    // index entries go along with their records
+    if (IsTxListIndexKey(skey)) continue;
     svalue = it->value();
 
     ++count;
@@ -3244,7 +3486,16 @@ unsigned int n_found = 0;
       {
         ++n_found;
         PrintToLog("%s() DELETING: %s=%s\n", __FUNCTION__, skey.ToString(), svalue.ToString());
-        if (bDeleteFound) pdb->Delete(writeoptions, skey);
+        if (bDeleteFound) {
+          leveldb::WriteBatch batch;
+          batch.Delete(skey);
+          bool fValid;
+          unsigned int type;
+          if (ParseTxListValue(strvalue, fValid, block, type)) {
+            batch.Delete(TxListIndexKey(type, block, skey.ToString()));
+          }
+          pdb->Write(writeoptions, &batch);
+        }
       }
     }
   }
@@ -3861,10 +4112,15 @@ bool mastercore::getValidMPTX(const uint256 &txid, int *block, unsigned int *typ
   return true;
 }
 
+//! Number of synced database writes when the current block was connected
+static unsigned int nSyncedWritesBlockBegin = 0;
+
 int mastercore_handler_block_begin(int nBlockPrev, CBlockIndex const * pBlockIndex)
 {
     LOCK(cs_tally);
 
+    nSyncedWritesBlockBegin = CDBBase::nSyncedWrites;
+
     if (reorgRecoveryMode > 0) {
         reorgRecoveryMode = 0; // clear reorgRecovery here as this is likely re-entrant
 
@@ -3904,6 +4160,13 @@ int mastercore_handler_block_begin(int nBlockPrev, CBlockIndex const * pBlockInd
         }
     }
 
+    // balance changes from here on are recorded with this block
+    if (fTallyRebuilt) {
+        nTallyRebuildHeight = std::max(nTallyRebuildHeight, pBlockIndex->nHeight);
+        fTallyRebuilt = false;
+    }
+    nTallyChangeHeight = pBlockIndex->nHeight;
+
     // handle any features that go live with this block
     //change_001
     //CheckLiveActivations(pBlockIndex->nHeight);
@@ -4027,16 +4290,24 @@ int mastercore_handler_block_end(int nBlockNow, CBlockIndex const * pBlockIndex,
             AbortNode(msg, msg);
         }
     } else {
-        // save out the state after this block
-        if (writePersistence(nBlockNow)) {
-            mastercore_save_state(pBlockIndex);
-        }
-        if(!my_erc721sps->flush(pBlockIndex->GetBlockHash())){
+        // the databases are only synced to disk when the state is persisted: the ERC721 stores
+        // first, then the SP watermark, which commits the block. A crash in between leaves the
+        // ERC721 stores one block ahead, and they are rolled back on startup.
+        bool fPersist = writePersistence(nBlockNow);
+        if(!my_erc721sps->flush(pBlockIndex->GetBlockHash(), fPersist)){
             return AbortNode("Failed to store data to database !", "Error: Failed to store ERC721 property Data !");
         }
-        if(!my_erc721tokens->flush(pBlockIndex->GetBlockHash())){
+        if(!my_erc721tokens->flush(pBlockIndex->GetBlockHash(), fPersist)){
             return AbortNode("Failed to store data to database !", "Error: Failed to store ERC721 Token Data !");
         }
+        // save out the state after this block
+        if (fPersist) {
+            mastercore_save_state(pBlockIndex);
+        }
+    }
+
+    if (msc_debug_persistence) {
+        PrintToLog("%s(): %u synced writes for block %d\n", __func__, CDBBase::nSyncedWrites - nSyncedWritesBlockBegin, nBlockNow);
     }
 
     return 0;
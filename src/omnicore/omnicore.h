@@ -216,6 +216,32 @@ public:
     std::string FetchInvalidReason(const uint256& txid);
 };
 
+/** LevelDB based storage for the outputs spent by Omni transactions, as coins.
+ *
+ * The coins are taken from the undo data of connected blocks, so the senders of Omni
+ * transactions can be resolved without the transaction index, and after the block files
+ * were pruned.
+ */
+class COmniPrevoutDB : public CDBBase
+{
+public:
+    COmniPrevoutDB(const boost::filesystem::path& path, bool fWipe)
+    {
+        leveldb::Status status = Open(path, fWipe);
+        PrintToConsole("Loading prevouts database: %s\n", status.ToString());
+    }
+
+    virtual ~COmniPrevoutDB()
+    {
+        if (msc_debug_persistence) PrintToLog("COmniPrevoutDB closed\n");
+    }
+
+    /** Stores the outputs spent by the inputs of a transaction. */
+    void RecordPrevouts(const CTransaction& tx, const CTxUndo& txundo);
+    /** Retrieves an output spent by an Omni transaction, with its height and coinbase flag. */
+    bool GetPrevout(const COutPoint& outpoint, Coin& coin);
+};
+
 /** LevelDB based storage for STO recipients.
  */
 class CMPSTOList : public CDBBase
@@ -269,15 +295,37 @@ public:
     int getMPTradeCountTotal();
 };
 
+/** A record of the tx list, as found through its (type, height) index.
+ */
+struct CMPTxListEntry
+{
+    //! Key of the record, the txid for the records of transactions
+    std::string key;
+    unsigned int type;
+    int block;
+    bool fValid;
+};
+
 /** LevelDB based storage for transactions, with txid as key and validity bit, and other data as value.
+ *
+ * The records of transactions are also indexed by type and height, under keys of the form
+ * "t<type><height><key>", so that the loaders only visit the few records they care about.
  */
 class CMPTxList : public CDBBase
 {
+private:
+    leveldb::Status writeIndexedRecord(const std::string& key, const std::string& value);
+    void buildTypeIndex();
+    std::vector<CMPTxListEntry> getIndexedRecords(unsigned int type, int startHeight, int endHeight);
+    std::vector<CMPTxListEntry> getIndexedRecords(int startHeight, int endHeight);
+    bool checkForFreezeTxsInRange(int startHeight, int endHeight);
+
 public:
     CMPTxList(const boost::filesystem::path& path, bool fWipe)
     {
         leveldb::Status status = Open(path, fWipe);
         PrintToConsole("Loading tx meta-info database: %s\n", status.ToString());
+        if (status.ok()) buildTypeIndex();
     }
 
     virtual ~CMPTxList()
@@ -357,6 +405,7 @@ extern CMPTxList *p_txlistdb;
 extern CMPTradeList *t_tradelistdb;
 extern CMPSTOList *s_stolistdb;
 extern COmniTransactionDB *p_OmniTXDB;
+extern COmniPrevoutDB *p_prevoutdb;
 //height, txid, address, amount
 extern std::multimap<int, std::pair<std::string, std::pair<std::string, int64_t> > > pendingCreateWHC;
 
@@ -396,6 +445,12 @@ bool getValidMPTX(const uint256 &txid, int *block = NULL, unsigned int *type = N
 
 bool update_tally_map(const std::string& who, uint32_t propertyId, int64_t amount, TallyType ttype);
 
+/** Returns the height of the block, with which balance changes are currently recorded. */
+int GetTallyChangeHeight();
+
+/** Returns true, if all balance changes at or after the given height were recorded. */
+bool IsTallyTrackedSince(int nHeight);
+
 std::string getTokenLabel(uint32_t propertyId);
 
 /**
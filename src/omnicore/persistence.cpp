@@ -55,6 +55,17 @@ void CDBBase::Clear()
             n, status.ToString(), (n > 0 ? (0.001 * nTime / n) : 0), 0.001 * nTime);
 }
 
+std::atomic<unsigned int> CDBBase::nSyncedWrites(0);
+
+/**
+ * Writes a batch to the database, flushing the database to disk if requested.
+ */
+leveldb::Status CDBBase::Write(leveldb::WriteBatch& batch, bool fSync)
+{
+    if (fSync) ++nSyncedWrites;
+    return pdb->Write(fSync ? syncoptions : writeoptions, &batch);
+}
+
 /**
  * Deinitializes and closes the database.
  */
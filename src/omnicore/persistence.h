@@ -8,6 +8,8 @@
 #include <assert.h>
 #include <stddef.h>
 
+#include <atomic>
+
 /** Base class for LevelDB based storage.
  */
 class CDBBase
@@ -86,7 +88,22 @@ protected:
      */
     void Close();
 
+    /**
+     * Writes a batch to the database.
+     *
+     * A synced write also flushes every earlier write to the database to disk, so the stores
+     * written while processing a block only sync once, when the block is committed.
+     *
+     * @param batch  The batch to write
+     * @param fSync  Whether to flush the database to disk
+     * @return A Status object, indicating success or failure
+     */
+    leveldb::Status Write(leveldb::WriteBatch& batch, bool fSync);
+
 public:
+    //! Number of synced writes, across all databases
+    static std::atomic<unsigned int> nSyncedWrites;
+
     /**
      * Deletes all entries of the database, and resets the counters.
      */
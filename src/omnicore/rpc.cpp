@@ -1010,6 +1010,93 @@ UniValue whc_getallbalancesforaddress(const Config &config, const JSONRPCRequest
     return response;
 }
 
+UniValue whc_getbalancesforaddresses(const Config &config, const JSONRPCRequest &request) {
+    if (request.fHelp || request.params.size() < 1 || request.params.size() > 3)
+        throw runtime_error(
+                "whc_getbalancesforaddresses [\"address\",...] ( [propertyid,...] changedsince )\n"
+                "\nReturns the token balances of a list of addresses.\n"
+                "\nArguments:\n"
+                "1. addresses            (array, required) the addresses\n"
+                "2. propertyids          (array, optional) only return the balances of these properties (default: all)\n"
+                "3. changedsince         (number, optional) only return the balances changed in this block or later (default: 0)\n"
+                "\nResult:\n"
+                "{\n"
+                "  \"height\" : n,                 (number) the height to use as changedsince, to poll for the next changes\n"
+                "  \"balances\" : [              (array of JSON objects)\n"
+                "    {\n"
+                "      \"address\" : \"address\",      (string) the address\n"
+                "      \"propertyid\" : n,           (number) the property identifier\n"
+                "      \"balance\" : \"n.nnnnnnnn\",   (string) the available balance of the address\n"
+                "      \"reserved\" : \"n.nnnnnnnn\"   (string) the amount reserved by sell offers and accepts\n"
+                "    },\n"
+                "    ...\n"
+                "  ]\n"
+                "}\n"
+                "\nBalances, which are zero, are only returned, when filtered by changedsince. All balances are returned,\n"
+                "if the state was rebuilt since the block, for example after a reorganization.\n"
+                "\nExamples:\n"
+                + HelpExampleCli("whc_getbalancesforaddresses", "\"[\\\"qqxyplcfuxnm9z4usma2wmnu4kw9mexeug580mc3lx\\\"]\" \"[1]\" 550000")
+                + HelpExampleRpc("whc_getbalancesforaddresses", "[\"qqxyplcfuxnm9z4usma2wmnu4kw9mexeug580mc3lx\"], [1], 550000")
+        );
+
+    std::vector<std::string> addresses = ParseAddresses(request.params[0]);
+
+    std::set<uint32_t> propertyIds;
+    if (request.params.size() > 1 && !request.params[1].isNull()) {
+        for (const UniValue& propertyId : request.params[1].get_array().getValues()) {
+            propertyIds.insert(ParsePropertyId(propertyId));
+        }
+    }
+
+    int nChangedSince = 0;
+    if (request.params.size() > 2 && !request.params[2].isNull()) {
+        nChangedSince = request.params[2].get_int();
+    }
+
+    UniValue balances(UniValue::VARR);
+
+    LOCK(cs_tally);
+
+    // without a filter, or if changes were not tracked since then, every balance is returned
+    const bool fAll = nChangedSince <= 0 || !IsTallyTrackedSince(nChangedSince);
+
+    for (const std::string& address : addresses) {
+        CMPTally *addressTally = getTally(address);
+        if (NULL == addressTally) {
+            continue;
+        }
+
+        addressTally->init();
+
+        uint32_t propertyId = 0;
+        while (0 != (propertyId = addressTally->next())) {
+            if (!propertyIds.empty() && propertyIds.count(propertyId) == 0) {
+                continue;
+            }
+            bool fChanged = addressTally->getLastChange(propertyId) >= nChangedSince;
+            if (!fAll && !fChanged) {
+                continue;
+            }
+
+            UniValue balanceObj(UniValue::VOBJ);
+            balanceObj.push_back(Pair("address", address));
+            balanceObj.push_back(Pair("propertyid", (uint64_t) propertyId));
+            bool nonEmptyBalance = BalanceToJSON(address, propertyId, balanceObj, getPropertyType(propertyId));
+
+            // a balance, which dropped to zero, is a change as well
+            if (nonEmptyBalance || (nChangedSince > 0 && fChanged)) {
+                balances.push_back(balanceObj);
+            }
+        }
+    }
+
+    UniValue response(UniValue::VOBJ);
+    response.push_back(Pair("height", GetTallyChangeHeight()));
+    response.push_back(Pair("balances", balances));
+
+    return response;
+}
+
 UniValue whc_getproperty(const Config &config, const JSONRPCRequest &request) {
     if (request.fHelp || request.params.size() != 1)
         throw runtime_error(
@@ -2784,6 +2871,7 @@ static const ContextFreeRPCCommand commands[] =
         {"omni layer (data retrieval)", "whc_listblocktransactions", &whc_listblocktransactions, {}},
         {"omni layer (data retrieval)", "whc_listpendingtransactions", &whc_listpendingtransactions, {}},
         {"omni layer (data retrieval)", "whc_getallbalancesforaddress", &whc_getallbalancesforaddress, {}},
+        {"omni layer (data retrieval)", "whc_getbalancesforaddresses", &whc_getbalancesforaddresses, {}},
         {"omni layer (data retrieval)", "whc_getcurrentconsensushash", &whc_getcurrentconsensushash, {}},
         {"omni layer (data retrieval)", "whc_getpayload", &whc_getpayload, {}},
         {"omni layer (data retrieval)", "whc_getseedblocks", &whc_getseedblocks, {}},
@@ -21,11 +21,23 @@
 #include <boost/lexical_cast.hpp>
 #include <boost/foreach.hpp>
 
+#include <algorithm>
 #include <string>
 #include <vector>
 
 using mastercore::StrToInt64;
 
+// a valid address differs from its canonical form only by case and the
+// optional prefix, so normalize the string instead of encoding it again
+static std::string NormalizeAddress(std::string address, const std::string& prefix)
+{
+    std::transform(address.begin(), address.end(), address.begin(), ::tolower);
+    if (address.compare(0, prefix.size() + 1, prefix + ":") != 0) {
+        address = prefix + ":" + address;
+    }
+    return address;
+}
+
 std::string ParseAddress(const UniValue& value)
 {
 	const CChainParams &param = GetConfig().GetChainParams();
@@ -35,7 +47,27 @@ std::string ParseAddress(const UniValue& value)
         throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Invalid address. Note: use cashAddress");
     }
 
-    return EncodeCashAddr(addr, param);
+    return NormalizeAddress(value.get_str(), param.CashAddrPrefix());
+}
+
+std::vector<std::string> ParseAddresses(const UniValue& value)
+{
+    const CChainParams &param = GetConfig().GetChainParams();
+    std::vector<std::string> addresses;
+    addresses.reserve(value.get_array().size());
+    for (const UniValue& address : value.get_array().getValues()) {
+        addresses.push_back(address.get_str());
+    }
+
+    // decode the addresses in one batch
+    std::vector<CTxDestination> dests = DecodeCashAddrs(addresses, param);
+    for (size_t i = 0; i < addresses.size(); ++i) {
+        if (dests[i] == CTxDestination(CNoDestination{})) {
+            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, strprintf("Invalid address: %s. Note: use cashAddress", addresses[i]));
+        }
+        addresses[i] = NormalizeAddress(addresses[i], param.CashAddrPrefix());
+    }
+    return addresses;
 }
 
 std::string ParseAddressOrEmpty(const UniValue& value)
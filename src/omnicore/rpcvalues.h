@@ -15,6 +15,8 @@ struct PrevTxsEntry;
 #define PRICE_PRECISION 8
 
 std::string ParseAddress(const UniValue& value);
+/** Parses an array of addresses, which are decoded in one batch. */
+std::vector<std::string> ParseAddresses(const UniValue& value);
 std::string ParseAddressOrEmpty(const UniValue& value);
 std::string ParseAddressOrWildcard(const UniValue& value);
 uint32_t ParsePropertyId(const UniValue& value);
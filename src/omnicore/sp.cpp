@@ -161,7 +161,7 @@ bool CMPSPInfo::updateSP(uint32_t propertyId, const Entry& info)
         batch.Put(slSpPrevKey, strSpPrevValue);
     }
     batch.Put(slSpKey, slSpValue);
-    leveldb::Status status = pdb->Write(syncoptions, &batch);
+    leveldb::Status status = Write(batch, false);
 
     if (!status.ok()) {
         PrintToLog("%s(): ERROR for SP %d: %s\n", __func__, propertyId, status.ToString());
@@ -190,7 +190,7 @@ void CMPSPInfo::initburnbch(){
     leveldb::WriteBatch batch;
     batch.Put(slSpKey, slSpValue);
 
-    leveldb::Status status = pdb->Write(syncoptions, &batch);
+    leveldb::Status status = Write(batch, true);
     if (!status.ok()) {
         PrintToLog("%s(): ERROR for SP %d: %s\n", __func__, OMNI_PROPERTY_WHC, status.ToString());
     }
@@ -248,7 +248,7 @@ uint32_t CMPSPInfo::putSP(uint8_t ecosystem, const Entry& info)
     batch.Put(slSpKey, slSpValue);
     batch.Put(slTxIndexKey, slTxValue);
 
-    leveldb::Status status = pdb->Write(syncoptions, &batch);
+    leveldb::Status status = Write(batch, false);
 
     if (!status.ok()) {
         PrintToLog("%s(): ERROR for SP %d: %s\n", __func__, propertyId, status.ToString());
@@ -396,7 +396,7 @@ int64_t CMPSPInfo::popBlock(const uint256& block_hash)
     // clean up the iterator
     delete iter;
 
-    leveldb::Status status = pdb->Write(syncoptions, &commitBatch);
+    leveldb::Status status = Write(commitBatch, true);
 
     if (!status.ok()) {
         PrintToLog("%s(): ERROR: %s\n", __func__, status.ToString());
@@ -422,7 +422,7 @@ void CMPSPInfo::setWatermark(const uint256& watermark)
     batch.Delete(slKey);
     batch.Put(slKey, slValue);
 
-    leveldb::Status status = pdb->Write(syncoptions, &batch);
+    leveldb::Status status = Write(batch, true);
     if (!status.ok()) {
         PrintToLog("%s(): ERROR: failed to write watermark: %s\n", __func__, status.ToString());
     }
@@ -166,6 +166,41 @@ int64_t CMPTally::getMoneyReserved(uint32_t propertyId) const
     return money;
 }
 
+/**
+ * Records the height of the block, in which a balance was changed.
+ *
+ * Changes outside of blocks, such as pending balances, are recorded with the
+ * height of the last block processed.
+ *
+ * @param propertyId  The identifier of the tally to update
+ * @param nBlock      The height of the block
+ */
+void CMPTally::setLastChange(uint32_t propertyId, int nBlock)
+{
+    TokenMap::iterator it = mp_token.find(propertyId);
+
+    if (it != mp_token.end()) {
+        it->second.lastChange = nBlock;
+    }
+}
+
+/**
+ * Returns the height of the block, in which a balance was last changed.
+ *
+ * @param propertyId  The identifier of the tally to lookup
+ * @return The height of the block, or 0, if there is no tally
+ */
+int CMPTally::getLastChange(uint32_t propertyId) const
+{
+    TokenMap::const_iterator it = mp_token.find(propertyId);
+
+    if (it != mp_token.end()) {
+        return it->second.lastChange;
+    }
+
+    return 0;
+}
+
 /**
  * Compares the tally with another tally and returns true, if they are equal.
  *
@@ -22,6 +22,8 @@ private:
     typedef struct balance_t{
         //change_101 modify value type to arith_uint256; because current WHC uint is 10 ** 18, int64_t is so s
         int64_t balance[TALLY_TYPE_COUNT];
+        //! Height of the block of the last change
+        int lastChange;
     } BalanceRecord;
 
     //! Map of balance records
@@ -53,6 +55,12 @@ public:
     /** Returns the number of reserved tokens. */
     int64_t getMoneyReserved(uint32_t propertyId) const;
 
+    /** Records the height of the block, in which a balance was changed. */
+    void setLastChange(uint32_t propertyId, int nBlock);
+
+    /** Returns the height of the block, in which a balance was last changed. */
+    int getLastChange(uint32_t propertyId) const;
+
     /** Compares the tally with another tally and returns true, if they are equal. */
     bool operator==(const CMPTally& rhs) const;
 
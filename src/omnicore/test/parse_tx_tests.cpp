@@ -1,12 +1,40 @@
 #include "test/test_bitcoin.h"
 
 #include "util/strencodings.h"
+#include "omnicore/createpayload.h"
 #include "omnicore/tx.h"
 
 #include <boost/test/unit_test.hpp>
 
+#include <algorithm>
+#include <string>
+#include <vector>
+
 using namespace mastercore;
 
+namespace
+{
+/**
+ * Sets the first size bytes of the payload. The bytes past them are left in the
+ * storage of the vector, and must not be seen by the parser.
+ */
+void SetTruncated(CMPTransaction& mp_obj, const std::vector<unsigned char>& payload, size_t size)
+{
+    std::vector<unsigned char> truncated(payload);
+    truncated.insert(truncated.end(), 2 * CMPTransaction::PAYLOAD_PADDING, 'x');
+    truncated.resize(size);
+    mp_obj.SetNull();
+    mp_obj.Set("", "", 0, uint256(), 0, 0, std::move(truncated), 3, 0);
+}
+
+/** Returns a string field starting at offset, as seen in a payload truncated to size bytes. */
+std::string TruncatedField(const std::string& field, size_t offset, size_t size)
+{
+    if (size <= offset) return "";
+    return field.substr(0, std::min(field.size(), size - offset));
+}
+}
+
 BOOST_FIXTURE_TEST_SUITE(parse_tx_tests, BasicTestingSetup)
 
 BOOST_AUTO_TEST_CASE(parse_erc721)
@@ -64,4 +92,73 @@ BOOST_AUTO_TEST_CASE(parse_erc721)
 
 }
 
+BOOST_AUTO_TEST_CASE(parse_truncated_string_fields)
+{
+    const std::string category = "Test Category";
+    const std::string subcategory = "Test Subcategory";
+    const std::string name = "Test Token";
+    const std::string url = "http://www.example.com";
+    const std::string data = "Test data";
+
+    // Strings start after version, type, ecosystem, property type and previous property id
+    std::vector<size_t> offsets(1, 11);
+    offsets.push_back(offsets.back() + category.size() + 1);
+    offsets.push_back(offsets.back() + subcategory.size() + 1);
+    offsets.push_back(offsets.back() + name.size() + 1);
+    offsets.push_back(offsets.back() + url.size() + 1);
+    const size_t valueOffset = offsets.back() + data.size() + 1;
+
+    CMPTransaction mp_obj;
+
+    std::vector<unsigned char> fixed = CreatePayload_IssuanceFixed(1, 1, 0, category, subcategory, name, url, data, 1000000);
+    BOOST_REQUIRE_EQUAL(fixed.size(), valueOffset + 8);
+    for (size_t size = 0; size <= fixed.size(); ++size) {
+        SetTruncated(mp_obj, fixed, size);
+        BOOST_CHECK_EQUAL(mp_obj.getPayloadSize(), (int) size);
+        BOOST_CHECK_EQUAL(mp_obj.interpret_Transaction(), size == fixed.size());
+        // shorter payloads are rejected before any field is read
+        if (size < 25) continue;
+        BOOST_CHECK_EQUAL(mp_obj.getSPCategory(), TruncatedField(category, offsets[0], size));
+        BOOST_CHECK_EQUAL(mp_obj.getSPSubCategory(), TruncatedField(subcategory, offsets[1], size));
+        BOOST_CHECK_EQUAL(mp_obj.getSPName(), TruncatedField(name, offsets[2], size));
+        BOOST_CHECK_EQUAL(mp_obj.getSPUrl(), TruncatedField(url, offsets[3], size));
+        BOOST_CHECK_EQUAL(mp_obj.getSPData(), TruncatedField(data, offsets[4], size));
+        if (size <= valueOffset) {
+            BOOST_CHECK_EQUAL(mp_obj.getAmount(), 0U);
+        }
+    }
+
+    std::vector<unsigned char> variable = CreatePayload_IssuanceVariable(1, 1, 0, category, subcategory, name, url, data, 1, 100, 1893456000, 10, 0, 1000000);
+    BOOST_REQUIRE_EQUAL(variable.size(), valueOffset + 30);
+    for (size_t size = 0; size <= variable.size(); ++size) {
+        SetTruncated(mp_obj, variable, size);
+        bool fValid = mp_obj.interpret_Transaction();
+        // The total number of tokens is read after the end of the payload is checked
+        if (size < variable.size() - 8) BOOST_CHECK(!fValid);
+        if (size == variable.size()) BOOST_CHECK(fValid);
+        if (size < 47) continue;
+        BOOST_CHECK_EQUAL(mp_obj.getSPCategory(), TruncatedField(category, offsets[0], size));
+        BOOST_CHECK_EQUAL(mp_obj.getSPSubCategory(), TruncatedField(subcategory, offsets[1], size));
+        BOOST_CHECK_EQUAL(mp_obj.getSPName(), TruncatedField(name, offsets[2], size));
+        BOOST_CHECK_EQUAL(mp_obj.getSPUrl(), TruncatedField(url, offsets[3], size));
+        BOOST_CHECK_EQUAL(mp_obj.getSPData(), TruncatedField(data, offsets[4], size));
+        if (size <= valueOffset) {
+            BOOST_CHECK_EQUAL(mp_obj.getProperty(), 0U);
+            BOOST_CHECK_EQUAL(mp_obj.getAmount(), 0U);
+            BOOST_CHECK_EQUAL(mp_obj.getDeadline(), 0);
+            BOOST_CHECK_EQUAL(mp_obj.getEarlyBirdBonus(), 0);
+            BOOST_CHECK_EQUAL(mp_obj.getTotalNumber(), 0U);
+        }
+    }
+
+    std::vector<unsigned char> erc721 = CreatePayload_IssueERC721Property(name, "TT", data, url, 1000);
+    for (size_t size = 0; size <= erc721.size(); ++size) {
+        SetTruncated(mp_obj, erc721, size);
+        bool fValid = mp_obj.interpret_Transaction();
+        // The number of tokens is read after the end of the payload is checked
+        if (size < erc721.size() - 8) BOOST_CHECK(!fValid);
+        if (size == erc721.size()) BOOST_CHECK(fValid);
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
\ No newline at end of file
@@ -0,0 +1,92 @@
+#include "omnicore/omnicore.h"
+
+#include "coins.h"
+#include "primitives/transaction.h"
+#include "random.h"
+#include "script/script.h"
+#include "test/test_bitcoin.h"
+#include "undo.h"
+
+#include <boost/filesystem/path.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <stdint.h>
+
+using namespace mastercore;
+
+namespace
+{
+CScript RandomScript()
+{
+    CScript script;
+    script << OP_DUP << OP_HASH160 << ToByteVector(InsecureRand256()) << OP_EQUALVERIFY << OP_CHECKSIG;
+    return script;
+}
+
+/** Creates a transaction spending some outputs, and the undo data of its inputs. */
+CTransaction SpendCoins(const std::vector<Coin>& coins, CTxUndo& txundo)
+{
+    CMutableTransaction mtx;
+    txundo.vprevout.clear();
+    for (const Coin& coin : coins) {
+        mtx.vin.push_back(CTxIn(COutPoint(TxId(InsecureRand256()), InsecureRandRange(10))));
+        txundo.vprevout.push_back(coin);
+    }
+    mtx.vout.push_back(CTxOut(Amount::zero(), CScript() << OP_RETURN));
+    return CTransaction(mtx);
+}
+}
+
+BOOST_FIXTURE_TEST_SUITE(omnicore_prevout_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(record_and_get_prevouts)
+{
+    boost::filesystem::path path = SetDataDir("omni_prevouts") / "OMNI_prevouts";
+
+    std::vector<Coin> coins;
+    coins.push_back(Coin(CTxOut(50 * COIN, RandomScript()), 5, true));
+    coins.push_back(Coin(CTxOut(1234 * SATOSHI, RandomScript()), 650000, false));
+    coins.push_back(Coin(CTxOut(Amount::zero(), CScript() << OP_TRUE), 0, false));
+
+    CTxUndo txundo;
+    CTransaction tx = SpendCoins(coins, txundo);
+
+    {
+        COmniPrevoutDB db(path, true);
+        db.RecordPrevouts(tx, txundo);
+    }
+
+    // The coins survive a restart, with their height and coinbase flag
+    COmniPrevoutDB db(path, false);
+    for (size_t i = 0; i < coins.size(); ++i) {
+        Coin coin;
+        BOOST_CHECK(db.GetPrevout(tx.vin[i].prevout, coin));
+        BOOST_CHECK(coin.GetTxOut() == coins[i].GetTxOut());
+        BOOST_CHECK_EQUAL(coin.GetHeight(), coins[i].GetHeight());
+        BOOST_CHECK_EQUAL(coin.IsCoinBase(), coins[i].IsCoinBase());
+    }
+
+    Coin coin;
+    BOOST_CHECK(!db.GetPrevout(COutPoint(TxId(InsecureRand256()), 0), coin));
+    BOOST_CHECK(!db.GetPrevout(COutPoint(tx.vin[0].prevout.GetTxId(), tx.vin[0].prevout.GetN() + 1), coin));
+}
+
+BOOST_AUTO_TEST_CASE(mismatching_undo_data)
+{
+    COmniPrevoutDB db(SetDataDir("omni_prevouts_mismatch") / "OMNI_prevouts", true);
+
+    std::vector<Coin> coins;
+    coins.push_back(Coin(CTxOut(COIN, RandomScript()), 100, false));
+    coins.push_back(Coin(CTxOut(2 * COIN, RandomScript()), 101, false));
+
+    CTxUndo txundo;
+    CTransaction tx = SpendCoins(coins, txundo);
+    txundo.vprevout.pop_back();
+    db.RecordPrevouts(tx, txundo);
+
+    Coin coin;
+    BOOST_CHECK(!db.GetPrevout(tx.vin[0].prevout, coin));
+    BOOST_CHECK(!db.GetPrevout(tx.vin[1].prevout, coin));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
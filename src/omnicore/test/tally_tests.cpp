@@ -319,5 +319,32 @@ BOOST_AUTO_TEST_CASE(tally_overflow)
     BOOST_CHECK_EQUAL(tally.getMoneyReserved(3), int64_t(9223372036854775807LL));
 }
 
+BOOST_AUTO_TEST_CASE(tally_last_change)
+{
+    CMPTally tally;
+    BOOST_CHECK_EQUAL(tally.getLastChange(1), 0);
+
+    // only existing balances are stamped
+    tally.setLastChange(1, 100);
+    BOOST_CHECK_EQUAL(tally.getLastChange(1), 0);
+
+    BOOST_CHECK(tally.updateMoney(1, 5, BALANCE));
+    BOOST_CHECK_EQUAL(tally.getLastChange(1), 0);
+    tally.setLastChange(1, 100);
+    BOOST_CHECK_EQUAL(tally.getLastChange(1), 100);
+    BOOST_CHECK_EQUAL(tally.getLastChange(2), 0);
+
+    BOOST_CHECK(tally.updateMoney(2, 7, PENDING));
+    tally.setLastChange(2, 101);
+    BOOST_CHECK_EQUAL(tally.getLastChange(1), 100);
+    BOOST_CHECK_EQUAL(tally.getLastChange(2), 101);
+
+    // the stamp is not part of the balance
+    CMPTally other;
+    BOOST_CHECK(other.updateMoney(1, 5, BALANCE));
+    BOOST_CHECK(other.updateMoney(2, 7, PENDING));
+    BOOST_CHECK(tally == other);
+}
+
 
 BOOST_AUTO_TEST_SUITE_END()
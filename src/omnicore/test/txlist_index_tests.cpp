@@ -0,0 +1,165 @@
+#include "omnicore/omnicore.h"
+
+#include "random.h"
+#include "test/test_bitcoin.h"
+#include "uint256.h"
+
+#include "leveldb/db.h"
+
+#include <boost/filesystem/operations.hpp>
+#include <boost/filesystem/path.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <stdint.h>
+#include <map>
+#include <set>
+#include <string>
+
+using namespace mastercore;
+
+namespace
+{
+/** Opens a tx list in a fresh data directory, which also serves as p_txlistdb. */
+struct TxListTestingSetup : public BasicTestingSetup
+{
+    boost::filesystem::path path;
+    CMPTxList* txlist;
+    CMPTxList* prev_txlistdb;
+
+    TxListTestingSetup() : path(SetDataDir("txlist_index") / "MP_txlist"), txlist(NULL), prev_txlistdb(p_txlistdb)
+    {
+        Reopen(true);
+    }
+
+    ~TxListTestingSetup()
+    {
+        p_txlistdb = prev_txlistdb;
+        delete txlist;
+    }
+
+    void Reopen(bool fWipe)
+    {
+        delete txlist;
+        txlist = new CMPTxList(path, fWipe);
+        p_txlistdb = txlist;
+    }
+
+    void Close()
+    {
+        p_txlistdb = prev_txlistdb;
+        delete txlist;
+        txlist = NULL;
+    }
+};
+
+const unsigned int TYPES[] = {0, 3, 50, 185, 65534, 99992104};
+
+uint256 RandomTxid()
+{
+    return InsecureRand256();
+}
+}
+
+BOOST_FIXTURE_TEST_SUITE(omnicore_txlist_index_tests, TxListTestingSetup)
+
+BOOST_AUTO_TEST_CASE(index_matches_full_scan)
+{
+    std::map<int, int> mapTxCount;
+    for (int i = 0; i < 200; ++i) {
+        int block = InsecureRandRange(100);
+        unsigned int type = TYPES[InsecureRandRange(sizeof(TYPES) / sizeof(TYPES[0]))];
+        txlist->recordTX(RandomTxid(), InsecureRandBool(), block, type, InsecureRandRange(1000));
+        ++mapTxCount[block];
+    }
+
+    // A transaction moved to another block leaves no index entry behind
+    uint256 txidMoved = RandomTxid();
+    txlist->recordTX(txidMoved, true, 100, 0, 1);
+    txlist->recordTX(txidMoved, true, 101, 0, 1);
+    ++mapTxCount[101];
+
+    // Cancel records are seeds, but not counted as transactions. The full scan takes the
+    // property of the sub record for a height, so it's kept out of the range checked.
+    txlist->recordMetaDExCancelTX(RandomTxid(), RandomTxid(), true, 102, 1000, 5);
+
+    BOOST_CHECK_EQUAL(txlist->getMPTransactionCountTotal(), 201);
+
+    for (int block = 0; block < 105; ++block) {
+        std::set<int> setSeedBlocks = txlist->GetSeedBlocks(block, block);
+        bool fScanned = txlist->isMPinBlockRange(block, block, false);
+        BOOST_CHECK_EQUAL(fScanned, setSeedBlocks.count(block) == 1);
+        BOOST_CHECK_EQUAL(fScanned, mapTxCount.count(block) == 1 || block == 102);
+        BOOST_CHECK_EQUAL(txlist->getMPTransactionCountBlock(block), mapTxCount.count(block) ? mapTxCount[block] : 0);
+    }
+
+    std::set<int> setSeedBlocks = txlist->GetSeedBlocks(10, 20);
+    BOOST_CHECK(!setSeedBlocks.empty());
+    BOOST_CHECK(*setSeedBlocks.begin() >= 10);
+    BOOST_CHECK(*setSeedBlocks.rbegin() <= 20);
+    BOOST_CHECK(txlist->GetSeedBlocks(100, 100).empty());
+}
+
+BOOST_AUTO_TEST_CASE(legacy_database_backfill)
+{
+    Close();
+    boost::filesystem::remove_all(path);
+
+    // Records written before the index existed
+    std::map<int, int> mapTxCount;
+    {
+        leveldb::DB* pdb = NULL;
+        leveldb::Options options;
+        options.create_if_missing = true;
+        BOOST_REQUIRE(leveldb::DB::Open(options, path.string(), &pdb).ok());
+        for (int i = 0; i < 50; ++i) {
+            int block = 1000 + InsecureRandRange(20);
+            unsigned int type = TYPES[InsecureRandRange(sizeof(TYPES) / sizeof(TYPES[0]))];
+            std::string value = strprintf("%u:%d:%u:%lu", 1, block, type, 7);
+            BOOST_REQUIRE(pdb->Put(leveldb::WriteOptions(), RandomTxid().ToString(), value).ok());
+            ++mapTxCount[block];
+        }
+        delete pdb;
+    }
+
+    for (int pass = 0; pass < 2; ++pass) {
+        Reopen(false);
+        BOOST_CHECK_EQUAL(txlist->getMPTransactionCountTotal(), 50);
+        std::set<int> setSeedBlocks = txlist->GetSeedBlocks(0, 2000);
+        BOOST_CHECK_EQUAL(setSeedBlocks.size(), mapTxCount.size());
+        for (std::map<int, int>::const_iterator it = mapTxCount.begin(); it != mapTxCount.end(); ++it) {
+            BOOST_CHECK(setSeedBlocks.count(it->first));
+            BOOST_CHECK_EQUAL(txlist->getMPTransactionCountBlock(it->first), it->second);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(block_range_deletion)
+{
+    for (int block = 10; block < 20; ++block) {
+        txlist->recordTX(RandomTxid(), true, block, TYPES[block % 6], 1);
+        txlist->recordTX(RandomTxid(), false, block, TYPES[(block + 1) % 6], 2);
+    }
+    BOOST_CHECK_EQUAL(txlist->getMPTransactionCountTotal(), 20);
+
+    BOOST_CHECK(txlist->isMPinBlockRange(15, 30, true));
+    BOOST_CHECK(!txlist->isMPinBlockRange(15, 30, false));
+    BOOST_CHECK_EQUAL(txlist->getMPTransactionCountTotal(), 10);
+
+    std::set<int> setSeedBlocks = txlist->GetSeedBlocks(0, 100);
+    BOOST_CHECK_EQUAL(setSeedBlocks.size(), 5U);
+    BOOST_CHECK(setSeedBlocks.count(14));
+    BOOST_CHECK(!setSeedBlocks.count(15));
+    for (int block = 15; block < 20; ++block) {
+        BOOST_CHECK_EQUAL(txlist->getMPTransactionCountBlock(block), 0);
+    }
+    for (int block = 10; block < 15; ++block) {
+        BOOST_CHECK_EQUAL(txlist->getMPTransactionCountBlock(block), 2);
+    }
+
+    // The blocks can be processed again after the deletion
+    txlist->recordTX(RandomTxid(), true, 15, 0, 1);
+    BOOST_CHECK_EQUAL(txlist->getMPTransactionCountBlock(15), 1);
+    BOOST_CHECK_EQUAL(txlist->GetSeedBlocks(15, 30).size(), 1U);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
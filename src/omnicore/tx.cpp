@@ -107,10 +107,16 @@ static std::string intToClass(int encodingClass)
     return "-";
 }
 
+/** Decodes a string field of the payload, truncated to SP_STRING_FIELD_LEN - 1 characters. */
+std::string CMPTransaction::decodeString(const std::string& str)
+{
+    return str.substr(0, SP_STRING_FIELD_LEN - 1);
+}
+
 /** Checks whether a pointer to the payload is past it's last position. */
 bool CMPTransaction::isOverrun(const char* p)
 {
-    ptrdiff_t pos = (char*) p - (char*) &pkt;
+    ptrdiff_t pos = p - (const char*) pkt.data();
     return (pos > pkt_size);
 }
 
@@ -353,21 +359,21 @@ bool CMPTransaction::interpret_ERC721_issueproperty(){
         return false;
     }
 
-    const char* p = (char*)&pkt + 5;
+    const char* p = (char*) pkt.data() + 5;
     std::vector<std::string> spstr;
     for (int i = 0; i < 4; i++) {
         spstr.push_back(std::string(p));
         p += spstr.back().size() + 1;
-        if( (ptrdiff_t)sizeof(pkt) -1 - (p - (char*)&pkt) <= 0){
+        if( (ptrdiff_t)MAX_PAYLOAD_SIZE - 1 - (p - (char*) pkt.data()) <= 0){
             PrintToLog("%s(): rejected: malformed string value(s)\n", __func__);
             return false;
         }
     }
-    memcpy(erc721_propertyname, spstr[0].data(), sizeof(erc721_propertyname) - 1);
-    memcpy(erc721_propertysymbol, spstr[1].data(), sizeof(erc721_propertysymbol) - 1);
-    memcpy(erc721_propertydata, spstr[2].data(), sizeof(erc721_propertydata) - 1);
-    memcpy(erc721_propertyurl, spstr[3].data(), sizeof(erc721_propertyurl) - 1);
-    if((ptrdiff_t)sizeof(pkt) -1 - (p - (char*)&pkt) <= 8){
+    erc721_propertyname = decodeString(spstr[0]);
+    erc721_propertysymbol = decodeString(spstr[1]);
+    erc721_propertydata = decodeString(spstr[2]);
+    erc721_propertyurl = decodeString(spstr[3]);
+    if((ptrdiff_t)MAX_PAYLOAD_SIZE - 1 - (p - (char*) pkt.data()) <= 8){
         PrintToLog("%s(): rejected: malformed string value(s). \n", __func__);
         return false;
     }
@@ -388,7 +394,7 @@ bool CMPTransaction::interpret_ERC721_issuetoken(){
     }
 
     std::vector<uint8_t > tmp(32);
-    uint8_t* p = (uint8_t *)pkt + 5;
+    uint8_t* p = pkt.data() + 5;
     tmp.assign(p, p + 32);
     p += 32;
     erc721_propertyid = uint256(tmp);
@@ -400,7 +406,7 @@ bool CMPTransaction::interpret_ERC721_issuetoken(){
     char *ptmp = (char*)p;
     std::string urlTmp = std::string(ptmp);
     p += urlTmp.size() + 1;
-    memcpy(erc721_tokenurl, urlTmp.data(), sizeof(erc721_tokenurl) - 1);
+    erc721_tokenurl = decodeString(urlTmp);
 
     if (isOverrun((char*)p)) {
         PrintToLog("%s(): rejected: malformed string value(s)\n", __func__);
@@ -416,7 +422,7 @@ bool CMPTransaction::interpret_ERC721_transfertoken(){
     }
 
     std::vector<uint8_t > tmp(32);
-    char* p = (char*)pkt + 5;
+    char* p = (char*) pkt.data() + 5;
     tmp.assign(p, p + 32);
     p += 32;
     erc721_propertyid = uint256(tmp);
@@ -433,7 +439,7 @@ bool CMPTransaction::interpret_ERC721_destroytoken(){
     }
 
     std::vector<uint8_t > tmp(32);
-    char* p = (char*)pkt + 5;
+    char* p = (char*) pkt.data() + 5;
     tmp.assign(p, p + 32);
     p += 32;
     erc721_propertyid = uint256(tmp);
@@ -607,7 +613,7 @@ bool CMPTransaction::interpret_CreatePropertyFixed()
     if (pkt_size < 25) {
         return false;
     }
-    const char* p = 11 + (char*) &pkt;
+    const char* p = 11 + (char*) pkt.data();
     std::vector<std::string> spstr;
     memcpy(&ecosystem, &pkt[4], 1);
     memcpy(&prop_type, &pkt[5], 2);
@@ -619,11 +625,11 @@ bool CMPTransaction::interpret_CreatePropertyFixed()
         p += spstr.back().size() + 1;
     }
     int i = 0;
-    memcpy(category, spstr[i].c_str(), std::min(spstr[i].length(), sizeof(category)-1)); i++;
-    memcpy(subcategory, spstr[i].c_str(), std::min(spstr[i].length(), sizeof(subcategory)-1)); i++;
-    memcpy(name, spstr[i].c_str(), std::min(spstr[i].length(), sizeof(name)-1)); i++;
-    memcpy(url, spstr[i].c_str(), std::min(spstr[i].length(), sizeof(url)-1)); i++;
-    memcpy(data, spstr[i].c_str(), std::min(spstr[i].length(), sizeof(data)-1)); i++;
+    category = decodeString(spstr[i++]);
+    subcategory = decodeString(spstr[i++]);
+    name = decodeString(spstr[i++]);
+    url = decodeString(spstr[i++]);
+    data = decodeString(spstr[i++]);
     memcpy(&nValue, p, 8);
     swapByteOrder64(nValue);
     p += 8;
@@ -655,7 +661,7 @@ bool CMPTransaction::interpret_CreatePropertyVariable()
     if (pkt_size < 47) {
         return false;
     }
-    const char* p = 11 + (char*) &pkt;
+    const char* p = 11 + (char*) pkt.data();
     std::vector<std::string> spstr;
     memcpy(&ecosystem, &pkt[4], 1);
     memcpy(&prop_type, &pkt[5], 2);
@@ -667,11 +673,11 @@ bool CMPTransaction::interpret_CreatePropertyVariable()
         p += spstr.back().size() + 1;
     }
     int i = 0;
-    memcpy(category, spstr[i].c_str(), std::min(spstr[i].length(), sizeof(category)-1)); i++;
-    memcpy(subcategory, spstr[i].c_str(), std::min(spstr[i].length(), sizeof(subcategory)-1)); i++;
-    memcpy(name, spstr[i].c_str(), std::min(spstr[i].length(), sizeof(name)-1)); i++;
-    memcpy(url, spstr[i].c_str(), std::min(spstr[i].length(), sizeof(url)-1)); i++;
-    memcpy(data, spstr[i].c_str(), std::min(spstr[i].length(), sizeof(data)-1)); i++;
+    category = decodeString(spstr[i++]);
+    subcategory = decodeString(spstr[i++]);
+    name = decodeString(spstr[i++]);
+    url = decodeString(spstr[i++]);
+    data = decodeString(spstr[i++]);
     memcpy(&property, p, 4);
     swapByteOrder32(property);
     p += 4;
@@ -738,7 +744,7 @@ bool CMPTransaction::interpret_CreatePropertyManaged()
     if (pkt_size < 17) {
         return false;
     }
-    const char* p = 11 + (char*) &pkt;
+    const char* p = 11 + (char*) pkt.data();
     std::vector<std::string> spstr;
     memcpy(&ecosystem, &pkt[4], 1);
     memcpy(&prop_type, &pkt[5], 2);
@@ -752,11 +758,11 @@ bool CMPTransaction::interpret_CreatePropertyManaged()
     }
 
     int i = 0;
-    memcpy(category, spstr[i].c_str(), std::min(spstr[i].length(), sizeof(category)-1)); i++;
-    memcpy(subcategory, spstr[i].c_str(), std::min(spstr[i].length(), sizeof(subcategory)-1)); i++;
-    memcpy(name, spstr[i].c_str(), std::min(spstr[i].length(), sizeof(name)-1)); i++;
-    memcpy(url, spstr[i].c_str(), std::min(spstr[i].length(), sizeof(url)-1)); i++;
-    memcpy(data, spstr[i].c_str(), std::min(spstr[i].length(), sizeof(data)-1)); i++;
+    category = decodeString(spstr[i++]);
+    subcategory = decodeString(spstr[i++]);
+    name = decodeString(spstr[i++]);
+    url = decodeString(spstr[i++]);
+    data = decodeString(spstr[i++]);
 
     if ((!rpcOnly && msc_debug_packets) || msc_debug_packets_readonly) {
         PrintToLog("\t       ecosystem: %d\n", ecosystem);
@@ -988,9 +994,9 @@ bool CMPTransaction::interpret_Alert()
     memcpy(&alert_expiry, &pkt[6], 4);
     swapByteOrder32(alert_expiry);
 
-    const char* p = 10 + (char*) &pkt;
+    const char* p = 10 + (char*) pkt.data();
     std::string spstr(p);
-    memcpy(alert_text, spstr.c_str(), std::min(spstr.length(), sizeof(alert_text)-1));
+    alert_text = decodeString(spstr);
 
     if ((!rpcOnly && msc_debug_packets) || msc_debug_packets_readonly) {
         PrintToLog("\t      alert type: %d\n", alert_type);
@@ -1212,7 +1218,7 @@ int CMPTransaction::logicMath_ERC721_issueproperty(){
         return (PKT_ERROR_BURN - 3);
     }
 
-    if ('\0' == erc721_propertyname[0]) {
+    if (erc721_propertyname.empty()) {
         PrintToLog("%s(): rejected: property name must not be empty\n", __func__);
         return (PKT_ERROR_SP -37);
     }
@@ -2249,7 +2255,7 @@ int CMPTransaction::logicMath_CreatePropertyFixed()
         return (PKT_ERROR_BURN -3);
     }
 
-    if ('\0' == name[0]) {
+    if (name.empty()) {
         PrintToLog("%s(): rejected: property name must not be empty\n", __func__);
         return (PKT_ERROR_SP -37);
     }
@@ -2361,7 +2367,7 @@ int CMPTransaction::logicMath_CreatePropertyVariable()
         return (PKT_ERROR_SP -51);
     }
 
-    if ('\0' == name[0]) {
+    if (name.empty()) {
         PrintToLog("%s(): rejected: property name must not be empty\n", __func__);
         return (PKT_ERROR_SP -37);
     }
@@ -2537,7 +2543,7 @@ int CMPTransaction::logicMath_CreatePropertyManaged()
     }
 
 
-    if ('\0' == name[0]) {
+    if (name.empty()) {
         PrintToLog("%s(): rejected: property name must not be empty\n", __func__);
         return (PKT_ERROR_SP -37);
     }
@@ -16,6 +16,7 @@ class CTransaction;
 
 #include <string.h>
 #include <string>
+#include <vector>
 
 using mastercore::strTransactionType;
 
@@ -35,8 +36,9 @@ private:
     unsigned int tx_idx;  // tx # within the block, 0-based
     uint64_t tx_fee_paid;
 
+    //! The payload, followed by PAYLOAD_PADDING zero bytes
+    std::vector<unsigned char> pkt;
     int pkt_size;
-    unsigned char pkt[1 + MAX_PACKETS * PACKET_SIZE];
     int encodingClass;  // No Marker = 0, Class A = 1, Class B = 2, Class C = 3
 
     std::string sender;
@@ -65,11 +67,11 @@ private:
     // CreatePropertyFixed, CreatePropertyVariable, CreatePropertyMananged
     unsigned short prop_type;
     unsigned int prev_prop_id;
-    char category[SP_STRING_FIELD_LEN];
-    char subcategory[SP_STRING_FIELD_LEN];
-    char name[SP_STRING_FIELD_LEN];
-    char url[SP_STRING_FIELD_LEN];
-    char data[SP_STRING_FIELD_LEN];
+    std::string category;
+    std::string subcategory;
+    std::string name;
+    std::string url;
+    std::string data;
     uint64_t deadline;
     unsigned char early_bird;
     unsigned char percentage;
@@ -91,7 +93,7 @@ private:
     // Alert
     uint16_t alert_type;
     uint32_t alert_expiry;
-    char alert_text[SP_STRING_FIELD_LEN];
+    std::string alert_text;
 
     // Activation
     uint16_t feature_id;
@@ -106,20 +108,23 @@ private:
     //ERC721 property And token
     uint8_t erc721_action;
     uint256 erc721_propertyid;
-    char erc721_propertysymbol[SP_STRING_FIELD_LEN];
-    char erc721_propertyname[SP_STRING_FIELD_LEN];
-    char erc721_propertyurl[SP_STRING_FIELD_LEN];
-    char erc721_propertydata[SP_STRING_FIELD_LEN];
+    std::string erc721_propertysymbol;
+    std::string erc721_propertyname;
+    std::string erc721_propertyurl;
+    std::string erc721_propertydata;
     uint64_t max_erc721number;
 
     uint256 erc721_tokenid;
     uint8_t erc721token_attribute[ERC721_TOKEN_ATTRIBUTES];
-    char erc721_tokenurl[SP_STRING_FIELD_LEN];
+    std::string erc721_tokenurl;
 
 
     /** Checks whether a pointer to the payload is past it's last position. */
     bool isOverrun(const char* p);
 
+    /** Decodes a string field of the payload, truncated to SP_STRING_FIELD_LEN - 1 characters. */
+    static std::string decodeString(const std::string& str);
+
     /**
      * Payload parsing
      */
@@ -190,6 +195,12 @@ private:
     int logicMath_ERC721_destroytoken();
 
 public:
+    //! Maximal size of a payload
+    static const unsigned int MAX_PAYLOAD_SIZE = 1 + MAX_PACKETS * PACKET_SIZE;
+    //! Number of zero bytes kept after the payload: fields are read before the
+    //! parser checks whether they were past the end of the payload
+    static const unsigned int PAYLOAD_PADDING = 64;
+
     //! DEx and MetaDEx action values
     enum ActionTypes
     {
@@ -220,7 +231,7 @@ public:
     uint64_t getFeePaid() const { return tx_fee_paid; }
     std::string getSender() const { return sender; }
     std::string getReceiver() const { return receiver; }
-    std::string getPayload() const { return HexStr(pkt, pkt + pkt_size); }
+    std::string getPayload() const { return HexStr(pkt.begin(), pkt.begin() + pkt_size); }
     uint64_t getAmount() const { return nValue; }
     uint64_t getTotalNumber() const { return totalCrowsToken; }
     uint64_t getNewAmount() const { return nNewValue; }
@@ -262,7 +273,7 @@ public:
         tx_fee_paid = 0;
         pkt_size = 0;
         burnBCH = 0;
-        memset(&pkt, 0, sizeof(pkt));
+        pkt.assign(PAYLOAD_PADDING, 0);
         encodingClass = 0;
         sender.clear();
         receiver.clear();
@@ -274,17 +285,17 @@ public:
         ecosystem = 0;
         prop_type = 0;
         prev_prop_id = 0;
-        memset(&category, 0, sizeof(category));
-        memset(&subcategory, 0, sizeof(subcategory));
-        memset(&name, 0, sizeof(name));
-        memset(&url, 0, sizeof(url));
-        memset(&data, 0, sizeof(data));
-        memset(&erc721_propertysymbol, 0, sizeof(erc721_propertysymbol));
-        memset(erc721_propertyname, 0, sizeof(erc721_propertyname));
-        memset(erc721_propertyurl, 0, sizeof(erc721_propertyurl));
-        memset(erc721_propertydata, 0, sizeof(erc721_propertydata));
+        category.clear();
+        subcategory.clear();
+        name.clear();
+        url.clear();
+        data.clear();
+        erc721_propertysymbol.clear();
+        erc721_propertyname.clear();
+        erc721_propertyurl.clear();
+        erc721_propertydata.clear();
         memset(erc721token_attribute, 0, sizeof(erc721token_attribute));
-        memset(erc721_tokenurl, 0, sizeof(erc721_tokenurl));
+        erc721_tokenurl.clear();
         deadline = 0;
         early_bird = 0;
         percentage = 0;
@@ -297,7 +308,7 @@ public:
         subaction = 0;
         alert_type = 0;
         alert_expiry = 0;
-        memset(&alert_text, 0, sizeof(alert_text));
+        alert_text.clear();
         rpcOnly = true;
         feature_id = 0;
         activation_block = 0;
@@ -318,21 +329,30 @@ public:
         blockTime = bt;
     }
 
-    /** Sets the given values. */
+    /** Sets the given values, and takes over the payload. */
     void Set(const std::string& s, const std::string& r, uint64_t n, const uint256& t,
-        int b, unsigned int idx, unsigned char *p, unsigned int size, int encodingClassIn, uint64_t txf)
+        int b, unsigned int idx, std::vector<unsigned char>&& payload, int encodingClassIn, uint64_t txf)
     {
         sender = s;
         receiver = r;
         txid = t;
         block = b;
         tx_idx = idx;
-        pkt_size = size < sizeof (pkt) ? size : sizeof (pkt);
+        pkt_size = payload.size() < MAX_PAYLOAD_SIZE ? payload.size() : MAX_PAYLOAD_SIZE;
         nValue = n;
         nNewValue = n;
         encodingClass = encodingClassIn;
         tx_fee_paid = txf;
-        memcpy(&pkt, p, pkt_size);
+        pkt = std::move(payload);
+        pkt.resize(pkt_size);
+        pkt.resize(pkt_size + PAYLOAD_PADDING, 0);
+    }
+
+    /** Sets the given values. */
+    void Set(const std::string& s, const std::string& r, uint64_t n, const uint256& t,
+        int b, unsigned int idx, unsigned char *p, unsigned int size, int encodingClassIn, uint64_t txf)
+    {
+        Set(s, r, n, t, b, idx, std::vector<unsigned char>(p, p + size), encodingClassIn, txf);
     }
 
     /** Parses the packet or payload. */
@@ -246,56 +246,64 @@ int64_t SelectCoins(const std::string& fromAddress, CCoinControl& coinControl, i
     if (0 < additional) nMax += additional;
 
     int nHeight = GetHeight();
+    const CChainParams& params = GetConfig().GetChainParams();
+
+    // only use funds from the sender's address
+    CTxDestination fromDest = DecodeCashAddr(fromAddress, params);
+    if (!IsValidDestination(fromDest)) {
+        return 0;
+    }
+    // only the canonical form of the address selects coins, as before, but
+    // compare destinations rather than encoding each candidate output
+    if (EncodeCashAddr(fromDest, params) != fromAddress) {
+        return 0;
+    }
+
     LOCK2(cs_main, pwalletMain->cs_wallet);
 
-    // iterate over the wallet
-    for (std::map<TxId, CWalletTx>::const_iterator it = pwalletMain->mapWallet.begin(); it != pwalletMain->mapWallet.end(); ++it) {
-        const TxId& txid = it->first;
-        const CWalletTx& wtx = it->second;
+    // iterate over the wallet's unspent outputs of the sender
+    for (const COutPoint& outpoint : pwalletMain->GetUnspentOutPoints(fromDest)) {
+        const TxId& txid = outpoint.GetTxId();
+        const unsigned int n = outpoint.GetN();
+        const CWalletTx* wtx = pwalletMain->GetWalletTx(txid);
+        assert(wtx != nullptr);
+
+        if (!wtx->IsTrusted()) {
+            continue;
+        }
+        if (!wtx->GetAvailableCredit().GetSatoshis()) {
+            continue;
+        }
+
+        const CTxOut& txOut = wtx->tx->vout[n];
 
-        if (!wtx.IsTrusted()) {
+        CTxDestination dest;
+        if (!CheckInput(txOut, nHeight, dest)) {
+            continue;
+        }
+        if (!IsMine(*pwalletMain, dest)) {
             continue;
         }
-        if (!wtx.GetAvailableCredit().GetSatoshis()) {
+        if (pwalletMain->IsSpent(outpoint)) {
             continue;
         }
-	    const CTransaction &tmpTx = wtx.getTx();
-        for (unsigned int n = 0; n < tmpTx.vout.size(); n++) {
-            const CTxOut& txOut = tmpTx.vout[n];
-
-            CTxDestination dest;
-            if (!CheckInput(txOut, nHeight, dest)) {
-                continue;
-            }
-            if (!IsMine(*pwalletMain, dest)) {
-                continue;
-            }
-            if (pwalletMain->IsSpent(COutPoint(txid, n))) {
-                continue;
-            }
-            if (txOut.nValue.GetSatoshis() < GetEconomicThreshold(txOut)) {
-                if (msc_debug_tokens)
-                    PrintToLog("%s: output value below economic threshold: %s:%d, value: %d\n",
-                            __func__, txid.GetHex(), n, txOut.nValue);
-                continue;
-            }
-		const CChainParams &params = GetConfig().GetChainParams();
-            std::string sAddress = EncodeCashAddr(dest, params);
+        if (txOut.nValue.GetSatoshis() < GetEconomicThreshold(txOut)) {
             if (msc_debug_tokens)
-                PrintToLog("%s: sender: %s, outpoint: %s:%d, value: %d\n", __func__, sAddress, txid.GetHex(), n, txOut.nValue);
+                PrintToLog("%s: output value below economic threshold: %s:%d, value: %d\n",
+                        __func__, txid.GetHex(), n, txOut.nValue);
+            continue;
+        }
 
-            // only use funds from the sender's address
-            if (fromAddress == sAddress) {
-                COutPoint outpoint(txid, n);
-                coinControl.Select(outpoint);
+        if (msc_debug_tokens)
+            PrintToLog("%s: sender: %s, outpoint: %s:%d, value: %d\n", __func__, EncodeCashAddr(dest, params), txid.GetHex(), n, txOut.nValue);
 
-                nTotal += txOut.nValue.GetSatoshis();
+        if (dest == fromDest) {
+            coinControl.Select(outpoint);
 
-                if (nMax <= nTotal) break;
-            }
-        }
+            nTotal += txOut.nValue.GetSatoshis();
 
-        if (nMax <= nTotal) break;
+            if (nMax <= nTotal) break;
+        }
     }
 #endif
 
@@ -9,6 +9,8 @@
 #include <secp256k1_recovery.h>
 #include <secp256k1_schnorr.h>
 
+#include <cassert>
+
 namespace {
 /* Global secp256k1_context object used for verification. */
 secp256k1_context *secp256k1_context_verify = nullptr;
@@ -215,6 +217,30 @@ bool CPubKey::VerifySchnorr(const uint256 &hash,
                                     hash.begin(), &pubkey);
 }
 
+bool CPubKey::VerifySchnorrBatch(const std::vector<const CPubKey *> &pubkeys,
+                                 const std::vector<const uint256 *> &hashes,
+                                 const std::vector<const uint8_t *> &sigs) {
+    assert(pubkeys.size() == hashes.size() && pubkeys.size() == sigs.size());
+
+    std::vector<secp256k1_pubkey> parsed(pubkeys.size());
+    std::vector<const secp256k1_pubkey *> ppubkeys(pubkeys.size());
+    std::vector<const uint8_t *> msgs(hashes.size());
+    for (size_t i = 0; i < pubkeys.size(); i++) {
+        const CPubKey &pubkey = *pubkeys[i];
+        if (!pubkey.IsValid() ||
+            !secp256k1_ec_pubkey_parse(secp256k1_context_verify, &parsed[i],
+                                       &pubkey[0], pubkey.size())) {
+            return false;
+        }
+        ppubkeys[i] = &parsed[i];
+        msgs[i] = hashes[i]->begin();
+    }
+
+    return secp256k1_schnorr_verify_batch(secp256k1_context_verify,
+                                          sigs.data(), msgs.data(),
+                                          ppubkeys.data(), sigs.size());
+}
+
 bool CPubKey::RecoverCompact(const uint256 &hash,
                              const std::vector<uint8_t> &vchSig) {
     if (vchSig.size() != COMPACT_SIGNATURE_SIZE) {
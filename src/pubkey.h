@@ -166,6 +166,16 @@ public:
     bool VerifySchnorr(const uint256 &hash,
                        const std::vector<uint8_t> &vchSig) const;
 
+    /**
+     * Verify a batch of Schnorr signatures (64 bytes each) at once, which is
+     * faster than verifying them one by one. The public keys, hashes and
+     * signatures are matched by index. Returns true if all the signatures are
+     * valid.
+     */
+    static bool VerifySchnorrBatch(const std::vector<const CPubKey *> &pubkeys,
+                                   const std::vector<const uint256 *> &hashes,
+                                   const std::vector<const uint8_t *> &sigs);
+
     /**
      * Check whether a DER-serialized ECDSA signature is normalized (lower-S).
      */
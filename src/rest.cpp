@@ -16,6 +16,7 @@
 #include <streams.h>
 #include <sync.h>
 #include <txmempool.h>
+#include <util/jsonwriter.h>
 #include <util/strencodings.h>
 #include <validation.h>
 #include <version.h>
@@ -225,6 +226,7 @@ static bool rest_block(const Config &config, HTTPRequest *req,
     }
 
     CBlock block;
+    std::vector<uint8_t> rawBlock;
     CBlockIndex *pblockindex = nullptr;
     CBlockIndex *tip = nullptr;
     {
@@ -241,35 +243,39 @@ static bool rest_block(const Config &config, HTTPRequest *req,
                            hashStr + " not available (pruned data)");
         }
 
-        if (!ReadBlockFromDisk(block, pblockindex,
-                               config.GetChainParams().GetConsensus())) {
+        // Only JSON needs the block to be deserialized, otherwise serve it
+        // as it is on disk.
+        if (rf == RetFormat::JSON) {
+            if (!ReadBlockFromDisk(block, pblockindex,
+                                   config.GetChainParams().GetConsensus())) {
+                return RESTERR(req, HTTP_NOT_FOUND, hashStr + " not found");
+            }
+        } else if (!ReadRawBlockFromDisk(
+                       rawBlock, pblockindex,
+                       config.GetChainParams().DiskMagic())) {
             return RESTERR(req, HTTP_NOT_FOUND, hashStr + " not found");
         }
     }
 
-    CDataStream ssBlock(SER_NETWORK,
-                        PROTOCOL_VERSION | RPCSerializationFlags());
-    ssBlock << block;
-
     switch (rf) {
         case RetFormat::BINARY: {
-            std::string binaryBlock = ssBlock.str();
+            std::string binaryBlock(rawBlock.begin(), rawBlock.end());
             req->WriteHeader("Content-Type", "application/octet-stream");
             req->WriteReply(HTTP_OK, binaryBlock);
             return true;
         }
 
         case RetFormat::HEX: {
-            std::string strHex = HexStr(ssBlock.begin(), ssBlock.end()) + "\n";
+            std::string strHex = HexStr(rawBlock) + "\n";
             req->WriteHeader("Content-Type", "text/plain");
             req->WriteReply(HTTP_OK, strHex);
             return true;
         }
 
         case RetFormat::JSON: {
-            UniValue objBlock =
-                blockToJSON(block, tip, pblockindex, showTxDetails);
-            std::string strJSON = objBlock.write() + "\n";
+            std::string strJSON;
+            WriteBlockJSON(block, tip, pblockindex, showTxDetails, strJSON);
+            strJSON += "\n";
             req->WriteHeader("Content-Type", "application/json");
             req->WriteReply(HTTP_OK, strJSON);
             return true;
@@ -415,9 +421,12 @@ static bool rest_tx(Config &config, HTTPRequest *req,
         }
 
         case RetFormat::JSON: {
-            UniValue objTx(UniValue::VOBJ);
-            TxToUniv(*tx, hashBlock, objTx);
-            std::string strJSON = objTx.write() + "\n";
+            std::string strJSON;
+            JSONWriter writer(strJSON);
+            writer.BeginObject();
+            WriteTxJSON(*tx, hashBlock, writer);
+            writer.EndObject();
+            strJSON += "\n";
             req->WriteHeader("Content-Type", "application/json");
             req->WriteReply(HTTP_OK, strJSON);
             return true;
@@ -14,6 +14,7 @@
 #include <consensus/validation.h>
 #include <core_io.h>
 #include <hash.h>
+#include <index/blockstatsindex.h>
 #include <index/txindex.h>
 #include <policy/policy.h>
 #include <primitives/transaction.h>
@@ -22,6 +23,7 @@
 #include <sync.h>
 #include <txdb.h>
 #include <txmempool.h>
+#include <util/jsonwriter.h>
 #include <util/strencodings.h>
 #include <util/system.h>
 #include <validation.h>
@@ -34,12 +36,16 @@
 #include <condition_variable>
 #include <cstdint>
 #include <mutex>
+#include <thread>
 
 struct CUpdatedBlock {
     uint256 hash;
     int height;
 };
 
+//! Maximum number of blocks getblockstatsrange returns in one call
+static const int MAX_BLOCK_STATS_RANGE = 10000;
+
 static Mutex cs_blockchange;
 static std::condition_variable cond_blockchange;
 static CUpdatedBlock latestblock;
@@ -145,6 +151,92 @@ UniValue blockToJSON(const CBlock &block, const CBlockIndex *tip,
     return result;
 }
 
+/**
+ * Write the transactions of a block, on several threads if there are many of
+ * them.
+ */
+static void WriteBlockTxsJSON(const CBlock &block, JSONWriter &writer) {
+    const int serialize_flags = RPCSerializationFlags();
+    auto write_txs = [&block, serialize_flags](size_t begin, size_t end,
+                                               JSONWriter &txs_writer) {
+        for (size_t i = begin; i < end; i++) {
+            txs_writer.BeginObject();
+            WriteTxJSON(*block.vtx[i], uint256(), txs_writer, true,
+                        serialize_flags);
+            txs_writer.EndObject();
+        }
+    };
+
+    const size_t num_parts = std::min<size_t>(
+        GetNumCores(), block.vtx.size() / PARALLEL_JSON_MIN_BLOCK_TXS);
+    if (num_parts <= 1) {
+        write_txs(0, block.vtx.size(), writer);
+        return;
+    }
+
+    // Each part is a comma separated list of transactions.
+    std::vector<std::string> parts(num_parts);
+    std::vector<std::thread> threads;
+    const size_t part_size = (block.vtx.size() + num_parts - 1) / num_parts;
+    for (size_t i = 0; i < num_parts; i++) {
+        const size_t begin = std::min(block.vtx.size(), i * part_size);
+        const size_t end = std::min(block.vtx.size(), begin + part_size);
+        threads.emplace_back([&write_txs, &parts, begin, end, i] {
+            JSONWriter part_writer(parts[i]);
+            write_txs(begin, end, part_writer);
+        });
+    }
+    for (size_t i = 0; i < num_parts; i++) {
+        threads[i].join();
+        if (!parts[i].empty()) {
+            writer.Raw(parts[i]);
+        }
+        std::string().swap(parts[i]);
+    }
+}
+
+void WriteBlockJSON(const CBlock &block, const CBlockIndex *tip,
+                    const CBlockIndex *blockindex, bool txDetails,
+                    std::string &json) {
+    JSONWriter writer(json);
+    writer.BeginObject();
+    writer.KV("hash", blockindex->GetBlockHash().GetHex());
+    const CBlockIndex *pnext;
+    int confirmations = ComputeNextBlockAndDepth(tip, blockindex, pnext);
+    writer.KV("confirmations", confirmations);
+    writer.KV("size", (int)::GetSerializeSize(block, SER_NETWORK,
+                                               PROTOCOL_VERSION));
+    writer.KV("height", blockindex->nHeight);
+    writer.KV("version", block.nVersion);
+    writer.KV("versionHex", strprintf("%08x", block.nVersion));
+    writer.KV("merkleroot", block.hashMerkleRoot.GetHex());
+    writer.Key("tx");
+    writer.BeginArray();
+    if (txDetails) {
+        WriteBlockTxsJSON(block, writer);
+    } else {
+        for (const auto &tx : block.vtx) {
+            writer.String(tx->GetId().GetHex());
+        }
+    }
+    writer.EndArray();
+    writer.KV("time", block.GetBlockTime());
+    writer.KV("mediantime", int64_t(blockindex->GetMedianTimePast()));
+    writer.KV("nonce", uint64_t(block.nNonce));
+    writer.KV("bits", strprintf("%08x", block.nBits));
+    writer.KV("difficulty", GetDifficulty(blockindex));
+    writer.KV("chainwork", blockindex->nChainWork.GetHex());
+
+    if (blockindex->pprev) {
+        writer.KV("previousblockhash",
+                  blockindex->pprev->GetBlockHash().GetHex());
+    }
+    if (pnext) {
+        writer.KV("nextblockhash", pnext->GetBlockHash().GetHex());
+    }
+    writer.EndObject();
+}
+
 static UniValue getblockcount(const Config &config,
                               const JSONRPCRequest &request) {
     if (request.fHelp || request.params.size() != 0) {
@@ -862,6 +954,22 @@ static CBlock GetBlockChecked(const Config &config,
     return block;
 }
 
+static std::vector<uint8_t> GetRawBlockChecked(const Config &config,
+                                               const CBlockIndex *pblockindex) {
+    std::vector<uint8_t> block;
+    if (fHavePruned && !pblockindex->nStatus.hasData() &&
+        pblockindex->nTx > 0) {
+        throw JSONRPCError(RPC_MISC_ERROR, "Block not available (pruned data)");
+    }
+
+    if (!ReadRawBlockFromDisk(block, pblockindex,
+                              config.GetChainParams().DiskMagic())) {
+        throw JSONRPCError(RPC_MISC_ERROR, "Block not found on disk");
+    }
+
+    return block;
+}
+
 static UniValue getblock(const Config &config, const JSONRPCRequest &request) {
     if (request.fHelp || request.params.size() < 1 ||
         request.params.size() > 2) {
@@ -947,16 +1055,18 @@ static UniValue getblock(const Config &config, const JSONRPCRequest &request) {
         throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Block not found");
     }
 
-    const CBlock block = GetBlockChecked(config, pblockindex);
-
     if (verbosity <= 0) {
-        CDataStream ssBlock(SER_NETWORK,
-                            PROTOCOL_VERSION | RPCSerializationFlags());
-        ssBlock << block;
-        std::string strHex = HexStr(ssBlock.begin(), ssBlock.end());
-        return strHex;
+        // The block is serialized the same way on disk.
+        return HexStr(GetRawBlockChecked(config, pblockindex));
     }
 
+    const CBlock block = GetBlockChecked(config, pblockindex);
+    if (request.fRawJSONAllowed) {
+        std::string json;
+        WriteBlockJSON(block, chainActive.Tip(), pblockindex, verbosity >= 2,
+                       json);
+        return JSONRPCRawResult(json);
+    }
     return blockToJSON(block, chainActive.Tip(), pblockindex, verbosity >= 2);
 }
 
@@ -1869,21 +1979,6 @@ static UniValue getchaintxstats(const Config &config,
     return ret;
 }
 
-template <typename T>
-static T CalculateTruncatedMedian(std::vector<T> &scores) {
-    size_t size = scores.size();
-    if (size == 0) {
-        return T();
-    }
-
-    std::sort(scores.begin(), scores.end());
-    if (size % 2 == 0) {
-        return (scores[size / 2 - 1] + scores[size / 2]) / 2;
-    } else {
-        return scores[size / 2];
-    }
-}
-
 template <typename T> static inline bool SetHasKeys(const std::set<T> &set) {
     return false;
 }
@@ -1893,9 +1988,77 @@ static inline bool SetHasKeys(const std::set<T> &set, const Tk &key,
     return (set.count(key) != 0) || SetHasKeys(set, args...);
 }
 
-// outpoint (needed for the utxo index) + nHeight + fCoinBase
-static constexpr size_t PER_UTXO_OVERHEAD =
-    sizeof(COutPoint) + sizeof(uint32_t) + sizeof(bool);
+static UniValue BlockStatsToJSON(const CBlockStats &stats,
+                                const CBlockIndex *pindex) {
+    const int64_t nTxs = stats.nTxs;
+    UniValue ret(UniValue::VOBJ);
+    ret.pushKV("avgfee",
+               ValueFromAmount((nTxs > 1) ? stats.totalFee / (nTxs - 1)
+                                          : Amount::zero()));
+    ret.pushKV("avgfeerate",
+               ValueFromAmount((stats.nTotalSize > 0)
+                                   ? stats.totalFee / int64_t(stats.nTotalSize)
+                                   : Amount::zero()));
+    ret.pushKV("avgtxsize",
+               (nTxs > 1) ? int64_t(stats.nTotalSize) / (nTxs - 1) : 0);
+    ret.pushKV("blockhash", pindex->GetBlockHash().GetHex());
+    ret.pushKV("height", (int64_t)pindex->nHeight);
+    ret.pushKV("ins", int64_t(stats.nInputs));
+    ret.pushKV("maxfee", ValueFromAmount(stats.maxFee));
+    ret.pushKV("maxfeerate", ValueFromAmount(stats.maxFeeRate));
+    ret.pushKV("maxtxsize", int64_t(stats.nMaxTxSize));
+    ret.pushKV("medianfee", ValueFromAmount(stats.medianFee));
+    ret.pushKV("medianfeerate", ValueFromAmount(stats.medianFeeRate));
+    ret.pushKV("mediantime", pindex->GetMedianTimePast());
+    ret.pushKV("mediantxsize", int64_t(stats.nMedianTxSize));
+    ret.pushKV("minfee", ValueFromAmount(stats.minFee));
+    ret.pushKV("minfeerate", ValueFromAmount(stats.minFeeRate));
+    ret.pushKV("mintxsize", int64_t(stats.nMinTxSize));
+    ret.pushKV("outs", int64_t(stats.nOutputs));
+    ret.pushKV("subsidy", ValueFromAmount(GetBlockSubsidy(
+                              pindex->nHeight, Params().GetConsensus())));
+    ret.pushKV("time", pindex->GetBlockTime());
+    ret.pushKV("total_out", ValueFromAmount(stats.totalOut));
+    ret.pushKV("total_size", int64_t(stats.nTotalSize));
+    ret.pushKV("totalfee", ValueFromAmount(stats.totalFee));
+    ret.pushKV("txs", nTxs);
+    ret.pushKV("utxo_increase",
+               int64_t(stats.nOutputs) - int64_t(stats.nInputs));
+    ret.pushKV("utxo_size_inc", stats.nUtxoSizeInc);
+    return ret;
+}
+
+static std::set<std::string> ParseSelectedStats(const UniValue &param) {
+    std::set<std::string> stats;
+    if (!param.isNull()) {
+        const UniValue stats_univalue = param.get_array();
+        for (unsigned int i = 0; i < stats_univalue.size(); i++) {
+            const std::string stat = stats_univalue[i].get_str();
+            stats.insert(stat);
+        }
+    }
+    return stats;
+}
+
+static UniValue SelectBlockStats(const UniValue &ret_all,
+                                 const std::set<std::string> &stats) {
+    // Everything is returned if nothing is selected (default)
+    if (stats.empty()) {
+        return ret_all;
+    }
+
+    UniValue ret(UniValue::VOBJ);
+    for (const std::string &stat : stats) {
+        const UniValue &value = ret_all[stat];
+        if (value.isNull()) {
+            throw JSONRPCError(
+                RPC_INVALID_PARAMETER,
+                strprintf("Invalid selected statistic %s", stat));
+        }
+        ret.pushKV(stat, value);
+    }
+    return ret;
+}
 
 static UniValue getblockstats(const Config &config,
                               const JSONRPCRequest &request) {
@@ -1908,8 +2071,8 @@ static UniValue getblockstats(const Config &config,
             CURRENCY_UNIT +
             ".\n"
             "It won't work for some heights with pruning.\n"
-            "It won't work without -txindex for utxo_size_inc, *fee or "
-            "*feerate stats.\n"
+            "It won't work without -txindex or -blockstatsindex for "
+            "utxo_size_inc, *fee or *feerate stats.\n"
             "\nArguments:\n"
             "1. \"hash_or_height\"     (string or numeric, required) The block "
             "hash or height of the target block\n"
@@ -2010,13 +2173,13 @@ static UniValue getblockstats(const Config &config,
 
     assert(pindex != nullptr);
 
-    std::set<std::string> stats;
-    if (!request.params[1].isNull()) {
-        const UniValue stats_univalue = request.params[1].get_array();
-        for (unsigned int i = 0; i < stats_univalue.size(); i++) {
-            const std::string stat = stats_univalue[i].get_str();
-            stats.insert(stat);
-        }
+    const std::set<std::string> stats = ParseSelectedStats(request.params[1]);
+
+    CBlockStats indexed_stats;
+    if (g_blockstatsindex &&
+        g_blockstatsindex->LookupStats(pindex, indexed_stats)) {
+        return SelectBlockStats(BlockStatsToJSON(indexed_stats, pindex),
+                                stats);
     }
 
     const CBlock block = GetBlockChecked(config, pindex);
@@ -2131,60 +2294,113 @@ static UniValue getblockstats(const Config &config,
         }
     }
 
-    UniValue ret_all(UniValue::VOBJ);
-    ret_all.pushKV("avgfee",
-                   ValueFromAmount((block.vtx.size() > 1)
-                                       ? totalfee / int((block.vtx.size() - 1))
-                                       : Amount::zero()));
-    ret_all.pushKV("avgfeerate",
-                   ValueFromAmount((total_size > 0) ? totalfee / total_size
-                                                    : Amount::zero()));
-    ret_all.pushKV("avgtxsize", (block.vtx.size() > 1)
-                                    ? total_size / (block.vtx.size() - 1)
-                                    : 0);
-    ret_all.pushKV("blockhash", pindex->GetBlockHash().GetHex());
-    ret_all.pushKV("height", (int64_t)pindex->nHeight);
-    ret_all.pushKV("ins", inputs);
-    ret_all.pushKV("maxfee", ValueFromAmount(maxfee));
-    ret_all.pushKV("maxfeerate", ValueFromAmount(maxfeerate));
-    ret_all.pushKV("maxtxsize", maxtxsize);
-    ret_all.pushKV("medianfee",
-                   ValueFromAmount(CalculateTruncatedMedian(fee_array)));
-    ret_all.pushKV("medianfeerate",
-                   ValueFromAmount(CalculateTruncatedMedian(feerate_array)));
-    ret_all.pushKV("mediantime", pindex->GetMedianTimePast());
-    ret_all.pushKV("mediantxsize", CalculateTruncatedMedian(txsize_array));
-    ret_all.pushKV(
-        "minfee",
-        ValueFromAmount((minfee == MAX_MONEY) ? Amount::zero() : minfee));
-    ret_all.pushKV("minfeerate",
-                   ValueFromAmount((minfeerate == MAX_MONEY) ? Amount::zero()
-                                                             : minfeerate));
-    ret_all.pushKV("mintxsize", mintxsize == blockMaxSize ? 0 : mintxsize);
-    ret_all.pushKV("outs", outputs);
-    ret_all.pushKV("subsidy", ValueFromAmount(GetBlockSubsidy(
-                                  pindex->nHeight, Params().GetConsensus())));
-    ret_all.pushKV("time", pindex->GetBlockTime());
-    ret_all.pushKV("total_out", ValueFromAmount(total_out));
-    ret_all.pushKV("total_size", total_size);
-    ret_all.pushKV("totalfee", ValueFromAmount(totalfee));
-    ret_all.pushKV("txs", (int64_t)block.vtx.size());
-    ret_all.pushKV("utxo_increase", outputs - inputs);
-    ret_all.pushKV("utxo_size_inc", utxo_size_inc);
-
-    if (do_all) {
-        return ret_all;
+    CBlockStats block_stats;
+    block_stats.nTxs = block.vtx.size();
+    block_stats.nInputs = inputs;
+    block_stats.nOutputs = outputs;
+    block_stats.nTotalSize = total_size;
+    block_stats.nMinTxSize = mintxsize == blockMaxSize ? 0 : mintxsize;
+    block_stats.nMaxTxSize = maxtxsize;
+    block_stats.nMedianTxSize = CalculateTruncatedMedian(txsize_array);
+    block_stats.totalOut = total_out;
+    block_stats.totalFee = totalfee;
+    block_stats.minFee = (minfee == MAX_MONEY) ? Amount::zero() : minfee;
+    block_stats.maxFee = maxfee;
+    block_stats.medianFee = CalculateTruncatedMedian(fee_array);
+    block_stats.minFeeRate =
+        (minfeerate == MAX_MONEY) ? Amount::zero() : minfeerate;
+    block_stats.maxFeeRate = maxfeerate;
+    block_stats.medianFeeRate = CalculateTruncatedMedian(feerate_array);
+    block_stats.nUtxoSizeInc = utxo_size_inc;
+
+    return SelectBlockStats(BlockStatsToJSON(block_stats, pindex), stats);
+}
+
+static UniValue getblockstatsrange(const Config &config,
+                                   const JSONRPCRequest &request) {
+    if (request.fHelp || request.params.size() < 2 ||
+        request.params.size() > 3) {
+        throw std::runtime_error(
+            "getblockstatsrange start_height stop_height ( stats )\n"
+            "\nReturn the per block statistics of getblockstats for a range "
+            "of heights of the active chain, from the block stats index.\n"
+            "It requires -blockstatsindex.\n"
+            "\nArguments:\n"
+            "1. \"start_height\"       (numeric, required) The height of "
+            "the first block\n"
+            "2. \"stop_height\"        (numeric, required) The height of "
+            "the last block, at most " +
+            std::to_string(MAX_BLOCK_STATS_RANGE - 1) +
+            " blocks after the first one\n"
+            "3. \"stats\"              (array,  optional) Values to plot, by "
+            "default all values (see getblockstats)\n"
+            "    [\n"
+            "      \"height\",         (string, optional) Selected statistic\n"
+            "      \"time\",           (string, optional) Selected statistic\n"
+            "      ,...\n"
+            "    ]\n"
+            "\nResult:\n"
+            "[                           (json array)\n"
+            "  {...},                    (json object) The statistics of a "
+            "block, as returned by getblockstats\n"
+            "  ,...\n"
+            "]\n"
+            "\nExamples:\n" +
+            HelpExampleCli("getblockstatsrange",
+                           "1000 1999 '[\"height\",\"avgfeerate\"]'") +
+            HelpExampleRpc("getblockstatsrange",
+                           "1000, 1999, [\"height\",\"avgfeerate\"]"));
     }
 
-    UniValue ret(UniValue::VOBJ);
-    for (const std::string &stat : stats) {
-        const UniValue &value = ret_all[stat];
-        if (value.isNull()) {
+    if (!g_blockstatsindex) {
+        throw JSONRPCError(RPC_MISC_ERROR,
+                           "getblockstatsrange requires -blockstatsindex");
+    }
+
+    const int start_height = request.params[0].get_int();
+    const int stop_height = request.params[1].get_int();
+    const std::set<std::string> stats = ParseSelectedStats(request.params[2]);
+
+    if (start_height < 0 || start_height > stop_height) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER,
+                           strprintf("Invalid height range %d to %d",
+                                     start_height, stop_height));
+    }
+    if (stop_height - start_height >= MAX_BLOCK_STATS_RANGE) {
+        throw JSONRPCError(
+            RPC_INVALID_PARAMETER,
+            strprintf("Height range is limited to %d blocks",
+                      MAX_BLOCK_STATS_RANGE));
+    }
+
+    g_blockstatsindex->BlockUntilSyncedToCurrentChain();
+
+    const CBlockIndex *stop_index;
+    {
+        LOCK(cs_main);
+        const int current_tip = chainActive.Height();
+        if (stop_height > current_tip) {
             throw JSONRPCError(
                 RPC_INVALID_PARAMETER,
-                strprintf("Invalid selected statistic %s", stat));
+                strprintf("Target block height %d after current tip %d",
+                          stop_height, current_tip));
         }
-        ret.pushKV(stat, value);
+        stop_index = chainActive[stop_height];
+    }
+
+    std::vector<CBlockStats> block_stats;
+    if (!g_blockstatsindex->LookupStatsRange(start_height, stop_index,
+                                             block_stats)) {
+        throw JSONRPCError(RPC_MISC_ERROR,
+                           "Block statistics not yet indexed, or the chain "
+                           "changed during the call");
+    }
+
+    UniValue ret(UniValue::VARR);
+    for (size_t i = 0; i < block_stats.size(); i++) {
+        const CBlockIndex *pindex = stop_index->GetAncestor(start_height + i);
+        ret.push_back(
+            SelectBlockStats(BlockStatsToJSON(block_stats[i], pindex), stats));
     }
     return ret;
 }
@@ -2222,6 +2438,7 @@ static const ContextFreeRPCCommand commands[] = {
     { "blockchain",         "getblockhash",           getblockhash,           {"height"} },
     { "blockchain",         "getblockheader",         getblockheader,         {"blockhash","verbose"} },
     { "blockchain",         "getblockstats",          getblockstats,          {"hash_or_height","stats"} },
+    { "blockchain",         "getblockstatsrange",     getblockstatsrange,     {"start_height","stop_height","stats"} },
     { "blockchain",         "getchaintips",           getchaintips,           {} },
     { "blockchain",         "getchaintxstats",        getchaintxstats,        {"nblocks", "blockhash"} },
     { "blockchain",         "getdifficulty",          getdifficulty,          {} },
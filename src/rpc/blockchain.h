@@ -26,10 +26,24 @@ double GetDifficulty(const CBlockIndex *blockindex);
 /** Callback for when block tip changed. */
 void RPCNotifyBlockChange(bool ibd, const CBlockIndex *pindex);
 
+/**
+ * Blocks with at least this many transactions per core are written out on
+ * several threads by WriteBlockJSON.
+ */
+static const size_t PARALLEL_JSON_MIN_BLOCK_TXS = 1000;
+
 /** Block description to JSON */
 UniValue blockToJSON(const CBlock &block, const CBlockIndex *tip,
                      const CBlockIndex *blockindex, bool txDetails = false);
 
+/**
+ * Append the JSON encoding of blockToJSON(block, tip, blockindex, txDetails)
+ * to a string, without building the UniValue.
+ */
+void WriteBlockJSON(const CBlock &block, const CBlockIndex *tip,
+                    const CBlockIndex *blockindex, bool txDetails,
+                    std::string &json);
+
 /** Mempool information to JSON */
 UniValue MempoolInfoToJSON(const CTxMemPool &pool);
 
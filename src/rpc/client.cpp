@@ -122,6 +122,9 @@ static const CRPCConvertParam vRPCConvertParams[] = {
     {"verifychain", 1, "nblocks"},
     {"getblockstats", 0, "hash_or_height"},
     {"getblockstats", 1, "stats"},
+    {"getblockstatsrange", 0, "start_height"},
+    {"getblockstatsrange", 1, "stop_height"},
+    {"getblockstatsrange", 2, "stats"},
     {"pruneblockchain", 0, "height"},
     {"keypoolrefill", 0, "newsize"},
     {"getrawmempool", 0, "verbose"},
@@ -160,6 +163,9 @@ static const CRPCConvertParam vRPCConvertParams[] = {
     { "whc_getcrowdsale", 1, "" },
     { "whc_getgrants", 0, "" },
     { "whc_getbalance", 1, "" },
+    { "whc_getbalancesforaddresses", 0, "" },
+    { "whc_getbalancesforaddresses", 1, "" },
+    { "whc_getbalancesforaddresses", 2, "" },
     { "whc_getfrozenbalance", 1, "" },
     { "whc_getfrozenbalanceforid", 0, "" },
     { "whc_getproperty", 0, "" },
@@ -17,8 +17,15 @@ public:
     bool fHelp;
     std::string URI;
     std::string authUser;
+    /**
+     * Whether the result is only written out as JSON, so that the command can
+     * return it already encoded with JSONRPCRawResult.
+     */
+    bool fRawJSONAllowed;
 
-    JSONRPCRequest() : id(NullUniValue), params(NullUniValue), fHelp(false) {}
+    JSONRPCRequest()
+        : id(NullUniValue), params(NullUniValue), fHelp(false),
+          fRawJSONAllowed(false) {}
 
     void parse(const UniValue &valRequest);
 };
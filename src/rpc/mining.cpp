@@ -302,6 +302,11 @@ static UniValue prioritisetransaction(const Config &config,
 
     g_mempool.PrioritiseTransaction(hash, request.params[1].get_real(),
                                     nAmount);
+    // Modified fees change package selection, which the incremental template
+    // cannot account for.
+    if (g_block_template_cache) {
+        g_block_template_cache->Invalidate();
+    }
     return true;
 }
 
@@ -569,13 +574,14 @@ static UniValue getblocktemplate(const Config &config,
         // expires-immediately template to stop miners?
     }
 
-    // Update block
+    // Update block. When the template cache is available, updating the
+    // template is cheap and is done whenever the mempool changed.
     static CBlockIndex *pindexPrev;
     static int64_t nStart;
     static std::unique_ptr<CBlockTemplate> pblocktemplate;
     if (pindexPrev != chainActive.Tip() ||
         (g_mempool.GetTransactionsUpdated() != nTransactionsUpdatedLast &&
-         GetTime() - nStart > 5)) {
+         (g_block_template_cache || GetTime() - nStart > 5))) {
         // Clear pindexPrev so future calls make a new block, despite any
         // failures from here on
         pindexPrev = nullptr;
@@ -588,7 +594,10 @@ static UniValue getblocktemplate(const Config &config,
         // Create new block
         CScript scriptDummy = CScript() << OP_TRUE;
         pblocktemplate =
-            BlockAssembler(config, g_mempool).CreateNewBlock(scriptDummy);
+            g_block_template_cache
+                ? g_block_template_cache->GetBlockTemplate(scriptDummy)
+                : BlockAssembler(config, g_mempool)
+                      .CreateNewBlock(scriptDummy);
         if (!pblocktemplate) {
             throw JSONRPCError(RPC_OUT_OF_MEMORY, "Out of memory");
         }
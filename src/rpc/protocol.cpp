@@ -48,8 +48,16 @@ UniValue JSONRPCReplyObj(const UniValue &result, const UniValue &error,
 
 std::string JSONRPCReply(const UniValue &result, const UniValue &error,
                          const UniValue &id) {
-    UniValue reply = JSONRPCReplyObj(result, error, id);
-    return reply.write() + "\n";
+    // The same as JSONRPCReplyObj(result, error, id).write(), without copying
+    // the result, which can be large, into the reply object first.
+    std::string reply = "{\"result\":";
+    reply += error.isNull() ? result.write() : NullUniValue.write();
+    reply += ",\"error\":";
+    reply += error.write();
+    reply += ",\"id\":";
+    reply += id.write();
+    reply += "}\n";
+    return reply;
 }
 
 UniValue JSONRPCError(int code, const std::string &message) {
@@ -59,6 +67,11 @@ UniValue JSONRPCError(int code, const std::string &message) {
     return error;
 }
 
+UniValue JSONRPCRawResult(const std::string &json) {
+    // Numbers are written out verbatim.
+    return UniValue(UniValue::VNUM, json);
+}
+
 /** Username used when cookie authentication is in use (arbitrary, only for
  * recognizability in debugging/logging purposes)
  */
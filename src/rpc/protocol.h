@@ -131,6 +131,12 @@ UniValue JSONRPCReplyObj(const UniValue &result, const UniValue &error,
 std::string JSONRPCReply(const UniValue &result, const UniValue &error,
                          const UniValue &id);
 UniValue JSONRPCError(int code, const std::string &message);
+/**
+ * A result written out as the given JSON, which is already encoded. Such a
+ * result can't be inspected as a UniValue, so it must only be returned for
+ * requests with fRawJSONAllowed set.
+ */
+UniValue JSONRPCRawResult(const std::string &json);
 
 /** Generate a new RPC authentication cookie and write it to disk */
 bool GenerateAuthCookie(std::string *cookie_out);
@@ -25,6 +25,7 @@
 #include <script/standard.h>
 #include <txmempool.h>
 #include <uint256.h>
+#include <util/jsonwriter.h>
 #include <util/strencodings.h>
 #include <validation.h>
 #include <validationinterface.h>
@@ -64,6 +65,29 @@ static void TxToJSON(const CTransaction &tx, const uint256 hashBlock,
     }
 }
 
+/** The same as above, writing the fields into the object the writer is in. */
+static void TxToJSON(const CTransaction &tx, const uint256 hashBlock,
+                     JSONWriter &writer) {
+    WriteTxJSON(tx, uint256(), writer, true, RPCSerializationFlags());
+
+    if (!hashBlock.IsNull()) {
+        LOCK(cs_main);
+
+        writer.KV("blockhash", hashBlock.GetHex());
+        CBlockIndex *pindex = LookupBlockIndex(hashBlock);
+        if (pindex) {
+            if (chainActive.Contains(pindex)) {
+                writer.KV("confirmations",
+                          1 + chainActive.Height() - pindex->nHeight);
+                writer.KV("time", pindex->GetBlockTime());
+                writer.KV("blocktime", pindex->GetBlockTime());
+            } else {
+                writer.KV("confirmations", 0);
+            }
+        }
+    }
+}
+
 static UniValue getrawtransaction(const Config &config,
                                   const JSONRPCRequest &request) {
     if (request.fHelp || request.params.size() < 1 ||
@@ -231,6 +255,18 @@ static UniValue getrawtransaction(const Config &config,
         return EncodeHexTx(*tx, RPCSerializationFlags());
     }
 
+    if (request.fRawJSONAllowed) {
+        std::string json;
+        JSONWriter writer(json);
+        writer.BeginObject();
+        if (blockindex) {
+            writer.KV("in_active_chain", in_active_chain);
+        }
+        TxToJSON(*tx, hash_block, writer);
+        writer.EndObject();
+        return JSONRPCRawResult(json);
+    }
+
     UniValue result(UniValue::VOBJ);
     if (blockindex) {
         result.pushKV("in_active_chain", in_active_chain);
@@ -337,14 +373,21 @@ static UniValue gettxoutproof(const Config &config,
         }
     }
 
-    CBlock block;
-    if (!ReadBlockFromDisk(block, pblockindex, params)) {
-        throw JSONRPCError(RPC_INTERNAL_ERROR, "Can't read block from disk");
+    // Proofs for recent blocks are made from their cached Merkle tree, without
+    // reading the block again.
+    CMerkleTreeRef tree = LookupBlockMerkleTree(pblockindex->GetBlockHash());
+    if (!tree) {
+        CBlock block;
+        if (!ReadBlockFromDisk(block, pblockindex, params)) {
+            throw JSONRPCError(RPC_INTERNAL_ERROR,
+                               "Can't read block from disk");
+        }
+        tree = GetBlockMerkleTree(block);
     }
 
     unsigned int ntxFound = 0;
-    for (const auto &tx : block.vtx) {
-        if (setTxIds.count(tx->GetId())) {
+    for (const uint256 &txid : tree->GetLeaves()) {
+        if (setTxIds.count(TxId(txid))) {
             ntxFound++;
         }
     }
@@ -356,7 +399,7 @@ static UniValue gettxoutproof(const Config &config,
     }
 
     CDataStream ssMB(SER_NETWORK, PROTOCOL_VERSION);
-    CMerkleBlock mb(block, setTxIds);
+    CMerkleBlock mb(pblockindex->GetBlockHeader(), *tree, setTxIds);
     ssMB << mb;
     std::string strHex = HexStr(ssMB.begin(), ssMB.end());
     return strHex;
@@ -7,7 +7,9 @@
 #include <random.h>
 #include <reverselock.h>
 
+#include <algorithm>
 #include <cassert>
+#include <iterator>
 #include <utility>
 
 CScheduler::CScheduler()
@@ -57,15 +59,33 @@ void CScheduler::serviceQueue() {
                 continue;
             }
 
+            const boost::chrono::system_clock::time_point due =
+                taskQueue.begin()->first;
             Function f = taskQueue.begin()->second;
             taskQueue.erase(taskQueue.begin());
 
+            const boost::chrono::system_clock::time_point start =
+                boost::chrono::system_clock::now();
             {
                 // Unlock before calling f, so it can reschedule itself or
                 // another task without deadlocking:
                 reverse_lock<boost::unique_lock<boost::mutex>> rlock(lock);
                 f();
             }
+
+            const int64_t delay = std::max<int64_t>(
+                0, boost::chrono::duration_cast<boost::chrono::microseconds>(
+                       start - due)
+                       .count());
+            const int64_t runTime =
+                boost::chrono::duration_cast<boost::chrono::microseconds>(
+                    boost::chrono::system_clock::now() - start)
+                    .count();
+            stats.nTasksRun++;
+            stats.nTotalDelay += delay;
+            stats.nMaxDelay = std::max(stats.nMaxDelay, delay);
+            stats.nTotalRunTime += runTime;
+            stats.nMaxRunTime = std::max(stats.nMaxRunTime, runTime);
         } catch (...) {
             --nThreadsServicingQueue;
             throw;
@@ -133,6 +153,17 @@ bool CScheduler::AreThreadsServicingQueue() const {
     return nThreadsServicingQueue;
 }
 
+CSchedulerStats CScheduler::getStats() const {
+    boost::unique_lock<boost::mutex> lock(newTaskMutex);
+    CSchedulerStats ret = stats;
+    ret.nQueued = taskQueue.size();
+    ret.nDue = std::distance(
+        taskQueue.begin(),
+        taskQueue.upper_bound(boost::chrono::system_clock::now()));
+    ret.nThreads = nThreadsServicingQueue;
+    return ret;
+}
+
 void SingleThreadedSchedulerClient::MaybeScheduleProcessQueue() {
     {
         LOCK(m_cs_callbacks_pending);
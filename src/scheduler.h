@@ -17,9 +17,36 @@
 
 #include <map>
 
+//! Default number of threads servicing the scheduler queue
+static const int DEFAULT_SCHEDULER_THREADS = 2;
+//! Maximum number of threads servicing the scheduler queue
+static const int MAX_SCHEDULER_THREADS = 16;
+
+/**
+ * Load of a CScheduler. Times are in microseconds.
+ */
+struct CSchedulerStats {
+    //! Number of tasks in the queue
+    size_t nQueued = 0;
+    //! Number of tasks in the queue which are already due
+    size_t nDue = 0;
+    //! Number of threads servicing the queue
+    int nThreads = 0;
+    //! Number of tasks run so far
+    uint64_t nTasksRun = 0;
+    //! Time between when the tasks were due and when they started
+    int64_t nTotalDelay = 0;
+    int64_t nMaxDelay = 0;
+    //! Time spent running the tasks
+    int64_t nTotalRunTime = 0;
+    int64_t nMaxRunTime = 0;
+};
+
 //
 // Simple class for background tasks that should be run periodically or once
-// "after a while"
+// "after a while". Several threads can service the queue, in which case tasks
+// may run concurrently; use SingleThreadedSchedulerClient for tasks which must
+// run in order.
 //
 // Usage:
 //
@@ -76,6 +103,9 @@ public:
     // Returns true if there are threads actively running in serviceQueue()
     bool AreThreadsServicingQueue() const;
 
+    // Returns the queue depth and the latency of the tasks run so far
+    CSchedulerStats getStats() const;
+
 private:
     std::multimap<boost::chrono::system_clock::time_point, Function> taskQueue;
     boost::condition_variable newTaskScheduled;
@@ -83,6 +113,7 @@ private:
     int nThreadsServicingQueue;
     bool stopRequested;
     bool stopWhenEmpty;
+    CSchedulerStats stats;
     bool shouldStop() const {
         return stopRequested || (stopWhenEmpty && taskQueue.empty());
     }
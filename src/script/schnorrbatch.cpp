@@ -0,0 +1,86 @@
+// Copyright (c) 2019 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <script/schnorrbatch.h>
+
+#include <algorithm>
+
+bool SchnorrBatchVerifier::VerifyBatch(
+    const std::vector<DeferredSchnorrSig> &sigs) {
+    if (sigs.empty()) {
+        return true;
+    }
+
+    std::vector<const CPubKey *> pubkeys;
+    std::vector<const uint256 *> hashes;
+    std::vector<const uint8_t *> sigdata;
+    pubkeys.reserve(sigs.size());
+    hashes.reserve(sigs.size());
+    sigdata.reserve(sigs.size());
+    for (const DeferredSchnorrSig &sig : sigs) {
+        pubkeys.push_back(&sig.pubkey);
+        hashes.push_back(&sig.sighash);
+        sigdata.push_back(sig.sig.data());
+    }
+
+    if (CPubKey::VerifySchnorrBatch(pubkeys, hashes, sigdata)) {
+        return true;
+    }
+
+    // Fall back to individual checks, so that the outcome never depends on
+    // the batch.
+    for (const DeferredSchnorrSig &sig : sigs) {
+        std::vector<uint8_t> vchSig(sig.sig.begin(), sig.sig.end());
+        if (!sig.pubkey.VerifySchnorr(sig.sighash, vchSig)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool SchnorrBatchVerifier::Add(std::vector<DeferredSchnorrSig> &sigs) {
+    std::vector<DeferredSchnorrSig> batch;
+    {
+        LOCK(cs);
+        pending.insert(pending.end(), std::make_move_iterator(sigs.begin()),
+                       std::make_move_iterator(sigs.end()));
+        if (pending.size() < SCHNORR_BATCH_SIZE) {
+            return true;
+        }
+        batch.swap(pending);
+    }
+
+    return VerifyBatch(batch);
+}
+
+bool SchnorrBatchVerifier::Verify() {
+    std::vector<DeferredSchnorrSig> batch;
+    {
+        LOCK(cs);
+        batch.swap(pending);
+    }
+
+    return VerifyBatch(batch);
+}
+
+bool BatchingTransactionSignatureChecker::VerifySignature(
+    const std::vector<uint8_t> &vchSig, const CPubKey &pubkey,
+    const uint256 &sighash) const {
+    if (vchSig.size() != 64 || !pubkey.IsValid()) {
+        return CachingTransactionSignatureChecker::VerifySignature(
+            vchSig, pubkey, sighash);
+    }
+
+    if (IsCached(vchSig, pubkey, sighash)) {
+        return true;
+    }
+
+    DeferredSchnorrSig sig;
+    sig.pubkey = pubkey;
+    sig.sighash = sighash;
+    std::copy(vchSig.begin(), vchSig.end(), sig.sig.begin());
+    deferred.push_back(std::move(sig));
+    return true;
+}
@@ -0,0 +1,83 @@
+// Copyright (c) 2019 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_SCRIPT_SCHNORRBATCH_H
+#define BITCOIN_SCRIPT_SCHNORRBATCH_H
+
+#include <pubkey.h>
+#include <script/sigcache.h>
+#include <sync.h>
+#include <uint256.h>
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+/** Number of Schnorr signatures verified together by SchnorrBatchVerifier. */
+static const size_t SCHNORR_BATCH_SIZE = 64;
+
+/**
+ * A Schnorr signature that was deferred during script execution, along with
+ * what it signs.
+ */
+struct DeferredSchnorrSig {
+    CPubKey pubkey;
+    uint256 sighash;
+    std::array<uint8_t, 64> sig;
+};
+
+/**
+ * Collects the Schnorr signatures deferred by the script checks of a block and
+ * verifies them in batches. Whichever script check thread completes a batch
+ * verifies it, and the remainder is verified by Verify() once all the script
+ * checks are done. If a batch fails, its signatures are verified one by one.
+ */
+class SchnorrBatchVerifier {
+private:
+    Mutex cs;
+    std::vector<DeferredSchnorrSig> pending GUARDED_BY(cs);
+
+    static bool VerifyBatch(const std::vector<DeferredSchnorrSig> &sigs);
+
+public:
+    /**
+     * Queue sigs for verification. Returns false if a batch was completed and
+     * it contains an invalid signature.
+     */
+    bool Add(std::vector<DeferredSchnorrSig> &sigs);
+
+    /** Verify the signatures queued so far. */
+    bool Verify();
+};
+
+/**
+ * Signature checker that defers Schnorr signatures to a SchnorrBatchVerifier
+ * instead of verifying them, assuming they are valid.
+ *
+ * This is only correct when the script fails whenever a non-empty signature is
+ * invalid, so it must only be used with SCRIPT_VERIFY_NULLFAIL. Legacy
+ * CHECKMULTISIG, where failed signature checks are expected, never accepts
+ * Schnorr signatures. Deferred signatures are not added to the signature
+ * cache.
+ */
+class BatchingTransactionSignatureChecker
+    : public CachingTransactionSignatureChecker {
+private:
+    std::vector<DeferredSchnorrSig> &deferred;
+
+public:
+    BatchingTransactionSignatureChecker(
+        const CTransaction *txToIn, unsigned int nInIn, const Amount amountIn,
+        bool storeIn, PrecomputedTransactionData &txdataIn,
+        std::vector<DeferredSchnorrSig> &deferredIn)
+        : CachingTransactionSignatureChecker(txToIn, nInIn, amountIn, storeIn,
+                                             txdataIn),
+          deferred(deferredIn) {}
+
+    bool VerifySignature(const std::vector<uint8_t> &vchSig,
+                         const CPubKey &vchPubKey,
+                         const uint256 &sighash) const override;
+};
+
+#endif // BITCOIN_SCRIPT_SCHNORRBATCH_H
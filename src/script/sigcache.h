@@ -43,6 +43,7 @@ class CachingTransactionSignatureChecker : public TransactionSignatureChecker {
 private:
     bool store;
 
+protected:
     bool IsCached(const std::vector<uint8_t> &vchSig, const CPubKey &vchPubKey,
                   const uint256 &sighash) const;
 
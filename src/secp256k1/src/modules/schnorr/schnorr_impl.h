@@ -100,6 +100,176 @@ static int secp256k1_schnorr_sig_verify(
     return 1;
 }
 
+/**
+ * Batch verification, using option 2 above.
+ *
+ * With random 128-bit scalars a_i (a_0 = 1), the batch is valid iff
+ *   sum(a_i * R_i) + sum(a_i * e_i * P_i) - sum(a_i * s_i) * G == 0
+ * which is evaluated with a single chain of doublings (Strauss' algorithm), so
+ * that doublings are shared between all the signatures. If any signature is
+ * invalid, the batch passes with probability 2^-128 at most. The a_i are
+ * derived by hashing all the inputs, so they can't be chosen by whoever
+ * provides the signatures.
+ */
+static void secp256k1_schnorr_odd_multiples(
+    secp256k1_gej *prej,
+    const secp256k1_ge *a
+) {
+    secp256k1_gej d;
+    int i;
+
+    secp256k1_gej_set_ge(&prej[0], a);
+    secp256k1_gej_double_var(&d, &prej[0], NULL);
+    for (i = 1; i < ECMULT_TABLE_SIZE(WINDOW_A); i++) {
+        secp256k1_gej_add_var(&prej[i], &prej[i - 1], &d, NULL);
+    }
+}
+
+static int secp256k1_schnorr_sig_verify_batch(
+    const secp256k1_ecmult_context* ctx,
+    const secp256k1_callback* cb,
+    const unsigned char *const *sig64,
+    const unsigned char *const *msg32,
+    secp256k1_ge *pubkeys,
+    size_t n
+) {
+    const size_t table_size = ECMULT_TABLE_SIZE(WINDOW_A);
+    secp256k1_sha256 sha;
+    unsigned char seed[32];
+    unsigned char buf[33];
+    size_t size;
+    secp256k1_gej *prej;
+    secp256k1_ge *pre;
+    int *wnaf;
+    int *bits;
+    int wnaf_g[256];
+    int bits_g;
+    int max_bits;
+    secp256k1_scalar a, e, s, sum_s;
+    secp256k1_gej r;
+    secp256k1_ge tmp;
+    size_t i, j;
+    int k;
+    int ret = 0;
+
+    if (n == 0) {
+        return 1;
+    }
+
+    /* Seed the weights with everything that is being verified. */
+    secp256k1_sha256_initialize(&sha);
+    for (i = 0; i < n; i++) {
+        if (secp256k1_ge_is_infinity(&pubkeys[i])) {
+            return 0;
+        }
+
+        secp256k1_sha256_write(&sha, sig64[i], 64);
+        secp256k1_sha256_write(&sha, msg32[i], 32);
+        secp256k1_eckey_pubkey_serialize(&pubkeys[i], buf, &size, 1);
+        VERIFY_CHECK(size == 33);
+        secp256k1_sha256_write(&sha, buf, 33);
+    }
+    secp256k1_sha256_finalize(&sha, seed);
+
+    /* Points 2i and 2i + 1 are P_i and R_i. */
+    prej = (secp256k1_gej *)checked_malloc(cb, sizeof(secp256k1_gej) * 2 * n * table_size);
+    pre = (secp256k1_ge *)checked_malloc(cb, sizeof(secp256k1_ge) * 2 * n * table_size);
+    wnaf = (int *)checked_malloc(cb, sizeof(int) * 2 * n * 256);
+    bits = (int *)checked_malloc(cb, sizeof(int) * 2 * n);
+
+    secp256k1_scalar_clear(&sum_s);
+    max_bits = 0;
+    for (i = 0; i < n; i++) {
+        secp256k1_fe rx;
+        secp256k1_ge R;
+        int overflow = 0;
+
+        /* Extract s */
+        secp256k1_scalar_set_b32(&s, sig64[i] + 32, &overflow);
+        if (overflow) {
+            goto end;
+        }
+
+        /* Extract R.x and decompress R, with R.y a quadratic residue. */
+        if (!secp256k1_fe_set_b32(&rx, sig64[i])) {
+            goto end;
+        }
+        if (!secp256k1_ge_set_xquad(&R, &rx)) {
+            goto end;
+        }
+
+        /* Compute e */
+        secp256k1_schnorr_compute_e(&e, sig64[i], &pubkeys[i], msg32[i]);
+
+        /* a_0 = 1, the other weights are 128 bits of H(seed || i). */
+        if (i == 0) {
+            secp256k1_scalar_set_int(&a, 1);
+        } else {
+            unsigned char index[8];
+            for (j = 0; j < 8; j++) {
+                index[j] = (unsigned char)((uint64_t)i >> (8 * j));
+            }
+            secp256k1_sha256_initialize(&sha);
+            secp256k1_sha256_write(&sha, seed, 32);
+            secp256k1_sha256_write(&sha, index, 8);
+            secp256k1_sha256_finalize(&sha, buf);
+            memset(buf, 0, 16);
+            secp256k1_scalar_set_b32(&a, buf, NULL);
+        }
+
+        /* sum_s += a * s */
+        secp256k1_scalar_mul(&s, &s, &a);
+        secp256k1_scalar_add(&sum_s, &sum_s, &s);
+
+        /* P_i is weighted by a * e, R_i by a. */
+        secp256k1_scalar_mul(&e, &e, &a);
+        bits[2 * i] = secp256k1_ecmult_wnaf(&wnaf[2 * i * 256], 256, &e, WINDOW_A);
+        bits[2 * i + 1] = secp256k1_ecmult_wnaf(&wnaf[(2 * i + 1) * 256], 256, &a, WINDOW_A);
+        for (j = 2 * i; j < 2 * i + 2; j++) {
+            if (bits[j] > max_bits) {
+                max_bits = bits[j];
+            }
+        }
+
+        secp256k1_schnorr_odd_multiples(&prej[2 * i * table_size], &pubkeys[i]);
+        secp256k1_schnorr_odd_multiples(&prej[(2 * i + 1) * table_size], &R);
+    }
+
+    /* Bring all the tables to affine coordinates with a single inversion. */
+    secp256k1_ge_set_all_gej_var(pre, prej, 2 * n * table_size, cb);
+
+    secp256k1_scalar_negate(&sum_s, &sum_s);
+    bits_g = secp256k1_ecmult_wnaf(wnaf_g, 256, &sum_s, WINDOW_G);
+    if (bits_g > max_bits) {
+        max_bits = bits_g;
+    }
+
+    secp256k1_gej_set_infinity(&r);
+    for (k = max_bits - 1; k >= 0; k--) {
+        int m;
+        secp256k1_gej_double_var(&r, &r, NULL);
+        for (j = 0; j < 2 * n; j++) {
+            if (k < bits[j] && (m = wnaf[j * 256 + k])) {
+                ECMULT_TABLE_GET_GE(&tmp, &pre[j * table_size], m, WINDOW_A);
+                secp256k1_gej_add_ge_var(&r, &r, &tmp, NULL);
+            }
+        }
+        if (k < bits_g && (m = wnaf_g[k])) {
+            ECMULT_TABLE_GET_GE_STORAGE(&tmp, *ctx->pre_g, m, WINDOW_G);
+            secp256k1_gej_add_ge_var(&r, &r, &tmp, NULL);
+        }
+    }
+
+    ret = secp256k1_gej_is_infinity(&r);
+
+end:
+    free(bits);
+    free(wnaf);
+    free(pre);
+    free(prej);
+    return ret;
+}
+
 static int secp256k1_schnorr_compute_e(
     secp256k1_scalar* e,
     const unsigned char *r,
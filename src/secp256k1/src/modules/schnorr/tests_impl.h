@@ -78,6 +78,60 @@ void test_schnorr_sign_verify(void) {
 
 #undef SIG_COUNT
 
+#define SIG_COUNT 64
+
+void test_schnorr_batch_verify(void) {
+    unsigned char privkey[SIG_COUNT][32];
+    unsigned char msg[SIG_COUNT][32];
+    unsigned char sig[SIG_COUNT][64];
+    secp256k1_pubkey pubkey[SIG_COUNT];
+    const unsigned char *sigs[SIG_COUNT];
+    const unsigned char *msgs[SIG_COUNT];
+    const secp256k1_pubkey *pubkeys[SIG_COUNT];
+    int i, n;
+
+    for (i = 0; i < SIG_COUNT; i++) {
+        secp256k1_scalar key;
+        random_scalar_order_test(&key);
+        secp256k1_scalar_get_b32(privkey[i], &key);
+        secp256k1_rand256_test(msg[i]);
+        CHECK(secp256k1_ec_pubkey_create(ctx, &pubkey[i], privkey[i]) == 1);
+        CHECK(secp256k1_schnorr_sign(ctx, sig[i], msg[i], privkey[i], NULL, NULL) == 1);
+        sigs[i] = sig[i];
+        msgs[i] = msg[i];
+        pubkeys[i] = &pubkey[i];
+    }
+
+    /* Empty batch. */
+    CHECK(secp256k1_schnorr_verify_batch(ctx, NULL, NULL, NULL, 0) == 1);
+
+    for (n = 1; n <= SIG_COUNT; n += 1 + secp256k1_rand_int(8)) {
+        int pos = secp256k1_rand_int(n);
+        int byte = secp256k1_rand_bits(6);
+        int mod = 1 + secp256k1_rand_int(255);
+        const unsigned char *tmp;
+
+        CHECK(secp256k1_schnorr_verify_batch(ctx, sigs, msgs, pubkeys, n) == 1);
+
+        /* A single bad signature fails the whole batch. */
+        sig[pos][byte] ^= mod;
+        CHECK(secp256k1_schnorr_verify_batch(ctx, sigs, msgs, pubkeys, n) == 0);
+        sig[pos][byte] ^= mod;
+
+        /* So does a signature that is valid for another message. */
+        if (n > 1) {
+            tmp = msgs[0];
+            msgs[0] = msgs[n - 1];
+            msgs[n - 1] = tmp;
+            CHECK(secp256k1_schnorr_verify_batch(ctx, sigs, msgs, pubkeys, n) == 0);
+            msgs[n - 1] = msgs[0];
+            msgs[0] = tmp;
+        }
+    }
+}
+
+#undef SIG_COUNT
+
 void run_schnorr_compact_test(void) {
     {
         /* Test vector 1 */
@@ -516,6 +570,7 @@ void run_schnorr_tests(void) {
     }
 
     test_schnorr_sign_verify();
+    test_schnorr_batch_verify();
     run_schnorr_compact_test();
 }
 
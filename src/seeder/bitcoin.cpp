@@ -230,6 +230,17 @@ bool CSeederNode::ProcessMessages() {
     return false;
 }
 
+void CSeederNode::Begin() {
+    PushVersion();
+}
+
+void CSeederNode::Receive(const char *pch, size_t nBytes) {
+    int nPos = vRecv.size();
+    vRecv.resize(nPos + nBytes);
+    memcpy(&vRecv[nPos], pch, nBytes);
+    ProcessMessages();
+}
+
 CSeederNode::CSeederNode(const CService &ip, std::vector<CAddress> *vAddrIn)
     : sock(INVALID_SOCKET), vSend(SER_NETWORK, 0), vRecv(SER_NETWORK, 0),
       nHeaderStart(-1), nMessageStart(-1), nVersion(0), vAddr(vAddrIn), ban(0),
@@ -274,7 +285,7 @@ bool CSeederNode::Run() {
         return false;
     }
 
-    PushVersion();
+    Begin();
     Send();
 
     bool res = true;
@@ -300,22 +311,18 @@ bool CSeederNode::Run() {
             break;
         }
         int nBytes = recv(sock, pchBuf, sizeof(pchBuf), 0);
-        int nPos = vRecv.size();
-        if (nBytes > 0) {
-            vRecv.resize(nPos + nBytes);
-            memcpy(&vRecv[nPos], pchBuf, nBytes);
-        } else if (nBytes == 0) {
+        if (nBytes == 0) {
             // fprintf(stdout, "%s: BAD (connection closed prematurely)\n",
             //        ToString(you).c_str());
             res = false;
             break;
-        } else {
+        } else if (nBytes < 0) {
             // fprintf(stdout, "%s: BAD (connection error)\n",
             // ToString(you).c_str());
             res = false;
             break;
         }
-        ProcessMessages();
+        Receive(pchBuf, nBytes);
         Send();
     }
     if (sock == INVALID_SOCKET) res = false;
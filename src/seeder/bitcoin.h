@@ -35,8 +35,6 @@ private:
     int64_t doneAfter;
     CAddress you;
 
-    int GetTimeout() { return you.IsTor() ? 120 : 30; }
-
     void BeginMessage(const char *pszCommand);
 
     void AbortMessage();
@@ -58,6 +56,26 @@ public:
 
     bool Run();
 
+    /**
+     * Event-driven interface, used by CSeederCrawler. The caller connects to
+     * the node, calls Begin(), then passes what it receives to Receive() and
+     * sends what GetSendBuffer() holds until IsDone(). Waiting longer than
+     * GetTimeout() without reaching doneAfter counts as a failure.
+     */
+    void Begin();
+
+    void Receive(const char *pch, size_t nBytes);
+
+    CDataStream &GetSendBuffer() { return vSend; }
+
+    bool IsDone(int64_t now) const {
+        return ban != 0 || (doneAfter != 0 && doneAfter <= now);
+    }
+
+    int64_t GetDoneAfter() const { return doneAfter; }
+
+    int GetTimeout() const { return you.IsTor() ? 120 : 30; }
+
     int GetBan() { return ban; }
 
     int GetClientVersion() { return nVersion; }
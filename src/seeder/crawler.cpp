@@ -0,0 +1,332 @@
+// Copyright (c) 2019 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <seeder/crawler.h>
+
+#include <netbase.h>
+#include <seeder/bitcoin.h>
+#include <support/events.h>
+#include <util/time.h>
+
+#include <event2/buffer.h>
+#include <event2/bufferevent.h>
+
+#include <algorithm>
+#include <ctime>
+#include <set>
+
+/**
+ * How often each event loop reports results and starts new probes.
+ */
+static const int CRAWLER_REFILL_MILLISECONDS = 100;
+
+struct CSeederCrawler::Probe {
+    Worker &worker;
+    CServiceResult result;
+    std::vector<CAddress> vAddr;
+    CSeederNode node;
+    struct bufferevent *bev = nullptr;
+    raii_event timer;
+
+    Probe(Worker &workerIn, const CServiceResult &resultIn, bool fGetAddr)
+        : worker(workerIn), result(resultIn),
+          node(resultIn.service, fGetAddr ? &vAddr : nullptr) {}
+    ~Probe() {
+        if (bev) {
+            bufferevent_free(bev);
+        }
+    }
+};
+
+class CSeederCrawler::Worker {
+public:
+    explicit Worker(CSeederCrawler &crawlerIn)
+        : crawler(crawlerIn), base(obtain_event_base()) {
+        refill = obtain_event(base.get(), -1, EV_PERSIST, RefillCallback, this);
+        struct timeval tv = {0, CRAWLER_REFILL_MILLISECONDS * 1000};
+        event_add(refill.get(), &tv);
+    }
+
+    ~Worker() {
+        for (Probe *probe : probes) {
+            delete probe;
+        }
+    }
+
+    void Run() {
+        event_base_dispatch(base.get());
+
+        // Report what is done and give back the addresses still being probed.
+        Report();
+        for (Probe *probe : probes) {
+            crawler.db.Skipped(probe->result.service);
+        }
+    }
+
+private:
+    // Worker and probes are only accessed from the thread running the loop.
+    CSeederCrawler &crawler;
+    raii_event_base base;
+    raii_event refill;
+    std::set<Probe *> probes;
+    int64_t nNextRefill = 0;
+
+    std::vector<CServiceResult> results;
+    std::vector<CAddress> addrs;
+
+    void Report() {
+        if (!results.empty()) {
+            crawler.db.ResultMany(results);
+            results.clear();
+        }
+        if (!addrs.empty()) {
+            crawler.db.Add(addrs);
+            addrs.clear();
+        }
+    }
+
+    void Refill() {
+        if (crawler.fStop) {
+            event_base_loopbreak(base.get());
+            return;
+        }
+
+        Report();
+
+        int64_t now = GetTimeMillis();
+        if (now < nNextRefill) {
+            return;
+        }
+
+        // Addresses waiting for a proxy thread count against the budget too.
+        int nFree = crawler.nMaxProbes - int(probes.size()) -
+                    int(crawler.GetProxyQueueSize() / crawler.nThreads);
+        if (nFree <= 0) {
+            return;
+        }
+
+        std::vector<CServiceResult> ips;
+        int wait = 5;
+        crawler.db.GetMany(ips, nFree, wait);
+        if (ips.empty()) {
+            nNextRefill = now + wait * 1000;
+            return;
+        }
+
+        for (const CServiceResult &ip : ips) {
+            proxyType proxy;
+            if (GetProxy(ip.service.GetNetwork(), proxy)) {
+                crawler.QueueProxied(ip);
+            } else {
+                StartProbe(ip);
+            }
+        }
+    }
+
+    void StartProbe(const CServiceResult &ip) {
+        bool getaddr = ip.ourLastSuccess + 86400 < time(nullptr);
+        Probe *probe = new Probe(*this, ip, getaddr);
+        probes.insert(probe);
+
+        struct sockaddr_storage sockaddr;
+        socklen_t len = sizeof(sockaddr);
+        if (!ip.service.IsValid() ||
+            !ip.service.GetSockAddr((struct sockaddr *)&sockaddr, &len)) {
+            Finish(probe, false);
+            return;
+        }
+
+        probe->bev =
+            bufferevent_socket_new(base.get(), -1, BEV_OPT_CLOSE_ON_FREE);
+        probe->timer = obtain_event(base.get(), -1, 0, TimeoutCallback, probe);
+        if (!probe->bev || !probe->timer) {
+            Finish(probe, false);
+            return;
+        }
+
+        bufferevent_setcb(probe->bev, ReadCallback, nullptr, EventCallback,
+                          probe);
+        bufferevent_enable(probe->bev, EV_READ | EV_WRITE);
+        struct timeval tv = {nConnectTimeout / 1000,
+                             (nConnectTimeout % 1000) * 1000};
+        event_add(probe->timer.get(), &tv);
+
+        // libevent may report a failed connect through EventCallback before
+        // returning, in which case the probe is already finished.
+        if (bufferevent_socket_connect(probe->bev, (struct sockaddr *)&sockaddr,
+                                       len) < 0 &&
+            probes.count(probe)) {
+            Finish(probe, false);
+        }
+    }
+
+    void Flush(Probe *probe) {
+        CDataStream &vSend = probe->node.GetSendBuffer();
+        if (!vSend.empty()) {
+            bufferevent_write(probe->bev, vSend.data(), vSend.size());
+            vSend.clear();
+        }
+    }
+
+    // Wait for the next message, as CSeederNode::Run does.
+    void Wait(Probe *probe) {
+        int64_t now = time(nullptr);
+        if (probe->node.IsDone(now)) {
+            Finish(probe, true);
+            return;
+        }
+
+        int64_t doneAfter = probe->node.GetDoneAfter();
+        struct timeval tv = {
+            doneAfter ? doneAfter - now : probe->node.GetTimeout(), 0};
+        event_add(probe->timer.get(), &tv);
+    }
+
+    void Finish(Probe *probe, bool fGood) {
+        CServiceResult &res = probe->result;
+        int ban = probe->node.GetBan();
+        res.fGood = fGood && ban == 0;
+        res.nBanTime = res.fGood ? 0 : ban;
+        res.nClientV = probe->node.GetClientVersion();
+        res.strClientV = probe->node.GetClientSubVersion();
+        res.nHeight = probe->node.GetStartingHeight();
+        results.push_back(res);
+        addrs.insert(addrs.end(), probe->vAddr.begin(), probe->vAddr.end());
+
+        probes.erase(probe);
+        delete probe;
+        crawler.nProbes++;
+
+        // Do not leave the loop idle until the next tick.
+        if (probes.size() < size_t(crawler.nMaxProbes) / 2) {
+            event_active(refill.get(), EV_TIMEOUT, 0);
+        }
+    }
+
+    static void RefillCallback(evutil_socket_t, short, void *ctx) {
+        static_cast<Worker *>(ctx)->Refill();
+    }
+
+    static void ReadCallback(struct bufferevent *bev, void *ctx) {
+        Probe *probe = static_cast<Probe *>(ctx);
+        struct evbuffer *input = bufferevent_get_input(bev);
+        char pchBuf[0x10000];
+        int nBytes;
+        try {
+            while (probe->node.GetBan() == 0 &&
+                   (nBytes = evbuffer_remove(input, pchBuf, sizeof(pchBuf))) >
+                       0) {
+                probe->node.Receive(pchBuf, nBytes);
+            }
+        } catch (std::ios_base::failure &e) {
+            probe->worker.Finish(probe, false);
+            return;
+        }
+
+        probe->worker.Flush(probe);
+        probe->worker.Wait(probe);
+    }
+
+    static void EventCallback(struct bufferevent *bev, short what, void *ctx) {
+        Probe *probe = static_cast<Probe *>(ctx);
+        if (what & BEV_EVENT_CONNECTED) {
+            probe->node.Begin();
+            probe->worker.Flush(probe);
+            probe->worker.Wait(probe);
+        } else if (what & (BEV_EVENT_EOF | BEV_EVENT_ERROR)) {
+            // Connection failed or closed prematurely.
+            probe->worker.Finish(probe, false);
+        }
+    }
+
+    static void TimeoutCallback(evutil_socket_t, short, void *ctx) {
+        Probe *probe = static_cast<Probe *>(ctx);
+        // Only a node which answered to our version gets to time out with
+        // success.
+        probe->worker.Finish(probe, probe->node.GetDoneAfter() != 0);
+    }
+};
+
+CSeederCrawler::CSeederCrawler(CAddrDb &dbIn, int nThreadsIn,
+                               int nMaxProbesIn)
+    : db(dbIn), nThreads(std::max(nThreadsIn, 1)),
+      nMaxProbes(std::max(nMaxProbesIn, 1)) {}
+
+CSeederCrawler::~CSeederCrawler() {
+    Stop();
+}
+
+void CSeederCrawler::Start() {
+    fStop = false;
+    for (int i = 0; i < nThreads; i++) {
+        workers.emplace_back(new Worker(*this));
+        Worker *worker = workers.back().get();
+        threads.emplace_back([worker]() { worker->Run(); });
+    }
+    for (int i = 0; i < CRAWLER_PROXY_THREADS; i++) {
+        threads.emplace_back([this]() { ThreadProxy(); });
+    }
+}
+
+void CSeederCrawler::Stop() {
+    {
+        LOCK(cs_proxy);
+        fStop = true;
+    }
+    cond_proxy.notify_all();
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+    threads.clear();
+    workers.clear();
+
+    LOCK(cs_proxy);
+    for (const CServiceResult &ip : proxyQueue) {
+        db.Skipped(ip.service);
+    }
+    proxyQueue.clear();
+}
+
+void CSeederCrawler::QueueProxied(const CServiceResult &ip) {
+    {
+        LOCK(cs_proxy);
+        proxyQueue.push_back(ip);
+    }
+    cond_proxy.notify_one();
+}
+
+size_t CSeederCrawler::GetProxyQueueSize() {
+    LOCK(cs_proxy);
+    return proxyQueue.size();
+}
+
+void CSeederCrawler::ThreadProxy() {
+    while (true) {
+        CServiceResult res;
+        {
+            WAIT_LOCK(cs_proxy, lock);
+            cond_proxy.wait(lock, [this]() EXCLUSIVE_LOCKS_REQUIRED(cs_proxy) {
+                return fStop || !proxyQueue.empty();
+            });
+            if (fStop) {
+                return;
+            }
+            res = proxyQueue.front();
+            proxyQueue.pop_front();
+        }
+
+        std::vector<CAddress> addr;
+        bool getaddr = res.ourLastSuccess + 86400 < time(nullptr);
+        res.nBanTime = 0;
+        res.nClientV = 0;
+        res.nHeight = 0;
+        res.strClientV = "";
+        res.fGood = TestNode(res.service, res.nBanTime, res.nClientV,
+                             res.strClientV, res.nHeight,
+                             getaddr ? &addr : nullptr);
+        db.ResultMany({res});
+        db.Add(addr);
+        nProbes++;
+    }
+}
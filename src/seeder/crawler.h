@@ -0,0 +1,68 @@
+// Copyright (c) 2019 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_SEEDER_CRAWLER_H
+#define BITCOIN_SEEDER_CRAWLER_H
+
+#include <seeder/db.h>
+#include <sync.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <vector>
+
+//! Default number of event-driven crawler threads, 0 uses blocking crawlers
+static const int DEFAULT_NUM_EVENT_THREADS = 0;
+//! Default maximum number of probes in flight per event-driven thread
+static const int DEFAULT_MAX_PROBES_PER_THREAD = 1024;
+//! Number of threads probing the addresses reached through a proxy
+static const int CRAWLER_PROXY_THREADS = 8;
+
+/**
+ * Crawls the network from a few threads, each running a libevent loop which
+ * multiplexes up to nMaxProbes outstanding handshakes, instead of running one
+ * blocking TestNode per thread. Results are reported to the database in
+ * batches.
+ *
+ * Connecting through a proxy is blocking, so the addresses which need one are
+ * handed to CRAWLER_PROXY_THREADS threads running TestNode.
+ */
+class CSeederCrawler {
+public:
+    CSeederCrawler(CAddrDb &dbIn, int nThreadsIn, int nMaxProbesIn);
+    ~CSeederCrawler();
+
+    void Start();
+    void Stop();
+
+    //! Number of probes completed so far.
+    uint64_t GetProbeCount() const { return nProbes; }
+
+private:
+    struct Probe;
+    class Worker;
+
+    CAddrDb &db;
+    const int nThreads;
+    const int nMaxProbes;
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<std::thread> threads;
+    std::atomic<bool> fStop{false};
+    std::atomic<uint64_t> nProbes{0};
+
+    Mutex cs_proxy;
+    std::condition_variable cond_proxy;
+    std::deque<CServiceResult> proxyQueue GUARDED_BY(cs_proxy);
+
+    void QueueProxied(const CServiceResult &ip);
+    size_t GetProxyQueueSize();
+    void ThreadProxy();
+};
+
+#endif // BITCOIN_SEEDER_CRAWLER_H
@@ -1,5 +1,6 @@
 #include <seeder/db.h>
 
+#include <algorithm>
 #include <cstdlib>
 
 void CAddrInfo::Update(bool good) {
@@ -32,7 +33,7 @@ void CAddrInfo::Update(bool good) {
     //  + 1.0 - stat1W.weight), stat1W.count);
 }
 
-bool CAddrDb::Get_(CServiceResult &ip, int &wait) {
+bool CAddrDbShard::Get_(CServiceResult &ip, int &wait) {
     int64_t now = time(nullptr);
     size_t tot = unkId.size() + ourId.size();
     if (tot == 0) {
@@ -50,7 +51,10 @@ bool CAddrDb::Get_(CServiceResult &ip, int &wait) {
             unkId.erase(it);
         } else {
             ret = ourId.front();
-            if (time(nullptr) - idToInfo[ret].ourLastTry < MIN_RETRY) {
+            const int64_t sinceLastTry =
+                time(nullptr) - idToInfo[ret].ourLastTry;
+            if (sinceLastTry < MIN_RETRY) {
+                wait = std::min<int64_t>(wait, MIN_RETRY - sinceLastTry);
                 return false;
             }
             ourId.pop_front();
@@ -70,13 +74,13 @@ bool CAddrDb::Get_(CServiceResult &ip, int &wait) {
     return true;
 }
 
-int CAddrDb::Lookup_(const CService &ip) {
+int CAddrDbShard::Lookup_(const CService &ip) {
     if (ipToId.count(ip)) return ipToId[ip];
     return -1;
 }
 
-void CAddrDb::Good_(const CService &addr, int clientV, std::string clientSV,
-                    int blocks) {
+void CAddrDbShard::Good_(const CService &addr, int clientV,
+                         std::string clientSV, int blocks) {
     int id = Lookup_(addr);
     if (id == -1) return;
     unkId.erase(id);
@@ -95,7 +99,7 @@ void CAddrDb::Good_(const CService &addr, int clientV, std::string clientSV,
     ourId.push_back(id);
 }
 
-void CAddrDb::Bad_(const CService &addr, int ban) {
+void CAddrDbShard::Bad_(const CService &addr, int ban) {
     int id = Lookup_(addr);
     if (id == -1) return;
     unkId.erase(id);
@@ -125,7 +129,7 @@ void CAddrDb::Bad_(const CService &addr, int ban) {
     nDirty++;
 }
 
-void CAddrDb::Skipped_(const CService &addr) {
+void CAddrDbShard::Skipped_(const CService &addr) {
     int id = Lookup_(addr);
     if (id == -1) return;
     unkId.erase(id);
@@ -134,7 +138,7 @@ void CAddrDb::Skipped_(const CService &addr) {
     nDirty++;
 }
 
-void CAddrDb::Add_(const CAddress &addr, bool force) {
+void CAddrDbShard::Add_(const CAddress &addr, bool force) {
     if (!force && !addr.IsRoutable()) {
         return;
     }
@@ -175,52 +179,93 @@ void CAddrDb::Add_(const CAddress &addr, bool force) {
     nDirty++;
 }
 
-void CAddrDb::GetIPs_(std::set<CNetAddr> &ips, uint64_t requestedFlags,
-                      uint32_t max, const bool *nets) {
-    if (goodId.size() == 0) {
-        int id = -1;
-        if (ourId.size() == 0) {
-            if (unkId.size() == 0) {
-                return;
-            }
-            id = *unkId.begin();
-        } else {
-            id = *ourId.begin();
-        }
-
-        if (id >= 0 &&
-            (idToInfo[id].services & requestedFlags) == requestedFlags) {
-            ips.insert(idToInfo[id].ip);
-        }
+void CAddrDbShard::Load_(const CAddrInfo &info) {
+    if (info.GetBanTime()) {
         return;
     }
+    int id = nId++;
+    idToInfo[id] = info;
+    ipToId[info.ip] = id;
+    if (info.ourLastTry) {
+        ourId.push_back(id);
+        if (info.IsGood()) goodId.insert(id);
+    } else {
+        unkId.insert(id);
+    }
+    nDirty++;
+}
 
-    std::vector<int> goodIdFiltered;
+void CAddrDbShard::GetGoodIPs_(std::vector<CService> &ips,
+                               uint64_t requestedFlags) {
     for (auto &id : goodId) {
         if ((idToInfo[id].services & requestedFlags) == requestedFlags) {
-            goodIdFiltered.push_back(id);
+            ips.push_back(idToInfo[id].ip);
+        }
+    }
+}
+
+bool CAddrDbShard::GetAnyIP_(CService &ip, uint64_t requestedFlags) {
+    int id = -1;
+    if (ourId.size() == 0) {
+        if (unkId.size() == 0) {
+            return false;
         }
+        id = *unkId.begin();
+    } else {
+        id = *ourId.begin();
+    }
+
+    if ((idToInfo[id].services & requestedFlags) != requestedFlags) {
+        return false;
+    }
+    ip = idToInfo[id].ip;
+    return true;
+}
+
+void CAddrDb::GetIPs(std::set<CNetAddr> &ips, uint64_t requestedFlags,
+                     uint32_t max, const bool *nets) {
+    std::vector<CService> goodIPs;
+    size_t nGood = 0;
+    for (CAddrDbShard &shard : shards) {
+        LOCK(shard.cs);
+        nGood += shard.goodId.size();
+        shard.GetGoodIPs_(goodIPs, requestedFlags);
+    }
+
+    if (nGood == 0) {
+        for (CAddrDbShard &shard : shards) {
+            LOCK(shard.cs);
+            if (shard.ourId.size() == 0 && shard.unkId.size() == 0) {
+                continue;
+            }
+            CService ip;
+            if (shard.GetAnyIP_(ip, requestedFlags)) {
+                ips.insert(ip);
+            }
+            return;
+        }
+        return;
     }
 
-    if (!goodIdFiltered.size()) {
+    if (!goodIPs.size()) {
         return;
     }
 
-    if (max > goodIdFiltered.size() / 2) {
-        max = goodIdFiltered.size() / 2;
+    if (max > goodIPs.size() / 2) {
+        max = goodIPs.size() / 2;
     }
 
     if (max < 1) {
         max = 1;
     }
 
-    std::set<int> ids;
-    while (ids.size() < max) {
-        ids.insert(goodIdFiltered[rand() % goodIdFiltered.size()]);
+    std::set<size_t> picked;
+    while (picked.size() < max) {
+        picked.insert(rand() % goodIPs.size());
     }
 
-    for (auto &id : ids) {
-        CService &ip = idToInfo[id].ip;
+    for (size_t i : picked) {
+        const CService &ip = goodIPs[i];
         if (nets[ip.GetNetwork()]) {
             ips.insert(ip);
         }
@@ -8,6 +8,9 @@
 #include <sync.h>
 #include <version.h>
 
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <cmath>
 #include <cstdint>
 #include <deque>
@@ -178,6 +181,7 @@ public:
     void Update(bool good);
 
     friend class CAddrDb;
+    friend class CAddrDbShard;
 
     ADD_SERIALIZE_METHODS;
 
@@ -234,6 +238,13 @@ struct CServiceResult {
     int64_t ourLastSuccess;
 };
 
+/**
+ * Number of shards the address database is split into. Each shard has its own
+ * lock, so that crawlers reporting results for different addresses do not
+ * contend with each other.
+ */
+static const size_t ADDRDB_SHARD_COUNT = 16;
+
 /**
  *             seen nodes
  *            /          \
@@ -242,8 +253,11 @@ struct CServiceResult {
  *               tracked nodes   (b) unknown nodes   (e) active nodes
  *              /           \
  *     (d) good nodes   (c) non-good nodes
+ *
+ * The part of the address database holding the addresses which hash to it.
+ * Only used through CAddrDb.
  */
-class CAddrDb {
+class CAddrDbShard {
 private:
     mutable CCriticalSection cs;
     // number of address id's
@@ -259,15 +273,18 @@ private:
     // set of good nodes  (d, good e)
     std::set<int> goodId;
     int nDirty;
+    // nodes that are banned, with their unban time (a)
+    std::map<CService, int64_t> banned;
 
-protected:
     // internal routines that assume proper locks are acquired
     // add an address
     void Add_(const CAddress &addr, bool force);
+    // add an address read from disk
+    void Load_(const CAddrInfo &info);
     // get an IP to test (must call Good_, Bad_, or Skipped_ on result
-    // afterwards)
+    // afterwards). When there is none, wait may be lowered to the number of
+    // seconds until there is one.
     bool Get_(CServiceResult &ip, int &wait);
-    bool GetMany_(std::vector<CServiceResult> &ips, int max, int &wait);
     // mark an IP as good (must have been returned by Get_)
     void Good_(const CService &ip, int clientV, std::string clientSV,
                int blocks);
@@ -278,43 +295,77 @@ protected:
     void Skipped_(const CService &ip);
     // look up id of an IP
     int Lookup_(const CService &ip);
-    // get a random set of IPs (shared lock only)
-    void GetIPs_(std::set<CNetAddr> &ips, uint64_t requestedFlags, uint32_t max,
-                 const bool *nets);
+    // get the good IPs with the requested flags
+    void GetGoodIPs_(std::vector<CService> &ips, uint64_t requestedFlags);
+    // get an IP to return when there is no good one, if any
+    bool GetAnyIP_(CService &ip, uint64_t requestedFlags);
 
 public:
-    // nodes that are banned, with their unban time (a)
-    std::map<CService, int64_t> banned;
+    CAddrDbShard() : nId(0), nDirty(0) {}
+
+    friend class CAddrDb;
+};
 
+class CAddrDb {
+private:
+    std::array<CAddrDbShard, ADDRDB_SHARD_COUNT> shards;
+    // shard Get starts looking for an address to test in
+    std::atomic<size_t> nNextShard{0};
+
+    size_t GetShardIndex(const CService &ip) const {
+        return (ip.GetHash() ^ ip.GetPort()) % ADDRDB_SHARD_COUNT;
+    }
+    CAddrDbShard &GetShard(const CService &ip) {
+        return shards[GetShardIndex(ip)];
+    }
+
+public:
     void GetStats(CAddrDbStats &stats) const {
-        LOCK(cs);
-        stats.nBanned = banned.size();
-        stats.nAvail = idToInfo.size();
-        stats.nTracked = ourId.size();
-        stats.nGood = goodId.size();
-        stats.nNew = unkId.size();
-        if (ourId.size() > 0) {
-            stats.nAge = time(nullptr) - idToInfo.at(ourId.at(0)).ourLastTry;
-        } else {
-            stats.nAge = 0;
+        stats = {};
+        int64_t now = time(nullptr);
+        for (const CAddrDbShard &shard : shards) {
+            LOCK(shard.cs);
+            stats.nBanned += shard.banned.size();
+            stats.nAvail += shard.idToInfo.size();
+            stats.nTracked += shard.ourId.size();
+            stats.nGood += shard.goodId.size();
+            stats.nNew += shard.unkId.size();
+            if (shard.ourId.size() > 0) {
+                int nAge =
+                    now - shard.idToInfo.at(shard.ourId.at(0)).ourLastTry;
+                stats.nAge = std::max(stats.nAge, nAge);
+            }
         }
     }
 
     void ResetIgnores() {
-        for (std::map<int, CAddrInfo>::iterator it = idToInfo.begin();
-             it != idToInfo.end(); it++) {
-            (*it).second.ignoreTill = 0;
+        for (CAddrDbShard &shard : shards) {
+            LOCK(shard.cs);
+            for (std::map<int, CAddrInfo>::iterator it =
+                     shard.idToInfo.begin();
+                 it != shard.idToInfo.end(); it++) {
+                (*it).second.ignoreTill = 0;
+            }
+        }
+    }
+
+    void ClearBanned() {
+        for (CAddrDbShard &shard : shards) {
+            LOCK(shard.cs);
+            shard.banned.clear();
         }
     }
 
     std::vector<CAddrReport> GetAll() {
         std::vector<CAddrReport> ret;
-        LOCK(cs);
-        for (std::deque<int>::const_iterator it = ourId.begin();
-             it != ourId.end(); it++) {
-            const CAddrInfo &info = idToInfo[*it];
-            if (info.success > 0) {
-                ret.push_back(info.GetReport());
+        for (CAddrDbShard &shard : shards) {
+            LOCK(shard.cs);
+            for (std::deque<int>::const_iterator it = shard.ourId.begin();
+                 it != shard.ourId.end(); it++) {
+                const CAddrInfo &info = shard.idToInfo[*it];
+                if (info.success > 0) {
+                    ret.push_back(info.GetReport());
+                }
             }
         }
         return ret;
@@ -326,123 +377,164 @@ public:
     //   n (number of ips in (b,c,d))
     //   CAddrInfo[n]
     //   banned
-    // acquires a shared lock (this does not suffice for read mode, but we
-    // assume that only happens at startup, single-threaded) this way, dumping
-    // does not interfere with GetIPs_, which is called from the DNS thread
+    // acquires the shard locks one at a time (this does not suffice for read
+    // mode, but we assume that only happens at startup, single-threaded) this
+    // way, dumping does not interfere with GetIPs, which is called from the
+    // DNS thread, for longer than it takes to copy one shard
     template <typename Stream> void Serialize(Stream &s) const {
-        LOCK(cs);
-
         int nVersion = 0;
         s << nVersion;
 
-        CAddrDb *db = const_cast<CAddrDb *>(this);
-        int n = ourId.size() + unkId.size();
+        std::vector<CAddrInfo> tried, unknown;
+        std::map<CService, int64_t> banned;
+        for (const CAddrDbShard &shard : shards) {
+            LOCK(shard.cs);
+            for (int id : shard.ourId) {
+                tried.push_back(shard.idToInfo.at(id));
+            }
+            for (int id : shard.unkId) {
+                unknown.push_back(shard.idToInfo.at(id));
+            }
+            banned.insert(shard.banned.begin(), shard.banned.end());
+        }
+
+        int n = tried.size() + unknown.size();
         s << n;
-        for (std::deque<int>::const_iterator it = ourId.begin();
-             it != ourId.end(); it++) {
-            std::map<int, CAddrInfo>::iterator ci = db->idToInfo.find(*it);
-            s << (*ci).second;
+        for (const CAddrInfo &info : tried) {
+            s << info;
         }
-        for (std::set<int>::const_iterator it = unkId.begin();
-             it != unkId.end(); it++) {
-            std::map<int, CAddrInfo>::iterator ci = db->idToInfo.find(*it);
-            s << (*ci).second;
+        for (const CAddrInfo &info : unknown) {
+            s << info;
         }
         s << banned;
     }
 
     template <typename Stream> void Unserialize(Stream &s) {
-        LOCK(cs);
-
         int nVersion;
         s >> nVersion;
 
-        CAddrDb *db = const_cast<CAddrDb *>(this);
-        db->nId = 0;
         int n;
         s >> n;
         for (int i = 0; i < n; i++) {
             CAddrInfo info;
             s >> info;
-            if (!info.GetBanTime()) {
-                int id = db->nId++;
-                db->idToInfo[id] = info;
-                db->ipToId[info.ip] = id;
-                if (info.ourLastTry) {
-                    db->ourId.push_back(id);
-                    if (info.IsGood()) db->goodId.insert(id);
-                } else {
-                    db->unkId.insert(id);
-                }
-            }
+            CAddrDbShard &shard = GetShard(info.ip);
+            LOCK(shard.cs);
+            shard.Load_(info);
         }
-        db->nDirty++;
 
+        std::map<CService, int64_t> banned;
         s >> banned;
+        for (const std::pair<const CService, int64_t> &ban : banned) {
+            CAddrDbShard &shard = GetShard(ban.first);
+            LOCK(shard.cs);
+            shard.banned.insert(ban);
+        }
     }
 
     void Add(const CAddress &addr, bool fForce = false) {
-        LOCK(cs);
-        Add_(addr, fForce);
+        CAddrDbShard &shard = GetShard(addr);
+        LOCK(shard.cs);
+        shard.Add_(addr, fForce);
     }
 
     void Add(const std::vector<CAddress> &vAddr, bool fForce = false) {
-        LOCK(cs);
-        for (size_t i = 0; i < vAddr.size(); i++) {
-            Add_(vAddr[i], fForce);
+        std::array<std::vector<const CAddress *>, ADDRDB_SHARD_COUNT> byShard;
+        for (const CAddress &addr : vAddr) {
+            byShard[GetShardIndex(addr)].push_back(&addr);
+        }
+        for (size_t i = 0; i < ADDRDB_SHARD_COUNT; i++) {
+            if (byShard[i].empty()) {
+                continue;
+            }
+            LOCK(shards[i].cs);
+            for (const CAddress *addr : byShard[i]) {
+                shards[i].Add_(*addr, fForce);
+            }
         }
     }
 
     void Good(const CService &addr, int clientVersion,
               std::string clientSubVersion, int blocks) {
-        LOCK(cs);
-        Good_(addr, clientVersion, clientSubVersion, blocks);
+        CAddrDbShard &shard = GetShard(addr);
+        LOCK(shard.cs);
+        shard.Good_(addr, clientVersion, clientSubVersion, blocks);
     }
 
     void Skipped(const CService &addr) {
-        LOCK(cs);
-        Skipped_(addr);
+        CAddrDbShard &shard = GetShard(addr);
+        LOCK(shard.cs);
+        shard.Skipped_(addr);
     }
 
     void Bad(const CService &addr, int ban = 0) {
-        LOCK(cs);
-        Bad_(addr, ban);
+        CAddrDbShard &shard = GetShard(addr);
+        LOCK(shard.cs);
+        shard.Bad_(addr, ban);
     }
 
     bool Get(CServiceResult &ip, int &wait) {
-        LOCK(cs);
-        return Get_(ip, wait);
+        std::vector<CServiceResult> ips;
+        GetMany(ips, 1, wait);
+        if (ips.empty()) {
+            return false;
+        }
+        ip = ips[0];
+        return true;
     }
 
+    // Takes addresses from the shards in turn, starting with a different
+    // shard at every call. wait is set to the shortest wait reported by the
+    // shards which ran out of addresses, if any.
     void GetMany(std::vector<CServiceResult> &ips, int max, int &wait) {
-        LOCK(cs);
-        while (max > 0) {
-            CServiceResult ip = {};
-            if (!Get_(ip, wait)) {
-                return;
+        const size_t first = nNextShard++;
+        int minWait = -1;
+        for (size_t i = 0; i < ADDRDB_SHARD_COUNT && max > 0; i++) {
+            CAddrDbShard &shard = shards[(first + i) % ADDRDB_SHARD_COUNT];
+            LOCK(shard.cs);
+            while (max > 0) {
+                CServiceResult ip = {};
+                int shardWait = wait;
+                if (!shard.Get_(ip, shardWait)) {
+                    if (minWait < 0 || shardWait < minWait) {
+                        minWait = shardWait;
+                    }
+                    break;
+                }
+                ips.push_back(ip);
+                max--;
             }
-            ips.push_back(ip);
-            max--;
+        }
+        if (minWait >= 0) {
+            wait = minWait;
         }
     }
 
     void ResultMany(const std::vector<CServiceResult> &ips) {
-        LOCK(cs);
-        for (size_t i = 0; i < ips.size(); i++) {
-            if (ips[i].fGood) {
-                Good_(ips[i].service, ips[i].nClientV, ips[i].strClientV,
-                      ips[i].nHeight);
-            } else {
-                Bad_(ips[i].service, ips[i].nBanTime);
+        std::array<std::vector<const CServiceResult *>, ADDRDB_SHARD_COUNT>
+            byShard;
+        for (const CServiceResult &ip : ips) {
+            byShard[GetShardIndex(ip.service)].push_back(&ip);
+        }
+        for (size_t i = 0; i < ADDRDB_SHARD_COUNT; i++) {
+            if (byShard[i].empty()) {
+                continue;
+            }
+            LOCK(shards[i].cs);
+            for (const CServiceResult *ip : byShard[i]) {
+                if (ip->fGood) {
+                    shards[i].Good_(ip->service, ip->nClientV, ip->strClientV,
+                                    ip->nHeight);
+                } else {
+                    shards[i].Bad_(ip->service, ip->nBanTime);
+                }
             }
         }
     }
 
+    // get a random set of IPs
     void GetIPs(std::set<CNetAddr> &ips, uint64_t requestedFlags, uint32_t max,
-                const bool *nets) {
-        LOCK(cs);
-        GetIPs_(ips, requestedFlags, max, nets);
-    }
+                const bool *nets);
 };
 
 #endif // BITCOIN_SEEDER_DB_H
@@ -0,0 +1,165 @@
+// Copyright (c) 2019 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <seeder/dnscache.h>
+
+#include <random.h>
+#include <seeder/db.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <tuple>
+
+/**
+ * Replace the answers in slot. The previous ones are deleted once no DNS
+ * thread can be reading them anymore, which RCULock::synchronize waits for.
+ */
+static void Publish(std::atomic<CDnsAnswers *> &slot,
+                    RCUPtr<CDnsAnswers> answers) {
+    CDnsAnswers *old = slot.exchange(answers.release());
+    RCUPtr<CDnsAnswers>::acquire(old);
+}
+
+CDnsAnswerCache::CDnsAnswerCache(CAddrDb &dbIn,
+                                 const std::set<uint64_t> &filters)
+    : db(dbIn) {
+    // Requests without filter get the nodes with the default flags.
+    answers.emplace(std::piecewise_construct, std::forward_as_tuple(0),
+                    std::forward_as_tuple(nullptr));
+    for (uint64_t flags : filters) {
+        answers.emplace(std::piecewise_construct, std::forward_as_tuple(flags),
+                        std::forward_as_tuple(nullptr));
+    }
+}
+
+CDnsAnswerCache::~CDnsAnswerCache() {
+    Stop();
+    for (auto &entry : answers) {
+        Publish(entry.second, RCUPtr<CDnsAnswers>());
+    }
+    RCULock::synchronize();
+}
+
+void CDnsAnswerCache::Start() {
+    Refresh();
+
+    {
+        LOCK(cs_thread);
+        fStop = false;
+    }
+    thread = std::thread([this]() { ThreadRefresh(); });
+}
+
+void CDnsAnswerCache::Stop() {
+    {
+        LOCK(cs_thread);
+        fStop = true;
+    }
+    cond_thread.notify_all();
+    if (thread.joinable()) {
+        thread.join();
+    }
+}
+
+void CDnsAnswerCache::Refresh() {
+    bool nets[NET_MAX] = {};
+    nets[NET_IPV4] = true;
+    nets[NET_IPV6] = true;
+
+    for (auto &entry : answers) {
+        std::set<CNetAddr> ips;
+        db.GetIPs(ips, entry.first, DNS_CACHE_MAX_ADDRESSES, nets);
+        nQueries++;
+
+        std::vector<addr_t> addrs;
+        std::vector<addr_t> addrs6;
+        addrs.reserve(ips.size());
+        for (const CNetAddr &ip : ips) {
+            struct in_addr addr;
+            struct in6_addr addr6;
+            addr_t a = {};
+            if (ip.GetInAddr(&addr)) {
+                a.v = 4;
+                memcpy(&a.data.v4, &addr, 4);
+                addrs.push_back(a);
+            } else if (ip.GetIn6Addr(&addr6)) {
+                a.v = 6;
+                memcpy(&a.data.v6, &addr6, 16);
+                addrs6.push_back(a);
+            }
+        }
+
+        const uint32_t nIPv4 = addrs.size();
+        addrs.insert(addrs.end(), addrs6.begin(), addrs6.end());
+        Publish(entry.second,
+                RCUPtr<CDnsAnswers>::make(std::move(addrs), nIPv4));
+    }
+
+    RCULock::synchronize();
+}
+
+uint32_t CDnsAnswerCache::GetAnswers(uint64_t requestedFlags, addr_t *addr,
+                                     uint32_t max, bool ipv4, bool ipv6,
+                                     FastRandomContext &rng) const {
+    auto it = answers.find(requestedFlags);
+    if (it == answers.end()) {
+        return 0;
+    }
+
+    RCULock lock;
+    const CDnsAnswers *ptr = it->second.load();
+    if (ptr == nullptr) {
+        return 0;
+    }
+
+    // IPv4 addresses come first, so the requested families are a range.
+    const uint32_t begin = ipv4 ? 0 : ptr->nIPv4;
+    const uint32_t end = ipv6 ? ptr->addrs.size() : ptr->nIPv4;
+    if (begin >= end) {
+        return 0;
+    }
+
+    const uint32_t size = end - begin;
+    if (max > size) {
+        max = size;
+    }
+
+    // Pick max distinct indexes in [0, size) using Floyd's algorithm, as the
+    // answers cannot be shuffled in place.
+    std::vector<uint32_t> chosen;
+    chosen.reserve(max);
+    for (uint32_t j = size - max; j < size; j++) {
+        uint32_t t = rng.randrange(j + 1);
+        if (std::find(chosen.begin(), chosen.end(), t) != chosen.end()) {
+            t = j;
+        }
+        chosen.push_back(t);
+    }
+
+    // The larger indexes tend to come last, shuffle them.
+    for (uint32_t i = 0; i < max; i++) {
+        std::swap(chosen[i], chosen[i + rng.randrange(max - i)]);
+        addr[i] = ptr->addrs[begin + chosen[i]];
+    }
+
+    return max;
+}
+
+void CDnsAnswerCache::ThreadRefresh() {
+    while (true) {
+        {
+            WAIT_LOCK(cs_thread, lock);
+            if (cond_thread.wait_for(
+                    lock, std::chrono::seconds(DNS_CACHE_REFRESH_SECONDS),
+                    [this]() EXCLUSIVE_LOCKS_REQUIRED(cs_thread) {
+                        return fStop;
+                    })) {
+                return;
+            }
+        }
+
+        Refresh();
+    }
+}
@@ -0,0 +1,92 @@
+// Copyright (c) 2019 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_SEEDER_DNSCACHE_H
+#define BITCOIN_SEEDER_DNSCACHE_H
+
+#include <rcu.h>
+#include <seeder/dns.h>
+#include <sync.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <set>
+#include <thread>
+#include <vector>
+
+class CAddrDb;
+class FastRandomContext;
+
+//! How often the answers are rebuilt from the database
+static const int DNS_CACHE_REFRESH_SECONDS = 5;
+//! Maximum number of addresses kept to answer each service flags filter
+static const int DNS_CACHE_MAX_ADDRESSES = 1000;
+
+/**
+ * The addresses to answer with for one service flags filter, IPv4 addresses
+ * first. Once published, it is never modified.
+ */
+class CDnsAnswers {
+public:
+    const std::vector<addr_t> addrs;
+    const uint32_t nIPv4;
+
+    CDnsAnswers(std::vector<addr_t> addrsIn, uint32_t nIPv4In)
+        : addrs(std::move(addrsIn)), nIPv4(nIPv4In) {}
+
+    uint32_t GetIPv6Count() const { return addrs.size() - nIPv4; }
+
+    IMPLEMENT_RCU_REFCOUNT(uint64_t);
+};
+
+/**
+ * Per filter answers for the DNS threads. A background thread rebuilds them
+ * from the database every DNS_CACHE_REFRESH_SECONDS and publishes them with
+ * RCU, so that answering a query neither takes a lock nor waits for a
+ * rebuild.
+ */
+class CDnsAnswerCache {
+public:
+    CDnsAnswerCache(CAddrDb &dbIn, const std::set<uint64_t> &filters);
+    ~CDnsAnswerCache();
+
+    /**
+     * Build the answers once, then keep them up to date from a background
+     * thread.
+     */
+    void Start();
+    void Stop();
+
+    //! Rebuild the answers for every filter.
+    void Refresh();
+
+    /**
+     * Pick up to max random addresses answering the requested service flags,
+     * of the requested families. Returns the number of addresses written.
+     */
+    uint32_t GetAnswers(uint64_t requestedFlags, addr_t *addr, uint32_t max,
+                        bool ipv4, bool ipv6, FastRandomContext &rng) const;
+
+    //! Number of database queries made to build the answers.
+    uint64_t GetQueryCount() const { return nQueries; }
+
+private:
+    CAddrDb &db;
+
+    // The set of filters is fixed on construction, so that only the answers
+    // need to be synchronized.
+    std::map<uint64_t, std::atomic<CDnsAnswers *>> answers;
+    std::atomic<uint64_t> nQueries{0};
+
+    Mutex cs_thread;
+    std::condition_variable cond_thread;
+    bool fStop GUARDED_BY(cs_thread) = false;
+    std::thread thread;
+
+    void ThreadRefresh();
+};
+
+#endif // BITCOIN_SEEDER_DNSCACHE_H
@@ -2,9 +2,12 @@
 #include <fs.h>
 #include <logging.h>
 #include <protocol.h>
+#include <random.h>
 #include <seeder/bitcoin.h>
+#include <seeder/crawler.h>
 #include <seeder/db.h>
 #include <seeder/dns.h>
+#include <seeder/dnscache.h>
 #include <streams.h>
 #include <util/system.h>
 
@@ -14,6 +17,7 @@
 #include <csignal>
 #include <cstdlib>
 #include <getopt.h>
+#include <memory>
 #include <pthread.h>
 
 const std::function<std::string(const char *)> G_TRANSLATION_FUN = nullptr;
@@ -34,6 +38,8 @@ static const std::string DEFAULT_IPV6_PROXY = "";
 class CDnsSeedOpts {
 public:
     int nThreads;
+    int nEventThreads;
+    int nMaxProbes;
     int nPort;
     int nDnsThreads;
     int fUseTestNet;
@@ -48,7 +54,9 @@ public:
     std::set<uint64_t> filter_whitelist;
 
     CDnsSeedOpts()
-        : nThreads(DEFAULT_NUM_THREADS), nPort(DEFAULT_PORT),
+        : nThreads(DEFAULT_NUM_THREADS),
+          nEventThreads(DEFAULT_NUM_EVENT_THREADS),
+          nMaxProbes(DEFAULT_MAX_PROBES_PER_THREAD), nPort(DEFAULT_PORT),
           nDnsThreads(DEFAULT_NUM_DNS_THREADS), fUseTestNet(DEFAULT_TESTNET),
           fWipeBan(DEFAULT_WIPE_BAN), fWipeIgnore(DEFAULT_WIPE_IGNORE),
           mbox(DEFAULT_EMAIL), ns(DEFAULT_NAMESERVER), host(DEFAULT_HOST),
@@ -67,6 +75,11 @@ public:
             "-m <mbox>       E-Mail address reported in SOA records\n"
             "-t <threads>    Number of crawlers to run in parallel (default "
             "96)\n"
+            "-e <threads>    Number of event-driven crawler threads, 0 to use "
+            "the\n"
+            "                crawlers above instead (default 0)\n"
+            "-c <probes>     Probes in flight per event-driven crawler (default "
+            "1024)\n"
             "-d <threads>    Number of DNS server threads (default 4)\n"
             "-p <port>       UDP port to listen on (default 53)\n"
             "-o <ip:port>    Tor proxy IP/Port\n"
@@ -86,6 +99,8 @@ public:
                 {"ns", required_argument, 0, 'n'},
                 {"mbox", required_argument, 0, 'm'},
                 {"threads", required_argument, 0, 't'},
+                {"eventthreads", required_argument, 0, 'e'},
+                {"probes", required_argument, 0, 'c'},
                 {"dnsthreads", required_argument, 0, 'd'},
                 {"port", required_argument, 0, 'p'},
                 {"onion", required_argument, 0, 'o'},
@@ -99,7 +114,7 @@ public:
                 {0, 0, 0, 0}};
             int option_index = 0;
             int c =
-                getopt_long(argc, argv, "h:n:m:t:p:d:o:i:k:w:", long_options,
+                getopt_long(argc, argv, "h:n:m:t:e:c:p:d:o:i:k:w:", long_options,
                             &option_index);
             if (c == -1) break;
             switch (c) {
@@ -124,6 +139,18 @@ public:
                     break;
                 }
 
+                case 'e': {
+                    int n = strtol(optarg, nullptr, 10);
+                    if (n >= 0 && n < 1000) nEventThreads = n;
+                    break;
+                }
+
+                case 'c': {
+                    int n = strtol(optarg, nullptr, 10);
+                    if (n > 0 && n < 100000) nMaxProbes = n;
+                    break;
+                }
+
                 case 'd': {
                     int n = strtol(optarg, nullptr, 10);
                     if (n > 0 && n < 1000) nDnsThreads = n;
@@ -227,65 +254,14 @@ extern "C" uint32_t GetIPList(void *thread, char *requestedHostname,
 
 class CDnsThread {
 public:
-    struct FlagSpecificData {
-        int nIPv4, nIPv6;
-        std::vector<addr_t> cache;
-        time_t cacheTime;
-        unsigned int cacheHits;
-        FlagSpecificData() : nIPv4(0), nIPv6(0), cacheTime(0), cacheHits(0) {}
-    };
-
     dns_opt_t dns_opt; // must be first
     const int id;
-    std::map<uint64_t, FlagSpecificData> perflag;
-    std::atomic<uint64_t> dbQueries;
+    CDnsAnswerCache &cache;
+    FastRandomContext rng;
     std::set<uint64_t> filterWhitelist;
 
-    void cacheHit(uint64_t requestedFlags, bool force = false) {
-        static bool nets[NET_MAX] = {};
-        if (!nets[NET_IPV4]) {
-            nets[NET_IPV4] = true;
-            nets[NET_IPV6] = true;
-        }
-        time_t now = time(nullptr);
-        FlagSpecificData &thisflag = perflag[requestedFlags];
-        thisflag.cacheHits++;
-        if (force ||
-            thisflag.cacheHits * 400 >
-                (thisflag.cache.size() * thisflag.cache.size()) ||
-            (thisflag.cacheHits * thisflag.cacheHits * 20 >
-                 thisflag.cache.size() &&
-             (now - thisflag.cacheTime > 5))) {
-            std::set<CNetAddr> ips;
-            db.GetIPs(ips, requestedFlags, 1000, nets);
-            dbQueries++;
-            thisflag.cache.clear();
-            thisflag.nIPv4 = 0;
-            thisflag.nIPv6 = 0;
-            thisflag.cache.reserve(ips.size());
-            for (auto &ip : ips) {
-                struct in_addr addr;
-                struct in6_addr addr6;
-                if (ip.GetInAddr(&addr)) {
-                    addr_t a;
-                    a.v = 4;
-                    memcpy(&a.data.v4, &addr, 4);
-                    thisflag.cache.push_back(a);
-                    thisflag.nIPv4++;
-                } else if (ip.GetIn6Addr(&addr6)) {
-                    addr_t a;
-                    a.v = 6;
-                    memcpy(&a.data.v6, &addr6, 16);
-                    thisflag.cache.push_back(a);
-                    thisflag.nIPv6++;
-                }
-            }
-            thisflag.cacheHits = 0;
-            thisflag.cacheTime = now;
-        }
-    }
-
-    CDnsThread(CDnsSeedOpts *opts, int idIn) : id(idIn) {
+    CDnsThread(CDnsSeedOpts *opts, CDnsAnswerCache &cacheIn, int idIn)
+        : id(idIn), cache(cacheIn) {
         dns_opt.host = opts->host.c_str();
         dns_opt.ns = opts->ns.c_str();
         dns_opt.mbox = opts->mbox.c_str();
@@ -294,8 +270,6 @@ public:
         dns_opt.cb = GetIPList;
         dns_opt.port = opts->nPort;
         dns_opt.nRequests = 0;
-        dbQueries = 0;
-        perflag.clear();
         filterWhitelist = opts->filter_whitelist;
     }
 
@@ -323,39 +297,14 @@ extern "C" uint32_t GetIPList(void *data, char *requestedHostname, addr_t *addr,
     } else if (strcasecmp(requestedHostname, thread->dns_opt.host)) {
         return 0;
     }
-    thread->cacheHit(requestedFlags);
-    auto &thisflag = thread->perflag[requestedFlags];
-    uint32_t size = thisflag.cache.size();
-    uint32_t maxmax = (ipv4 ? thisflag.nIPv4 : 0) + (ipv6 ? thisflag.nIPv6 : 0);
-    if (max > size) {
-        max = size;
-    }
-    if (max > maxmax) {
-        max = maxmax;
-    }
-    uint32_t i = 0;
-    while (i < max) {
-        uint32_t j = i + (rand() % (size - i));
-        do {
-            bool ok = (ipv4 && thisflag.cache[j].v == 4) ||
-                      (ipv6 && thisflag.cache[j].v == 6);
-            if (ok) {
-                break;
-            }
-            j++;
-            if (j == size) {
-                j = i;
-            }
-        } while (1);
-        addr[i] = thisflag.cache[j];
-        thisflag.cache[j] = thisflag.cache[i];
-        thisflag.cache[i] = addr[i];
-        i++;
-    }
-    return max;
+    return thread->cache.GetAnswers(requestedFlags, addr, max, ipv4, ipv6,
+                                    thread->rng);
 }
 
 std::vector<CDnsThread *> dnsThread;
+// Declared after db, so that its refresh thread is stopped and joined before db
+// is destroyed when main returns.
+std::unique_ptr<CDnsAnswerCache> dnsCache;
 
 extern "C" void *ThreadDNS(void *arg) {
     CDnsThread *thread = (CDnsThread *)arg;
@@ -444,10 +393,9 @@ extern "C" void *ThreadStats(void *) {
             fprintf(stdout, "\x1b[2K\x1b[u");
         fprintf(stdout, "\x1b[s");
         uint64_t requests = 0;
-        uint64_t queries = 0;
+        uint64_t queries = dnsCache ? dnsCache->GetQueryCount() : 0;
         for (unsigned int i = 0; i < dnsThread.size(); i++) {
             requests += dnsThread[i]->dns_opt.nRequests;
-            queries += dnsThread[i]->dbQueries;
         }
         fprintf(stdout,
                 "%s %i/%i available (%i tried in %is, %i new, %i active), %i "
@@ -557,7 +505,7 @@ int main(int argc, char **argv) {
         CAutoFile cf(f, SER_DISK, CLIENT_VERSION);
         cf >> db;
         if (opts.fWipeBan) {
-            db.banned.clear();
+            db.ClearBanned();
             fprintf(stdout, "Ban list wiped...");
         }
         if (opts.fWipeIgnore) {
@@ -571,9 +519,11 @@ int main(int argc, char **argv) {
         fprintf(stdout, "Starting %i DNS threads for %s on %s (port %i)...",
                 opts.nDnsThreads, opts.host.c_str(), opts.ns.c_str(),
                 opts.nPort);
+        dnsCache.reset(new CDnsAnswerCache(db, opts.filter_whitelist));
+        dnsCache->Start();
         dnsThread.clear();
         for (int i = 0; i < opts.nDnsThreads; i++) {
-            dnsThread.push_back(new CDnsThread(&opts, i));
+            dnsThread.push_back(new CDnsThread(&opts, *dnsCache, i));
             pthread_create(&threadDns, nullptr, ThreadDNS, dnsThread[i]);
             fprintf(stdout, ".");
             Sleep(20);
@@ -583,15 +533,27 @@ int main(int argc, char **argv) {
     fprintf(stdout, "Starting seeder...");
     pthread_create(&threadSeed, nullptr, ThreadSeeder, nullptr);
     fprintf(stdout, "done\n");
-    fprintf(stdout, "Starting %i crawler threads...", opts.nThreads);
-    pthread_attr_t attr_crawler;
-    pthread_attr_init(&attr_crawler);
-    pthread_attr_setstacksize(&attr_crawler, 0x20000);
-    for (int i = 0; i < opts.nThreads; i++) {
-        pthread_t thread;
-        pthread_create(&thread, &attr_crawler, ThreadCrawler, &opts.nThreads);
+    // Stopped and joined when main returns.
+    std::unique_ptr<CSeederCrawler> crawler;
+    if (opts.nEventThreads > 0) {
+        fprintf(stdout,
+                "Starting %i event-driven crawler threads (%i probes each)...",
+                opts.nEventThreads, opts.nMaxProbes);
+        crawler.reset(
+            new CSeederCrawler(db, opts.nEventThreads, opts.nMaxProbes));
+        crawler->Start();
+    } else {
+        fprintf(stdout, "Starting %i crawler threads...", opts.nThreads);
+        pthread_attr_t attr_crawler;
+        pthread_attr_init(&attr_crawler);
+        pthread_attr_setstacksize(&attr_crawler, 0x20000);
+        for (int i = 0; i < opts.nThreads; i++) {
+            pthread_t thread;
+            pthread_create(&thread, &attr_crawler, ThreadCrawler,
+                           &opts.nThreads);
+        }
+        pthread_attr_destroy(&attr_crawler);
     }
-    pthread_attr_destroy(&attr_crawler);
     fprintf(stdout, "done\n");
     pthread_create(&threadStats, nullptr, ThreadStats, nullptr);
     pthread_create(&threadDump, nullptr, ThreadDumper, nullptr);
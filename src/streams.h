@@ -120,6 +120,52 @@ private:
     size_t nPos;
 };
 
+/**
+ * XOR size bytes of data with key, repeated over the data, with the first byte
+ * of data lined up with byte key_offset of the key.
+ *
+ * Keys of 8 bytes, such as the database obfuscation key, are applied a 64 bit
+ * word at a time, which compilers turn into vector instructions.
+ */
+inline void XorWithKey(uint8_t *data, size_t size,
+                       const std::vector<uint8_t> &key, size_t key_offset = 0) {
+    const size_t key_size = key.size();
+    if (key_size == 0) {
+        return;
+    }
+
+    key_offset %= key_size;
+    if (key_size != sizeof(uint64_t)) {
+        for (size_t i = 0, j = key_offset; i != size; i++) {
+            data[i] ^= key[j++];
+            // Avoid a % for each byte, which would effectively be a division.
+            if (j == key_size) {
+                j = 0;
+            }
+        }
+        return;
+    }
+
+    // Rotate the key so that it lines up with the start of data.
+    uint8_t pattern[sizeof(uint64_t)];
+    for (size_t i = 0; i < sizeof(pattern); i++) {
+        pattern[i] = key[(key_offset + i) % sizeof(pattern)];
+    }
+    uint64_t word_key;
+    memcpy(&word_key, pattern, sizeof(word_key));
+
+    size_t i = 0;
+    for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+        uint64_t word;
+        memcpy(&word, data + i, sizeof(word));
+        word ^= word_key;
+        memcpy(data + i, &word, sizeof(word));
+    }
+    for (size_t j = 0; i < size && j < sizeof(pattern); i++, j++) {
+        data[i] ^= pattern[j];
+    }
+}
+
 /**
  * Minimal stream for reading from an existing vector by reference
  */
@@ -453,19 +499,8 @@ public:
      * @param[in] key    The key used to XOR the data in this stream.
      */
     void Xor(const std::vector<uint8_t> &key) {
-        if (key.size() == 0) {
-            return;
-        }
-
-        for (size_type i = 0, j = 0; i != size(); i++) {
-            vch[i] ^= key[j++];
-
-            // This potentially acts on very many bytes of data, so it's
-            // important that we calculate `j`, i.e. the `key` index in this way
-            // instead of doing a %, which would effectively be a division for
-            // each byte Xor'd -- much slower than need be.
-            if (j == key.size()) j = 0;
-        }
+        XorWithKey(reinterpret_cast<uint8_t *>(vch.data() + nReadPos), size(),
+                   key);
     }
 };
 
@@ -217,6 +217,8 @@ BOOST_AUTO_TEST_CASE(block_register) {
         connman.get(), nullptr, scheduler, false);
 
     AvalancheProcessor p(connman.get());
+    // Poll one node per run of the event loop.
+    p.setMaxPollsPerTick(1);
     std::vector<AvalancheBlockUpdate> updates;
 
     CBlock block = CreateAndProcessBlock({}, CScript());
@@ -373,6 +375,67 @@ BOOST_AUTO_TEST_CASE(block_register) {
     connman->ClearNodes();
 }
 
+BOOST_AUTO_TEST_CASE(block_register_fan_out) {
+    const Config &config = GetConfig();
+
+    auto connman = std::make_unique<CConnmanTest>(config, 0x1337, 0x1337);
+    auto peerLogic = std::make_unique<PeerLogicValidation>(
+        connman.get(), nullptr, scheduler, false);
+
+    AvalancheProcessor p(connman.get());
+    std::vector<AvalancheBlockUpdate> updates;
+
+    CBlock block = CreateAndProcessBlock({}, CScript());
+    const uint256 blockHash = block.GetHash();
+    const CBlockIndex *pindex = mapBlockIndex[blockHash];
+
+    auto avanodes =
+        ConnectNodes(config, p, NODE_AVALANCHE, *peerLogic, connman.get());
+    BOOST_CHECK(p.addBlockToReconcile(pindex));
+
+    // Poll every node on each run of the event loop, and have them all vote
+    // for the block. Each run then counts as many votes as there are nodes.
+    p.setMaxPollsPerTick(avanodes.size());
+    const std::vector<AvalancheVote> votes = {AvalancheVote(0, blockHash)};
+    int nTicks = 0;
+    while (updates.empty() && nTicks < AVALANCHE_FINALIZATION_SCORE) {
+        const uint64_t round = AvalancheTest::getRound(p);
+        AvalancheTest::runEventLoop(p);
+        nTicks++;
+        BOOST_CHECK_EQUAL(AvalancheTest::getRound(p),
+                          round + avanodes.size());
+        BOOST_CHECK_EQUAL(AvalancheTest::getSuitableNodeToQuery(p), NO_NODE);
+
+        // The nodes are polled in no particular order.
+        for (const CNode *n : avanodes) {
+            bool fRegistered = false;
+            for (uint64_t r = round; r < round + avanodes.size(); r++) {
+                if (p.registerVotes(n->GetId(), {r, 0, votes}, updates)) {
+                    fRegistered = true;
+                    break;
+                }
+            }
+            BOOST_CHECK(fRegistered);
+        }
+
+        // Once finalized, the block is no longer tracked.
+        BOOST_CHECK_EQUAL(p.isAccepted(pindex), updates.empty());
+    }
+
+    // Polling a single node per run would have taken more runs than the
+    // finalization score.
+    BOOST_CHECK_LE(nTicks, AVALANCHE_FINALIZATION_SCORE / avanodes.size() + 2);
+    BOOST_CHECK_EQUAL(updates.size(), 1);
+    BOOST_CHECK(updates[0].getBlockIndex() == pindex);
+    BOOST_CHECK_EQUAL(updates[0].getStatus(),
+                      AvalancheBlockUpdate::Status::Finalized);
+
+    // Once the decision is finalized, there is no poll for it.
+    BOOST_CHECK_EQUAL(AvalancheTest::getInvsForNextPoll(p).size(), 0);
+
+    connman->ClearNodes();
+}
+
 BOOST_AUTO_TEST_CASE(multi_block_register) {
     const Config &config = GetConfig();
 
@@ -381,6 +444,8 @@ BOOST_AUTO_TEST_CASE(multi_block_register) {
         connman.get(), nullptr, scheduler, false);
 
     AvalancheProcessor p(connman.get());
+    // Poll one node per run of the event loop.
+    p.setMaxPollsPerTick(1);
     CBlockIndex indexA, indexB;
 
     std::vector<AvalancheBlockUpdate> updates;
@@ -704,6 +769,8 @@ BOOST_AUTO_TEST_CASE(poll_inflight_count) {
         connman.get(), nullptr, scheduler, false);
 
     AvalancheProcessor p(connman.get());
+    // Poll one node per run of the event loop.
+    p.setMaxPollsPerTick(1);
 
     // Create enough nodes so that we run into the inflight request limit.
     std::array<CNode *, AVALANCHE_MAX_INFLIGHT_POLL + 1> nodes;
@@ -755,6 +822,74 @@ BOOST_AUTO_TEST_CASE(poll_inflight_count) {
     connman->ClearNodes();
 }
 
+BOOST_AUTO_TEST_CASE(poll_fan_out) {
+    const Config &config = GetConfig();
+
+    auto connman = std::make_unique<CConnmanTest>(config, 0x1337, 0x1337);
+    auto peerLogic = std::make_unique<PeerLogicValidation>(
+        connman.get(), nullptr, scheduler, false);
+
+    AvalancheProcessor p(connman.get());
+
+    // Create more nodes than we can have requests in flight for.
+    std::array<CNode *, AVALANCHE_MAX_INFLIGHT_POLL + 2> nodes;
+    for (auto &n : nodes) {
+        n = ConnectNode(config, NODE_AVALANCHE, *peerLogic, connman.get());
+        BOOST_CHECK(p.addPeer(n->GetId(), 0));
+    }
+
+    // Add blocks to poll, so they are spread over several shards.
+    std::vector<uint256> blockHashes;
+    for (int i = 0; i < 4; i++) {
+        CBlock block = CreateAndProcessBlock({}, CScript());
+        blockHashes.push_back(block.GetHash());
+        BOOST_CHECK(p.addBlockToReconcile(mapBlockIndex[block.GetHash()]));
+    }
+
+    // The most worked block is polled first.
+    auto invs = AvalancheTest::getInvsForNextPoll(p);
+    BOOST_CHECK_EQUAL(invs.size(), blockHashes.size());
+    for (size_t i = 0; i < invs.size(); i++) {
+        BOOST_CHECK(invs[i].hash == blockHashes[blockHashes.size() - 1 - i]);
+    }
+
+    // One run of the event loop polls several nodes.
+    p.setMaxPollsPerTick(3);
+    uint64_t round = AvalancheTest::getRound(p);
+    AvalancheTest::runEventLoop(p);
+    BOOST_CHECK_EQUAL(AvalancheTest::getRound(p), round + 3);
+
+    // And stops when the inflight request limit is reached, leaving the other
+    // nodes available.
+    p.setMaxPollsPerTick(nodes.size());
+    AvalancheTest::runEventLoop(p);
+    BOOST_CHECK_EQUAL(AvalancheTest::getRound(p),
+                      round + AVALANCHE_MAX_INFLIGHT_POLL);
+    BOOST_CHECK(AvalancheTest::getSuitableNodeToQuery(p) != NO_NODE);
+    BOOST_CHECK_EQUAL(AvalancheTest::getInvsForNextPoll(p).size(), 0);
+
+    // Every node polled can respond.
+    std::vector<AvalancheVote> votes;
+    for (const CInv &inv : invs) {
+        votes.emplace_back(0, inv.hash);
+    }
+
+    std::vector<AvalancheBlockUpdate> updates;
+    for (const CNode *n : nodes) {
+        for (uint64_t r = round; r < round + AVALANCHE_MAX_INFLIGHT_POLL;
+             r++) {
+            if (p.registerVotes(n->GetId(), {r, 0, votes}, updates)) {
+                break;
+            }
+        }
+    }
+
+    BOOST_CHECK_EQUAL(AvalancheTest::getInvsForNextPoll(p).size(),
+                      blockHashes.size());
+
+    connman->ClearNodes();
+}
+
 BOOST_AUTO_TEST_CASE(quorum_diversity) {
     const Config &config = GetConfig();
 
@@ -763,6 +898,8 @@ BOOST_AUTO_TEST_CASE(quorum_diversity) {
         connman.get(), nullptr, scheduler, false);
 
     AvalancheProcessor p(connman.get());
+    // Poll one node per run of the event loop.
+    p.setMaxPollsPerTick(1);
     std::vector<AvalancheBlockUpdate> updates;
 
     CBlock block = CreateAndProcessBlock({}, CScript());
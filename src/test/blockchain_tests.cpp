@@ -1,6 +1,10 @@
 #include <rpc/blockchain.h>
 
 #include <chain.h>
+#include <primitives/block.h>
+#include <script/script.h>
+
+#include <univalue.h>
 
 #include <test/test_bitcoin.h>
 
@@ -66,4 +70,47 @@ BOOST_AUTO_TEST_CASE(get_difficulty_for_very_high_target) {
     TestDifficulty(0x12345678, 5913134931067755359633408.0);
 }
 
+BOOST_AUTO_TEST_CASE(write_block_json_matches_block_to_json) {
+    // Enough transactions to be split across threads on a multi core machine.
+    CBlock block;
+    block.nVersion = 0x20000000;
+    block.nTime = 1269211443;
+    block.nBits = 0x1cf88f6f;
+    block.nNonce = 0xffffffff;
+    for (size_t i = 0; i < 2 * PARALLEL_JSON_MIN_BLOCK_TXS + 1; i++) {
+        CMutableTransaction tx;
+        tx.vin.resize(1);
+        tx.vin[0].prevout = COutPoint(TxId(InsecureRand256()), i);
+        tx.vin[0].scriptSig = CScript() << i;
+        tx.vout.resize(1);
+        tx.vout[0].nValue = int64_t(i) * SATOSHI;
+        tx.vout[0].scriptPubKey = CScript() << OP_TRUE;
+        block.vtx.push_back(MakeTransactionRef(tx));
+    }
+    block.hashMerkleRoot = InsecureRand256();
+
+    // A block in the middle of a chain of three, starting at genesis so that
+    // the skip pointers can be built.
+    const uint256 hashes[3] = {InsecureRand256(), block.GetHash(),
+                               InsecureRand256()};
+    CBlockIndex indexes[3];
+    for (int i = 0; i < 3; i++) {
+        indexes[i].phashBlock = &hashes[i];
+        indexes[i].nHeight = i;
+        indexes[i].nBits = block.nBits;
+        indexes[i].nTime = block.nTime + i;
+        indexes[i].pprev = i > 0 ? &indexes[i - 1] : nullptr;
+        indexes[i].BuildSkip();
+    }
+
+    for (const CBlockIndex *tip : {&indexes[1], &indexes[2]}) {
+        for (bool txDetails : {false, true}) {
+            std::string json;
+            WriteBlockJSON(block, tip, &indexes[1], txDetails, json);
+            BOOST_CHECK_EQUAL(
+                json, blockToJSON(block, tip, &indexes[1], txDetails).write());
+        }
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
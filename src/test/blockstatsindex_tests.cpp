@@ -0,0 +1,175 @@
+// Copyright (c) 2019 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <index/blockstatsindex.h>
+
+#include <chain.h>
+#include <config.h>
+#include <consensus/validation.h>
+#include <script/sighashtype.h>
+#include <script/sign.h>
+#include <script/standard.h>
+#include <undo.h>
+#include <util/time.h>
+#include <validation.h>
+#include <validationinterface.h>
+
+#include <test/test_bitcoin.h>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_SUITE(blockstatsindex_tests)
+
+static bool operator==(const CBlockStats &a, const CBlockStats &b) {
+    return a.nTxs == b.nTxs && a.nInputs == b.nInputs &&
+           a.nOutputs == b.nOutputs && a.nTotalSize == b.nTotalSize &&
+           a.nMinTxSize == b.nMinTxSize && a.nMaxTxSize == b.nMaxTxSize &&
+           a.nMedianTxSize == b.nMedianTxSize && a.totalOut == b.totalOut &&
+           a.totalFee == b.totalFee && a.minFee == b.minFee &&
+           a.maxFee == b.maxFee && a.medianFee == b.medianFee &&
+           a.minFeeRate == b.minFeeRate && a.maxFeeRate == b.maxFeeRate &&
+           a.medianFeeRate == b.medianFeeRate &&
+           a.nUtxoSizeInc == b.nUtxoSizeInc;
+}
+
+BOOST_AUTO_TEST_CASE(blockstats_serialization) {
+    CBlockStats stats;
+    stats.nTxs = 3;
+    stats.nInputs = 4;
+    stats.nOutputs = 5;
+    stats.nTotalSize = 500;
+    stats.nMinTxSize = 200;
+    stats.nMaxTxSize = 300;
+    stats.nMedianTxSize = 250;
+    stats.totalOut = 21 * COIN;
+    stats.totalFee = 1000 * SATOSHI;
+    stats.minFee = 400 * SATOSHI;
+    stats.maxFee = 600 * SATOSHI;
+    stats.medianFee = 500 * SATOSHI;
+    stats.minFeeRate = 2 * SATOSHI;
+    stats.maxFeeRate = 2 * SATOSHI;
+    stats.medianFeeRate = 2 * SATOSHI;
+    stats.nUtxoSizeInc = -42;
+
+    CDataStream ss(SER_DISK, PROTOCOL_VERSION);
+    ss << stats;
+    // Every statistic but the utxo size increase fits in a few bytes.
+    BOOST_CHECK(ss.size() < 40);
+
+    CBlockStats stats2;
+    ss >> stats2;
+    BOOST_CHECK(stats == stats2);
+    BOOST_CHECK(ss.empty());
+}
+
+BOOST_FIXTURE_TEST_CASE(blockstatsindex_sync_and_rewind, TestChain100Setup) {
+    BlockStatsIndex index(1 << 20, true);
+
+    const CBlockIndex *tip;
+    {
+        LOCK(cs_main);
+        tip = chainActive.Tip();
+    }
+
+    CBlockStats stats;
+    BOOST_CHECK(!index.LookupStats(tip, stats));
+    BOOST_CHECK(!index.BlockUntilSyncedToCurrentChain());
+
+    index.Start();
+
+    // Allow the index to catch up with the block index.
+    constexpr int64_t timeout_ms = 10 * 1000;
+    int64_t time_start = GetTimeMillis();
+    while (!index.BlockUntilSyncedToCurrentChain()) {
+        BOOST_REQUIRE(time_start + timeout_ms > GetTimeMillis());
+        MilliSleep(100);
+    }
+
+    // All the blocks so far only have a coinbase.
+    std::vector<CBlockStats> range;
+    BOOST_CHECK(index.LookupStatsRange(0, tip, range));
+    BOOST_CHECK_EQUAL(range.size(), tip->nHeight + 1);
+    for (const CBlockStats &block_stats : range) {
+        BOOST_CHECK_EQUAL(block_stats.nTxs, 1);
+        BOOST_CHECK_EQUAL(block_stats.nInputs, 0);
+        BOOST_CHECK_EQUAL(block_stats.totalFee, Amount::zero());
+        BOOST_CHECK(block_stats.nUtxoSizeInc > 0);
+    }
+
+    // Spend a mature coinbase with a fee, in a new block.
+    CScript scriptPubKey = CScript() << ToByteVector(coinbaseKey.GetPubKey())
+                                     << OP_CHECKSIG;
+    const Amount fee = 1000 * SATOSHI;
+    CMutableTransaction spend;
+    spend.nVersion = 1;
+    spend.vin.resize(1);
+    spend.vin[0].prevout = COutPoint(m_coinbase_txns[0]->GetId(), 0);
+    spend.vout.resize(2);
+    spend.vout[0].nValue = 11 * CENT;
+    spend.vout[0].scriptPubKey = scriptPubKey;
+    spend.vout[1].nValue =
+        m_coinbase_txns[0]->vout[0].nValue - 11 * CENT - fee;
+    spend.vout[1].scriptPubKey = scriptPubKey;
+
+    std::vector<uint8_t> vchSig;
+    uint256 hash = SignatureHash(scriptPubKey, CTransaction(spend), 0,
+                                 SigHashType().withForkId(),
+                                 m_coinbase_txns[0]->vout[0].nValue);
+    BOOST_CHECK(coinbaseKey.SignECDSA(hash, vchSig));
+    vchSig.push_back(uint8_t(SIGHASH_ALL | SIGHASH_FORKID));
+    spend.vin[0].scriptSig << vchSig;
+
+    const CBlock block = CreateAndProcessBlock({spend}, scriptPubKey);
+    BOOST_CHECK(index.BlockUntilSyncedToCurrentChain());
+
+    CBlockIndex *new_tip;
+    {
+        LOCK(cs_main);
+        new_tip = chainActive.Tip();
+    }
+    BOOST_CHECK_EQUAL(new_tip->GetBlockHash(), block.GetHash());
+
+    const uint64_t spend_size = CTransaction(spend).GetTotalSize();
+    BOOST_CHECK(index.LookupStats(new_tip, stats));
+    BOOST_CHECK_EQUAL(stats.nTxs, 2);
+    BOOST_CHECK_EQUAL(stats.nInputs, 1);
+    BOOST_CHECK_EQUAL(stats.nOutputs, block.vtx[0]->vout.size() + 2);
+    BOOST_CHECK_EQUAL(stats.totalFee, fee);
+    BOOST_CHECK_EQUAL(stats.minFee, fee);
+    BOOST_CHECK_EQUAL(stats.maxFee, fee);
+    BOOST_CHECK_EQUAL(stats.medianFee, fee);
+    BOOST_CHECK_EQUAL(stats.minFeeRate, fee / int64_t(spend_size));
+    BOOST_CHECK_EQUAL(stats.nTotalSize, spend_size);
+    BOOST_CHECK_EQUAL(stats.nMinTxSize, spend_size);
+    BOOST_CHECK_EQUAL(stats.totalOut,
+                      m_coinbase_txns[0]->vout[0].nValue - fee);
+
+    // The index matches the stats computed from the block and its undo data.
+    CBlockUndo blockundo;
+    BOOST_CHECK(UndoReadFromDisk(blockundo, new_tip));
+    BOOST_CHECK(stats == ComputeBlockStats(block, blockundo));
+
+    // Disconnecting the block erases its stats.
+    {
+        LOCK(cs_main);
+        CValidationState state;
+        BOOST_CHECK(InvalidateBlock(GetConfig(), state, new_tip));
+    }
+    SyncWithValidationInterfaceQueue();
+
+    BOOST_CHECK(!index.LookupStats(new_tip, stats));
+    BOOST_CHECK(!index.LookupStatsRange(0, new_tip, range));
+    BOOST_CHECK(index.LookupStatsRange(tip->nHeight, tip, range));
+    BOOST_CHECK_EQUAL(range.size(), 1);
+
+    // shutdown sequence (c.f. Shutdown() in init.cpp)
+    index.Stop();
+
+    threadGroup.interrupt_all();
+    threadGroup.join_all();
+
+    // Rest of shutdown sequence and destructors happen in ~TestingSetup()
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -1189,6 +1189,109 @@ BOOST_AUTO_TEST_CASE(merkle_block_4_test_update_none) {
     BOOST_CHECK(!filter.contains(COutPoint(txid2, 0)));
 }
 
+static std::vector<uint8_t> RandomBytes(size_t size) {
+    std::vector<uint8_t> data(size);
+    for (uint8_t &byte : data) {
+        byte = InsecureRandBits(8);
+    }
+    return data;
+}
+
+BOOST_AUTO_TEST_CASE(bloom_tx_elements) {
+    for (int round = 0; round < 100; round++) {
+        // Transactions spending each other, with data pushes of all sizes and
+        // some scripts that can't be parsed to the end.
+        std::vector<CTransactionRef> vtx;
+        std::vector<std::vector<uint8_t>> vPushes;
+        for (int i = 0; i < 20; i++) {
+            CMutableTransaction tx;
+            tx.vin.resize(1 + InsecureRandRange(3));
+            for (CTxIn &txin : tx.vin) {
+                txin.prevout = COutPoint(
+                    vtx.empty() || InsecureRandBool()
+                        ? TxId(InsecureRand256())
+                        : vtx[InsecureRandRange(vtx.size())]->GetId(),
+                    InsecureRandRange(3));
+                vPushes.push_back(RandomBytes(InsecureRandRange(80)));
+                txin.scriptSig = CScript() << vPushes.back() << RandomBytes(33);
+                if (InsecureRandRange(5) == 0) {
+                    txin.scriptSig.push_back(OP_PUSHDATA2);
+                }
+            }
+            tx.vout.resize(1 + InsecureRandRange(3));
+            for (CTxOut &txout : tx.vout) {
+                vPushes.push_back(RandomBytes(InsecureRandBool() ? 20 : 33));
+                if (vPushes.back().size() == 33) {
+                    txout.scriptPubKey = CScript()
+                                         << vPushes.back() << OP_CHECKSIG;
+                } else {
+                    txout.scriptPubKey =
+                        CScript() << OP_DUP << OP_HASH160 << vPushes.back()
+                                  << OP_EQUALVERIFY << OP_CHECKSIG;
+                }
+            }
+            vtx.push_back(MakeTransactionRef(tx));
+        }
+
+        CBloomFilter filter(10 + InsecureRandRange(50),
+                            0.001 + InsecureRandRange(100) / 200.0,
+                            InsecureRand32(), InsecureRandRange(3));
+        for (int i = InsecureRandRange(40); i > 0; i--) {
+            if (InsecureRandBool()) {
+                filter.insert(vPushes[InsecureRandRange(vPushes.size())]);
+            } else {
+                filter.insert(
+                    COutPoint(vtx[InsecureRandRange(vtx.size())]->GetId(), 0));
+            }
+        }
+        filter.UpdateEmptyFull();
+
+        // Matching the extracted elements gives the same result as matching
+        // the transactions, and updates the filter the same way.
+        CBloomFilter filter2 = filter;
+        const CBloomTxElements elements(vtx);
+        BOOST_CHECK_EQUAL(elements.GetNumTransactions(), vtx.size());
+        std::vector<bool> vMatch, vMatch2;
+        for (size_t i = 0; i < vtx.size(); i++) {
+            vMatch.push_back(filter.MatchAndInsertOutputs(*vtx[i]));
+            vMatch2.push_back(filter2.MatchAndInsertOutputs(elements, i));
+        }
+        for (size_t i = 0; i < vtx.size(); i++) {
+            vMatch[i] = vMatch[i] || filter.MatchInputs(*vtx[i]);
+            vMatch2[i] = vMatch2[i] || filter2.MatchInputs(elements, i);
+        }
+        BOOST_CHECK(vMatch == vMatch2);
+
+        CDataStream stream(SER_NETWORK, PROTOCOL_VERSION);
+        CDataStream stream2(SER_NETWORK, PROTOCOL_VERSION);
+        stream << filter;
+        stream2 << filter2;
+        BOOST_CHECK(stream.str() == stream2.str());
+    }
+}
+
+BOOST_AUTO_TEST_CASE(bloom_block_elements_cache) {
+    CBlock block;
+    for (unsigned int j = 0; j < 10; j++) {
+        CMutableTransaction tx;
+        tx.nLockTime = j;
+        block.vtx.push_back(MakeTransactionRef(std::move(tx)));
+    }
+
+    // The elements are only extracted once.
+    CBloomTxElementsRef elements = GetBlockBloomElements(block);
+    BOOST_CHECK_EQUAL(elements->GetNumTransactions(), 10);
+    BOOST_CHECK(GetBlockBloomElements(block) == elements);
+
+    // A block with the same hash but other transactions has its own.
+    CBlock reversed(block);
+    std::reverse(reversed.vtx.begin(), reversed.vtx.end());
+    CBloomTxElementsRef reversed_elements = GetBlockBloomElements(reversed);
+    BOOST_CHECK(reversed_elements != elements);
+    BOOST_CHECK(reversed_elements->GetTransaction(0).GetId() ==
+                block.vtx[9]->GetId());
+}
+
 static std::vector<uint8_t> RandomData() {
     uint256 r = InsecureRand256();
     return std::vector<uint8_t>(r.begin(), r.end());
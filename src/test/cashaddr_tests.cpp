@@ -115,4 +115,42 @@ BOOST_AUTO_TEST_CASE(cashaddr_testvectors_noprefix) {
     }
 }
 
+BOOST_AUTO_TEST_CASE(cashaddr_batch) {
+    static const std::string CASES[] = {
+        "prefix:x64nx6hz",
+        "PREFIX:X64NX6HZ",
+        "bitcoincash:qpzry9x8gf2tvdw0s3jn54khce6mua7lcw20ayyn",
+        "qpzry9x8gf2tvdw0s3jn54khce6mua7lcw20ayyn",
+        "bchtest:testnetaddress4d6njnut",
+        "bchreg:555555555555555555555555555555555555555555555udxmlmrz",
+        "bitcoincash:qpzry9x8gf2tvdw0s3jn54khce6mua7lcw20ayy",
+        "bitcoincash:Qpzry9x8gf2tvdw0s3jn54khce6mua7lcw20ayyn",
+        "",
+        "prefix:",
+    };
+
+    std::vector<std::string> addrs(std::begin(CASES), std::end(CASES));
+    auto decoded = cashaddr::Decode(addrs, "bitcoincash");
+    BOOST_CHECK_EQUAL(decoded.size(), addrs.size());
+    for (size_t i = 0; i < addrs.size(); ++i) {
+        auto ret = cashaddr::Decode(addrs[i], "bitcoincash");
+        BOOST_CHECK_MESSAGE(decoded[i] == ret, addrs[i]);
+    }
+
+    std::vector<std::vector<uint8_t>> payloads;
+    for (const auto &ret : decoded) {
+        payloads.push_back(ret.second);
+    }
+    auto encoded = cashaddr::Encode("bitcoincash", payloads);
+    BOOST_CHECK_EQUAL(encoded.size(), payloads.size());
+    for (size_t i = 0; i < payloads.size(); ++i) {
+        BOOST_CHECK_EQUAL(encoded[i],
+                          cashaddr::Encode("bitcoincash", payloads[i]));
+    }
+
+    BOOST_CHECK(cashaddr::Decode(std::vector<std::string>(), "").empty());
+    BOOST_CHECK(
+        cashaddr::Encode("", std::vector<std::vector<uint8_t>>()).empty());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -169,6 +169,39 @@ BOOST_AUTO_TEST_CASE(random_dst) {
     }
 }
 
+BOOST_AUTO_TEST_CASE(batch_dst) {
+    FastRandomContext rand(true);
+    const auto params = CreateChainParams(CBaseChainParams::MAIN);
+
+    std::vector<CTxDestination> dsts = {CNoDestination{}};
+    for (size_t i = 0; i < 100; ++i) {
+        uint160 hash = insecure_GetRandUInt160(rand);
+        dsts.push_back(CKeyID(hash));
+        dsts.push_back(CScriptID(hash));
+    }
+
+    std::vector<std::string> encoded = EncodeCashAddrs(dsts, *params);
+    BOOST_CHECK_EQUAL(encoded.size(), dsts.size());
+    for (size_t i = 0; i < dsts.size(); ++i) {
+        BOOST_CHECK_EQUAL(encoded[i], EncodeCashAddr(dsts[i], *params));
+    }
+
+    // Mix in addresses without prefix, from another network and invalid ones.
+    const auto testParams = CreateChainParams(CBaseChainParams::TESTNET);
+    encoded[1] = encoded[1].substr(encoded[1].find(':') + 1);
+    encoded[2] = EncodeCashAddr(dsts[2], *testParams);
+    encoded[3].back() = encoded[3].back() == 'q' ? 'p' : 'q';
+    std::vector<CTxDestination> decoded = DecodeCashAddrs(encoded, *params);
+    BOOST_CHECK_EQUAL(decoded.size(), encoded.size());
+    for (size_t i = 0; i < encoded.size(); ++i) {
+        BOOST_CHECK(decoded[i] == DecodeCashAddr(encoded[i], *params));
+    }
+    BOOST_CHECK(decoded[1] == dsts[1]);
+    BOOST_CHECK(decoded[2] == CTxDestination(CNoDestination{}));
+    BOOST_CHECK(decoded[3] == CTxDestination(CNoDestination{}));
+    BOOST_CHECK(decoded[4] == dsts[4]);
+}
+
 /**
  * Cashaddr payload made of 5-bit nibbles. The last one is padded. When
  * converting back to bytes, this extra padding is truncated. In order to ensure
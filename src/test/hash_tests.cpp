@@ -161,6 +161,60 @@ BOOST_AUTO_TEST_CASE(siphash) {
     }
 }
 
+BOOST_AUTO_TEST_CASE(siphash_batch) {
+    // Check consistency between SipHashUint256Batch and SipHashUint256, for
+    // batches which are and are not a multiple of the number of lanes.
+    FastRandomContext ctx;
+    for (size_t n = 0; n <= 11; n++) {
+        uint64_t k1 = ctx.rand64();
+        uint64_t k2 = ctx.rand64();
+        std::vector<uint256> vals(n);
+        std::vector<const uint256 *> ptrs(n);
+        for (size_t i = 0; i < n; i++) {
+            vals[i] = InsecureRand256();
+            ptrs[i] = &vals[i];
+        }
+
+        std::vector<uint64_t> out(n);
+        SipHashUint256Batch(k1, k2, ptrs.data(), n, out.data());
+        for (size_t i = 0; i < n; i++) {
+            BOOST_CHECK_EQUAL(out[i], SipHashUint256(k1, k2, vals[i]));
+        }
+    }
+}
+
+#if defined(ENABLE_AVX2) && defined(USE_ASM) &&                               \
+    (defined(__x86_64__) || defined(__amd64__) || defined(__i386__))
+BOOST_AUTO_TEST_CASE(siphash_4way) {
+    if (!__builtin_cpu_supports("avx2")) {
+        return;
+    }
+
+    // Built with AVX2 support on a CPU which has it: batches have to go
+    // through the 4 way implementation, which has to agree with the scalar
+    // one.
+    BOOST_CHECK_EQUAL(SipHashUint256BatchImplementation(), "avx2(4way)");
+
+    FastRandomContext ctx;
+    for (int i = 0; i < 100; i++) {
+        uint64_t k1 = ctx.rand64();
+        uint64_t k2 = ctx.rand64();
+        uint256 vals[4];
+        const uint256 *ptrs[4];
+        for (size_t j = 0; j < 4; j++) {
+            vals[j] = InsecureRand256();
+            ptrs[j] = &vals[j];
+        }
+
+        uint64_t out[4];
+        siphash_avx2::SipHashUint256_4way(k1, k2, ptrs, out);
+        for (size_t j = 0; j < 4; j++) {
+            BOOST_CHECK_EQUAL(out[j], SipHashUint256(k1, k2, vals[j]));
+        }
+    }
+}
+#endif
+
 namespace {
 class CDummyObject {
     uint32_t value;
@@ -0,0 +1,166 @@
+// Copyright (c) 2019 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <util/jsonwriter.h>
+
+#include <core_io.h>
+#include <primitives/transaction.h>
+#include <script/script.h>
+#include <uint256.h>
+#include <util/strencodings.h>
+
+#include <test/test_bitcoin.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <univalue.h>
+
+#include <limits>
+
+BOOST_FIXTURE_TEST_SUITE(jsonwriter_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(jsonwriter_matches_univalue) {
+    std::string all_chars;
+    for (int c = 1; c < 256; c++) {
+        all_chars += char(c);
+    }
+    const std::vector<uint8_t> bytes = ParseHex("00ff7f80deadbeef");
+
+    UniValue expected(UniValue::VOBJ);
+    expected.pushKV("string", "abc");
+    expected.pushKV("escapes", all_chars);
+    expected.pushKV("hex", HexStr(bytes));
+    expected.pushKV("int", -42);
+    expected.pushKV("int64", std::numeric_limits<int64_t>::min());
+    expected.pushKV("uint64", std::numeric_limits<uint64_t>::max());
+    expected.pushKV("real", 0.1);
+    expected.pushKV("bigreal", 5913134931067755359633408.0);
+    expected.pushKV("true", true);
+    expected.pushKV("false", false);
+    expected.pushKV("null", NullUniValue);
+    expected.pushKV("emptyobj", UniValue(UniValue::VOBJ));
+    expected.pushKV(all_chars, UniValue(UniValue::VARR));
+    UniValue arr(UniValue::VARR);
+    arr.push_back(1);
+    arr.push_back("two");
+    UniValue obj(UniValue::VOBJ);
+    obj.pushKV("three", 3);
+    arr.push_back(obj);
+    arr.push_back(UniValue(UniValue::VARR));
+    expected.pushKV("array", arr);
+
+    std::string json;
+    JSONWriter writer(json);
+    writer.BeginObject();
+    writer.KV("string", "abc");
+    writer.KV("escapes", all_chars);
+    writer.Key("hex");
+    writer.Hex(bytes.data(), bytes.data() + bytes.size());
+    writer.KV("int", -42);
+    writer.KV("int64", std::numeric_limits<int64_t>::min());
+    writer.KV("uint64", std::numeric_limits<uint64_t>::max());
+    writer.KV("real", 0.1);
+    writer.KV("bigreal", 5913134931067755359633408.0);
+    writer.KV("true", true);
+    writer.KV("false", false);
+    writer.Key("null");
+    writer.Null();
+    writer.Key("emptyobj");
+    writer.BeginObject();
+    writer.EndObject();
+    writer.Key(all_chars);
+    writer.BeginArray();
+    writer.EndArray();
+    writer.Key("array");
+    writer.BeginArray();
+    writer.Int(1);
+    writer.String("two");
+    writer.BeginObject();
+    writer.KV("three", 3);
+    writer.EndObject();
+    writer.BeginArray();
+    writer.EndArray();
+    writer.EndArray();
+    writer.EndObject();
+
+    BOOST_CHECK_EQUAL(json, expected.write());
+}
+
+BOOST_AUTO_TEST_CASE(jsonwriter_raw) {
+    std::string part;
+    JSONWriter part_writer(part);
+    part_writer.Int(1);
+    part_writer.Int(2);
+    BOOST_CHECK_EQUAL(part, "1,2");
+
+    // A list of values written apart is spliced in as is.
+    std::string json;
+    JSONWriter writer(json);
+    writer.BeginArray();
+    writer.Int(0);
+    writer.Raw(part);
+    writer.Raw("3");
+    writer.EndArray();
+    BOOST_CHECK_EQUAL(json, "[0,1,2,3]");
+}
+
+BOOST_AUTO_TEST_CASE(write_tx_json) {
+    CMutableTransaction mtx;
+    mtx.nVersion = 2;
+    mtx.nLockTime = 500000;
+    mtx.vin.resize(2);
+    mtx.vin[0].prevout = COutPoint(TxId(InsecureRand256()), 3);
+    mtx.vin[0].scriptSig = CScript() << OP_0 << ParseHex("deadbeef");
+    mtx.vin[0].nSequence = 0xfffffffe;
+    mtx.vin[1].prevout = COutPoint(TxId(InsecureRand256()), 0);
+    mtx.vout.resize(4);
+    std::vector<uint8_t> hash = ToByteVector(InsecureRand256());
+    hash.resize(20);
+    // Pay to pubkey hash
+    mtx.vout[0].nValue = 123456789 * SATOSHI;
+    mtx.vout[0].scriptPubKey = CScript() << OP_DUP << OP_HASH160 << hash
+                                         << OP_EQUALVERIFY << OP_CHECKSIG;
+    // Pay to script hash
+    mtx.vout[1].nValue = 21000000 * COIN;
+    mtx.vout[1].scriptPubKey = CScript() << OP_HASH160 << hash << OP_EQUAL;
+    // Data carrier
+    mtx.vout[2].nValue = Amount::zero();
+    mtx.vout[2].scriptPubKey = CScript() << OP_RETURN << ParseHex("0badc0de");
+    // Invalid script
+    mtx.vout[3].nValue = -1 * SATOSHI;
+    mtx.vout[3].scriptPubKey = CScript() << OP_PUSHDATA2;
+    const CTransaction tx(mtx);
+
+    for (const uint256 &hashBlock : {uint256(), InsecureRand256()}) {
+        for (bool include_hex : {false, true}) {
+            UniValue expected(UniValue::VOBJ);
+            TxToUniv(tx, hashBlock, expected, include_hex);
+
+            std::string json;
+            JSONWriter writer(json);
+            writer.BeginObject();
+            WriteTxJSON(tx, hashBlock, writer, include_hex);
+            writer.EndObject();
+            BOOST_CHECK_EQUAL(json, expected.write());
+        }
+    }
+
+    // A coinbase has no prevout.
+    CMutableTransaction coinbase;
+    coinbase.vin.resize(1);
+    coinbase.vin[0].scriptSig = CScript() << OP_0 << OP_0;
+    coinbase.vout.resize(1);
+    coinbase.vout[0].nValue = 50 * COIN;
+    UniValue expected(UniValue::VOBJ);
+    TxToUniv(CTransaction(coinbase), uint256(), expected);
+
+    std::string json;
+    JSONWriter writer(json);
+    writer.BeginObject();
+    WriteTxJSON(CTransaction(coinbase), uint256(), writer);
+    writer.EndObject();
+    BOOST_CHECK_EQUAL(json, expected.write());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -600,6 +600,95 @@ BOOST_AUTO_TEST_CASE(MempoolAncestorIndexingTest) {
                               "MempoolAncestorIndexingTest5");
 }
 
+BOOST_AUTO_TEST_CASE(MempoolRemoveForBlockChainTest) {
+    CTxMemPool pool;
+    LOCK2(cs_main, pool.cs);
+    TestMemPoolEntryHelper entry;
+
+    // root -> a -> b -> c, and d spending both b and an unrelated tx o.
+    auto makeTx = [](const std::vector<COutPoint> &prevouts) {
+        CMutableTransaction tx;
+        for (const COutPoint &prevout : prevouts) {
+            tx.vin.emplace_back(prevout);
+        }
+        tx.vout.emplace_back(10 * COIN, CScript() << OP_TRUE);
+        return tx;
+    };
+
+    CMutableTransaction root =
+        makeTx({COutPoint(TxId(InsecureRand256()), 0)});
+    CMutableTransaction a = makeTx({COutPoint(root.GetId(), 0)});
+    CMutableTransaction b = makeTx({COutPoint(a.GetId(), 0)});
+    CMutableTransaction c = makeTx({COutPoint(b.GetId(), 0)});
+    CMutableTransaction o = makeTx({COutPoint(TxId(InsecureRand256()), 0)});
+    CMutableTransaction d = makeTx({COutPoint(b.GetId(), 0)});
+    d.vin.emplace_back(COutPoint(o.GetId(), 0));
+
+    pool.addUnchecked(root.GetId(),
+                      entry.Fee(1000 * SATOSHI).SigOpsCost(1).FromTx(root));
+    pool.addUnchecked(a.GetId(),
+                      entry.Fee(2000 * SATOSHI).SigOpsCost(2).FromTx(a));
+    pool.addUnchecked(b.GetId(),
+                      entry.Fee(3000 * SATOSHI).SigOpsCost(3).FromTx(b));
+    pool.addUnchecked(c.GetId(),
+                      entry.Fee(4000 * SATOSHI).SigOpsCost(4).FromTx(c));
+    pool.addUnchecked(o.GetId(),
+                      entry.Fee(5000 * SATOSHI).SigOpsCost(5).FromTx(o));
+    pool.addUnchecked(d.GetId(),
+                      entry.Fee(6000 * SATOSHI).SigOpsCost(6).FromTx(d));
+    BOOST_CHECK_EQUAL(pool.size(), 6UL);
+
+    // Mine root and a.
+    std::vector<CTransactionRef> vtx;
+    vtx.push_back(MakeTransactionRef(root));
+    vtx.push_back(MakeTransactionRef(a));
+    pool.removeForBlock(vtx, 1);
+    BOOST_CHECK_EQUAL(pool.size(), 4UL);
+
+    const uint64_t bSize = CTransaction(b).GetTotalSize();
+    const uint64_t cSize = CTransaction(c).GetTotalSize();
+    const uint64_t dSize = CTransaction(d).GetTotalSize();
+    const uint64_t oSize = CTransaction(o).GetTotalSize();
+
+    const CTxMemPoolEntry &bEntry = *pool.mapTx.find(b.GetId());
+    BOOST_CHECK_EQUAL(bEntry.GetCountWithAncestors(), 1ULL);
+    BOOST_CHECK_EQUAL(bEntry.GetSizeWithAncestors(), bSize);
+    BOOST_CHECK_EQUAL(bEntry.GetModFeesWithAncestors(), 3000 * SATOSHI);
+    BOOST_CHECK_EQUAL(bEntry.GetSigOpCountWithAncestors(), 3);
+    BOOST_CHECK_EQUAL(bEntry.GetCountWithDescendants(), 3ULL);
+    BOOST_CHECK_EQUAL(bEntry.GetSizeWithDescendants(), bSize + cSize + dSize);
+
+    const CTxMemPoolEntry &cEntry = *pool.mapTx.find(c.GetId());
+    BOOST_CHECK_EQUAL(cEntry.GetCountWithAncestors(), 2ULL);
+    BOOST_CHECK_EQUAL(cEntry.GetSizeWithAncestors(), bSize + cSize);
+    BOOST_CHECK_EQUAL(cEntry.GetModFeesWithAncestors(), 7000 * SATOSHI);
+    BOOST_CHECK_EQUAL(cEntry.GetSigOpCountWithAncestors(), 7);
+
+    const CTxMemPoolEntry &dEntry = *pool.mapTx.find(d.GetId());
+    BOOST_CHECK_EQUAL(dEntry.GetCountWithAncestors(), 3ULL);
+    BOOST_CHECK_EQUAL(dEntry.GetSizeWithAncestors(), bSize + oSize + dSize);
+    BOOST_CHECK_EQUAL(dEntry.GetModFeesWithAncestors(), 14000 * SATOSHI);
+    BOOST_CHECK_EQUAL(dEntry.GetSigOpCountWithAncestors(), 14);
+
+    const CTxMemPoolEntry &oEntry = *pool.mapTx.find(o.GetId());
+    BOOST_CHECK_EQUAL(oEntry.GetCountWithDescendants(), 2ULL);
+    BOOST_CHECK_EQUAL(oEntry.GetSizeWithDescendants(), oSize + dSize);
+
+    BOOST_CHECK(pool.GetMemPoolParents(pool.mapTx.find(b.GetId())).empty());
+
+    // Mine b and o, leaving c and d without in-mempool ancestors.
+    vtx.clear();
+    vtx.push_back(MakeTransactionRef(b));
+    vtx.push_back(MakeTransactionRef(o));
+    pool.removeForBlock(vtx, 2);
+    BOOST_CHECK_EQUAL(pool.size(), 2UL);
+    for (const CTxMemPoolEntry &e : pool.mapTx) {
+        BOOST_CHECK_EQUAL(e.GetCountWithAncestors(), 1ULL);
+        BOOST_CHECK_EQUAL(e.GetSizeWithAncestors(), e.GetTxSize());
+        BOOST_CHECK_EQUAL(e.GetCountWithDescendants(), 1ULL);
+    }
+}
+
 BOOST_AUTO_TEST_CASE(MempoolSizeLimitTest) {
     CTxMemPool pool;
     LOCK2(cs_main, pool.cs);
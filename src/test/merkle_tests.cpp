@@ -292,4 +292,56 @@ BOOST_AUTO_TEST_CASE(merkle_test) {
     }
 }
 
+BOOST_AUTO_TEST_CASE(merkle_parallel_test) {
+    // Sizes around the boundaries of the subtrees the leaves are split into.
+    const size_t sizes[] = {1,
+                            MERKLE_PARALLEL_MIN_SUBTREE,
+                            MERKLE_PARALLEL_MIN_SUBTREE + 1,
+                            2 * MERKLE_PARALLEL_MIN_SUBTREE - 1,
+                            3 * MERKLE_PARALLEL_MIN_SUBTREE + 7,
+                            MERKLE_PARALLEL_MIN_LEAVES,
+                            MERKLE_PARALLEL_MIN_LEAVES + 1,
+                            5 * MERKLE_PARALLEL_MIN_LEAVES / 2 + 3};
+    for (const size_t size : sizes) {
+        std::vector<uint256> leaves(size);
+        for (uint256 &leaf : leaves) {
+            leaf = InsecureRand256();
+        }
+
+        bool mutated = true;
+        const uint256 root = ComputeMerkleRoot(leaves, &mutated);
+        BOOST_CHECK(!mutated);
+        for (unsigned int num_threads = 0; num_threads <= 5; num_threads++) {
+            BOOST_CHECK(ComputeMerkleRootParallel(leaves, &mutated,
+                                                  num_threads) == root);
+            BOOST_CHECK(!mutated);
+        }
+
+        // Duplicate the last leaves, or a pair of leaves in the middle of a
+        // subtree, which must be detected by the thread hashing it.
+        if (size > 1) {
+            const size_t duplicate = size_t(1) << ctz(size);
+            std::vector<uint256> mutated_leaves(leaves);
+            if (duplicate < size) {
+                mutated_leaves.insert(mutated_leaves.end(),
+                                      leaves.end() - duplicate, leaves.end());
+            } else {
+                mutated_leaves[size / 2 + 1] = mutated_leaves[size / 2];
+            }
+            for (unsigned int num_threads = 1; num_threads <= 4;
+                 num_threads++) {
+                mutated = false;
+                const uint256 mutated_root = ComputeMerkleRootParallel(
+                    mutated_leaves, &mutated, num_threads);
+                BOOST_CHECK(mutated);
+                BOOST_CHECK(mutated_root ==
+                            ComputeMerkleRoot(mutated_leaves));
+                if (duplicate < size) {
+                    BOOST_CHECK(mutated_root == root);
+                }
+            }
+        }
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
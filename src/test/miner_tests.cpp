@@ -787,4 +787,145 @@ BOOST_AUTO_TEST_CASE(TestCBlockTemplateEntry) {
     BOOST_CHECK_EQUAL(txEntry.txSigOps, 10);
 }
 
+BOOST_AUTO_TEST_CASE(BlockTemplateCache_incremental) {
+    GlobalConfig config;
+    const CChainParams &chainparams = config.GetChainParams();
+    CTxMemPool pool;
+    BlockTemplateCache cache(config, pool);
+    const CScript scriptPubKey = CScript() << OP_TRUE;
+
+    std::unique_ptr<CBlockTemplate> pblocktemplate =
+        cache.GetBlockTemplate(scriptPubKey);
+    BOOST_CHECK_EQUAL(pblocktemplate->block.vtx.size(), 1);
+    BOOST_CHECK_EQUAL(cache.size(), 0);
+
+    TestMemPoolEntryHelper entry;
+    CMutableTransaction parent;
+    parent.vin.resize(1);
+    parent.vin[0].prevout = COutPoint(TxId(InsecureRand256()), 0);
+    parent.vin[0].scriptSig = CScript() << OP_1;
+    parent.vout.resize(1);
+    parent.vout[0].nValue = 10 * COIN;
+    parent.vout[0].scriptPubKey = CScript() << OP_TRUE;
+
+    CMutableTransaction child = parent;
+    child.vin[0].prevout = COutPoint(parent.GetId(), 0);
+
+    // A free parent is not selected, and neither is its child.
+    CMutableTransaction freeParent = parent;
+    freeParent.vin[0].prevout = COutPoint(TxId(InsecureRand256()), 0);
+    CMutableTransaction freeChild = parent;
+    freeChild.vin[0].prevout = COutPoint(freeParent.GetId(), 0);
+
+    {
+        LOCK2(cs_main, pool.cs);
+        pool.addUnchecked(parent.GetId(),
+                          entry.Fee(10000 * SATOSHI).FromTx(parent));
+        pool.addUnchecked(child.GetId(),
+                          entry.Fee(20000 * SATOSHI).FromTx(child));
+        pool.addUnchecked(freeParent.GetId(),
+                          entry.Fee(Amount::zero()).FromTx(freeParent));
+        pool.addUnchecked(freeChild.GetId(),
+                          entry.Fee(50000 * SATOSHI).FromTx(freeChild));
+    }
+
+    pblocktemplate = cache.GetBlockTemplate(scriptPubKey);
+    BOOST_CHECK_EQUAL(cache.size(), 2);
+    BOOST_CHECK_EQUAL(pblocktemplate->block.vtx.size(), 3);
+    std::set<TxId> txids;
+    for (const CTransactionRef &tx : pblocktemplate->block.vtx) {
+        txids.insert(tx->GetId());
+    }
+    BOOST_CHECK(txids.count(parent.GetId()));
+    BOOST_CHECK(txids.count(child.GetId()));
+    BOOST_CHECK(!txids.count(freeParent.GetId()));
+    BOOST_CHECK(!txids.count(freeChild.GetId()));
+    BOOST_CHECK_EQUAL(pblocktemplate->block.vtx[0]->GetValueOut(),
+                      GetBlockSubsidy(chainActive.Height() + 1,
+                                      chainparams.GetConsensus()) +
+                          30000 * SATOSHI);
+
+    // Removing the parent also removes the child from the template.
+    {
+        LOCK2(cs_main, pool.cs);
+        pool.removeRecursive(CTransaction(parent));
+    }
+
+    pblocktemplate = cache.GetBlockTemplate(scriptPubKey);
+    BOOST_CHECK_EQUAL(cache.size(), 0);
+    BOOST_CHECK_EQUAL(pblocktemplate->block.vtx.size(), 1);
+    BOOST_CHECK_EQUAL(pblocktemplate->block.vtx[0]->GetValueOut(),
+                      GetBlockSubsidy(chainActive.Height() + 1,
+                                      chainparams.GetConsensus()));
+}
+
+BOOST_FIXTURE_TEST_CASE(BlockTemplateCache_journal_limit, TestChain100Setup) {
+    GlobalConfig config;
+    // The free parent spends an old coin, keep it out of the priority area.
+    config.SetBlockPriorityPercentage(0);
+    CTxMemPool pool;
+    BlockTemplateCache cache(config, pool, 2);
+    const CScript scriptPubKey = CScript() << OP_TRUE;
+
+    // The rebuild goes through TestBlockValidity, so the transactions must
+    // spend mature coins and pay the fees they claim.
+    std::vector<CTransactionRef> coinbases;
+    for (int i = 0; i < 3; i++) {
+        coinbases.push_back(CreateAndProcessBlock({}, scriptPubKey).vtx[0]);
+    }
+    for (int i = 0; i < COINBASE_MATURITY; i++) {
+        CreateAndProcessBlock({}, scriptPubKey);
+    }
+
+    auto spend = [&](const COutPoint &prevout, const Amount value) {
+        CMutableTransaction tx;
+        tx.vin.resize(1);
+        tx.vin[0].prevout = prevout;
+        tx.vout.resize(2);
+        tx.vout[0].nValue = value;
+        tx.vout[0].scriptPubKey = scriptPubKey;
+        // Keep the transaction above the minimum size.
+        tx.vout[1].nValue = Amount::zero();
+        tx.vout[1].scriptPubKey = CScript()
+                                  << OP_RETURN << std::vector<uint8_t>(64);
+        return tx;
+    };
+
+    TestMemPoolEntryHelper entry;
+    const Amount coinbaseValue = coinbases[0]->vout[0].nValue;
+    CMutableTransaction freeParent =
+        spend(COutPoint(coinbases[0]->GetId(), 0), coinbaseValue);
+    {
+        LOCK2(cs_main, pool.cs);
+        pool.addUnchecked(freeParent.GetId(),
+                          entry.Fee(Amount::zero()).FromTx(freeParent));
+    }
+
+    cache.GetBlockTemplate(scriptPubKey);
+    BOOST_CHECK_EQUAL(cache.size(), 0);
+
+    // A child paying for its parent is never appended to the candidate, but is
+    // selected along with its parent when the candidate is rebuilt. Going past
+    // the journal limit forces that rebuild.
+    CMutableTransaction child = spend(COutPoint(freeParent.GetId(), 0),
+                                      coinbaseValue - 50000 * SATOSHI);
+    {
+        LOCK2(cs_main, pool.cs);
+        pool.addUnchecked(child.GetId(),
+                          entry.Fee(50000 * SATOSHI).FromTx(child));
+        for (int i = 1; i < 3; i++) {
+            CMutableTransaction tx =
+                spend(COutPoint(coinbases[i]->GetId(), 0),
+                      coinbases[i]->vout[0].nValue - 10000 * SATOSHI);
+            pool.addUnchecked(tx.GetId(),
+                              entry.Fee(10000 * SATOSHI).FromTx(tx));
+        }
+    }
+
+    std::unique_ptr<CBlockTemplate> pblocktemplate =
+        cache.GetBlockTemplate(scriptPubKey);
+    BOOST_CHECK_EQUAL(cache.size(), 4);
+    BOOST_CHECK_EQUAL(pblocktemplate->block.vtx.size(), 5);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
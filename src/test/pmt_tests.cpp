@@ -8,6 +8,7 @@
 #include <serialize.h>
 #include <streams.h>
 #include <uint256.h>
+#include <util/strencodings.h>
 #include <version.h>
 
 #include <test/test_bitcoin.h>
@@ -125,4 +126,57 @@ BOOST_AUTO_TEST_CASE(pmt_malleability) {
     BOOST_CHECK(tree.ExtractMatches(vTxid, vIndex).IsNull());
 }
 
+BOOST_AUTO_TEST_CASE(pmt_merkle_tree_cache) {
+    CBlock block;
+    for (unsigned int j = 0; j < 77; j++) {
+        CMutableTransaction tx;
+        tx.nLockTime = j;
+        block.vtx.push_back(MakeTransactionRef(std::move(tx)));
+    }
+    block.hashMerkleRoot = BlockMerkleRoot(block);
+
+    // All the levels of the tree are kept.
+    CMerkleTreeRef tree = GetBlockMerkleTree(block);
+    BOOST_CHECK_EQUAL(tree->GetNumLeaves(), 77);
+    BOOST_CHECK_EQUAL(tree->GetHeight(), 7);
+    BOOST_CHECK(tree->GetRoot() == block.hashMerkleRoot);
+    BOOST_CHECK(!tree->IsMutated());
+    BOOST_CHECK(tree->GetHash(0, 76) == block.vtx[76]->GetId());
+    const uint256 &last = block.vtx[76]->GetId();
+    BOOST_CHECK(tree->GetHash(1, 38) ==
+                Hash(BEGIN(last), END(last), BEGIN(last), END(last)));
+
+    // The tree is only computed once.
+    BOOST_CHECK(LookupBlockMerkleTree(block.GetHash()) == tree);
+    BOOST_CHECK(GetBlockMerkleTree(block) == tree);
+
+    // Proofs from the cached tree are the same as from the block.
+    const std::set<TxId> txids = {block.vtx[3]->GetId(),
+                                  block.vtx[76]->GetId()};
+    CDataStream ss1(SER_NETWORK, PROTOCOL_VERSION);
+    CDataStream ss2(SER_NETWORK, PROTOCOL_VERSION);
+    ss1 << CMerkleBlock(block, txids);
+    ss2 << CMerkleBlock(block.GetBlockHeader(), *tree, txids);
+    BOOST_CHECK(ss1.str() == ss2.str());
+
+    // A mutated block with the same hash does not use the cached tree.
+    CBlock mutated(block);
+    mutated.vtx.push_back(block.vtx[76]);
+    BOOST_CHECK(mutated.GetHash() == block.GetHash());
+    CMerkleTreeRef mutated_tree = GetBlockMerkleTree(mutated);
+    BOOST_CHECK(mutated_tree != tree);
+    BOOST_CHECK(mutated_tree->IsMutated());
+    BOOST_CHECK(mutated_tree->GetRoot() == tree->GetRoot());
+    BOOST_CHECK_EQUAL(mutated_tree->GetNumLeaves(), 78);
+    BOOST_CHECK(LookupBlockMerkleTree(block.GetHash()) == tree);
+
+    // Only the most recent blocks are kept.
+    for (size_t i = 0; i < MERKLE_TREE_CACHE_SIZE; i++) {
+        CBlock other(block);
+        other.nNonce = i + 1;
+        GetBlockMerkleTree(other);
+    }
+    BOOST_CHECK(!LookupBlockMerkleTree(block.GetHash()));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -226,4 +226,51 @@ BOOST_AUTO_TEST_CASE(singlethreadedscheduler_ordered) {
     BOOST_CHECK_EQUAL(counter2, 100);
 }
 
+BOOST_AUTO_TEST_CASE(scheduler_stats) {
+    CScheduler scheduler;
+
+    CSchedulerStats stats = scheduler.getStats();
+    BOOST_CHECK_EQUAL(stats.nQueued, 0);
+    BOOST_CHECK_EQUAL(stats.nTasksRun, 0);
+
+    // Three tasks which are due now and one which is not.
+    std::atomic<int> counter{0};
+    for (int i = 0; i < 3; i++) {
+        scheduler.schedule([&counter]() {
+            MicroSleep(10000);
+            counter++;
+        });
+    }
+    scheduler.scheduleFromNow([]() {}, 3600 * 1000);
+
+    stats = scheduler.getStats();
+    BOOST_CHECK_EQUAL(stats.nQueued, 4);
+    BOOST_CHECK_EQUAL(stats.nDue, 3);
+    BOOST_CHECK_EQUAL(stats.nThreads, 0);
+
+    std::thread schedulerThread(
+        std::bind(&CScheduler::serviceQueue, &scheduler));
+    while (counter < 3) {
+        MicroSleep(1000);
+    }
+
+    // The last task has to be done running, as it is counted after it returns.
+    do {
+        stats = scheduler.getStats();
+    } while (stats.nTasksRun < 3);
+
+    BOOST_CHECK_EQUAL(stats.nQueued, 1);
+    BOOST_CHECK_EQUAL(stats.nDue, 0);
+    BOOST_CHECK_EQUAL(stats.nThreads, 1);
+    BOOST_CHECK_EQUAL(stats.nTasksRun, 3);
+    BOOST_CHECK(stats.nMaxRunTime >= 10000);
+    BOOST_CHECK(stats.nTotalRunTime >= 30000);
+    // With a single thread, the last task waited for the two others.
+    BOOST_CHECK(stats.nMaxDelay >= 20000);
+    BOOST_CHECK(stats.nTotalDelay >= stats.nMaxDelay);
+
+    scheduler.stop();
+    schedulerThread.join();
+}
+
 BOOST_AUTO_TEST_SUITE_END()
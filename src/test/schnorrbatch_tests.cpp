@@ -0,0 +1,134 @@
+// Copyright (c) 2019 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <script/schnorrbatch.h>
+
+#include <key.h>
+#include <streams.h>
+#include <util/strencodings.h>
+
+#include <test/test_bitcoin.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <vector>
+
+BOOST_FIXTURE_TEST_SUITE(schnorrbatch_tests, BasicTestingSetup)
+
+static std::vector<DeferredSchnorrSig> MakeSigs(size_t n) {
+    std::vector<DeferredSchnorrSig> sigs(n);
+    for (DeferredSchnorrSig &sig : sigs) {
+        CKey key;
+        key.MakeNewKey(InsecureRandBool());
+        sig.pubkey = key.GetPubKey();
+        sig.sighash = InsecureRand256();
+
+        std::vector<uint8_t> vchSig;
+        BOOST_CHECK(key.SignSchnorr(sig.sighash, vchSig));
+        BOOST_CHECK_EQUAL(vchSig.size(), 64U);
+        std::copy(vchSig.begin(), vchSig.end(), sig.sig.begin());
+    }
+    return sigs;
+}
+
+static bool VerifyBatch(const std::vector<DeferredSchnorrSig> &sigs) {
+    std::vector<const CPubKey *> pubkeys;
+    std::vector<const uint256 *> hashes;
+    std::vector<const uint8_t *> sigdata;
+    for (const DeferredSchnorrSig &sig : sigs) {
+        pubkeys.push_back(&sig.pubkey);
+        hashes.push_back(&sig.sighash);
+        sigdata.push_back(sig.sig.data());
+    }
+    return CPubKey::VerifySchnorrBatch(pubkeys, hashes, sigdata);
+}
+
+BOOST_AUTO_TEST_CASE(verify_schnorr_batch) {
+    BOOST_CHECK(VerifyBatch({}));
+
+    std::vector<DeferredSchnorrSig> sigs = MakeSigs(100);
+    BOOST_CHECK(VerifyBatch(sigs));
+
+    // A single bad signature fails the batch.
+    for (int i = 0; i < 10; i++) {
+        DeferredSchnorrSig &sig = sigs[InsecureRandRange(sigs.size())];
+        const size_t pos = InsecureRandRange(64);
+        sig.sig[pos] ^= 0x01;
+        BOOST_CHECK(!VerifyBatch(sigs));
+        sig.sig[pos] ^= 0x01;
+    }
+
+    // So does a valid signature for another message.
+    std::swap(sigs[3].sighash, sigs[42].sighash);
+    BOOST_CHECK(!VerifyBatch(sigs));
+    std::swap(sigs[3].sighash, sigs[42].sighash);
+    BOOST_CHECK(VerifyBatch(sigs));
+}
+
+BOOST_AUTO_TEST_CASE(batch_verifier) {
+    // Feed the verifier one signature at a time, as script checks do, so that
+    // full batches are verified by Add and the rest by Verify.
+    const size_t nSigs = 2 * SCHNORR_BATCH_SIZE + 10;
+    const std::vector<DeferredSchnorrSig> sigs = MakeSigs(nSigs);
+    {
+        SchnorrBatchVerifier verifier;
+        for (const DeferredSchnorrSig &sig : sigs) {
+            std::vector<DeferredSchnorrSig> deferred{sig};
+            BOOST_CHECK(verifier.Add(deferred));
+        }
+        BOOST_CHECK(verifier.Verify());
+    }
+
+    // Corrupt a signature in a full batch and one in the remainder.
+    for (size_t bad : {size_t(5), nSigs - 5}) {
+        SchnorrBatchVerifier verifier;
+        bool fOk = true;
+        for (size_t i = 0; i < nSigs; i++) {
+            std::vector<DeferredSchnorrSig> deferred{sigs[i]};
+            if (i == bad) {
+                deferred[0].sig[10] ^= 0x01;
+            }
+            fOk &= verifier.Add(deferred);
+        }
+        fOk &= verifier.Verify();
+        BOOST_CHECK(!fOk);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(batching_checker) {
+    CDataStream stream(
+        ParseHex(
+            "010000000122739e70fbee987a8be1788395a2f2e6ad18ccb7ff611cd798071539"
+            "dde3c38e000000000151ffffffff010000000000000000016a00000000"),
+        SER_NETWORK, PROTOCOL_VERSION);
+    CTransaction dummyTx(deserialize, stream);
+    PrecomputedTransactionData txdata(dummyTx);
+    std::vector<DeferredSchnorrSig> deferred;
+    BatchingTransactionSignatureChecker checker(&dummyTx, 0, 0 * SATOSHI,
+                                                false, txdata, deferred);
+
+    CKey key;
+    key.MakeNewKey(true);
+    const CPubKey pubkey = key.GetPubKey();
+    const uint256 hash = InsecureRand256();
+
+    // ECDSA signatures are verified right away.
+    std::vector<uint8_t> sig;
+    BOOST_CHECK(key.SignECDSA(hash, sig));
+    BOOST_CHECK(checker.VerifySignature(sig, pubkey, hash));
+    BOOST_CHECK(!checker.VerifySignature(sig, pubkey, InsecureRand256()));
+    BOOST_CHECK(deferred.empty());
+
+    // Schnorr signatures are assumed valid and deferred, even bad ones.
+    BOOST_CHECK(key.SignSchnorr(hash, sig));
+    BOOST_CHECK(checker.VerifySignature(sig, pubkey, hash));
+    BOOST_CHECK(checker.VerifySignature(sig, pubkey, InsecureRand256()));
+    BOOST_CHECK_EQUAL(deferred.size(), 2U);
+
+    SchnorrBatchVerifier verifier;
+    BOOST_CHECK(verifier.Add(deferred));
+    BOOST_CHECK(!verifier.Verify());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -199,6 +199,35 @@ BOOST_AUTO_TEST_CASE(streams_serializedata_xor) {
                       std::string(ds.begin(), ds.end()));
 }
 
+BOOST_AUTO_TEST_CASE(streams_xor_with_key) {
+    // Compare the word-wide XOR of 8 bytes keys, and the bytewise XOR of other
+    // keys, with a plain bytewise XOR, for every alignment of the key.
+    for (size_t key_size : {3, 8}) {
+        std::vector<uint8_t> key(key_size);
+        for (size_t i = 0; i < key_size; i++) {
+            key[i] = InsecureRandBits(8);
+        }
+
+        for (size_t size = 0; size < 40; size++) {
+            std::vector<uint8_t> data(size);
+            for (uint8_t &byte : data) {
+                byte = InsecureRandBits(8);
+            }
+
+            for (size_t offset = 0; offset < 2 * key_size; offset++) {
+                std::vector<uint8_t> expected = data;
+                for (size_t i = 0; i < size; i++) {
+                    expected[i] ^= key[(offset + i) % key_size];
+                }
+
+                std::vector<uint8_t> result = data;
+                XorWithKey(result.data(), result.size(), key, offset);
+                BOOST_CHECK(result == expected);
+            }
+        }
+    }
+}
+
 BOOST_AUTO_TEST_CASE(streams_empty_vector) {
     std::vector<char> in;
     CDataStream ds(in, 0, 0);
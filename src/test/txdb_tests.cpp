@@ -0,0 +1,153 @@
+// Copyright (c) 2019 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <txdb.h>
+
+#include <chain.h>
+#include <chainparams.h>
+#include <pow.h>
+
+#include <test/test_bitcoin.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <memory>
+
+BOOST_FIXTURE_TEST_SUITE(txdb_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(blockindexarena) {
+    BlockIndexArena arena;
+    std::vector<CBlockIndex *> entries;
+    for (int i = 0; i < 10000; i++) {
+        entries.push_back(arena.New());
+        entries.back()->nHeight = i;
+    }
+
+    BlockIndexArena other;
+    CBlockIndex *other_entry = other.New();
+    arena.Merge(std::move(other));
+    BOOST_CHECK(!other.Owns(other_entry));
+
+    // Entries keep their address.
+    for (int i = 0; i < 10000; i++) {
+        BOOST_CHECK_EQUAL(entries[i]->nHeight, i);
+        BOOST_CHECK(arena.Owns(entries[i]));
+    }
+    BOOST_CHECK(arena.Owns(other_entry));
+
+    // Allocating after a merge does not reuse the merged entries.
+    CBlockIndex *after_merge = arena.New();
+    BOOST_CHECK(after_merge != other_entry + 1);
+    BOOST_CHECK(arena.Owns(after_merge));
+
+    std::unique_ptr<CBlockIndex> outside(new CBlockIndex());
+    BOOST_CHECK(!arena.Owns(outside.get()));
+
+    arena.Clear();
+    BOOST_CHECK(!arena.Owns(entries[0]));
+}
+
+// Make a header with a valid regtest proof of work.
+static CBlockHeader MakeHeader(const Consensus::Params &params,
+                               const uint256 &hashPrev, uint32_t nTime) {
+    CBlockHeader header;
+    header.hashPrevBlock = hashPrev;
+    header.hashMerkleRoot = InsecureRand256();
+    header.nTime = nTime;
+    header.nBits = UintToArith256(params.powLimit).GetCompact();
+    while (!CheckProofOfWork(header.GetHash(), header.nBits, params)) {
+        header.nNonce++;
+    }
+    return header;
+}
+
+BOOST_AUTO_TEST_CASE(load_block_index_guts) {
+    const std::unique_ptr<CChainParams> chainparams =
+        CreateChainParams(CBaseChainParams::REGTEST);
+    const Consensus::Params &params = chainparams->GetConsensus();
+
+    BlockMap written;
+    std::vector<std::unique_ptr<CBlockIndex>> owned;
+    std::vector<const CBlockIndex *> entries;
+    auto add = [&](CBlockIndex *parent) {
+        const int height = parent ? parent->nHeight + 1 : 0;
+        const CBlockHeader header = MakeHeader(
+            params, parent ? parent->GetBlockHash() : uint256(), height);
+        owned.emplace_back(new CBlockIndex(header));
+        CBlockIndex *pindex = owned.back().get();
+        pindex->pprev = parent;
+        pindex->nHeight = height;
+        pindex->nTx = height + 1;
+        pindex->nStatus = BlockStatus().withValidity(BlockValidity::TREE);
+        pindex->phashBlock =
+            &written.emplace(header.GetHash(), pindex).first->first;
+        entries.push_back(pindex);
+        return pindex;
+    };
+
+    // A chain with a fork, so that there are more entries than heights.
+    CBlockIndex *tip = add(nullptr);
+    CBlockIndex *fork = nullptr;
+    for (int height = 1; height < 1000; height++) {
+        tip = add(tip);
+        if (height == 500) {
+            fork = tip;
+        }
+    }
+    for (int i = 0; i < 200; i++) {
+        fork = add(fork);
+    }
+
+    CBlockTreeDB db(1 << 20, true);
+    BOOST_CHECK(db.WriteBatchSync({}, 0, entries));
+
+    BlockIndexArena arena;
+    BlockMap loaded;
+    auto insert = [&loaded](const uint256 &hash) -> CBlockIndex * {
+        if (hash.IsNull()) {
+            return nullptr;
+        }
+        auto it = loaded.emplace(hash, nullptr).first;
+        if (it->second == nullptr) {
+            it->second = new CBlockIndex();
+            it->second->phashBlock = &it->first;
+        }
+        return it->second;
+    };
+    BOOST_CHECK(db.LoadBlockIndexGuts(
+        params, arena,
+        [&loaded](const uint256 &hash, CBlockIndex *pindex) {
+            auto it = loaded.emplace(hash, pindex).first;
+            BOOST_CHECK(it->second == pindex);
+            pindex->phashBlock = &it->first;
+            return pindex;
+        },
+        insert));
+
+    // Every entry is read back and linked to its parent.
+    BOOST_CHECK_EQUAL(loaded.size(), written.size());
+    for (const BlockMap::value_type &entry : written) {
+        const CBlockIndex *pindex = entry.second;
+        auto it = loaded.find(entry.first);
+        BOOST_REQUIRE(it != loaded.end());
+        const CBlockIndex *pindexLoaded = it->second;
+        BOOST_CHECK(arena.Owns(pindexLoaded));
+        BOOST_CHECK(pindexLoaded->GetBlockHash() == pindex->GetBlockHash());
+        BOOST_CHECK(pindexLoaded->GetBlockHeader().GetHash() ==
+                    pindex->GetBlockHash());
+        BOOST_CHECK_EQUAL(pindexLoaded->nHeight, pindex->nHeight);
+        BOOST_CHECK_EQUAL(pindexLoaded->nTx, pindex->nTx);
+        BOOST_CHECK(pindexLoaded->nStatus.getValidity() ==
+                    BlockValidity::TREE);
+        if (pindex->pprev) {
+            BOOST_REQUIRE(pindexLoaded->pprev);
+            BOOST_CHECK(pindexLoaded->pprev->GetBlockHash() ==
+                        pindex->pprev->GetBlockHash());
+        } else {
+            BOOST_CHECK(pindexLoaded->pprev == nullptr);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
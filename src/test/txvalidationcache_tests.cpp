@@ -91,6 +91,71 @@ BOOST_FIXTURE_TEST_CASE(tx_mempool_block_doublespend, TestChain100Setup) {
     BOOST_CHECK_EQUAL(g_mempool.size(), 0U);
 }
 
+BOOST_FIXTURE_TEST_CASE(tx_mempool_prevalidation, TestChain100Setup) {
+    CScript scriptPubKey = CScript() << ToByteVector(coinbaseKey.GetPubKey())
+                                     << OP_CHECKSIG;
+
+    // Spend the mature coinbase in various ways.
+    const Amount coinbaseValue = m_coinbase_txns[0]->vout[0].nValue;
+    auto spend = [&](int32_t nVersion, Amount nValue, const TxId &prevTxId) {
+        CMutableTransaction tx;
+        tx.nVersion = nVersion;
+        tx.vin.resize(1);
+        tx.vin[0].prevout = COutPoint(prevTxId, 0);
+        tx.vout.resize(1);
+        tx.vout[0].nValue = nValue;
+        tx.vout[0].scriptPubKey = scriptPubKey;
+
+        // Sign:
+        std::vector<uint8_t> vchSig;
+        uint256 hash = SignatureHash(scriptPubKey, CTransaction(tx), 0,
+                                     SigHashType().withForkId(), coinbaseValue);
+        BOOST_CHECK(coinbaseKey.SignECDSA(hash, vchSig));
+        vchSig.push_back(uint8_t(SIGHASH_ALL | SIGHASH_FORKID));
+        tx.vin[0].scriptSig << vchSig;
+        return tx;
+    };
+
+    const TxId coinbaseId = m_coinbase_txns[0]->GetId();
+    CMutableTransaction valid = spend(1, 11 * CENT, coinbaseId);
+
+    // Corrupt the signature.
+    CMutableTransaction badSig = valid;
+    std::vector<uint8_t> vchBadSig(badSig.vin[0].scriptSig.begin() + 1,
+                                   badSig.vin[0].scriptSig.end());
+    vchBadSig[10] ^= 0x01;
+    badSig.vin[0].scriptSig = CScript() << vchBadSig;
+
+    const Config &config = GetConfig();
+
+    // Invalid scripts, missing inputs, and transactions failing the policy
+    // checks that come before the scripts in AcceptToMemoryPool do not get
+    // their scripts verified.
+    const std::vector<CMutableTransaction> rejected = {
+        badSig,
+        spend(1, 11 * CENT, TxId(InsecureRand256())),
+        // Non-standard version.
+        spend(3, 11 * CENT, coinbaseId),
+        // No fee.
+        spend(1, coinbaseValue, coinbaseId),
+    };
+    for (const CMutableTransaction &mtx : rejected) {
+        BOOST_CHECK(!PreValidateTransaction(config, g_mempool,
+                                            MakeTransactionRef(mtx)));
+    }
+    BOOST_CHECK(!ToMemPool(badSig));
+
+    // A valid transaction gets its scripts verified ahead of admission...
+    CTransactionRef tx = MakeTransactionRef(valid);
+    BOOST_CHECK(PreValidateTransaction(config, g_mempool, tx));
+    BOOST_CHECK(ToMemPool(valid));
+    // ... but not once it is in the mempool.
+    BOOST_CHECK(!PreValidateTransaction(config, g_mempool, tx));
+
+    BOOST_CHECK_EQUAL(g_mempool.size(), 1U);
+    g_mempool.clear();
+}
+
 // Run CheckInputs (using pcoinsTip) on the given transaction, for all script
 // flags. Test that CheckInputs passes for all flags that don't overlap with the
 // failing_flags argument, but otherwise fails.
@@ -5,6 +5,7 @@
 
 #include <validation.h>
 
+#include <chain.h>
 #include <chainparams.h>
 #include <clientversion.h>
 #include <config.h>
@@ -79,4 +80,49 @@ BOOST_AUTO_TEST_CASE(validation_load_external_block_file) {
     BOOST_CHECK_NO_THROW({ LoadExternalBlockFile(config, fp, 0); });
 }
 
+BOOST_FIXTURE_TEST_CASE(read_raw_block_from_disk, TestChain100Setup) {
+    const CChainParams &chainparams = GetConfig().GetChainParams();
+    const CBlockIndex *pindex;
+    FlatFilePos prevPos;
+    {
+        LOCK(cs_main);
+        pindex = chainActive.Tip();
+        prevPos = pindex->pprev->GetBlockPos();
+    }
+
+    // The raw block is the network serialization of the block.
+    CBlock block;
+    BOOST_CHECK(ReadBlockFromDisk(block, pindex, chainparams.GetConsensus()));
+    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+    ss << block;
+
+    std::vector<uint8_t> rawBlock;
+    BOOST_CHECK(
+        ReadRawBlockFromDisk(rawBlock, pindex, chainparams.DiskMagic()));
+    BOOST_CHECK(std::vector<uint8_t>(ss.begin(), ss.end()) == rawBlock);
+
+    // The index header has to match.
+    CMessageHeader::MessageMagic magic = chainparams.DiskMagic();
+    magic[0] ^= 0xff;
+    BOOST_CHECK(!ReadRawBlockFromDisk(rawBlock, pindex, magic));
+
+    // A position which is not right after an index header.
+    BOOST_CHECK(!ReadRawBlockFromDisk(rawBlock, FlatFilePos(prevPos.nFile, 0),
+                                      chainparams.DiskMagic()));
+    BOOST_CHECK(!ReadRawBlockFromDisk(
+        rawBlock, FlatFilePos(prevPos.nFile, prevPos.nPos + 1),
+        chainparams.DiskMagic()));
+
+    // The block at the position has to be the one of the index.
+    CBlockIndex index(pindex->GetBlockHeader());
+    index.phashBlock = pindex->phashBlock;
+    index.nFile = prevPos.nFile;
+    index.nDataPos = prevPos.nPos;
+    index.nStatus = index.nStatus.withData();
+    BOOST_CHECK(
+        ReadRawBlockFromDisk(rawBlock, prevPos, chainparams.DiskMagic()));
+    BOOST_CHECK(
+        !ReadRawBlockFromDisk(rawBlock, &index, chainparams.DiskMagic()));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -18,7 +18,9 @@
 
 #include <boost/thread.hpp> // boost::this_thread::interruption_point() (mingw)
 
+#include <algorithm>
 #include <cstdint>
+#include <thread>
 
 static const char DB_COIN = 'C';
 static const char DB_COINS = 'c';
@@ -264,30 +266,61 @@ bool CBlockTreeDB::ReadFlag(const std::string &name, bool &fValue) {
     return true;
 }
 
-bool CBlockTreeDB::LoadBlockIndexGuts(
-    const Consensus::Params &params,
-    std::function<CBlockIndex *(const uint256 &)> insertBlockIndex) {
+/** The maximum number of threads reading the block index at startup. */
+static const int MAX_BLOCK_INDEX_LOAD_THREADS = 16;
+
+namespace {
+/** A block index entry read from disk, not linked to its parent yet. */
+struct LoadedBlockIndex {
+    CBlockIndex *pindex;
+    uint256 hash;
+    uint256 hashPrev;
+};
+
+/**
+ * The entries of the blocks whose hash starts with a byte in
+ * [first_byte, end_byte), read and checked by one thread.
+ */
+struct BlockIndexShard {
+    int first_byte;
+    int end_byte;
+    BlockIndexArena arena;
+    std::vector<LoadedBlockIndex> entries;
+    bool ok = true;
+};
+} // namespace
 
-    std::unique_ptr<CDBIterator> pcursor(NewIterator());
+static void LoadBlockIndexShard(CBlockTreeDB &db,
+                                const Consensus::Params &params,
+                                BlockIndexShard &shard) {
+    std::unique_ptr<CDBIterator> pcursor(db.NewIterator());
 
-    pcursor->Seek(std::make_pair(DB_BLOCK_INDEX, uint256()));
+    uint256 start;
+    *start.begin() = shard.first_byte;
+    pcursor->Seek(std::make_pair(DB_BLOCK_INDEX, start));
 
-    // Load mapBlockIndex
     while (pcursor->Valid()) {
-        boost::this_thread::interruption_point();
         std::pair<char, uint256> key;
-        if (!pcursor->GetKey(key) || key.first != DB_BLOCK_INDEX) {
+        if (!pcursor->GetKey(key) || key.first != DB_BLOCK_INDEX ||
+            *key.second.begin() >= shard.end_byte) {
             break;
         }
 
         CDiskBlockIndex diskindex;
         if (!pcursor->GetValue(diskindex)) {
-            return error("%s : failed to read value", __func__);
+            shard.ok = error("%s : failed to read value", __func__);
+            return;
+        }
+
+        const uint256 hash = diskindex.GetBlockHash();
+        if (!CheckProofOfWork(hash, diskindex.nBits, params)) {
+            shard.ok = error("%s: CheckProofOfWork failed: %s", __func__,
+                             diskindex.ToString());
+            return;
         }
 
         // Construct block index object
-        CBlockIndex *pindexNew = insertBlockIndex(diskindex.GetBlockHash());
-        pindexNew->pprev = insertBlockIndex(diskindex.hashPrev);
+        CBlockIndex *pindexNew = shard.arena.New();
         pindexNew->nHeight = diskindex.nHeight;
         pindexNew->nFile = diskindex.nFile;
         pindexNew->nDataPos = diskindex.nDataPos;
@@ -299,16 +332,68 @@ bool CBlockTreeDB::LoadBlockIndexGuts(
         pindexNew->nNonce = diskindex.nNonce;
         pindexNew->nStatus = diskindex.nStatus;
         pindexNew->nTx = diskindex.nTx;
+        shard.entries.push_back({pindexNew, hash, diskindex.hashPrev});
+
+        pcursor->Next();
+    }
+}
 
-        if (!CheckProofOfWork(pindexNew->GetBlockHash(), pindexNew->nBits,
-                              params)) {
-            return error("%s: CheckProofOfWork failed: %s", __func__,
-                         pindexNew->ToString());
+bool CBlockTreeDB::LoadBlockIndexGuts(
+    const Consensus::Params &params, BlockIndexArena &arena,
+    std::function<CBlockIndex *(const uint256 &, CBlockIndex *)> addBlockIndex,
+    std::function<CBlockIndex *(const uint256 &)> insertBlockIndex) {
+    int64_t nTimeStart = GetTimeMillis();
+
+    // Read the entries on several threads, sharded by the first byte of the
+    // block hash, which is uniformly distributed.
+    const int nShards = std::max(
+        1, std::min(GetNumCores(), MAX_BLOCK_INDEX_LOAD_THREADS));
+    std::vector<BlockIndexShard> shards(nShards);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < nShards; i++) {
+        shards[i].first_byte = i * 256 / nShards;
+        shards[i].end_byte = (i + 1) * 256 / nShards;
+        if (i > 0) {
+            threads.emplace_back(LoadBlockIndexShard, std::ref(*this),
+                                 std::cref(params), std::ref(shards[i]));
         }
+    }
+    LoadBlockIndexShard(*this, params, shards[0]);
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
 
-        pcursor->Next();
+    size_t nEntries = 0;
+    for (BlockIndexShard &shard : shards) {
+        if (!shard.ok) {
+            return false;
+        }
+        nEntries += shard.entries.size();
+        arena.Merge(std::move(shard.arena));
     }
 
+    int64_t nTimeRead = GetTimeMillis();
+    LogPrintf("%s: read %u block index entries on %d threads in %dms\n",
+              __func__, nEntries, nShards, nTimeRead - nTimeStart);
+
+    boost::this_thread::interruption_point();
+
+    // Register every entry before linking them, so that parents are found
+    // whatever the order they were read in.
+    for (BlockIndexShard &shard : shards) {
+        for (LoadedBlockIndex &entry : shard.entries) {
+            entry.pindex = addBlockIndex(entry.hash, entry.pindex);
+        }
+    }
+    for (const BlockIndexShard &shard : shards) {
+        for (const LoadedBlockIndex &entry : shard.entries) {
+            entry.pindex->pprev = insertBlockIndex(entry.hashPrev);
+        }
+    }
+
+    LogPrintf("%s: linked block index entries in %dms\n", __func__,
+              GetTimeMillis() - nTimeRead);
+
     return true;
 }
 
@@ -19,6 +19,7 @@
 #include <utility>
 #include <vector>
 
+class BlockIndexArena;
 class CBlockIndex;
 class CCoinsViewDBCursor;
 class uint256;
@@ -44,6 +45,8 @@ static const int64_t nMaxBlockDBCache = 2;
 // a meaningful difference:
 // https://github.com/bitcoin/bitcoin/pull/8273#issuecomment-229601991
 static const int64_t nMaxTxIndexCache = 1024;
+//! Max memory allocated to block stats index DB specific cache (MiB)
+static const int64_t nMaxBlockStatsIndexCache = 16;
 //! Max memory allocated to coin DB specific cache (MiB)
 static const int64_t nMaxCoinsDBCache = 8;
 
@@ -130,8 +133,17 @@ public:
     bool ReadTxIndex(const uint256 &txid, CDiskTxPos &pos);
     bool WriteFlag(const std::string &name, bool fValue);
     bool ReadFlag(const std::string &name, bool &fValue);
+    /**
+     * Load the whole block index. The entries are read and checked on several
+     * threads, each over a range of block hashes, and allocated from the
+     * arena. They are then handed over to addBlockIndex, which returns the
+     * entry that is actually kept for the block, and finally linked to their
+     * parent found with insertBlockIndex.
+     */
     bool LoadBlockIndexGuts(
-        const Consensus::Params &params,
+        const Consensus::Params &params, BlockIndexArena &arena,
+        std::function<CBlockIndex *(const uint256 &, CBlockIndex *)>
+            addBlockIndex,
         std::function<CBlockIndex *(const uint256 &)> insertBlockIndex);
 };
 
@@ -80,7 +80,8 @@ void CTxMemPoolEntry::UpdateLockPoints(const LockPoints &lp) {
 // descendants.
 void CTxMemPool::UpdateForDescendants(txiter updateIt,
                                       cacheMap &cachedDescendants,
-                                      const std::set<TxId> &setExclude) {
+                                      const std::set<TxId> &setExclude,
+                                      stateDeltaMap &descendantDeltas) {
     setEntries stageEntries, setAllDescendants;
     stageEntries = GetMemPoolChildren(updateIt);
 
@@ -114,11 +115,12 @@ void CTxMemPool::UpdateForDescendants(txiter updateIt,
             modifyFee += cit->GetModifiedFee();
             modifyCount++;
             cachedDescendants[updateIt].insert(cit);
-            // Update ancestor state for each descendant
-            mapTx.modify(cit,
-                         update_ancestor_state(updateIt->GetTxSize(),
-                                               updateIt->GetModifiedFee(), 1,
-                                               updateIt->GetSigOpCount()));
+            // Record the ancestor state update for each descendant
+            StateDelta &delta = descendantDeltas[cit];
+            delta.modifySize += updateIt->GetTxSize();
+            delta.modifyFee += updateIt->GetModifiedFee();
+            delta.modifyCount++;
+            delta.modifySigOps += updateIt->GetSigOpCount();
         }
     }
     mapTx.modify(updateIt,
@@ -137,6 +139,10 @@ void CTxMemPool::UpdateTransactionsFromBlock(
     // in-txidsToUpdate transactions, so that we don't have to recalculate
     // descendants when we come across a previously seen entry.
     cacheMap mapMemPoolDescendantsToUpdate;
+    // Ancestor state updates for descendants, applied once at the end so that
+    // long chains hanging off several block transactions are only modified
+    // once per descendant.
+    stateDeltaMap mapDescendantDeltas;
 
     // Use a set for lookups into txidsToUpdate (these entries are already
     // accounted for in the state of their ancestors)
@@ -174,7 +180,15 @@ void CTxMemPool::UpdateTransactionsFromBlock(
             }
         }
         UpdateForDescendants(it, mapMemPoolDescendantsToUpdate,
-                             setAlreadyIncluded);
+                             setAlreadyIncluded, mapDescendantDeltas);
+    }
+
+    for (const auto &delta : mapDescendantDeltas) {
+        mapTx.modify(delta.first,
+                     update_ancestor_state(delta.second.modifySize,
+                                           delta.second.modifyFee,
+                                           delta.second.modifyCount,
+                                           delta.second.modifySigOps));
     }
 }
 
@@ -310,21 +324,62 @@ void CTxMemPool::UpdateForRemoveFromMempool(const setEntries &entriesToRemove,
         // confirmed in a block. Here we only update statistics and not data in
         // mapLinks (which we need to preserve until we're finished with all
         // operations that need to traverse the mempool).
+        stateDeltaMap mapDescendantDeltas;
         for (txiter removeIt : entriesToRemove) {
             setEntries setDescendants;
             CalculateDescendants(removeIt, setDescendants);
-            setDescendants.erase(removeIt); // don't update state for self
-            int64_t modifySize = -int64_t(removeIt->GetTxSize());
-            Amount modifyFee = -1 * removeIt->GetModifiedFee();
-            int modifySigOps = -removeIt->GetSigOpCount();
             for (txiter dit : setDescendants) {
-                mapTx.modify(dit, update_ancestor_state(modifySize, modifyFee,
-                                                        -1, modifySigOps));
+                // Don't update state for self or anything else going away.
+                if (entriesToRemove.count(dit)) {
+                    continue;
+                }
+
+                StateDelta &delta = mapDescendantDeltas[dit];
+                delta.modifySize -= removeIt->GetTxSize();
+                delta.modifyFee -= removeIt->GetModifiedFee();
+                delta.modifyCount--;
+                delta.modifySigOps -= removeIt->GetSigOpCount();
             }
         }
+
+        for (const auto &delta : mapDescendantDeltas) {
+            mapTx.modify(delta.first,
+                         update_ancestor_state(delta.second.modifySize,
+                                               delta.second.modifyFee,
+                                               delta.second.modifyCount,
+                                               delta.second.modifySigOps));
+        }
     }
 
+    // Only entries with an ancestor outside of entriesToRemove need to walk
+    // their ancestors: the ones with a parent outside of the set, and the
+    // entries of the set descending from them. When removing the transactions
+    // of a block this is usually none of them, as their in-mempool ancestors
+    // are in the block too.
+    setEntries setWithOutsideAncestors;
+    setEntries stage;
     for (txiter removeIt : entriesToRemove) {
+        for (txiter piter : GetMemPoolParents(removeIt)) {
+            if (!entriesToRemove.count(piter)) {
+                stage.insert(removeIt);
+                break;
+            }
+        }
+    }
+    while (!stage.empty()) {
+        txiter it = *stage.begin();
+        stage.erase(stage.begin());
+        setWithOutsideAncestors.insert(it);
+        for (txiter childiter : GetMemPoolChildren(it)) {
+            if (entriesToRemove.count(childiter) &&
+                !setWithOutsideAncestors.count(childiter)) {
+                stage.insert(childiter);
+            }
+        }
+    }
+
+    stateDeltaMap mapAncestorDeltas;
+    for (txiter removeIt : setWithOutsideAncestors) {
         setEntries setAncestors;
         const CTxMemPoolEntry &entry = *removeIt;
         std::string dummy;
@@ -347,10 +402,34 @@ void CTxMemPool::UpdateForRemoveFromMempool(const setEntries &entriesToRemove,
         // to update for removal.
         CalculateMemPoolAncestors(entry, setAncestors, nNoLimit, nNoLimit,
                                   nNoLimit, nNoLimit, dummy, false);
-        // Note that UpdateAncestorsOf severs the child links that point to
-        // removeIt in the entries for the parents of removeIt.
-        UpdateAncestorsOf(false, removeIt, setAncestors);
+
+        // Sever the child links that point to removeIt in the entries for the
+        // parents of removeIt which remain in the mempool.
+        for (txiter piter : GetMemPoolParents(removeIt)) {
+            if (!entriesToRemove.count(piter)) {
+                UpdateChild(piter, removeIt, false);
+            }
+        }
+
+        for (txiter ancestorIt : setAncestors) {
+            if (entriesToRemove.count(ancestorIt)) {
+                continue;
+            }
+
+            StateDelta &delta = mapAncestorDeltas[ancestorIt];
+            delta.modifySize -= removeIt->GetTxSize();
+            delta.modifyFee -= removeIt->GetModifiedFee();
+            delta.modifyCount--;
+        }
+    }
+
+    for (const auto &delta : mapAncestorDeltas) {
+        mapTx.modify(delta.first,
+                     update_descendant_state(delta.second.modifySize,
+                                             delta.second.modifyFee,
+                                             delta.second.modifyCount));
     }
+
     // After updating all the ancestor sizes, we can now sever the link between
     // each transaction being removed and any mempool children (ie, update
     // setMemPoolParents for each direct child of a transaction being removed).
@@ -627,34 +706,23 @@ void CTxMemPool::removeForBlock(const std::vector<CTransactionRef> &vtx,
                                 unsigned int nBlockHeight) {
     LOCK(cs);
 
-    DisconnectedBlockTransactions disconnectpool;
-    disconnectpool.addForBlock(vtx);
-
-    std::vector<const CTxMemPoolEntry *> entries;
-    for (const CTransactionRef &tx :
-         reverse_iterate(disconnectpool.GetQueuedTx().get<insertion_order>())) {
-        uint256 txid = tx->GetId();
-
-        indexed_transaction_set::iterator i = mapTx.find(txid);
-        if (i != mapTx.end()) {
-            entries.push_back(&*i);
-        }
-    }
-
-    for (const CTransactionRef &tx :
-         reverse_iterate(disconnectpool.GetQueuedTx().get<insertion_order>())) {
+    // Remove all the confirmed transactions at once, so that ancestor and
+    // descendant state is updated with a single aggregated change per
+    // remaining entry instead of once per confirmed transaction.
+    setEntries stage;
+    for (const CTransactionRef &tx : vtx) {
         txiter it = mapTx.find(tx->GetId());
         if (it != mapTx.end()) {
-            setEntries stage;
             stage.insert(it);
-            RemoveStaged(stage, true, MemPoolRemovalReason::BLOCK);
         }
+    }
+    RemoveStaged(stage, true, MemPoolRemovalReason::BLOCK);
+
+    for (const CTransactionRef &tx : vtx) {
         removeConflicts(*tx);
         ClearPrioritisation(tx->GetId());
     }
 
-    disconnectpool.clear();
-
     lastRollingFeeUpdate = GetTime();
     blockSinceLastRollingFeeBump = true;
 }
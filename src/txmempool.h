@@ -584,6 +584,18 @@ public:
 private:
     typedef std::map<txiter, setEntries, CompareIteratorByHash> cacheMap;
 
+    /**
+     * Accumulated change to the ancestor or descendant state of an entry, so
+     * that entries affected by many others can be modified once in mapTx.
+     */
+    struct StateDelta {
+        int64_t modifySize = 0;
+        Amount modifyFee = Amount::zero();
+        int64_t modifyCount = 0;
+        int64_t modifySigOps = 0;
+    };
+    typedef std::map<txiter, StateDelta, CompareIteratorByHash> stateDeltaMap;
+
     struct TxLinks {
         setEntries parents;
         setEntries children;
@@ -801,9 +813,14 @@ private:
      * cachedDescendants will be updated with the descendants of the transaction
      * being updated, so that future invocations don't need to walk the same
      * transaction again, if encountered in another transaction chain.
+     *
+     * The ancestor state changes of the descendants are accumulated in
+     * descendantDeltas rather than applied, so that the caller can apply them
+     * once all transactions have been processed.
      */
     void UpdateForDescendants(txiter updateIt, cacheMap &cachedDescendants,
-                              const std::set<TxId> &setExclude)
+                              const std::set<TxId> &setExclude,
+                              stateDeltaMap &descendantDeltas)
         EXCLUSIVE_LOCKS_REQUIRED(cs);
     /**
      * Update ancestors of hash to add/remove it as a descendant transaction.
@@ -816,7 +833,9 @@ private:
     /**
      * For each transaction being removed, update ancestors and any direct
      * children. If updateDescendants is true, then also update in-mempool
-     * descendants' ancestor state.
+     * descendants' ancestor state. Entries that are part of entriesToRemove
+     * are not updated, and the changes for every other entry are aggregated so
+     * that it is modified only once.
      */
     void UpdateForRemoveFromMempool(const setEntries &entriesToRemove,
                                     bool updateDescendants)
@@ -0,0 +1,107 @@
+// Copyright (c) 2019 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <util/jsonwriter.h>
+
+#include <iomanip>
+#include <sstream>
+
+static const char HEX_DIGITS[] = "0123456789abcdef";
+
+void JSONWriter::WriteEscaped(const char *str, size_t size) {
+    m_out += '"';
+    for (size_t i = 0; i < size; i++) {
+        const uint8_t ch = str[i];
+        // The same escapes as UniValue, see univalue_escapes.h.
+        switch (ch) {
+            case '"':
+                m_out += "\\\"";
+                break;
+            case '\\':
+                m_out += "\\\\";
+                break;
+            case '\b':
+                m_out += "\\b";
+                break;
+            case '\t':
+                m_out += "\\t";
+                break;
+            case '\n':
+                m_out += "\\n";
+                break;
+            case '\f':
+                m_out += "\\f";
+                break;
+            case '\r':
+                m_out += "\\r";
+                break;
+            default:
+                if (ch < 0x20 || ch == 0x7f) {
+                    m_out += "\\u00";
+                    m_out += HEX_DIGITS[ch >> 4];
+                    m_out += HEX_DIGITS[ch & 0xf];
+                } else {
+                    m_out += char(ch);
+                }
+        }
+    }
+    m_out += '"';
+}
+
+void JSONWriter::Key(const std::string &key) {
+    Separate();
+    WriteEscaped(key.data(), key.size());
+    m_out += ':';
+    m_after_key = true;
+}
+
+void JSONWriter::String(const std::string &str) {
+    Separate();
+    WriteEscaped(str.data(), str.size());
+}
+
+void JSONWriter::Hex(const uint8_t *begin, const uint8_t *end) {
+    Separate();
+    m_out += '"';
+    const size_t pos = m_out.size();
+    m_out.resize(pos + (end - begin) * 2);
+    char *dest = &m_out[pos];
+    for (const uint8_t *it = begin; it != end; ++it) {
+        *dest++ = HEX_DIGITS[*it >> 4];
+        *dest++ = HEX_DIGITS[*it & 0xf];
+    }
+    m_out += '"';
+}
+
+void JSONWriter::Int(int64_t n) {
+    Separate();
+    m_out += std::to_string(n);
+}
+
+void JSONWriter::UInt(uint64_t n) {
+    Separate();
+    m_out += std::to_string(n);
+}
+
+void JSONWriter::Real(double n) {
+    Separate();
+    std::ostringstream oss;
+    oss << std::setprecision(16) << n;
+    m_out += oss.str();
+}
+
+void JSONWriter::Bool(bool b) {
+    Separate();
+    m_out += b ? "true" : "false";
+}
+
+void JSONWriter::Null() {
+    Separate();
+    m_out += "null";
+}
+
+void JSONWriter::Raw(const std::string &json) {
+    Separate();
+    m_out += json;
+}
@@ -0,0 +1,106 @@
+// Copyright (c) 2019 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_UTIL_JSONWRITER_H
+#define BITCOIN_UTIL_JSONWRITER_H
+
+#include <cstdint>
+#include <string>
+
+/**
+ * Appends compact JSON to a string as it goes, without building a tree of
+ * values first. The output is the same as UniValue::write() without
+ * indentation would give for the same sequence of values, so the two can be
+ * used interchangeably.
+ *
+ * Commas are inserted by the writer; it is up to the caller to open and close
+ * the objects and arrays, and to give every value of an object a key.
+ */
+class JSONWriter {
+private:
+    std::string &m_out;
+    //! Whether the next value is the first of its object or array.
+    bool m_first = true;
+    //! Whether a key was just written, so that no comma is expected.
+    bool m_after_key = false;
+
+    void Separate() {
+        if (m_after_key) {
+            m_after_key = false;
+        } else if (!m_first) {
+            m_out += ',';
+        }
+        m_first = false;
+    }
+
+    void WriteEscaped(const char *str, size_t size);
+
+public:
+    explicit JSONWriter(std::string &out) : m_out(out) {}
+
+    void BeginObject() {
+        Separate();
+        m_out += '{';
+        m_first = true;
+    }
+    void EndObject() {
+        m_out += '}';
+        m_first = false;
+    }
+    void BeginArray() {
+        Separate();
+        m_out += '[';
+        m_first = true;
+    }
+    void EndArray() {
+        m_out += ']';
+        m_first = false;
+    }
+
+    void Key(const std::string &key);
+
+    void String(const std::string &str);
+    /** A string of the hex encoding of some bytes, as HexStr. */
+    void Hex(const uint8_t *begin, const uint8_t *end);
+    void Int(int64_t n);
+    void UInt(uint64_t n);
+    /** A floating point number, with the precision UniValue uses. */
+    void Real(double n);
+    void Bool(bool b);
+    void Null();
+    /** A value already encoded as JSON, such as a formatted number. */
+    void Raw(const std::string &json);
+
+    /** Add a key and its value to an object. */
+    void KV(const std::string &key, const std::string &value) {
+        Key(key);
+        String(value);
+    }
+    void KV(const std::string &key, const char *value) {
+        Key(key);
+        String(value);
+    }
+    void KV(const std::string &key, int value) {
+        Key(key);
+        Int(value);
+    }
+    void KV(const std::string &key, int64_t value) {
+        Key(key);
+        Int(value);
+    }
+    void KV(const std::string &key, uint64_t value) {
+        Key(key);
+        UInt(value);
+    }
+    void KV(const std::string &key, double value) {
+        Key(key);
+        Real(value);
+    }
+    void KV(const std::string &key, bool value) {
+        Key(key);
+        Bool(value);
+    }
+};
+
+#endif // BITCOIN_UTIL_JSONWRITER_H
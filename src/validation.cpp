@@ -30,6 +30,7 @@
 #include <primitives/transaction.h>
 #include <random.h>
 #include <reverse_iterator.h>
+#include <script/schnorrbatch.h>
 #include <script/script.h>
 #include <script/scriptcache.h>
 #include <script/sigcache.h>
@@ -125,6 +126,8 @@ private:
 public:
     CChain chainActive;
     BlockMap mapBlockIndex;
+    //! Holds the entries of mapBlockIndex loaded from disk.
+    BlockIndexArena m_block_index_arena;
     std::multimap<CBlockIndex *, CBlockIndex *> mapBlocksUnlinked;
     CBlockIndex *pindexBestInvalid = nullptr;
     CBlockIndex *pindexBestParked = nullptr;
@@ -211,6 +214,12 @@ private:
     /** Create a new block index entry for a given block hash */
     CBlockIndex *InsertBlockIndex(const uint256 &hash)
         EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+    /**
+     * Add a block index entry loaded from disk, or copy it into the existing
+     * entry for the same block hash. Returns the entry kept.
+     */
+    CBlockIndex *AddLoadedBlockIndex(const uint256 &hash, CBlockIndex *pindex)
+        EXCLUSIVE_LOCKS_REQUIRED(cs_main);
     /**
      * Make various assertions about the state of the block index.
      *
@@ -535,27 +544,36 @@ static bool CheckInputsFromMempoolAndCache(
                        txdata);
 }
 
-static bool AcceptToMemoryPoolWorker(
-    const Config &config, CTxMemPool &pool, CValidationState &state,
-    const CTransactionRef &ptx, bool fLimitFree, bool *pfMissingInputs,
-    int64_t nAcceptTime, bool fOverrideMempoolLimit, const Amount nAbsurdFee,
-    std::vector<COutPoint> &coins_to_uncache, bool test_accept)
+// Script flags transactions have to pass to be accepted to the mempool.
+static uint32_t GetMempoolScriptFlags(const Consensus::Params &params)
     EXCLUSIVE_LOCKS_REQUIRED(cs_main) {
-    AssertLockHeld(cs_main);
-
-    const Consensus::Params &consensusParams =
-        config.GetChainParams().GetConsensus();
+    // Set extraFlags as a set of flags that needs to be activated.
+    uint32_t extraFlags = SCRIPT_VERIFY_NONE;
+    if (IsReplayProtectionEnabledForCurrentBlock(params)) {
+        extraFlags |= SCRIPT_ENABLE_REPLAY_PROTECTION;
+    }
 
-    const CTransaction &tx = *ptx;
-    const TxId txid = tx.GetId();
+    if (IsMagneticAnomalyEnabledForCurrentBlock(params)) {
+        extraFlags |= SCRIPT_VERIFY_CHECKDATASIG_SIGOPS;
+    }
 
-    // mempool "read lock" (held through
-    // GetMainSignals().TransactionAddedToMempool())
-    LOCK(pool.cs);
-    if (pfMissingInputs) {
-        *pfMissingInputs = false;
+    if (IsGravitonEnabledForCurrentBlock(params)) {
+        extraFlags |= SCRIPT_ENABLE_SCHNORR_MULTISIG;
+        extraFlags |= SCRIPT_VERIFY_MINIMALDATA;
     }
 
+    // Make sure whatever we need to activate is actually activated.
+    return STANDARD_SCRIPT_VERIFY_FLAGS | extraFlags;
+}
+
+/**
+ * The checks AcceptToMemoryPoolWorker runs on a transaction before looking up
+ * its inputs: context-free validity, standardness and finality.
+ */
+static bool PreCheckTransaction(const Consensus::Params &consensusParams,
+                                const CTransaction &tx,
+                                CValidationState &state)
+    EXCLUSIVE_LOCKS_REQUIRED(cs_main) {
     // Coinbase is only valid in a block, not as a loose transaction.
     if (!CheckRegularTransaction(tx, state)) {
         // state filled in by CheckRegularTransaction.
@@ -581,6 +599,101 @@ static bool AcceptToMemoryPoolWorker(
             ctxState.CorruptionPossible(), ctxState.GetDebugMessage());
     }
 
+    return true;
+}
+
+/**
+ * The checks AcceptToMemoryPoolWorker runs on the inputs of a transaction
+ * before its scripts: sequence locks, amounts, standardness of the spent
+ * outputs, sigops and the mempool minimum fee. view must have all the inputs
+ * of tx cached.
+ */
+static bool PreCheckInputs(const CTxMemPool &pool, const CTransaction &tx,
+                           CValidationState &state, const CCoinsViewCache &view,
+                           LockPoints &lp, Amount &nFees,
+                           Amount &nModifiedFees, int64_t &nSigOpsCount)
+    EXCLUSIVE_LOCKS_REQUIRED(cs_main, pool.cs) {
+    // Only accept BIP68 sequence locked transactions that can be mined in
+    // the next block; we don't want our mempool filled up with transactions
+    // that can't be mined yet. Must keep pool.cs for this unless we change
+    // CheckSequenceLocks to take a CoinsViewCache instead of create its
+    // own.
+    if (!CheckSequenceLocks(pool, tx, STANDARD_LOCKTIME_VERIFY_FLAGS, &lp)) {
+        return state.DoS(0, false, REJECT_NONSTANDARD, "non-BIP68-final");
+    }
+
+    nFees = Amount::zero();
+    if (!Consensus::CheckTxInputs(tx, state, view, GetSpendHeight(view),
+                                  nFees)) {
+        return error("%s: Consensus::CheckTxInputs: %s, %s", __func__,
+                     tx.GetId().ToString(), FormatStateMessage(state));
+    }
+
+    // Check for non-standard pay-to-script-hash in inputs
+    if (fRequireStandard && !AreInputsStandard(tx, view)) {
+        return state.Invalid(false, REJECT_NONSTANDARD,
+                             "bad-txns-nonstandard-inputs");
+    }
+
+    nSigOpsCount =
+        GetTransactionSigOpCount(tx, view, STANDARD_SCRIPT_VERIFY_FLAGS);
+
+    // Check that the transaction doesn't have an excessive number of
+    // sigops, making it impossible to mine. Since the coinbase transaction
+    // itself can contain sigops MAX_STANDARD_TX_SIGOPS is less than
+    // MAX_BLOCK_SIGOPS_PER_MB; we still consider this an invalid rather
+    // than merely non-standard transaction.
+    if (nSigOpsCount > MAX_STANDARD_TX_SIGOPS) {
+        return state.DoS(0, false, REJECT_NONSTANDARD,
+                         "bad-txns-too-many-sigops", false,
+                         strprintf("%d", nSigOpsCount));
+    }
+
+    // nModifiedFees includes any fee deltas from PrioritiseTransaction
+    nModifiedFees = nFees;
+    double nPriorityDummy = 0;
+    pool.ApplyDeltas(tx.GetId(), nPriorityDummy, nModifiedFees);
+
+    Amount mempoolRejectFee =
+        pool.GetMinFee(gArgs.GetArg("-maxmempool", DEFAULT_MAX_MEMPOOL_SIZE) *
+                       1000000)
+            .GetFee(tx.GetTotalSize());
+    if (mempoolRejectFee > Amount::zero() &&
+        nModifiedFees < mempoolRejectFee) {
+        return state.DoS(
+            0, false, REJECT_INSUFFICIENTFEE, "mempool min fee not met", false,
+            strprintf("%d < %d", nModifiedFees, mempoolRejectFee));
+    }
+
+    return true;
+}
+
+static bool AcceptToMemoryPoolWorker(
+    const Config &config, CTxMemPool &pool, CValidationState &state,
+    const CTransactionRef &ptx, bool fLimitFree, bool *pfMissingInputs,
+    int64_t nAcceptTime, bool fOverrideMempoolLimit, const Amount nAbsurdFee,
+    std::vector<COutPoint> &coins_to_uncache, bool test_accept)
+    EXCLUSIVE_LOCKS_REQUIRED(cs_main) {
+    AssertLockHeld(cs_main);
+
+    const Consensus::Params &consensusParams =
+        config.GetChainParams().GetConsensus();
+
+    const CTransaction &tx = *ptx;
+    const TxId txid = tx.GetId();
+
+    // mempool "read lock" (held through
+    // GetMainSignals().TransactionAddedToMempool())
+    LOCK(pool.cs);
+    if (pfMissingInputs) {
+        *pfMissingInputs = false;
+    }
+
+    if (!PreCheckTransaction(consensusParams, tx, state)) {
+        // state filled in by PreCheckTransaction.
+        return false;
+    }
+
     // Is it already in the memory pool?
     if (pool.exists(txid)) {
         return state.Invalid(false, REJECT_DUPLICATE, "txn-already-in-mempool");
@@ -646,37 +759,14 @@ static bool AcceptToMemoryPoolWorker(
         // need to keep lock on mempool.
         view.SetBackend(dummy);
 
-        // Only accept BIP68 sequence locked transactions that can be mined in
-        // the next block; we don't want our mempool filled up with transactions
-        // that can't be mined yet. Must keep pool.cs for this unless we change
-        // CheckSequenceLocks to take a CoinsViewCache instead of create its
-        // own.
-        if (!CheckSequenceLocks(pool, tx, STANDARD_LOCKTIME_VERIFY_FLAGS,
-                                &lp)) {
-            return state.DoS(0, false, REJECT_NONSTANDARD, "non-BIP68-final");
-        }
-
-        Amount nFees = Amount::zero();
-        if (!Consensus::CheckTxInputs(tx, state, view, GetSpendHeight(view),
-                                      nFees)) {
-            return error("%s: Consensus::CheckTxInputs: %s, %s", __func__,
-                         tx.GetId().ToString(), FormatStateMessage(state));
-        }
-
-        // Check for non-standard pay-to-script-hash in inputs
-        if (fRequireStandard && !AreInputsStandard(tx, view)) {
-            return state.Invalid(false, REJECT_NONSTANDARD,
-                                 "bad-txns-nonstandard-inputs");
+        Amount nFees, nModifiedFees;
+        int64_t nSigOpsCount;
+        if (!PreCheckInputs(pool, tx, state, view, lp, nFees, nModifiedFees,
+                            nSigOpsCount)) {
+            // state filled in by PreCheckInputs.
+            return false;
         }
 
-        int64_t nSigOpsCount =
-            GetTransactionSigOpCount(tx, view, STANDARD_SCRIPT_VERIFY_FLAGS);
-
-        // nModifiedFees includes any fee deltas from PrioritiseTransaction
-        Amount nModifiedFees = nFees;
-        double nPriorityDummy = 0;
-        pool.ApplyDeltas(txid, nPriorityDummy, nModifiedFees);
-
         Amount inChainInputValue;
         double dPriority =
             view.GetPriority(tx, chainActive.Height(), inChainInputValue);
@@ -697,29 +787,6 @@ static bool AcceptToMemoryPoolWorker(
                               fSpendsCoinbase, nSigOpsCount, lp);
         unsigned int nSize = entry.GetTxSize();
 
-        // Check that the transaction doesn't have an excessive number of
-        // sigops, making it impossible to mine. Since the coinbase transaction
-        // itself can contain sigops MAX_STANDARD_TX_SIGOPS is less than
-        // MAX_BLOCK_SIGOPS_PER_MB; we still consider this an invalid rather
-        // than merely non-standard transaction.
-        if (nSigOpsCount > MAX_STANDARD_TX_SIGOPS) {
-            return state.DoS(0, false, REJECT_NONSTANDARD,
-                             "bad-txns-too-many-sigops", false,
-                             strprintf("%d", nSigOpsCount));
-        }
-
-        Amount mempoolRejectFee =
-            pool.GetMinFee(
-                    gArgs.GetArg("-maxmempool", DEFAULT_MAX_MEMPOOL_SIZE) *
-                    1000000)
-                .GetFee(nSize);
-        if (mempoolRejectFee > Amount::zero() &&
-            nModifiedFees < mempoolRejectFee) {
-            return state.DoS(
-                0, false, REJECT_INSUFFICIENTFEE, "mempool min fee not met",
-                false, strprintf("%d < %d", nModifiedFees, mempoolRejectFee));
-        }
-
         if (gArgs.GetBoolArg("-relaypriority", DEFAULT_RELAYPRIORITY) &&
             nModifiedFees < minRelayTxFee.GetFee(nSize) &&
             !AllowFree(entry.GetPriority(chainActive.Height() + 1))) {
@@ -787,27 +854,13 @@ static bool AcceptToMemoryPoolWorker(
                              "too-long-mempool-chain", false, errString);
         }
 
-        // Set extraFlags as a set of flags that needs to be activated.
-        uint32_t extraFlags = SCRIPT_VERIFY_NONE;
-        if (IsReplayProtectionEnabledForCurrentBlock(consensusParams)) {
-            extraFlags |= SCRIPT_ENABLE_REPLAY_PROTECTION;
-        }
-
-        if (IsMagneticAnomalyEnabledForCurrentBlock(consensusParams)) {
-            extraFlags |= SCRIPT_VERIFY_CHECKDATASIG_SIGOPS;
-        }
-
-        if (IsGravitonEnabledForCurrentBlock(consensusParams)) {
-            extraFlags |= SCRIPT_ENABLE_SCHNORR_MULTISIG;
-            extraFlags |= SCRIPT_VERIFY_MINIMALDATA;
-        }
-
-        // Make sure whatever we need to activate is actually activated.
         const uint32_t scriptVerifyFlags =
-            STANDARD_SCRIPT_VERIFY_FLAGS | extraFlags;
+            GetMempoolScriptFlags(consensusParams);
 
         // Check against previous transactions. This is done last to help
-        // prevent CPU exhaustion denial-of-service attacks.
+        // prevent CPU exhaustion denial-of-service attacks. When the
+        // transaction went through PreValidateTransaction, this only hits the
+        // script execution cache.
         PrecomputedTransactionData txdata(tx);
         if (!CheckInputs(tx, state, view, true, scriptVerifyFlags, true, false,
                          txdata)) {
@@ -1033,6 +1086,86 @@ bool ReadBlockFromDisk(CBlock &block, const CBlockIndex *pindex,
     return true;
 }
 
+bool ReadRawBlockFromDisk(std::vector<uint8_t> &block, const FlatFilePos &pos,
+                          const CMessageHeader::MessageMagic &messageStart) {
+    block.clear();
+
+    // Open history file at the index header written by WriteBlockToDisk
+    FlatFilePos hpos = pos;
+    if (hpos.nPos < CMessageHeader::MESSAGE_START_SIZE + sizeof(uint32_t)) {
+        return error("ReadRawBlockFromDisk: Invalid position %s",
+                     pos.ToString());
+    }
+    hpos.nPos -= CMessageHeader::MESSAGE_START_SIZE + sizeof(uint32_t);
+
+    CAutoFile filein(OpenBlockFile(hpos, true), SER_DISK, CLIENT_VERSION);
+    if (filein.IsNull()) {
+        return error("ReadRawBlockFromDisk: OpenBlockFile failed for %s",
+                     pos.ToString());
+    }
+
+    try {
+        CMessageHeader::MessageMagic blkStart;
+        uint32_t blkSize;
+        filein >> blkStart >> blkSize;
+
+        if (blkStart != messageStart) {
+            return error("ReadRawBlockFromDisk: Block magic mismatch at %s",
+                         pos.ToString());
+        }
+
+        // Do not trust the size before allocating for it.
+        FILE *file = filein.Get();
+        const long nStart = ftell(file);
+        if (nStart < 0 || fseek(file, 0, SEEK_END) != 0) {
+            return error("ReadRawBlockFromDisk: Cannot seek in %s",
+                         pos.ToString());
+        }
+        const long nEnd = ftell(file);
+        if (nEnd < nStart || blkSize > uint64_t(nEnd - nStart) ||
+            fseek(file, nStart, SEEK_SET) != 0) {
+            return error("ReadRawBlockFromDisk: Invalid size %u at %s",
+                         blkSize, pos.ToString());
+        }
+
+        block.resize(blkSize);
+        filein.read((char *)block.data(), blkSize);
+    } catch (const std::exception &e) {
+        return error("%s: Read from block file failed: %s at %s", __func__,
+                     e.what(), pos.ToString());
+    }
+
+    return true;
+}
+
+bool ReadRawBlockFromDisk(std::vector<uint8_t> &block,
+                          const CBlockIndex *pindex,
+                          const CMessageHeader::MessageMagic &messageStart) {
+    FlatFilePos blockPos;
+    {
+        LOCK(cs_main);
+        blockPos = pindex->GetBlockPos();
+    }
+
+    if (!ReadRawBlockFromDisk(block, blockPos, messageStart)) {
+        return false;
+    }
+
+    // The block is not deserialized, so at least check it starts with the
+    // header of the requested block.
+    const size_t nHeaderSize =
+        ::GetSerializeSize(CBlockHeader(), SER_DISK, CLIENT_VERSION);
+    if (block.size() < nHeaderSize ||
+        Hash(block.begin(), block.begin() + nHeaderSize) !=
+            pindex->GetBlockHash()) {
+        return error("ReadRawBlockFromDisk(CBlockIndex*): Header doesn't "
+                     "match index for %s at %s",
+                     pindex->ToString(), blockPos.ToString());
+    }
+
+    return true;
+}
+
 Amount GetBlockSubsidy(int nHeight, const Consensus::Params &consensusParams) {
     int halvings = nHeight / consensusParams.nSubsidyHalvingInterval;
     // Force block reward to zero when right shift is undefined.
@@ -1248,10 +1381,22 @@ void UpdateCoins(CCoinsViewCache &view, const CTransaction &tx, int nHeight) {
 
 bool CScriptCheck::operator()() {
     const CScript &scriptSig = ptxTo->vin[nIn].scriptSig;
-    return VerifyScript(scriptSig, scriptPubKey, nFlags,
-                        CachingTransactionSignatureChecker(ptxTo, nIn, amount,
-                                                           cacheStore, txdata),
-                        &error);
+    if (!schnorrBatch || !(nFlags & SCRIPT_VERIFY_NULLFAIL)) {
+        return VerifyScript(scriptSig, scriptPubKey, nFlags,
+                            CachingTransactionSignatureChecker(
+                                ptxTo, nIn, amount, cacheStore, txdata),
+                            &error);
+    }
+
+    std::vector<DeferredSchnorrSig> deferred;
+    if (!VerifyScript(scriptSig, scriptPubKey, nFlags,
+                      BatchingTransactionSignatureChecker(
+                          ptxTo, nIn, amount, cacheStore, txdata, deferred),
+                      &error)) {
+        return false;
+    }
+
+    return deferred.empty() || schnorrBatch->Add(deferred);
 }
 
 int GetSpendHeight(const CCoinsViewCache &inputs) {
@@ -1265,7 +1410,8 @@ bool CheckInputs(const CTransaction &tx, CValidationState &state,
                  const uint32_t flags, bool sigCacheStore,
                  bool scriptCacheStore,
                  const PrecomputedTransactionData &txdata,
-                 std::vector<CScriptCheck> *pvChecks)
+                 std::vector<CScriptCheck> *pvChecks,
+                 SchnorrBatchVerifier *schnorrBatch)
     EXCLUSIVE_LOCKS_REQUIRED(cs_main) {
     assert(!tx.IsCoinBase());
 
@@ -1305,11 +1451,15 @@ bool CheckInputs(const CTransaction &tx, CValidationState &state,
         const Amount amount = coin.GetTxOut().nValue;
 
         // Verify signature
+        if (pvChecks) {
+            pvChecks->emplace_back(scriptPubKey, amount, tx, i, flags,
+                                   sigCacheStore, txdata, schnorrBatch);
+            continue;
+        }
+
         CScriptCheck check(scriptPubKey, amount, tx, i, flags, sigCacheStore,
                            txdata);
-        if (pvChecks) {
-            pvChecks->push_back(std::move(check));
-        } else if (!check()) {
+        if (!check()) {
             ScriptError scriptError = check.GetScriptError();
             // Compute flags without the optional standardness flags.
             // This differs from MANDATORY_SCRIPT_VERIFY_FLAGS as it contains
@@ -1401,8 +1551,15 @@ bool UndoWriteToDisk(const CBlockUndo &blockundo, FlatFilePos &pos,
     return true;
 }
 
-static bool UndoReadFromDisk(CBlockUndo &blockundo, const CBlockIndex *pindex) {
-    FlatFilePos pos = pindex->GetUndoPos();
+} // namespace
+
+bool UndoReadFromDisk(CBlockUndo &blockundo, const CBlockIndex *pindex) {
+    return UndoReadFromDisk(blockundo, pindex->GetUndoPos(),
+                            pindex->pprev->GetBlockHash());
+}
+
+bool UndoReadFromDisk(CBlockUndo &blockundo, const FlatFilePos &pos,
+                      const uint256 &hashPrevBlock) {
     if (pos.IsNull()) {
         return error("%s: no undo data available", __func__);
     }
@@ -1418,7 +1575,7 @@ static bool UndoReadFromDisk(CBlockUndo &blockundo, const CBlockIndex *pindex) {
     // We need a CHashVerifier as reserializing may lose data
     CHashVerifier<CAutoFile> verifier(&filein);
     try {
-        verifier << pindex->pprev->GetBlockHash();
+        verifier << hashPrevBlock;
         verifier >> blockundo;
         filein >> hashChecksum;
     } catch (const std::exception &e) {
@@ -1433,8 +1590,6 @@ static bool UndoReadFromDisk(CBlockUndo &blockundo, const CBlockIndex *pindex) {
     return true;
 }
 
-
-} // namespace
 /** Abort with a message */
 bool AbortNode(const std::string &strMessage,
                       const std::string &userMessage) {
@@ -1621,6 +1776,120 @@ void ThreadScriptCheck() {
     scriptcheckqueue.Thread();
 }
 
+bool PreValidateTransaction(const Config &config, const CTxMemPool &pool,
+                            const CTransactionRef &ptx) {
+    AssertLockNotHeld(cs_main);
+
+    const CTransaction &tx = *ptx;
+
+    // Only transactions passing the policy checks AcceptToMemoryPoolWorker
+    // runs before the scripts get their scripts verified here, so a peer
+    // cannot make us verify anything it could not get verified under cs_main.
+    // Anything failing them is left for AcceptToMemoryPool to reject.
+    // Coins pulled into pcoinsTip for the checks are uncached again so that
+    // the accounting of AcceptToMemoryPoolWorker's coins_to_uncache stays
+    // correct.
+    std::vector<CTxOut> spentOutputs;
+    spentOutputs.reserve(tx.vin.size());
+    uint32_t scriptVerifyFlags, nextBlockScriptVerifyFlags;
+    {
+        LOCK2(cs_main, pool.cs);
+
+        const Consensus::Params &consensusParams =
+            config.GetChainParams().GetConsensus();
+        CValidationState state;
+        if (!PreCheckTransaction(consensusParams, tx, state) ||
+            pool.exists(tx.GetId())) {
+            return false;
+        }
+
+        CCoinsView dummy;
+        CCoinsViewCache view(&dummy);
+        CCoinsViewMemPool viewMemPool(pcoinsTip.get(), pool);
+        view.SetBackend(viewMemPool);
+
+        std::vector<COutPoint> coins_to_uncache;
+        bool fHaveInputs = true;
+        for (const CTxIn &txin : tx.vin) {
+            if (pool.mapNextTx.count(txin.prevout)) {
+                fHaveInputs = false;
+                break;
+            }
+
+            if (!pcoinsTip->HaveCoinInCache(txin.prevout)) {
+                coins_to_uncache.push_back(txin.prevout);
+            }
+
+            if (!view.HaveCoin(txin.prevout)) {
+                fHaveInputs = false;
+                break;
+            }
+        }
+
+        bool fPassed = false;
+        if (fHaveInputs) {
+            view.GetBestBlock();
+            view.SetBackend(dummy);
+
+            LockPoints lp;
+            Amount nFees, nModifiedFees;
+            int64_t nSigOpsCount;
+            // Free and low fee transactions are rate limited or rejected by
+            // AcceptToMemoryPoolWorker, so they are not worth verifying early.
+            fPassed = PreCheckInputs(pool, tx, state, view, lp, nFees,
+                                     nModifiedFees, nSigOpsCount) &&
+                      nModifiedFees >= minRelayTxFee.GetFee(tx.GetTotalSize());
+        }
+
+        for (const COutPoint &outpoint : coins_to_uncache) {
+            pcoinsTip->Uncache(outpoint);
+        }
+
+        if (!fPassed) {
+            return false;
+        }
+
+        for (const CTxIn &txin : tx.vin) {
+            spentOutputs.push_back(view.AccessCoin(txin.prevout).GetTxOut());
+        }
+
+        scriptVerifyFlags = GetMempoolScriptFlags(consensusParams);
+        nextBlockScriptVerifyFlags =
+            GetNextBlockScriptFlags(consensusParams, chainActive.Tip());
+    }
+
+    // Run the scripts against both sets of flags AcceptToMemoryPoolWorker
+    // checks, spreading the inputs over the script check threads. Results are
+    // keyed on the transaction hash, which commits to the spent outputs, so
+    // they stay valid whatever happens to the chain in the meantime.
+    PrecomputedTransactionData txdata(tx);
+    for (const uint32_t flags :
+         {scriptVerifyFlags, nextBlockScriptVerifyFlags}) {
+        const uint256 hashCacheEntry = GetScriptCacheKey(tx, flags);
+        if (IsKeyInScriptCache(hashCacheEntry, false)) {
+            continue;
+        }
+
+        std::vector<CScriptCheck> vChecks;
+        vChecks.reserve(tx.vin.size());
+        for (size_t i = 0; i < tx.vin.size(); i++) {
+            vChecks.emplace_back(spentOutputs[i].scriptPubKey,
+                                 spentOutputs[i].nValue, tx, i, flags, true,
+                                 txdata);
+        }
+
+        CCheckQueueControl<CScriptCheck> control(&scriptcheckqueue);
+        control.Add(vChecks);
+        if (!control.Wait()) {
+            return false;
+        }
+
+        AddKeyInScriptCache(hashCacheEntry);
+    }
+
+    return true;
+}
+
 int32_t ComputeBlockVersion(const CBlockIndex *pindexPrev,
                             const Consensus::Params &params) {
     int32_t nVersion = VERSIONBITS_TOP_BITS;
@@ -1875,6 +2144,10 @@ bool CChainState::ConnectBlock(const CBlock &block, CValidationState &state,
 
     CBlockUndo blockundo;
 
+    // Schnorr signatures are deferred by the script checks and verified in
+    // batches. This must outlive control.
+    SchnorrBatchVerifier schnorrBatch;
+
     CCheckQueueControl<CScriptCheck> control(fScriptChecks ? &scriptcheckqueue
                                                            : nullptr);
 
@@ -1964,7 +2237,7 @@ bool CChainState::ConnectBlock(const CBlock &block, CValidationState &state,
         std::vector<CScriptCheck> vChecks;
         if (!CheckInputs(tx, state, view, fScriptChecks, flags, fCacheResults,
                          fCacheResults, PrecomputedTransactionData(tx),
-                         &vChecks)) {
+                         &vChecks, &schnorrBatch)) {
             return error("ConnectBlock(): CheckInputs on %s failed with %s",
                          tx.GetId().ToString(), FormatStateMessage(state));
         }
@@ -1995,7 +2268,7 @@ bool CChainState::ConnectBlock(const CBlock &block, CValidationState &state,
                          REJECT_INVALID, "bad-cb-amount");
     }
 
-    if (!control.Wait()) {
+    if (!control.Wait() || !schnorrBatch.Verify()) {
         return state.DoS(100, false, REJECT_INVALID, "blk-bad-inputs", false,
                          "parallel script check failed");
     }
@@ -4503,10 +4776,30 @@ CBlockIndex *CChainState::InsertBlockIndex(const uint256 &hash) {
     return pindexNew;
 }
 
+CBlockIndex *CChainState::AddLoadedBlockIndex(const uint256 &hash,
+                                              CBlockIndex *pindex) {
+    AssertLockHeld(cs_main);
+
+    auto inserted = mapBlockIndex.emplace(hash, pindex);
+    if (!inserted.second) {
+        // Fill in the existing entry, which may be pointed to already.
+        CBlockIndex *pindexExisting = inserted.first->second;
+        *pindexExisting = *pindex;
+        pindex = pindexExisting;
+    }
+    pindex->phashBlock = &inserted.first->first;
+
+    return pindex;
+}
+
 bool CChainState::LoadBlockIndex(const Config &config,
                                  CBlockTreeDB &blocktree) {
     if (!blocktree.LoadBlockIndexGuts(
-            config.GetChainParams().GetConsensus(),
+            config.GetChainParams().GetConsensus(), m_block_index_arena,
+            [this](const uint256 &hash, CBlockIndex *pindex)
+                EXCLUSIVE_LOCKS_REQUIRED(cs_main) {
+                    return this->AddLoadedBlockIndex(hash, pindex);
+                },
             [this](const uint256 &hash) EXCLUSIVE_LOCKS_REQUIRED(cs_main) {
                 return this->InsertBlockIndex(hash);
             })) {
@@ -4515,6 +4808,8 @@ bool CChainState::LoadBlockIndex(const Config &config,
 
     boost::this_thread::interruption_point();
 
+    int64_t nTimeStart = GetTimeMillis();
+
     // Calculate nChainWork
     std::vector<std::pair<int, CBlockIndex *>> vSortedByHeight;
     vSortedByHeight.reserve(mapBlockIndex.size());
@@ -4580,6 +4875,9 @@ bool CChainState::LoadBlockIndex(const Config &config,
         }
     }
 
+    LogPrintf("%s: computed the chain work of %u blocks in %dms\n", __func__,
+              vSortedByHeight.size(), GetTimeMillis() - nTimeStart);
+
     return true;
 }
 
@@ -5086,10 +5384,13 @@ void UnloadBlockIndex() {
     setDirtyFileInfo.clear();
 
     for (const BlockMap::value_type &entry : mapBlockIndex) {
-        delete entry.second;
+        if (!g_chainstate.m_block_index_arena.Owns(entry.second)) {
+            delete entry.second;
+        }
     }
 
     mapBlockIndex.clear();
+    g_chainstate.m_block_index_arena.Clear();
     fHavePruned = false;
 
     g_chainstate.UnloadBlockIndex();
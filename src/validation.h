@@ -35,6 +35,7 @@
 class arith_uint256;
 
 class CBlockIndex;
+class CBlockUndo;
 class CBlockTreeDB;
 class CChainParams;
 class CChain;
@@ -46,6 +47,7 @@ class CScriptCheck;
 class CTxMemPool;
 class CTxUndo;
 class CValidationState;
+class SchnorrBatchVerifier;
 
 struct FlatFilePos;
 struct ChainTxData;
@@ -482,6 +484,22 @@ bool AcceptToMemoryPool(const Config &config, CTxMemPool &pool,
                         bool test_accept = false)
     EXCLUSIVE_LOCKS_REQUIRED(cs_main);
 
+/**
+ * Lock-free first stage of mempool admission. Runs the policy checks that
+ * AcceptToMemoryPool does before the scripts and, if tx passes them and pays
+ * at least the minimum relay fee, verifies the scripts of tx against a
+ * snapshot of its spent coins on the script check threads, holding cs_main and
+ * pool.cs only while checking and taking the snapshot. On success, the script
+ * execution cache is primed so that the following AcceptToMemoryPool call,
+ * which re-checks that the inputs are still available, does not verify
+ * signatures under cs_main again.
+ * Returns false if the scripts were not verified, in which case
+ * AcceptToMemoryPool does the full work (and determines the reject reason).
+ */
+bool PreValidateTransaction(const Config &config, const CTxMemPool &pool,
+                            const CTransactionRef &tx)
+    LOCKS_EXCLUDED(cs_main);
+
 /** Convert CValidationState to a human-readable message for logging */
 std::string FormatStateMessage(const CValidationState &state);
 
@@ -491,7 +509,8 @@ std::string FormatStateMessage(const CValidationState &state);
  *
  * If pvChecks is not nullptr, script checks are pushed onto it instead of being
  * performed inline. Any script checks which are not necessary (eg due to script
- * execution cache hits) are, obviously, not pushed onto pvChecks/run.
+ * execution cache hits) are, obviously, not pushed onto pvChecks/run. The
+ * pushed checks defer their Schnorr signatures to schnorrBatch, if set.
  *
  * Setting sigCacheStore/scriptCacheStore to false will remove elements from the
  * corresponding cache which are matched. This is useful for checking blocks
@@ -502,7 +521,8 @@ bool CheckInputs(const CTransaction &tx, CValidationState &state,
                  const uint32_t flags, bool sigCacheStore,
                  bool scriptCacheStore,
                  const PrecomputedTransactionData &txdata,
-                 std::vector<CScriptCheck> *pvChecks = nullptr);
+                 std::vector<CScriptCheck> *pvChecks = nullptr,
+                 SchnorrBatchVerifier *schnorrBatch = nullptr);
 
 /**
  * Mark all the coins corresponding to a given transaction inputs as spent.
@@ -554,19 +574,22 @@ private:
     bool cacheStore;
     ScriptError error;
     PrecomputedTransactionData txdata;
+    SchnorrBatchVerifier *schnorrBatch;
 
 public:
     CScriptCheck()
         : amount(), ptxTo(nullptr), nIn(0), nFlags(0), cacheStore(false),
-          error(ScriptError::UNKNOWN), txdata() {}
+          error(ScriptError::UNKNOWN), txdata(), schnorrBatch(nullptr) {}
 
     CScriptCheck(const CScript &scriptPubKeyIn, const Amount amountIn,
                  const CTransaction &txToIn, unsigned int nInIn,
                  uint32_t nFlagsIn, bool cacheIn,
-                 const PrecomputedTransactionData &txdataIn)
+                 const PrecomputedTransactionData &txdataIn,
+                 SchnorrBatchVerifier *schnorrBatchIn = nullptr)
         : scriptPubKey(scriptPubKeyIn), amount(amountIn), ptxTo(&txToIn),
           nIn(nInIn), nFlags(nFlagsIn), cacheStore(cacheIn),
-          error(ScriptError::UNKNOWN), txdata(txdataIn) {}
+          error(ScriptError::UNKNOWN), txdata(txdataIn),
+          schnorrBatch(schnorrBatchIn) {}
 
     bool operator()();
 
@@ -579,6 +602,7 @@ public:
         std::swap(cacheStore, check.cacheStore);
         std::swap(error, check.error);
         std::swap(txdata, check.txdata);
+        std::swap(schnorrBatch, check.schnorrBatch);
     }
 
     ScriptError GetScriptError() const { return error; }
@@ -589,6 +613,20 @@ bool ReadBlockFromDisk(CBlock &block, const FlatFilePos &pos,
                        const Consensus::Params &params);
 bool ReadBlockFromDisk(CBlock &block, const CBlockIndex *pindex,
                        const Consensus::Params &params);
+/**
+ * Read the serialized block as it is on disk, which is also its network
+ * serialization, to serve it without deserializing it. The index header in
+ * front of the block is checked against messageStart, and the block header
+ * against the block index.
+ */
+bool ReadRawBlockFromDisk(std::vector<uint8_t> &block, const FlatFilePos &pos,
+                          const CMessageHeader::MessageMagic &messageStart);
+bool ReadRawBlockFromDisk(std::vector<uint8_t> &block,
+                          const CBlockIndex *pindex,
+                          const CMessageHeader::MessageMagic &messageStart);
+bool UndoReadFromDisk(CBlockUndo &blockundo, const FlatFilePos &pos,
+                      const uint256 &hashPrevBlock);
+bool UndoReadFromDisk(CBlockUndo &blockundo, const CBlockIndex *pindex);
 
 /** Functions for validating blocks and updating the block tree */
 
@@ -11,6 +11,7 @@
 #include <util/moneystr.h>
 #include <util/system.h>
 #include <validation.h>
+#include <wallet/rescan.h>
 #include <wallet/rpcdump.h>
 #include <wallet/rpcwallet.h>
 #include <wallet/wallet.h>
@@ -101,6 +102,14 @@ void WalletInit::AddWalletOptions() const {
         "-rescan",
         _("Rescan the block chain for missing wallet transactions on startup"),
         false, OptionsCategory::WALLET);
+    gArgs.AddArg(
+        "-rescanthreads=<n>",
+        strprintf(_("Number of threads matching blocks against block filters "
+                    "of the wallet scripts during rescans, so that only "
+                    "matching blocks are scanned (0 to scan every block, up "
+                    "to %d, default: %d)"),
+                  MAX_RESCAN_THREADS, DEFAULT_RESCAN_THREADS),
+        false, OptionsCategory::WALLET);
     gArgs.AddArg(
         "-salvagewallet",
         _("Attempt to recover private keys from a corrupt wallet on startup"),
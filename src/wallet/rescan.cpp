@@ -0,0 +1,144 @@
+// Copyright (c) 2019 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <wallet/rescan.h>
+
+#include <chain.h>
+#include <primitives/block.h>
+#include <sync.h>
+#include <undo.h>
+#include <validation.h>
+#include <wallet/wallet.h>
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+WalletRescanFilter::WalletRescanFilter(const CWallet &walletIn,
+                                       const Consensus::Params &paramsIn,
+                                       int nThreadsIn)
+    : wallet(walletIn), params(paramsIn), nThreads(std::max(nThreadsIn, 1)) {
+    UpdateElements();
+}
+
+bool WalletRescanFilter::UpdateElements() {
+    const std::vector<CScript> scripts = wallet.GetScriptPubKeys();
+    const size_t nElements = elements.size();
+    for (const CScript &script : scripts) {
+        elements.emplace(script.begin(), script.end());
+    }
+    return elements.size() != nElements;
+}
+
+WalletRescanFilter::Entry::Entry(const CBlockIndex *pindexIn)
+    : pindex(pindexIn), hash(pindexIn->GetBlockHash()),
+      blockPos(pindexIn->GetBlockPos()) {
+    // Without a previous block there is no undo data.
+    if (pindexIn->pprev) {
+        hashPrev = pindexIn->pprev->GetBlockHash();
+        undoPos = pindexIn->GetUndoPos();
+    }
+}
+
+void WalletRescanFilter::Match(Entry &entry) const {
+    auto block = std::make_shared<CBlock>();
+    if (!ReadBlockFromDisk(*block, entry.blockPos, params) ||
+        block->GetHash() != entry.hash) {
+        return;
+    }
+    entry.fRead = true;
+
+    // Without undo data, e.g. for the genesis block, the block has to be
+    // scanned.
+    CBlockUndo blockundo;
+    if (!entry.undoPos.IsNull() &&
+        UndoReadFromDisk(blockundo, entry.undoPos, entry.hashPrev)) {
+        entry.filter = BlockFilter(BlockFilterType::BASIC, *block, blockundo);
+        entry.fMatch = entry.filter.GetFilter().MatchAny(elements);
+    }
+
+    if (entry.fMatch) {
+        entry.block = std::move(block);
+    }
+}
+
+void WalletRescanFilter::ReadAhead(const CBlockIndex *pindex,
+                                   const CBlockIndex *pindexStop) {
+    entries.clear();
+    nextEntry = 0;
+
+    // The workers only get to see what the entries copied from the block
+    // index under cs_main.
+    const size_t nMaxEntries = nThreads * RESCAN_BLOCKS_PER_THREAD;
+    {
+        LOCK(cs_main);
+        while (pindex && entries.size() < nMaxEntries) {
+            entries.emplace_back(pindex);
+            if (pindex == pindexStop) {
+                break;
+            }
+            pindex = chainActive.Next(pindex);
+        }
+    }
+
+    std::atomic<size_t> next{0};
+    auto worker = [this, &next]() {
+        for (size_t i = next++; i < entries.size(); i = next++) {
+            Match(entries[i]);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (int i = 1; i < nThreads; i++) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+}
+
+bool WalletRescanFilter::ReadBlock(const CBlockIndex *pindex,
+                                   const CBlockIndex *pindexStop,
+                                   std::shared_ptr<const CBlock> &block) {
+    block.reset();
+
+    // Processing the previous block may have topped up the keypool, in which
+    // case the blocks read ahead of it are matched against the new keys too.
+    const bool fNewElements = fLastMatch && UpdateElements();
+    if (nextEntry == entries.size() || entries[nextEntry].pindex != pindex) {
+        ReadAhead(pindex, pindexStop);
+    } else if (fNewElements) {
+        for (size_t i = nextEntry; i < entries.size(); i++) {
+            Entry &entry = entries[i];
+            if (entry.fRead && !entry.fMatch) {
+                entry.fMatch = entry.filter.GetFilter().MatchAny(elements);
+            }
+        }
+    }
+
+    Entry &entry = entries[nextEntry++];
+    nBlocks++;
+    fLastMatch = false;
+    if (!entry.fRead) {
+        return false;
+    }
+
+    if (entry.fMatch) {
+        if (!entry.block) {
+            // Only matched after the wallet gained scripts, read it again.
+            auto pblock = std::make_shared<CBlock>();
+            if (!ReadBlockFromDisk(*pblock, entry.blockPos, params)) {
+                return false;
+            }
+            entry.block = std::move(pblock);
+        }
+
+        block = std::move(entry.block);
+        fLastMatch = true;
+        nMatches++;
+    }
+
+    return true;
+}
@@ -0,0 +1,97 @@
+// Copyright (c) 2019 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_WALLET_RESCAN_H
+#define BITCOIN_WALLET_RESCAN_H
+
+#include <blockfilter.h>
+#include <flatfile.h>
+#include <uint256.h>
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+class CBlock;
+class CBlockIndex;
+class CWallet;
+
+namespace Consensus {
+struct Params;
+}
+
+//! Default for -rescanthreads, 0 scans every transaction of every block
+static const int DEFAULT_RESCAN_THREADS = 0;
+//! Maximum number of threads matching blocks during a rescan
+static const int MAX_RESCAN_THREADS = 16;
+//! Number of blocks each thread reads ahead of the rescan
+static const unsigned int RESCAN_BLOCKS_PER_THREAD = 16;
+
+/**
+ * Reads the blocks of a wallet rescan ahead on worker threads and matches
+ * their BIP 158 basic filter against the scripts of the wallet, so that the
+ * rescan only has to look at the transactions of the blocks which may involve
+ * the wallet. Filters are computed on the fly from the block and its undo
+ * data, blocks without undo data are always considered.
+ *
+ * Only payments to and spends from CWallet::GetScriptPubKeys() are detected:
+ * a transaction which conflicts with a wallet transaction through an input
+ * that isn't the wallet's is not seen, and neither are outputs to scripts the
+ * wallet only recognizes as bare multisig.
+ */
+class WalletRescanFilter {
+public:
+    WalletRescanFilter(const CWallet &walletIn,
+                       const Consensus::Params &paramsIn, int nThreadsIn);
+
+    /**
+     * Read the block at pindex, which has to follow the previous block read in
+     * the active chain when there is one, and blocks ahead of it up to
+     * pindexStop. block is set if the block may involve the wallet and left
+     * null otherwise. Returns false if the block could not be read.
+     */
+    bool ReadBlock(const CBlockIndex *pindex, const CBlockIndex *pindexStop,
+                   std::shared_ptr<const CBlock> &block);
+
+    //! Number of blocks read and number of them which matched the filters.
+    uint64_t GetBlockCount() const { return nBlocks; }
+    uint64_t GetMatchCount() const { return nMatches; }
+
+private:
+    struct Entry {
+        const CBlockIndex *pindex;
+        //! Copied from pindex under cs_main for the worker threads.
+        uint256 hash;
+        uint256 hashPrev;
+        FlatFilePos blockPos;
+        FlatFilePos undoPos;
+
+        bool fRead = false;
+        bool fMatch = true;
+        BlockFilter filter;
+        std::shared_ptr<const CBlock> block;
+
+        explicit Entry(const CBlockIndex *pindexIn);
+    };
+
+    const CWallet &wallet;
+    const Consensus::Params &params;
+    const int nThreads;
+
+    GCSFilter::ElementSet elements;
+    std::vector<Entry> entries;
+    size_t nextEntry = 0;
+    bool fLastMatch = false;
+
+    uint64_t nBlocks = 0;
+    uint64_t nMatches = 0;
+
+    //! Read and match the blocks from pindex on, in parallel.
+    void ReadAhead(const CBlockIndex *pindex, const CBlockIndex *pindexStop);
+    void Match(Entry &entry) const;
+    //! Returns whether the wallet gained scripts since the last update.
+    bool UpdateElements();
+};
+
+#endif // BITCOIN_WALLET_RESCAN_H
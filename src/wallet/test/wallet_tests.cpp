@@ -19,8 +19,11 @@
 
 #include <univalue.h>
 
+#include <algorithm>
 #include <cstdint>
+#include <map>
 #include <set>
+#include <string>
 #include <utility>
 #include <vector>
 
@@ -118,6 +121,76 @@ BOOST_FIXTURE_TEST_CASE(rescan, TestChain100Setup) {
     }
 }
 
+BOOST_FIXTURE_TEST_CASE(rescan_filtered, TestChain100Setup) {
+    // Spend the first coinbase to a new key, then mine blocks paying to
+    // another key.
+    CKey key;
+    key.MakeNewKey(true);
+    const CScript coinbaseScript =
+        GetScriptForRawPubKey(coinbaseKey.GetPubKey());
+    CMutableTransaction spend;
+    spend.vin.resize(1);
+    spend.vin[0].prevout = COutPoint(m_coinbase_txns[0]->GetId(), 0);
+    spend.vout.resize(1);
+    spend.vout[0].nValue = 11 * CENT;
+    spend.vout[0].scriptPubKey =
+        GetScriptForDestination(key.GetPubKey().GetID());
+    std::vector<uint8_t> vchSig;
+    uint256 hash = SignatureHash(coinbaseScript, CTransaction(spend), 0,
+                                 SigHashType().withForkId(),
+                                 m_coinbase_txns[0]->vout[0].nValue);
+    BOOST_CHECK(coinbaseKey.SignECDSA(hash, vchSig));
+    vchSig.push_back(uint8_t(SIGHASH_ALL | SIGHASH_FORKID));
+    spend.vin[0].scriptSig << vchSig;
+    CreateAndProcessBlock({spend}, coinbaseScript);
+
+    CKey otherKey;
+    otherKey.MakeNewKey(true);
+    for (int i = 0; i < 10; i++) {
+        CreateAndProcessBlock({}, GetScriptForRawPubKey(otherKey.GetPubKey()));
+    }
+
+    // Scanning with and without block filters finds the same transactions.
+    std::map<CKeyID, std::set<TxId>> found;
+    for (const char *threads : {"0", "3"}) {
+        gArgs.ForceSetArg("-rescanthreads", threads);
+        for (const CKey &walletKey : {coinbaseKey, key, otherKey}) {
+            CWallet wallet(Params(), "dummy", WalletDatabase::CreateDummy());
+            AddKey(wallet, walletKey);
+            WalletRescanReserver reserver(&wallet);
+            reserver.reserve();
+            CBlockIndex *const nullBlock = nullptr;
+            BOOST_CHECK_EQUAL(nullBlock,
+                              wallet.ScanForWalletTransactions(
+                                  chainActive.Genesis(), nullptr, reserver));
+
+            std::set<TxId> txids;
+            {
+                LOCK(wallet.cs_wallet);
+                for (const auto &entry : wallet.mapWallet) {
+                    txids.insert(entry.first);
+                }
+            }
+
+            const CKeyID keyid = walletKey.GetPubKey().GetID();
+            if (std::string(threads) == "0") {
+                found[keyid] = txids;
+            } else {
+                BOOST_CHECK(found[keyid] == txids);
+            }
+        }
+    }
+    gArgs.ForceSetArg("-rescanthreads", "0");
+
+    // The coinbase key wallet sees the spend through its input, the wallet
+    // of the new key through its output.
+    BOOST_CHECK_EQUAL(found[coinbaseKey.GetPubKey().GetID()].size(), 102U);
+    BOOST_CHECK(found[coinbaseKey.GetPubKey().GetID()].count(spend.GetId()));
+    BOOST_CHECK(found[key.GetPubKey().GetID()] ==
+                std::set<TxId>{spend.GetId()});
+    BOOST_CHECK_EQUAL(found[otherKey.GetPubKey().GetID()].size(), 10U);
+}
+
 // Verify importwallet RPC starts rescan at earliest block with timestamp
 // greater or equal than key birthday. Previously there was a bug where
 // importwallet RPC would start the scan at the latest block with timestamp less
@@ -397,4 +470,66 @@ BOOST_FIXTURE_TEST_CASE(ListCoins, ListCoinsTestingSetup) {
     BOOST_CHECK_EQUAL(list.begin()->second.size(), 2U);
 }
 
+BOOST_FIXTURE_TEST_CASE(unspent_index, ListCoinsTestingSetup) {
+    const CTxDestination coinbaseDest = coinbaseKey.GetPubKey().GetID();
+
+    // All the 101 coinbase outputs are unspent, only one of them is mature.
+    {
+        LOCK2(cs_main, wallet->cs_wallet);
+        BOOST_CHECK_EQUAL(wallet->GetUnspentOutPoints(coinbaseDest).size(),
+                          101U);
+        std::vector<COutput> available;
+        wallet->AvailableCoins(available);
+        BOOST_CHECK_EQUAL(available.size(), 1U);
+    }
+    BOOST_CHECK_EQUAL(wallet->GetBalance(), 50 * COIN);
+
+    // Spend the mature coinbase. Its output leaves the index, the change
+    // output and the coinbase of the new block enter it.
+    const CScript recipient = GetScriptForRawPubKey({});
+    const CWalletTx &wtx =
+        AddTx(CRecipient{recipient, 1 * COIN, false /* subtract fee */});
+    const TxId txid = wtx.GetId();
+    const COutPoint spent = wtx.tx->vin[0].prevout;
+    std::vector<COutPoint> coinbaseOutPoints;
+    std::vector<COutPoint> changeOutPoints;
+    {
+        LOCK2(cs_main, wallet->cs_wallet);
+        coinbaseOutPoints = wallet->GetUnspentOutPoints(coinbaseDest);
+        BOOST_CHECK_EQUAL(coinbaseOutPoints.size(), 101U);
+        BOOST_CHECK(std::find(coinbaseOutPoints.begin(),
+                              coinbaseOutPoints.end(),
+                              spent) == coinbaseOutPoints.end());
+
+        BOOST_CHECK_EQUAL(wtx.tx->vout.size(), 2U);
+        const uint32_t nChange = wtx.tx->vout[0].scriptPubKey == recipient;
+        CTxDestination changeDest;
+        BOOST_CHECK(ExtractDestination(wtx.tx->vout[nChange].scriptPubKey,
+                                       changeDest));
+        changeOutPoints = wallet->GetUnspentOutPoints(changeDest);
+        BOOST_CHECK(changeOutPoints == std::vector<COutPoint>{
+                                           COutPoint(txid, nChange)});
+
+        // The recipient output is not ours.
+        CTxDestination recipientDest;
+        if (ExtractDestination(recipient, recipientDest)) {
+            BOOST_CHECK(wallet->GetUnspentOutPoints(recipientDest).empty());
+        }
+
+        std::vector<COutput> available;
+        wallet->AvailableCoins(available);
+        BOOST_CHECK_EQUAL(available.size(), 2U);
+        for (const COutput &out : available) {
+            BOOST_CHECK(COutPoint(out.tx->GetId(), out.i) != spent);
+        }
+
+        // Rebuilding the index from scratch gives the same result.
+        wallet->MarkDirty();
+        BOOST_CHECK(wallet->GetUnspentOutPoints(coinbaseDest) ==
+                    coinbaseOutPoints);
+        BOOST_CHECK(wallet->GetUnspentOutPoints(changeDest) ==
+                    changeOutPoints);
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -33,6 +33,7 @@
 #include <wallet/coinselection.h>
 #include <wallet/fees.h>
 #include <wallet/finaltx.h>
+#include <wallet/rescan.h>
 #include <wallet/walletutil.h>
 
 #include <boost/algorithm/string/replace.hpp>
@@ -684,6 +685,11 @@ void CWallet::AddToSpends(const COutPoint &outpoint, const TxId &wtxid) {
     std::pair<TxSpends::iterator, TxSpends::iterator> range;
     range = mapTxSpends.equal_range(outpoint);
     SyncMetaData(range);
+
+    AssertLockHeld(cs_wallet);
+    if (IsSpentByActiveTx(outpoint)) {
+        RemoveFromUnspent(outpoint);
+    }
 }
 
 void CWallet::AddToSpends(const TxId &wtxid) {
@@ -700,6 +706,101 @@ void CWallet::AddToSpends(const TxId &wtxid) {
     }
 }
 
+/**
+ * Outpoint is spent by an active transaction if a wallet transaction that is
+ * neither abandoned nor marked conflicted spends it. Such an outpoint is spent
+ * whatever the state of the chain.
+ */
+bool CWallet::IsSpentByActiveTx(const COutPoint &outpoint) const {
+    std::pair<TxSpends::const_iterator, TxSpends::const_iterator> range =
+        mapTxSpends.equal_range(outpoint);
+
+    for (TxSpends::const_iterator it = range.first; it != range.second; ++it) {
+        std::map<TxId, CWalletTx>::const_iterator mit =
+            mapWallet.find(it->second);
+        if (mit == mapWallet.end()) {
+            continue;
+        }
+
+        const CWalletTx &wtx = mit->second;
+        if (!wtx.isAbandoned() && (wtx.nIndex != -1 || wtx.hashUnset())) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * Update the unspent index entries of all the outputs of wtx, which must be in
+ * mapWallet.
+ */
+void CWallet::AddToUnspent(const CWalletTx &wtx) {
+    AssertLockHeld(cs_wallet);
+
+    const TxId &txid = wtx.GetId();
+    for (uint32_t i = 0; i < wtx.tx->vout.size(); i++) {
+        const CTxOut &txout = wtx.tx->vout[i];
+        const COutPoint outpoint(txid, i);
+        if (IsMine(txout) == ISMINE_NO || IsSpentByActiveTx(outpoint)) {
+            RemoveFromUnspent(outpoint);
+            continue;
+        }
+
+        if (!mapUnspent.emplace(outpoint, &wtx).second) {
+            continue;
+        }
+
+        CTxDestination dest;
+        if (ExtractDestination(txout.scriptPubKey, dest)) {
+            setUnspentByDest.emplace(dest, outpoint);
+        }
+    }
+}
+
+void CWallet::RemoveFromUnspent(const COutPoint &outpoint) {
+    AssertLockHeld(cs_wallet);
+
+    auto it = mapUnspent.find(outpoint);
+    if (it == mapUnspent.end()) {
+        return;
+    }
+
+    CTxDestination dest;
+    if (ExtractDestination(it->second->tx->vout[outpoint.GetN()].scriptPubKey,
+                           dest)) {
+        setUnspentByDest.erase(std::make_pair(dest, outpoint));
+    }
+    mapUnspent.erase(it);
+}
+
+std::vector<const CWalletTx *> CWallet::GetUnspentTxs() const {
+    AssertLockHeld(cs_wallet);
+
+    std::vector<const CWalletTx *> vTxs;
+    // mapUnspent is sorted by outpoint, so the outputs of a transaction are
+    // next to each other.
+    for (const auto &entry : mapUnspent) {
+        if (vTxs.empty() || vTxs.back() != entry.second) {
+            vTxs.push_back(entry.second);
+        }
+    }
+    return vTxs;
+}
+
+std::vector<COutPoint>
+CWallet::GetUnspentOutPoints(const CTxDestination &dest) const {
+    AssertLockHeld(cs_wallet);
+
+    std::vector<COutPoint> vOutPoints;
+    for (auto it = setUnspentByDest.lower_bound(
+             std::make_pair(dest, COutPoint(TxId(), 0)));
+         it != setUnspentByDest.end() && it->first == dest; ++it) {
+        vOutPoints.push_back(it->second);
+    }
+    return vOutPoints;
+}
+
 bool CWallet::EncryptWallet(const SecureString &strWalletPassphrase) {
     if (IsCrypted()) {
         return false;
@@ -970,8 +1071,12 @@ bool CWallet::GetLabelDestination(CTxDestination &dest,
 
 void CWallet::MarkDirty() {
     LOCK(cs_wallet);
+    // Keys may have been added, so rebuild the unspent index as well.
+    mapUnspent.clear();
+    setUnspentByDest.clear();
     for (std::pair<const TxId, CWalletTx> &item : mapWallet) {
         item.second.MarkDirty();
+        AddToUnspent(item.second);
     }
 }
 
@@ -1032,6 +1137,7 @@ bool CWallet::AddToWallet(const CWalletTx &wtxIn, bool fFlushOnClose) {
 
     // Break debit/credit balance caches:
     wtx.MarkDirty();
+    AddToUnspent(wtx);
 
     // Notify UI of new or updated transaction.
     NotifyTransactionChanged(this, txid, fInsertedNew ? CT_NEW : CT_UPDATED);
@@ -1220,6 +1326,7 @@ bool CWallet::AbandonTransaction(const TxId &txid) {
                 auto it2 = mapWallet.find(txin.prevout.GetTxId());
                 if (it2 != mapWallet.end()) {
                     it2->second.MarkDirty();
+                    AddToUnspent(it2->second);
                 }
             }
         }
@@ -1284,6 +1391,7 @@ void CWallet::MarkConflicted(const uint256 &hashBlock, const TxId &txid) {
                 auto it2 = mapWallet.find(txin.prevout.GetTxId());
                 if (it2 != mapWallet.end()) {
                     it2->second.MarkDirty();
+                    AddToUnspent(it2->second);
                 }
             }
         }
@@ -1306,6 +1414,7 @@ void CWallet::SyncTransaction(const CTransactionRef &ptx,
         auto it = mapWallet.find(txin.prevout.GetTxId());
         if (it != mapWallet.end()) {
             it->second.MarkDirty();
+            AddToUnspent(it->second);
         }
     }
 }
@@ -1476,6 +1585,26 @@ bool CWallet::IsMine(const CTransaction &tx) const {
     return false;
 }
 
+std::vector<CScript> CWallet::GetScriptPubKeys() const {
+    LOCK(cs_KeyStore);
+
+    std::vector<CScript> scripts;
+    for (const CKeyID &keyid : GetKeys()) {
+        scripts.push_back(GetScriptForDestination(keyid));
+        CPubKey pubkey;
+        if (GetPubKey(keyid, pubkey)) {
+            scripts.push_back(GetScriptForRawPubKey(pubkey));
+        }
+    }
+
+    for (const CScriptID &scriptid : GetCScripts()) {
+        scripts.push_back(GetScriptForDestination(scriptid));
+    }
+
+    scripts.insert(scripts.end(), setWatchOnly.begin(), setWatchOnly.end());
+    return scripts;
+}
+
 bool CWallet::IsFromMe(const CTransaction &tx) const {
     return GetDebit(tx, ISMINE_ALL) > Amount::zero();
 }
@@ -1805,8 +1934,20 @@ CBlockIndex *CWallet::ScanForWalletTransactions(
     CBlockIndex *pindex = pindexStart;
     CBlockIndex *ret = nullptr;
 
+    const int nThreads = std::min<int64_t>(
+        gArgs.GetArg("-rescanthreads", DEFAULT_RESCAN_THREADS),
+        MAX_RESCAN_THREADS);
+    std::unique_ptr<WalletRescanFilter> filter;
+    if (nThreads > 0) {
+        filter = std::make_unique<WalletRescanFilter>(
+            *this, chainParams.GetConsensus(), nThreads);
+    }
+
     if (pindex) {
-        LogPrintf("Rescan started from block %d...\n", pindex->nHeight);
+        LogPrintf("Rescan started from block %d%s...\n", pindex->nHeight,
+                  filter ? strprintf(" using block filters on %d threads",
+                                     nThreads)
+                         : "");
     }
 
     {
@@ -1832,6 +1973,8 @@ CBlockIndex *CWallet::ScanForWalletTransactions(
             }
         }
         double progress_current = progress_begin;
+        const int64_t nStart = nNow;
+        int nLastHeight = pindex ? pindex->nHeight : 0;
         while (pindex && !fAbortRescan && !ShutdownRequested()) {
             if (pindex->nHeight % 100 == 0 &&
                 progress_end - progress_begin > 0.0) {
@@ -1844,13 +1987,27 @@ CBlockIndex *CWallet::ScanForWalletTransactions(
                                            100))));
             }
             if (GetTime() >= nNow + 60) {
-                nNow = GetTime();
-                LogPrintf("Still rescanning. At block %d. Progress=%f\n",
-                          pindex->nHeight, progress_current);
+                const int64_t nElapsed = GetTime() - nNow;
+                nNow += nElapsed;
+                LogPrintf("Still rescanning. At block %d. Progress=%f "
+                          "(%.1f blocks/s)\n",
+                          pindex->nHeight, progress_current,
+                          double(pindex->nHeight - nLastHeight) / nElapsed);
+                nLastHeight = pindex->nHeight;
             }
 
-            CBlock block;
-            if (ReadBlockFromDisk(block, pindex, chainParams.GetConsensus())) {
+            std::shared_ptr<const CBlock> block;
+            bool fRead;
+            if (filter) {
+                // The block is only returned if it matched the filters.
+                fRead = filter->ReadBlock(pindex, pindexStop, block);
+            } else {
+                auto pblock = std::make_shared<CBlock>();
+                fRead = ReadBlockFromDisk(*pblock, pindex,
+                                          chainParams.GetConsensus());
+                block = std::move(pblock);
+            }
+            if (fRead) {
                 LOCK2(cs_main, cs_wallet);
                 if (pindex && !chainActive.Contains(pindex)) {
                     // Abort scan if current block is no longer active, to
@@ -1859,9 +2016,9 @@ CBlockIndex *CWallet::ScanForWalletTransactions(
                     ret = pindex;
                     break;
                 }
-                for (size_t posInBlock = 0; posInBlock < block.vtx.size();
-                     ++posInBlock) {
-                    AddToWalletIfInvolvingMe(block.vtx[posInBlock], pindex,
+                for (size_t posInBlock = 0;
+                     block && posInBlock < block->vtx.size(); ++posInBlock) {
+                    AddToWalletIfInvolvingMe(block->vtx[posInBlock], pindex,
                                              posInBlock, fUpdate);
                 }
             } else {
@@ -1884,6 +2041,13 @@ CBlockIndex *CWallet::ScanForWalletTransactions(
             }
         }
 
+        if (filter) {
+            LogPrintf("Rescan matched %d of %d blocks against the wallet in "
+                      "%ds\n",
+                      filter->GetMatchCount(), filter->GetBlockCount(),
+                      GetTime() - nStart);
+        }
+
         if (pindex && fAbortRescan) {
             LogPrintf("Rescan aborted at block %d. Progress=%f\n",
                       pindex->nHeight, progress_current);
@@ -2259,8 +2423,7 @@ Amount CWallet::GetBalance() const {
     LOCK2(cs_main, cs_wallet);
 
     Amount nTotal = Amount::zero();
-    for (const auto &entry : mapWallet) {
-        const CWalletTx *pcoin = &entry.second;
+    for (const CWalletTx *pcoin : GetUnspentTxs()) {
         if (pcoin->IsTrusted()) {
             nTotal += pcoin->GetAvailableCredit();
         }
@@ -2273,8 +2436,7 @@ Amount CWallet::GetUnconfirmedBalance() const {
     LOCK2(cs_main, cs_wallet);
 
     Amount nTotal = Amount::zero();
-    for (const auto &entry : mapWallet) {
-        const CWalletTx *pcoin = &entry.second;
+    for (const CWalletTx *pcoin : GetUnspentTxs()) {
         if (!pcoin->IsTrusted() && pcoin->GetDepthInMainChain() == 0 &&
             pcoin->InMempool()) {
             nTotal += pcoin->GetAvailableCredit();
@@ -2300,8 +2462,7 @@ Amount CWallet::GetWatchOnlyBalance() const {
     LOCK2(cs_main, cs_wallet);
 
     Amount nTotal = Amount::zero();
-    for (const auto &entry : mapWallet) {
-        const CWalletTx *pcoin = &entry.second;
+    for (const CWalletTx *pcoin : GetUnspentTxs()) {
         if (pcoin->IsTrusted()) {
             nTotal += pcoin->GetAvailableWatchOnlyCredit();
         }
@@ -2314,8 +2475,7 @@ Amount CWallet::GetUnconfirmedWatchOnlyBalance() const {
     LOCK2(cs_main, cs_wallet);
 
     Amount nTotal = Amount::zero();
-    for (const auto &entry : mapWallet) {
-        const CWalletTx *pcoin = &entry.second;
+    for (const CWalletTx *pcoin : GetUnspentTxs()) {
         if (!pcoin->IsTrusted() && pcoin->GetDepthInMainChain() == 0 &&
             pcoin->InMempool()) {
             nTotal += pcoin->GetAvailableWatchOnlyCredit();
@@ -2410,9 +2570,8 @@ void CWallet::AvailableCoins(std::vector<COutput> &vCoins, bool fOnlySafe,
     vCoins.clear();
     Amount nTotal = Amount::zero();
 
-    for (const auto &entry : mapWallet) {
-        const TxId &wtxid = entry.first;
-        const CWalletTx *pcoin = &entry.second;
+    for (const CWalletTx *pcoin : GetUnspentTxs()) {
+        const TxId &wtxid = pcoin->GetId();
 
         if (!CheckFinalTx(*pcoin->tx)) {
             continue;
@@ -3425,6 +3584,10 @@ DBErrors CWallet::LoadWallet(bool &fFirstRunRet) {
                        mapScripts.empty();
     }
 
+    // Transactions can be loaded before the keys that make their outputs ours,
+    // so the unspent index is only built once everything is loaded.
+    MarkDirty();
+
     if (nLoadWalletRet != DBErrors::LOAD_OK) {
         return nLoadWalletRet;
     }
@@ -3439,7 +3602,14 @@ DBErrors CWallet::ZapSelectTx(std::vector<TxId> &txIdsIn,
     DBErrors nZapSelectTxRet =
         WalletBatch(*database, "cr+").ZapSelectTx(txIdsIn, txIdsOut);
     for (const TxId &txid : txIdsOut) {
-        mapWallet.erase(txid);
+        auto it = mapWallet.find(txid);
+        if (it == mapWallet.end()) {
+            continue;
+        }
+        for (uint32_t i = 0; i < it->second.tx->vout.size(); i++) {
+            RemoveFromUnspent(COutPoint(txid, i));
+        }
+        mapWallet.erase(it);
     }
 
     if (nZapSelectTxRet == DBErrors::NEED_REWRITE) {
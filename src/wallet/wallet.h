@@ -718,6 +718,26 @@ private:
     void AddToSpends(const COutPoint &outpoint, const TxId &wtxid);
     void AddToSpends(const TxId &wtxid);
 
+    /**
+     * Index of the outputs of wallet transactions that are ours and not spent
+     * by an active (neither conflicted nor abandoned) wallet transaction, so
+     * coin selection and balance queries don't have to walk mapWallet.
+     * Outputs that are only spent by conflicted transactions stay in the
+     * index as whether they are spent depends on the chain: users still have
+     * to check IsSpent().
+     */
+    std::map<COutPoint, const CWalletTx *> mapUnspent GUARDED_BY(cs_wallet);
+    //! The outputs of mapUnspent which have a destination, by destination.
+    std::set<std::pair<CTxDestination, COutPoint>>
+        setUnspentByDest GUARDED_BY(cs_wallet);
+    bool IsSpentByActiveTx(const COutPoint &outpoint) const;
+    void AddToUnspent(const CWalletTx &wtx) EXCLUSIVE_LOCKS_REQUIRED(cs_wallet);
+    void RemoveFromUnspent(const COutPoint &outpoint)
+        EXCLUSIVE_LOCKS_REQUIRED(cs_wallet);
+    //! Wallet transactions with at least one output in mapUnspent.
+    std::vector<const CWalletTx *> GetUnspentTxs() const
+        EXCLUSIVE_LOCKS_REQUIRED(cs_wallet);
+
     /**
      * Mark a transaction (and its in-wallet descendants) as conflicting with a
      * particular block.
@@ -908,6 +928,14 @@ public:
 
     bool IsSpent(const COutPoint &outpoint) const
         EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+
+    /**
+     * Return the outputs paying to dest that may be unspent, in outpoint
+     * order. Some of them can still be spent by a conflicted transaction, so
+     * check IsSpent().
+     */
+    std::vector<COutPoint> GetUnspentOutPoints(const CTxDestination &dest) const
+        EXCLUSIVE_LOCKS_REQUIRED(cs_wallet);
     std::vector<OutputGroup> GroupOutputs(const std::vector<COutput> &outputs,
                                           bool single_coin) const;
 
@@ -1175,6 +1203,11 @@ public:
     bool IsChange(const CTxOut &txout) const;
     Amount GetChange(const CTxOut &txout) const;
     bool IsMine(const CTransaction &tx) const;
+    /**
+     * Return the P2PK, P2PKH and P2SH scripts of the keys and scripts of the
+     * wallet, and its watch-only scripts.
+     */
+    std::vector<CScript> GetScriptPubKeys() const;
     /** should probably be renamed to IsRelevantToMe */
     bool IsFromMe(const CTransaction &tx) const;
     Amount GetDebit(const CTransaction &tx, const isminefilter &filter) const;
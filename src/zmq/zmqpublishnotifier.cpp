@@ -170,20 +170,14 @@ bool CZMQPublishRawBlockNotifier::NotifyBlock(const CBlockIndex *pindex) {
              pindex->GetBlockHash().GetHex());
 
     const Config &config = GetConfig();
-    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION | RPCSerializationFlags());
-    {
-        LOCK(cs_main);
-        CBlock block;
-        if (!ReadBlockFromDisk(block, pindex,
-                               config.GetChainParams().GetConsensus())) {
-            zmqError("Can't read block from disk");
-            return false;
-        }
-
-        ss << block;
+    std::vector<uint8_t> block;
+    if (!ReadRawBlockFromDisk(block, pindex,
+                              config.GetChainParams().DiskMagic())) {
+        zmqError("Can't read block from disk");
+        return false;
     }
 
-    return SendMessage(MSG_RAWBLOCK, &(*ss.begin()), ss.size());
+    return SendMessage(MSG_RAWBLOCK, block.data(), block.size());
 }
 
 bool CZMQPublishRawTransactionNotifier::NotifyTransaction(